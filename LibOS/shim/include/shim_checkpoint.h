@@ -60,7 +60,8 @@ struct shim_mem_entry {
     size_t size;
     void** paddr;
     void* data;
-    int prot;     /* combination of PAL_PROT_* flags */
+    int prot;       /* combination of PAL_PROT_* flags */
+    int alloc_type; /* combination of PAL_ALLOC_* flags */
 };
 
 struct shim_palhdl_entry {
@@ -346,6 +347,8 @@ typedef int (*migrate_func_t)(struct shim_cp_store*, struct shim_thread*, struct
  *
  * \param migrate_func Migration function defined by the caller.
  * \param exec         Executable to load in the child process.
+ * \param replace      True if the child process replaces the current one (execve), false if it is
+ *                     a new child of the current process (fork/clone, execve after vfork).
  * \param thread       Main-thread handle to be migrated to the child process.
  *
  * The remaining arguments are passed into the migration function.
@@ -353,7 +356,7 @@ typedef int (*migrate_func_t)(struct shim_cp_store*, struct shim_thread*, struct
  * \return             0 on success, negative POSIX error code on failure.
  */
 int create_process_and_send_checkpoint(migrate_func_t migrate_func, struct shim_handle* exec,
-                                       struct shim_thread* thread, ...);
+                                       bool replace, struct shim_thread* thread, ...);
 
 /*!
  * \brief Receive a checkpoint from parent process and restore state based on it.
@@ -12,6 +12,8 @@
 #include <shim_tcb.h>
 
 void restore_context(struct shim_context* context);
+void restore_context_with_retval(struct shim_context* context, long retval);
 void fixup_child_context(struct shim_regs* regs);
+void fixup_resumed_context(struct shim_regs* regs);
 
 #endif /* _SHIM_CONTEXT_H_ */
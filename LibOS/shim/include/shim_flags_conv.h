@@ -13,12 +13,28 @@
 #define SHIM_FLAGS_CONV_H
 
 #include <asm/fcntl.h>
+#include <linux/fadvise.h>
+#include <linux/falloc.h>
 #include <linux/mman.h>
 #include <linux/fcntl.h>
 
 #include "assert.h"
 #include "pal.h"
 
+#ifndef SYNC_FILE_RANGE_WAIT_BEFORE
+#define SYNC_FILE_RANGE_WAIT_BEFORE 1
+#define SYNC_FILE_RANGE_WRITE       2
+#define SYNC_FILE_RANGE_WAIT_AFTER  4
+#endif
+
+#ifndef RWF_HIPRI
+#define RWF_HIPRI  0x00000001
+#define RWF_DSYNC  0x00000002
+#define RWF_SYNC   0x00000004
+#define RWF_NOWAIT 0x00000008
+#define RWF_APPEND 0x00000010
+#endif
+
 static inline int LINUX_PROT_TO_PAL(int prot, int map_flags) {
     assert(WITHIN_MASK(prot, PROT_NONE | PROT_READ | PROT_WRITE | PROT_EXEC
                                 | PROT_GROWSDOWN | PROT_GROWSUP));
@@ -48,4 +64,35 @@ static inline int LINUX_OPEN_FLAGS_TO_PAL_OPTIONS(int flags) {
            (flags & O_NONBLOCK ? PAL_OPTION_NONBLOCK : 0);
 }
 
+static inline int LINUX_FALLOCATE_TO_PAL(int mode) {
+    return (mode & FALLOC_FL_KEEP_SIZE  ? PAL_FALLOCATE_KEEP_SIZE  : 0) |
+           (mode & FALLOC_FL_PUNCH_HOLE ? PAL_FALLOCATE_PUNCH_HOLE : 0) |
+           (mode & FALLOC_FL_ZERO_RANGE ? PAL_FALLOCATE_ZERO_RANGE : 0);
+}
+
+static inline int LINUX_FADVISE_TO_PAL(int advice) {
+    switch (advice) {
+        case POSIX_FADV_RANDOM:     return PAL_ADVICE_RANDOM;
+        case POSIX_FADV_SEQUENTIAL: return PAL_ADVICE_SEQUENTIAL;
+        case POSIX_FADV_WILLNEED:   return PAL_ADVICE_WILLNEED;
+        case POSIX_FADV_DONTNEED:   return PAL_ADVICE_DONTNEED;
+        case POSIX_FADV_NOREUSE:    return PAL_ADVICE_NOREUSE;
+        default:
+            assert(advice == POSIX_FADV_NORMAL);
+            return PAL_ADVICE_NORMAL;
+    }
+}
+
+static inline int LINUX_SYNC_FILE_RANGE_TO_PAL(int flags) {
+    return (flags & SYNC_FILE_RANGE_WAIT_BEFORE ? PAL_FLUSH_RANGE_WAIT_BEFORE : 0) |
+           (flags & SYNC_FILE_RANGE_WRITE       ? PAL_FLUSH_RANGE_WRITE       : 0) |
+           (flags & SYNC_FILE_RANGE_WAIT_AFTER  ? PAL_FLUSH_RANGE_WAIT_AFTER  : 0);
+}
+
+static inline int LINUX_RWF_TO_PAL(int flags) {
+    assert(WITHIN_MASK(flags, RWF_NOWAIT | RWF_HIPRI));
+    return (flags & RWF_NOWAIT ? PAL_RW_NOWAIT : 0) |
+           (flags & RWF_HIPRI  ? PAL_RW_HIPRI  : 0);
+}
+
 #endif /* SHIM_FLAGS_CONV_H */
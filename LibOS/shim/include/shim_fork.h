@@ -10,4 +10,8 @@
 int migrate_fork(struct shim_cp_store* store, struct shim_thread* thread,
                  struct shim_process* process, va_list ap);
 
+int do_vfork(void* child_stack);
+noreturn void vfork_child_exit(int error_code, int term_signal);
+noreturn void vfork_child_exec_done(void);
+
 #endif /* _SHIM_FORK_H_ */
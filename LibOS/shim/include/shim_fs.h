@@ -42,6 +42,13 @@ struct shim_fs_ops {
     /* write: the content from the file opened as handle */
     ssize_t (*write)(struct shim_handle* hdl, const void* buf, size_t count);
 
+    /* preadv, pwritev: vectored read and write at `pos`, or at the file position (which is then
+     * advanced) if `pos` is -1; `flags` are RWF_NOWAIT and RWF_HIPRI */
+    ssize_t (*preadv)(struct shim_handle* hdl, const struct iovec* iov, int iovcnt, off_t pos,
+                      int flags);
+    ssize_t (*pwritev)(struct shim_handle* hdl, const struct iovec* iov, int iovcnt, off_t pos,
+                       int flags);
+
     /* mmap: mmap handle to address */
     int (*mmap)(struct shim_handle* hdl, void** addr, size_t size, int prot, int flags,
                 off_t offset);
@@ -59,6 +66,15 @@ struct shim_fs_ops {
     /* Returns 0 on success, -errno on error */
     int (*truncate)(struct shim_handle* hdl, off_t len);
 
+    /* fallocate: allocate or deallocate a byte range of the file (FALLOC_FL_* modes) */
+    int (*fallocate)(struct shim_handle* hdl, int mode, off_t offset, off_t len);
+
+    /* fadvise: announce an access pattern (POSIX_FADV_*) for a byte range of the file */
+    int (*fadvise)(struct shim_handle* hdl, off_t offset, off_t len, int advice);
+
+    /* sync_range: write back a byte range of the file (SYNC_FILE_RANGE_* flags) */
+    int (*sync_range)(struct shim_handle* hdl, off_t offset, off_t nbytes, int flags);
+
     /* hstat: get status of the file */
     int (*hstat)(struct shim_handle* hdl, struct stat* buf);
 
@@ -501,6 +517,12 @@ HASHTYPE rehash_path(HASHTYPE ancester_hbuf, const char* path, size_t size);
 extern struct shim_fs_ops chroot_fs_ops;
 extern struct shim_d_ops chroot_d_ops;
 
+/* I/O at absolute offsets directly on the PAL handle of a regular chroot file, which leaves the
+ * file position alone (used to batch asynchronous I/O). chroot_direct_handle() returns NULL if
+ * `hdl` is not a regular file; chroot_direct_written() must follow writes which ended at `end`. */
+PAL_HANDLE chroot_direct_handle(struct shim_handle* hdl);
+void chroot_direct_written(struct shim_handle* hdl, off_t end);
+
 extern struct shim_fs_ops str_fs_ops;
 extern struct shim_d_ops str_d_ops;
 
@@ -510,6 +532,9 @@ extern struct shim_mount fifo_builtin_fs;
 extern struct shim_mount socket_builtin_fs;
 extern struct shim_mount epoll_builtin_fs;
 extern struct shim_mount eventfd_builtin_fs;
+extern struct shim_mount timerfd_builtin_fs;
+extern struct shim_mount mqueue_builtin_fs;
+extern struct shim_mount signalfd_builtin_fs;
 
 /* pseudo file systems (separate treatment since they don't have associated dentries) */
 #define DIR_RX_MODE  0555
@@ -37,7 +37,10 @@ enum shim_handle_type {
     TYPE_FUTEX,
     TYPE_STR,
     TYPE_EPOLL,
-    TYPE_EVENTFD
+    TYPE_EVENTFD,
+    TYPE_TIMERFD,
+    TYPE_MQUEUE,
+    TYPE_SIGNALFD
 };
 
 struct shim_handle;
@@ -183,11 +186,12 @@ struct shim_sock_handle {
     }* pending_options;
 
     struct shim_peek_buffer {
-        size_t size;             /* total size (capacity) of buffer `buf` */
-        size_t start;            /* beginning of buffered but yet unread data in `buf` */
-        size_t end;              /* end of buffered but yet unread data in `buf` */
-        char uri[SOCK_URI_SIZE]; /* cached URI for recvfrom(udp_socket) case */
-        char buf[];              /* peek buffer of size `size` */
+        size_t size;                  /* total size (capacity) of buffer `buf` */
+        size_t start;                 /* beginning of buffered but yet unread data in `buf` */
+        size_t end;                   /* end of buffered but yet unread data in `buf` */
+        struct sockaddr_storage addr; /* cached source for recvfrom(udp_socket) case */
+        size_t addrlen;               /* size of `addr` */
+        char buf[];                   /* peek buffer of size `size` */
     }* peek_buffer;
 };
 
@@ -212,9 +216,16 @@ struct shim_dir_handle {
     struct shim_dentry** ptr;
 };
 
+struct shm_segment_hdr;
+
+DEFINE_LIST(shim_shm_handle);
 struct shim_shm_handle {
-    /* XXX: need to implement */
-    void* __reserved;
+    IDTYPE shmid;
+    unsigned long shmkey;
+    size_t size;                 /* size of the data, page-aligned */
+    struct shm_segment_hdr* hdr; /* mapped header of the host object */
+    int nattach;                 /* attaches in this process */
+    LIST_TYPE(shim_shm_handle) list;
 };
 
 struct msg_type;
@@ -299,6 +310,39 @@ struct shim_epoll_handle {
     LISTP_TYPE(shim_epoll_item) fds;
 };
 
+struct shim_timerfd_handle {
+    struct async_timer timer;
+    uint64_t expirations; /* expirations not read yet, protected by the handle lock */
+    AEVENTTYPE event;     /* readable while `expirations` is non-zero, serves as the PAL handle */
+};
+
+struct mq_shared_hdr;
+
+DEFINE_LIST(shim_mqueue_handle);
+struct shim_mqueue_handle {
+    PAL_HANDLE file;            /* host shared-memory object holding the queue */
+    struct mq_shared_hdr* hdr;  /* mapping of `file` */
+    size_t map_size;
+    int opener;                 /* slot of this process in `hdr->openers`, -1 if none */
+    bool ready;                 /* whether `event` is signaled, protected by the handle lock */
+    bool waited;                /* whether poll(), select() or epoll waited on `event` */
+    bool notify;                /* whether this descriptor registered with mq_notify() */
+    int notify_signo;           /* 0 for SIGEV_NONE */
+    sigval_t notify_value;
+    IDTYPE notify_tgid;         /* process to which the notification is sent */
+    AEVENTTYPE event;           /* readable while the queue is not empty, serves as the PAL handle */
+    LIST_TYPE(shim_mqueue_handle) list; /* message queues opened in this process */
+};
+
+struct signalfd_notifier;
+
+struct shim_signalfd_handle {
+    __sigset_t mask;            /* protected by the signalfd list lock, see shim_signalfd.c */
+    bool ready;                 /* whether `event` is signaled */
+    AEVENTTYPE event;           /* readable while a signal in `mask` may be pending */
+    struct signalfd_notifier* notifier; /* entry of this signalfd in the process-wide list */
+};
+
 struct shim_mount;
 struct shim_qstr;
 struct shim_dentry;
@@ -334,6 +378,9 @@ struct shim_handle {
         struct shim_sem_handle sem;
         struct shim_str_handle str;
         struct shim_epoll_handle epoll;
+        struct shim_timerfd_handle timerfd;
+        struct shim_mqueue_handle mqueue;
+        struct shim_signalfd_handle signalfd;
     } info;
 
     struct shim_dir_handle dir_info;
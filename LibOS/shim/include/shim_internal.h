@@ -162,8 +162,34 @@ static inline int64_t get_cur_preempt (void) {
     return __atomic_load_n(&tcb->context.preempt.counter, __ATOMIC_SEQ_CST);
 }
 
+/* Syscall profiler (see shim_profile.c), enabled with `sys.syscall_profile = 1` in the
+ * manifest. Calls served by the fast path (see shim_fast_table) are counted separately. */
+extern bool g_syscall_profile;
+
+struct shim_syscall_profile;
+
+int init_syscall_profile(void);
+void syscall_profile_begin(uint64_t* cycles, uint64_t* pal_cycles);
+void syscall_profile_end(int sysno, bool fast, uint64_t cycles, uint64_t pal_cycles);
+void release_syscall_profile(struct shim_syscall_profile* prof);
+int format_syscall_profile(char** str, size_t* len);
+void dump_syscall_profile(void);
+
+#define SYSCALL_PROFILE_BEGIN()                             \
+        uint64_t __prof_cycles = 0, __prof_pal_cycles = 0;  \
+        if (g_syscall_profile)                              \
+            syscall_profile_begin(&__prof_cycles,           \
+                                  &__prof_pal_cycles);
+
+#define SYSCALL_PROFILE_END(name, fast)                     \
+        if (__prof_cycles)                                  \
+            syscall_profile_end(__NR_##name, fast,          \
+                                __prof_cycles,              \
+                                __prof_pal_cycles);
+
 #define BEGIN_SHIM(name, args ...)                          \
     SHIM_ARG_TYPE __shim_##name(args) {                     \
+        SYSCALL_PROFILE_BEGIN()                             \
         SHIM_ARG_TYPE ret = 0;                              \
         int64_t preempt = get_cur_preempt();                \
         __UNUSED(preempt);
@@ -171,6 +197,7 @@ static inline int64_t get_cur_preempt (void) {
 #define END_SHIM(name)                                      \
         handle_signals();                                   \
         assert(preempt == get_cur_preempt());               \
+        SYSCALL_PROFILE_END(name, false)                    \
         return ret;                                         \
     }
 
@@ -315,6 +342,42 @@ void parse_syscall_after (int sysno, const char * name, int nr, ...);
     END_SHIM(name)
 
 #define SHIM_PROTO_ARGS_0 void
+/* Fast-path entries for cheap syscalls which never block for long and never need the caller's
+ * register context. syscalldb calls them through shim_fast_table without building a shim_regs
+ * frame and without handling signals on return; while a signal or an exit is pending, syscalldb
+ * takes the regular path instead, which handles it. These entries also skip syscall tracing, so
+ * shim_init() clears shim_fast_table when debug output is enabled. */
+#define DEFINE_SHIM_FAST_SYSCALL(name, n, func, ...)        \
+    SHIM_FAST_SYSCALL_##n (name, func, __VA_ARGS__)
+
+#define SHIM_FAST_SYSCALL_0(name, func, r)                                  \
+    SHIM_ARG_TYPE __shim_fast_##name(void) {                                \
+        SYSCALL_PROFILE_BEGIN()                                             \
+        r __ret = (func)();                                                 \
+        SYSCALL_PROFILE_END(name, true)                                     \
+        return (SHIM_ARG_TYPE) __ret;                                       \
+    }
+
+#define SHIM_FAST_SYSCALL_1(name, func, r, t1, a1)                          \
+    SHIM_ARG_TYPE __shim_fast_##name(SHIM_ARG_TYPE __arg1) {                \
+        SYSCALL_PROFILE_BEGIN()                                             \
+        t1 a1 = (t1) __arg1;                                                \
+        r __ret = (func)(a1);                                               \
+        SYSCALL_PROFILE_END(name, true)                                     \
+        return (SHIM_ARG_TYPE) __ret;                                       \
+    }
+
+#define SHIM_FAST_SYSCALL_2(name, func, r, t1, a1, t2, a2)                  \
+    SHIM_ARG_TYPE __shim_fast_##name(SHIM_ARG_TYPE __arg1,                  \
+                                     SHIM_ARG_TYPE __arg2) {                \
+        SYSCALL_PROFILE_BEGIN()                                             \
+        t1 a1 = (t1) __arg1;                                                \
+        t2 a2 = (t2) __arg2;                                                \
+        r __ret = (func)(a1, a2);                                           \
+        SYSCALL_PROFILE_END(name, true)                                     \
+        return (SHIM_ARG_TYPE) __ret;                                       \
+    }
+
 #define SHIM_PROTO_ARGS_1 SHIM_ARG_TYPE __arg1
 #define SHIM_PROTO_ARGS_2 SHIM_PROTO_ARGS_1, SHIM_ARG_TYPE __arg2
 #define SHIM_PROTO_ARGS_3 SHIM_PROTO_ARGS_2, SHIM_ARG_TYPE __arg3
@@ -720,6 +783,7 @@ void set_rlimit_cur(int resource, uint64_t rlim);
 int object_wait_with_retry(PAL_HANDLE handle);
 
 void release_clear_child_tid(int* clear_child_tid);
+int init_futex(void);
 
 void delete_from_epoll_handles(struct shim_handle* handle);
 
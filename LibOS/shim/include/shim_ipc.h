@@ -135,6 +135,7 @@ enum {
     IPC_PID_RETMETA,
     IPC_PID_NOP,
     IPC_PID_SENDRPC,
+    IPC_PID_MQNOTIFY,
     IPC_PID_BOUND,
 };
 
@@ -223,6 +224,25 @@ struct shim_ipc_pid_sendrpc {
 int ipc_pid_sendrpc_send(IDTYPE pid, IDTYPE sender, const void* buf, int len);
 int ipc_pid_sendrpc_callback(IPC_CALLBACK_ARGS);
 
+/* PID_MQNOTIFY: a POSIX message queue opened by the process became non-empty */
+enum {
+    MQNOTIFY_READY  = 1, /* update the poll readiness of the process' descriptors of the queue */
+    MQNOTIFY_SIGNAL = 2, /* deliver the mq_notify() notification registered by the process */
+};
+
+struct shim_ipc_pid_mqnotify {
+    IDTYPE sender;
+    int flags;
+    char name[];
+} __attribute__((packed));
+
+int ipc_pid_mqnotify_send(IDTYPE pid, IDTYPE sender, const char* name, int flags);
+int ipc_pid_mqnotify_callback(IPC_CALLBACK_ARGS);
+
+/* implemented in sys/shim_mqueue.c */
+void mqueue_notified(IDTYPE sender, const char* name, int flags);
+int init_mqueue(void);
+
 #define IPC_SYSV_BASE IPC_PID_BOUND
 
 struct sysv_key {
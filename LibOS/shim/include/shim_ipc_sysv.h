@@ -3,7 +3,10 @@
 #ifndef _SHIM_IPC_SYSV_H_
 #define _SHIM_IPC_SYSV_H_
 
+#include <shim_types.h>
+
 int init_ns_sysv(void);
+int get_sysv_leader(IDTYPE* vmid);
 void debug_print_sysv_ranges(void);
 
 #endif /* _SHIM_IPC_SYSV_H_ */
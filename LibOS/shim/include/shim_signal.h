@@ -110,6 +110,15 @@ int append_signal(struct shim_thread* thread, siginfo_t* info);
 
 void deliver_signal(siginfo_t* info, PAL_CONTEXT* context);
 
+/* pop a pending signal in `mask` (thread queue first, then process queue) without handling it */
+bool dequeue_signal(struct shim_thread* thread, const __sigset_t* mask, siginfo_t* info);
+
+/* number of signals in the process-wide queue */
+extern uint64_t process_pending_signals_cnt;
+
+/* wake up signalfds waiting for `sig`; implemented in shim_signalfd.c */
+void signalfd_notify(int sig);
+
 __sigset_t * get_sig_mask (struct shim_thread * thread);
 __sigset_t * set_sig_mask (struct shim_thread * thread,
                            const __sigset_t * new_set);
@@ -117,6 +126,9 @@ __sigset_t * set_sig_mask (struct shim_thread * thread,
 int do_kill_thread (IDTYPE sender, IDTYPE tgid, IDTYPE tid, int sig,
                     bool use_ipc);
 int do_kill_proc (IDTYPE sender, IDTYPE tgid, int sig, bool use_ipc);
+/* deliver a signal with a complete siginfo within this process (no IPC) */
+int do_kill_proc_info(IDTYPE tgid, siginfo_t* info);
+int do_kill_thread_info(IDTYPE tgid, IDTYPE tid, siginfo_t* info);
 int do_kill_pgroup (IDTYPE sender, IDTYPE pgid, int sig, bool use_ipc);
 
 #endif /* _SHIM_SIGNAL_H_ */
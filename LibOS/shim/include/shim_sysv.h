@@ -200,6 +200,21 @@ int recover_sem_ownership(struct shim_sem_handle* sem, struct sem_backup* backup
 int submit_sysv_sem(struct shim_sem_handle* sem, struct sembuf* sops, int nsops,
                     unsigned long timeout, struct sysv_client* client);
 
+/* Header of a shared-memory segment, kept in the first page of its host object so that all
+ * attaching processes see the same state. */
+struct shm_segment_hdr {
+    unsigned long key;
+    size_t size;
+    int mode;
+    bool deleted;
+    uint32_t nattch;
+    IDTYPE cpid, lpid;
+    IDTYPE cuid, cgid, uid, gid;
+    uint64_t atime, dtime, ctime;
+};
+
+void detach_all_shm(void);
+
 #ifdef USE_SHARED_SEMAPHORE
 int send_sem_host_ids(struct shim_sem_handle* sem, struct shim_ipc_port* port, IDTYPE dest,
                       unsigned long seq);
@@ -15,6 +15,7 @@ void debug_unsupp(int num);
 typedef void (*shim_fp)(void);
 
 extern shim_fp shim_table[];
+extern shim_fp shim_fast_table[];
 
 /* syscall entries */
 long __shim_read(long, long, long);
@@ -319,6 +320,8 @@ long __shim_syncfs(long);
 long __shim_sendmmsg(long, long, long, long);
 long __shim_setns(long, long);
 long __shim_getcpu(long, long, long);
+long __shim_preadv2(long, long, long, long, long, long);
+long __shim_pwritev2(long, long, long, long, long, long);
 
 /* libos call entries */
 long __shim_msgpersist(long, long);
@@ -326,6 +329,19 @@ long __shim_benchmark_rpc(long, long, long, long);
 long __shim_send_rpc(long, long, long);
 long __shim_recv_rpc(long, long, long);
 
+/* fast-path syscall entries */
+long __shim_fast_sched_yield(void);
+long __shim_fast_getpid(void);
+long __shim_fast_gettimeofday(long, long);
+long __shim_fast_getuid(void);
+long __shim_fast_getgid(void);
+long __shim_fast_geteuid(void);
+long __shim_fast_getegid(void);
+long __shim_fast_getppid(void);
+long __shim_fast_gettid(void);
+long __shim_fast_time(long);
+long __shim_fast_clock_gettime(long, long);
+
 /* syscall implementation */
 size_t shim_do_read(int fd, void* buf, size_t count);
 size_t shim_do_write(int fd, const void* buf, size_t count);
@@ -359,6 +375,10 @@ int shim_do_sched_yield(void);
 void* shim_do_mremap(void* addr, size_t old_len, size_t new_len, int flags, void* new_addr);
 int shim_do_msync(void* start, size_t len, int flags);
 int shim_do_mincore(void* start, size_t len, unsigned char* vec);
+int shim_do_madvise(void* start, size_t len, int behavior);
+int shim_do_shmget(key_t key, size_t size, int shmflg);
+void* shim_do_shmat(int shmid, const void* shmaddr, int shmflg);
+int shim_do_shmctl(int shmid, int cmd, struct shmid_ds* buf);
 int shim_do_dup(unsigned int fd);
 int shim_do_dup2(unsigned int oldfd, unsigned int newfd);
 int shim_do_pause(void);
@@ -398,6 +418,7 @@ int shim_do_uname(struct new_utsname* buf);
 int shim_do_semget(key_t key, int nsems, int semflg);
 int shim_do_semop(int semid, struct sembuf* sops, unsigned int nsops);
 int shim_do_semctl(int semid, int semnum, int cmd, unsigned long arg);
+int shim_do_shmdt(const void* shmaddr);
 int shim_do_msgget(key_t key, int msgflg);
 int shim_do_msgsnd(int msqid, const void* msgp, size_t msgsz, int msgflg);
 int shim_do_msgrcv(int msqid, void* msgp, size_t msgsz, long msgtyp, int msgflg);
@@ -407,6 +428,10 @@ int shim_do_fsync(int fd);
 int shim_do_fdatasync(int fd);
 int shim_do_truncate(const char* path, loff_t length);
 int shim_do_ftruncate(int fd, loff_t length);
+int shim_do_fallocate(int fd, int mode, loff_t offset, loff_t len);
+int shim_do_fadvise64(int fd, loff_t offset, size_t len, int advice);
+int shim_do_readahead(int fd, loff_t offset, size_t count);
+int shim_do_sync_file_range(int fd, loff_t offset, loff_t nbytes, int flags);
 size_t shim_do_getdents(int fd, struct linux_dirent* buf, size_t count);
 int shim_do_getcwd(char* buf, size_t size);
 int shim_do_chdir(const char* filename);
@@ -462,6 +487,12 @@ time_t shim_do_time(time_t* tloc);
 int shim_do_futex(int* uaddr, int op, int val, void* utime, int* uaddr2, int val3);
 int shim_do_sched_setaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr);
 int shim_do_sched_getaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr);
+int shim_do_io_setup(unsigned int nr_events, aio_context_t* ctxp);
+int shim_do_io_destroy(aio_context_t ctx_id);
+int shim_do_io_getevents(aio_context_t ctx_id, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout);
+int shim_do_io_submit(aio_context_t ctx_id, long nr, struct iocb** iocbpp);
+int shim_do_io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* result);
 int shim_do_set_tid_address(int* tidptr);
 int shim_do_semtimedop(int semid, struct sembuf* sops, unsigned int nsops,
                        const struct timespec* timeout);
@@ -470,6 +501,14 @@ size_t shim_do_getdents64(int fd, struct linux_dirent64* buf, size_t count);
 int shim_do_epoll_wait(int epfd, struct __kernel_epoll_event* events, int maxevents,
                        int timeout_ms);
 int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* event);
+int shim_do_timer_create(clockid_t which_clock, struct sigevent* timer_event_spec,
+                         timer_t* created_timer_id);
+int shim_do_timer_settime(timer_t timer_id, int flags,
+                          const struct __kernel_itimerspec* new_setting,
+                          struct __kernel_itimerspec* old_setting);
+int shim_do_timer_gettime(timer_t timer_id, struct __kernel_itimerspec* setting);
+int shim_do_timer_getoverrun(timer_t timer_id);
+int shim_do_timer_delete(timer_t timer_id);
 int shim_do_clock_gettime(clockid_t which_clock, struct timespec* tp);
 int shim_do_clock_getres(clockid_t which_clock, struct timespec* tp);
 int shim_do_clock_nanosleep(clockid_t clock_id, int flags, const struct __kernel_timespec* rqtp,
@@ -478,6 +517,15 @@ noreturn int shim_do_exit_group(int error_code);
 int shim_do_tgkill(int tgid, int pid, int sig);
 int shim_do_mbind(void* start, unsigned long len, int mode, unsigned long* nmask,
                   unsigned long maxnode, int flags);
+int shim_do_mq_open(const char* name, int oflag, mode_t mode, struct __kernel_mq_attr* attr);
+int shim_do_mq_unlink(const char* name);
+int shim_do_mq_timedsend(__kernel_mqd_t mqdes, const char* msg_ptr, size_t msg_len,
+                         unsigned int msg_prio, const struct timespec* abs_timeout);
+int shim_do_mq_timedreceive(__kernel_mqd_t mqdes, char* msg_ptr, size_t msg_len,
+                            unsigned int* msg_prio, const struct timespec* abs_timeout);
+int shim_do_mq_notify(__kernel_mqd_t mqdes, const struct sigevent* notification);
+int shim_do_mq_getsetattr(__kernel_mqd_t mqdes, const struct __kernel_mq_attr* mqstat,
+                          struct __kernel_mq_attr* omqstat);
 int shim_do_openat(int dfd, const char* filename, int flags, int mode);
 int shim_do_mkdirat(int dfd, const char* pathname, int mode);
 int shim_do_newfstatat(int dirfd, const char* pathname, struct stat* statbuf, int flags);
@@ -492,9 +540,20 @@ int shim_do_ppoll(struct pollfd* fds, int nfds, struct timespec* tsp, const __si
                   size_t sigsetsize);
 int shim_do_set_robust_list(struct robust_list_head* head, size_t len);
 int shim_do_get_robust_list(pid_t pid, struct robust_list_head** head, size_t* len);
+ssize_t shim_do_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                       unsigned int flags);
+ssize_t shim_do_tee(int fd_in, int fd_out, size_t len, unsigned int flags);
+ssize_t shim_do_vmsplice(int fd, const struct iovec* iov, unsigned long nr_segs,
+                         unsigned int flags);
 int shim_do_epoll_pwait(int epfd, struct __kernel_epoll_event* events, int maxevents,
                         int timeout_ms, const __sigset_t* sigmask, size_t sigsetsize);
+int shim_do_signalfd(int ufd, __sigset_t* user_mask, size_t sizemask);
+int shim_do_timerfd_create(int clockid, int flags);
+int shim_do_timerfd_settime(int ufd, int flags, const struct __kernel_itimerspec* utmr,
+                            struct __kernel_itimerspec* otmr);
+int shim_do_timerfd_gettime(int ufd, struct __kernel_itimerspec* otmr);
 int shim_do_accept4(int sockfd, struct sockaddr* addr, int* addrlen, int flags);
+int shim_do_signalfd4(int ufd, __sigset_t* user_mask, size_t sizemask, int flags);
 int shim_do_dup3(unsigned int oldfd, unsigned int newfd, int flags);
 int shim_do_epoll_create1(int flags);
 int shim_do_pipe2(int* fildes, int flags);
@@ -508,6 +567,14 @@ ssize_t shim_do_sendmmsg(int sockfd, struct mmsghdr* msg, unsigned int vlen, int
 int shim_do_eventfd2(unsigned int count, int flags);
 int shim_do_eventfd(unsigned int count);
 int shim_do_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused);
+ssize_t shim_do_preadv(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                       unsigned long pos_h);
+ssize_t shim_do_pwritev(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h);
+ssize_t shim_do_preadv2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h, int flags);
+ssize_t shim_do_pwritev2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                         unsigned long pos_h, int flags);
 
 /* libos call implementation */
 int shim_do_msgpersist(int msqid, int cmd);
@@ -801,10 +868,11 @@ int shim_ppoll(struct pollfd* fds, int nfds, struct timespec* tsp, const __sigse
 int shim_unshare(int unshare_flags);
 int shim_set_robust_list(struct robust_list_head* head, size_t len);
 int shim_get_robust_list(pid_t pid, struct robust_list_head** head, size_t* len);
-int shim_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len, int flags);
-int shim_tee(int fdin, int fdout, size_t len, unsigned int flags);
+ssize_t shim_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                    unsigned int flags);
+ssize_t shim_tee(int fdin, int fdout, size_t len, unsigned int flags);
 int shim_sync_file_range(int fd, loff_t offset, loff_t nbytes, int flags);
-int shim_vmsplice(int fd, const struct iovec* iov, unsigned long nr_segs, int flags);
+ssize_t shim_vmsplice(int fd, const struct iovec* iov, unsigned long nr_segs, unsigned int flags);
 int shim_move_pages(pid_t pid, unsigned long nr_pages, void** pages, const int* nodes, int* status,
                     int flags);
 int shim_utimensat(int dfd, const char* filename, struct timespec* utimes, int flags);
@@ -824,10 +892,10 @@ int shim_epoll_create1(int flags);
 int shim_dup3(unsigned int oldfd, unsigned int newfd, int flags);
 int shim_pipe2(int* fildes, int flags);
 int shim_inotify_init1(int flags);
-int shim_preadv(unsigned long fd, const struct iovec* vec, unsigned long vlen, unsigned long pos_l,
-                unsigned long pos_h);
-int shim_pwritev(unsigned long fd, const struct iovec* vec, unsigned long vlen, unsigned long pos_l,
-                 unsigned long pos_h);
+ssize_t shim_preadv(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                    unsigned long pos_h);
+ssize_t shim_pwritev(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                     unsigned long pos_h);
 int shim_rt_tgsigqueueinfo(pid_t tgid, pid_t pid, int sig, siginfo_t* uinfo);
 int shim_perf_event_open(struct perf_event_attr* attr_uptr, pid_t pid, int cpu, int group_fd,
                          int flags);
@@ -837,6 +905,10 @@ int shim_prlimit64(pid_t pid, int resource, const struct __kernel_rlimit64* new_
                    struct __kernel_rlimit64* old_rlim);
 ssize_t shim_sendmmsg(int sockfd, struct mmsghdr* msg, unsigned int vlen, int flags);
 int shim_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused);
+ssize_t shim_preadv2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                     unsigned long pos_h, int flags);
+ssize_t shim_pwritev2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                      unsigned long pos_h, int flags);
 
 /* libos call wrappers */
 int shim_msgpersist(int msqid, int cmd);
@@ -16,6 +16,7 @@
 struct shim_handle;
 struct shim_fd_map;
 struct shim_dentry;
+struct shim_vfork_state;
 
 #define WAKE_QUEUE_TAIL ((void*)1)
 /* If next is NULL, then this node is not on any queue.
@@ -42,8 +43,15 @@ struct shim_rt_signal_queue {
     struct shim_signal* queue[MAX_SIGNAL_LOG];
 };
 
+/* Standard signals are not queued: at most one instance of each is pending. They are kept in
+ * preallocated slots, so that appending one needs no allocation. Bit `sig - 1` of
+ * `standard_claimed` is owned by whoever writes or reads the slot of `sig`; the same bit of
+ * `standard_pending` tells that the slot holds a pending signal. See append_standard_signal() in
+ * shim_signal.c. */
 struct shim_signal_queue {
-    struct shim_signal* standard_signals[SIGRTMIN - 1];
+    uint64_t standard_claimed;
+    uint64_t standard_pending;
+    siginfo_t standard_signals[SIGRTMIN - 1];
     struct shim_rt_signal_queue rt_signal_queues[NUM_SIGS - SIGRTMIN + 1];
 };
 
@@ -93,6 +101,17 @@ struct shim_thread {
     /* futex robust list */
     struct robust_list_head* robust_list;
 
+    /* futex word of the host futex wait in progress (if any) and the number of host futex waits
+     * started; see `wake_host_futex_waiter()` */
+    uint32_t* host_futex_uaddr;
+    uint64_t host_futex_waits;
+
+    /* CPU affinity; inherited by child threads and migrated to child processes */
+    __kernel_cpu_set_t cpu_affinity;
+
+    /* syscall profiler counters of this thread; see shim_profile.c */
+    struct shim_syscall_profile* syscall_profile;
+
     PAL_HANDLE scheduler_event;
 
     struct wake_queue_node wake_queue;
@@ -118,6 +137,9 @@ struct shim_thread {
     shim_tcb_t * shim_tcb;
     void * frameptr;
 
+    /* set while this vfork child runs in place of its suspended parent, see shim_fork.c */
+    struct shim_vfork_state* vfork_state;
+
     REFTYPE ref_count;
     struct shim_lock lock;
 };
@@ -131,6 +153,7 @@ static inline bool is_internal(struct shim_thread *thread)
 
 void get_signal_handles(struct shim_signal_handles* handles);
 void put_signal_handles(struct shim_signal_handles* handles);
+struct shim_signal_handles* dup_signal_handles(struct shim_signal_handles* handles);
 
 void get_thread (struct shim_thread * thread);
 void put_thread (struct shim_thread * thread);
@@ -310,6 +333,7 @@ noreturn void thread_exit(int error_code, int term_signal);
 noreturn void process_exit(int error_code, int term_signal);
 
 void release_robust_list(struct robust_list_head* head);
+void wake_host_futex_waiter(struct shim_thread* thread);
 
 /* thread cloning helpers */
 struct shim_clone_args {
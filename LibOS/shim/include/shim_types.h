@@ -219,10 +219,20 @@ struct __kernel_ustat
 /* bits/socket.h */
 enum
 {
-    MSG_OOB  = 0x01, /* Process out-of-band data. */
-    MSG_PEEK = 0x02, /* Peek at incoming messages. */
+    MSG_OOB      = 0x01,   /* Process out-of-band data. */
+    MSG_PEEK     = 0x02,   /* Peek at incoming messages. */
+    MSG_TRUNC    = 0x20,   /* Return the real length of a truncated datagram. */
+    MSG_DONTWAIT = 0x40,   /* Nonblocking IO. */
+    MSG_WAITALL  = 0x100,  /* Wait for a full request. */
+    MSG_NOSIGNAL = 0x4000, /* Do not generate SIGPIPE. */
+    MSG_MORE     = 0x8000, /* Sender will send more. */
 #define MSG_OOB MSG_OOB
 #define MSG_PEEK MSG_PEEK
+#define MSG_TRUNC MSG_TRUNC
+#define MSG_DONTWAIT MSG_DONTWAIT
+#define MSG_WAITALL MSG_WAITALL
+#define MSG_NOSIGNAL MSG_NOSIGNAL
+#define MSG_MORE MSG_MORE
 };
 
 struct msghdr {
@@ -368,6 +378,14 @@ typedef struct shim_aevent {
     PAL_HANDLE event;
 } AEVENTTYPE;
 
+/* timer serviced by the async helper thread, see shim_async.c */
+struct async_timer {
+    uint64_t expire_time; /* absolute time in usecs, 0 if the timer is disarmed */
+    uint64_t interval;    /* period in usecs, 0 for one-shot timers */
+    size_t heap_idx;      /* position in the timer heap, only valid if armed */
+    void (*callback)(struct async_timer* timer, uint64_t expirations);
+};
+
 #define STR_SIZE    4096
 
 struct shim_str {
@@ -212,10 +212,27 @@ int create_handle(const char* prefix, char* path, size_t size, PAL_HANDLE* hdl,
 
 /* Asynchronous event support */
 int init_async(void);
-int64_t install_async_event(PAL_HANDLE object, unsigned long time,
-                            void (*callback)(IDTYPE caller, void* arg), void* arg);
+int install_async_event(PAL_HANDLE object, void (*callback)(IDTYPE caller, void* arg),
+                        void* arg);
 struct shim_thread* terminate_async_helper(void);
 
+/* Timers serviced by the async helper; `timer` must be zero-initialized before first use */
+int set_async_timer(struct async_timer* timer, uint64_t expire_time, uint64_t interval);
+uint64_t get_async_timer(struct async_timer* timer, uint64_t* interval);
+void cancel_async_timer(struct async_timer* timer);
+int itimerspec_to_async_timer(const struct __kernel_itimerspec* spec, bool abstime,
+                              uint64_t* expire_time, uint64_t* interval);
+void async_timer_to_itimerspec(struct async_timer* timer, struct __kernel_itimerspec* spec);
+
+/* POSIX per-process timers (timer_create) */
+void delete_all_posix_timers(void);
+
+/* POSIX message queues (mq_open) */
+void mqueue_prepare_wait(struct shim_handle* hdl);
+
+/* Asynchronous I/O (io_submit) support */
+void destroy_all_aio_contexts(void);
+
 extern struct config_store* root_config;
 
 #endif /* _SHIM_UTILS_H */
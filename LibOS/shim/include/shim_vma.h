@@ -48,9 +48,29 @@ struct shim_vma_info {
 /* vma is backed by a file and has been protected as writable, so it has to be checkpointed during
  * migration */
 #define VMA_TAINTED 0x40000000
+/* vma is not inherited by child processes (MADV_DONTFORK) */
+#define VMA_DONTFORK 0x08000000
+/* vma is backed by 1GB huge pages (only together with MAP_HUGETLB, which alone means the host
+ * default huge page size); the MAP_HUGE_* size bits of mmap() overlap with VMA_* flags and are never
+ * stored */
+#define VMA_HUGEPAGE_1G 0x02000000
+/* vma is advised to use transparent huge pages */
+#define VMA_THP 0x01000000
+
+/* Converts the host-backing flags of a vma (MAP_* and VMA_*) to PAL_ALLOC_* flags. */
+static inline int VMA_FLAGS_TO_PAL_ALLOC(int flags) {
+    return (flags & MAP_HUGETLB     ? PAL_ALLOC_HUGEPAGE    : 0) |
+           (flags & VMA_HUGEPAGE_1G ? PAL_ALLOC_HUGEPAGE_1G : 0) |
+           (flags & VMA_THP         ? PAL_ALLOC_THP         : 0) |
+           (flags & MAP_POPULATE    ? PAL_ALLOC_POPULATE    : 0) |
+           (flags & MAP_NORESERVE   ? PAL_ALLOC_NORESERVE   : 0);
+}
 
 int init_vma(void);
 
+/* Reads the mmap-related manifest options; must be called after the manifest is loaded. */
+int init_mmap(void);
+
 /*
  * Bookkeeping a removal of mapped memory. On success returns a temporary VMA pointer in
  * `tmp_vma_ptr`, which must be subsequently freed by calling `bkeep_remove_tmp_vma` - but this
@@ -69,6 +89,17 @@ int init_vma(void);
 int bkeep_munmap(void* addr, size_t length, bool is_internal, void** tmp_vma_ptr);
 void bkeep_remove_tmp_vma(void* vma);
 
+/*
+ * Bookkeeping an in-place growth of mapped memory (for mremap). [`addr`, `addr` + `old_length`) must
+ * be the tail of a user VMA, which is extended to `addr` + `new_length`. Returns -ENOMEM if the
+ * range after the VMA is not free.
+ */
+int bkeep_mremap_extend(void* addr, size_t old_length, size_t new_length);
+
+/* Bookkeeping MADV_DONTFORK (if `dontfork` is true) or MADV_DOFORK on [`addr`, `addr` + `length`),
+ * which must be mapped as user memory. */
+int bkeep_madvise_dontfork(void* addr, size_t length, bool dontfork);
+
 /* Bookkeeping a change to memory protections. */
 int bkeep_mprotect(void* addr, size_t length, int prot, bool is_internal);
 
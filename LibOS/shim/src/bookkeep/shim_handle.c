@@ -749,6 +749,14 @@ BEGIN_CP_FUNC(handle) {
             new_hdl->info.sock.peek_buffer     = NULL;
         }
 
+        if (hdl->type == TYPE_MQUEUE && hdl->info.mqueue.file) {
+            /* the host object may already be unlinked, so the child cannot re-open it by name */
+            struct shim_palhdl_entry* entry;
+            DO_CP(palhdl, hdl->info.mqueue.file, &entry);
+            entry->uri     = &new_hdl->uri;
+            entry->phandle = &new_hdl->info.mqueue.file;
+        }
+
         INIT_LISTP(&new_hdl->epolls);
 
         unlock(&hdl->lock);
@@ -62,8 +62,8 @@ static struct shim_signal_queue process_signal_queue = { 0 };
 /* This is just an optimization, not to have to check the queue for pending signals. A thread will
  * be woken up after signal is appended to its queue and will handle all unblocked pending signals
  * no matter what is the relative ordering of increasing this variable vs. appending signal to
- * the queue. */
-static uint64_t process_pending_signals_cnt = 0;
+ * the queue. Also read by the syscalldb fast path (see syscallas-x86_64.S). */
+uint64_t process_pending_signals_cnt = 0;
 
 /*
  * These checks are racy, but we can't do better anyway: signal can be delivered in any moment.
@@ -80,8 +80,12 @@ static bool is_rt_sq_empty(struct shim_rt_signal_queue* queue) {
             == __atomic_load_n(&queue->put_idx, __ATOMIC_ACQUIRE);
 }
 
-static bool has_standard_signal(struct shim_signal** queue) {
-    return !!__atomic_load_n(queue, __ATOMIC_ACQUIRE);
+static uint64_t sig_bit(int sig) {
+    return 1UL << (sig - 1);
+}
+
+static bool has_standard_signal(struct shim_signal_queue* queue, int sig) {
+    return !!(__atomic_load_n(&queue->standard_pending, __ATOMIC_ACQUIRE) & sig_bit(sig));
 }
 
 void get_pending_signals(struct shim_thread* thread, __sigset_t* set) {
@@ -93,8 +97,8 @@ void get_pending_signals(struct shim_thread* thread, __sigset_t* set) {
     }
 
     for (int sig = 1; sig < SIGRTMIN; sig++) {
-        if (has_standard_signal(&thread->signal_queue.standard_signals[sig - 1])
-                || has_standard_signal(&process_signal_queue.standard_signals[sig - 1])) {
+        if (has_standard_signal(&thread->signal_queue, sig)
+                || has_standard_signal(&process_signal_queue, sig)) {
             __sigaddset(set, sig);
         }
     }
@@ -107,10 +111,20 @@ void get_pending_signals(struct shim_thread* thread, __sigset_t* set) {
     }
 }
 
-static bool append_standard_signal(struct shim_signal** signal_slot, struct shim_signal* signal) {
-    struct shim_signal* old = NULL;
-    return __atomic_compare_exchange_n(signal_slot, &old, signal, /*weak=*/false,
-                                       __ATOMIC_RELEASE, __ATOMIC_ACQUIRE);
+/* A standard signal which is already pending is dropped. So is one which arrives while the pending
+ * instance is being popped (between the two atomic updates in pop_standard_signal()); the signal
+ * is being delivered at that moment anyway. We cannot wait for the popper instead: it may be this
+ * very thread, interrupted by a host signal. */
+static bool append_standard_signal(struct shim_signal_queue* queue, siginfo_t* info) {
+    uint64_t bit = sig_bit(info->si_signo);
+
+    if (__atomic_fetch_or(&queue->standard_claimed, bit, __ATOMIC_ACQUIRE) & bit) {
+        return false;
+    }
+
+    memcpy(&queue->standard_signals[info->si_signo - 1], info, sizeof(*info));
+    __atomic_fetch_or(&queue->standard_pending, bit, __ATOMIC_RELEASE);
+    return true;
 }
 
 /* In theory `get_idx` and `put_idx` could overflow, but adding signals with 1GHz (10**9 signals
@@ -137,36 +151,64 @@ static bool append_rt_signal(struct shim_rt_signal_queue* queue,
     return true;
 }
 
-static bool queue_append_signal(struct shim_signal_queue* queue, struct shim_signal* signal) {
+/* Standard signals only keep their siginfo: the context is taken when they are handled. Real-time
+ * signals are queued as heap copies of `signal`. Returns -EAGAIN if the signal was dropped. */
+static int queue_append_signal(struct shim_signal_queue* queue, struct shim_signal* signal) {
     int sig = signal->info.si_signo;
 
     if (sig < 1 || sig > NUM_SIGS) {
-        return false;
+        return -EINVAL;
     } else if (sig < SIGRTMIN) {
-        return append_standard_signal(&queue->standard_signals[sig - 1], signal);
-    } else {
-        return append_rt_signal(&queue->rt_signal_queues[sig - SIGRTMIN], signal);
+        return append_standard_signal(queue, &signal->info) ? 0 : -EAGAIN;
     }
+
+    struct shim_signal* copy = malloc(sizeof(*copy));
+    if (!copy) {
+        return -ENOMEM;
+    }
+
+    memcpy(&copy->info, &signal->info, sizeof(copy->info));
+    copy->context_stored = signal->context_stored;
+    if (signal->context_stored) {
+        memcpy(&copy->context, &signal->context, sizeof(copy->context));
+    }
+    copy->pal_context = signal->pal_context;
+
+    if (!append_rt_signal(&queue->rt_signal_queues[sig - SIGRTMIN], copy)) {
+        free(copy);
+        return -EAGAIN;
+    }
+    return 0;
 }
 
-static bool append_thread_signal(struct shim_thread* thread, struct shim_signal* signal) {
-    bool ret = queue_append_signal(&thread->signal_queue, signal);
-    if (ret) {
+static int append_thread_signal(struct shim_thread* thread, struct shim_signal* signal) {
+    int ret = queue_append_signal(&thread->signal_queue, signal);
+    if (!ret) {
         (void)__atomic_add_fetch(&thread->pending_signals, 1, __ATOMIC_RELEASE);
+        signalfd_notify(signal->info.si_signo);
     }
     return ret;
 }
 
-static bool append_process_signal(struct shim_signal* signal) {
-    bool ret = queue_append_signal(&process_signal_queue, signal);
-    if (ret) {
+static int append_process_signal(struct shim_signal* signal) {
+    int ret = queue_append_signal(&process_signal_queue, signal);
+    if (!ret) {
         (void)__atomic_add_fetch(&process_pending_signals_cnt, 1, __ATOMIC_RELEASE);
+        signalfd_notify(signal->info.si_signo);
     }
     return ret;
 }
 
-static struct shim_signal* pop_standard_signal(struct shim_signal** signal_slot) {
-    return __atomic_exchange_n(signal_slot, NULL, __ATOMIC_ACQ_REL);
+static bool pop_standard_signal(struct shim_signal_queue* queue, int sig, siginfo_t* info) {
+    uint64_t bit = sig_bit(sig);
+
+    if (!(__atomic_fetch_and(&queue->standard_pending, ~bit, __ATOMIC_ACQUIRE) & bit)) {
+        return false;
+    }
+
+    memcpy(info, &queue->standard_signals[sig - 1], sizeof(*info));
+    __atomic_fetch_and(&queue->standard_claimed, ~bit, __ATOMIC_RELEASE);
+    return true;
 }
 
 static struct shim_signal* pop_rt_signal(struct shim_rt_signal_queue* queue) {
@@ -185,26 +227,52 @@ static struct shim_signal* pop_rt_signal(struct shim_rt_signal_queue* queue) {
     return queue->queue[get_idx % ARRAY_SIZE(queue->queue)];
 }
 
-static struct shim_signal* queue_pop_signal(struct shim_signal_queue* queue, int sig) {
-    if (sig < 1 || sig > NUM_SIGS) {
-        return NULL;
-    } else if (sig < SIGRTMIN) {
-        return pop_standard_signal(&queue->standard_signals[sig - 1]);
-    } else {
-        return pop_rt_signal(&queue->rt_signal_queues[sig - SIGRTMIN]);
+static bool thread_pop_standard_signal(struct shim_thread* thread, int sig, siginfo_t* info) {
+    if (!pop_standard_signal(&thread->signal_queue, sig, info)) {
+        return false;
+    }
+    (void)__atomic_sub_fetch(&thread->pending_signals, 1, __ATOMIC_ACQUIRE);
+    return true;
+}
+
+static bool process_pop_standard_signal(int sig, siginfo_t* info) {
+    if (!pop_standard_signal(&process_signal_queue, sig, info)) {
+        return false;
+    }
+    (void)__atomic_sub_fetch(&process_pending_signals_cnt, 1, __ATOMIC_ACQUIRE);
+    return true;
+}
+
+/* Pops the lowest-numbered pending standard signal in `wanted`, from the queue of `thread` or of
+ * the process. */
+static bool pop_wanted_standard_signal(struct shim_thread* thread, uint64_t wanted,
+                                       siginfo_t* info) {
+    uint64_t standard = (__atomic_load_n(&thread->signal_queue.standard_pending, __ATOMIC_ACQUIRE)
+                         | __atomic_load_n(&process_signal_queue.standard_pending,
+                                           __ATOMIC_ACQUIRE))
+                        & wanted;
+    while (standard) {
+        int sig = __builtin_ctzl(standard) + 1;
+        standard &= standard - 1;
+
+        if (thread_pop_standard_signal(thread, sig, info) || process_pop_standard_signal(sig, info))
+            return true;
     }
+    return false;
 }
 
-static struct shim_signal* thread_pop_signal(struct shim_thread* thread, int sig) {
-    struct shim_signal* signal = queue_pop_signal(&thread->signal_queue, sig);
+static struct shim_signal* thread_pop_rt_signal(struct shim_thread* thread, int sig) {
+    struct shim_signal_queue* queue = &thread->signal_queue;
+    struct shim_signal* signal = pop_rt_signal(&queue->rt_signal_queues[sig - SIGRTMIN]);
     if (signal) {
         (void)__atomic_sub_fetch(&thread->pending_signals, 1, __ATOMIC_ACQUIRE);
     }
     return signal;
 }
 
-static struct shim_signal* process_pop_signal(int sig) {
-    struct shim_signal* signal = queue_pop_signal(&process_signal_queue, sig);
+static struct shim_signal* process_pop_rt_signal(int sig) {
+    struct shim_signal_queue* queue = &process_signal_queue;
+    struct shim_signal* signal = pop_rt_signal(&queue->rt_signal_queues[sig - SIGRTMIN]);
     if (signal) {
         (void)__atomic_sub_fetch(&process_pending_signals_cnt, 1, __ATOMIC_ACQUIRE);
     }
@@ -263,13 +331,9 @@ void deliver_signal (siginfo_t * info, PAL_CONTEXT * context)
     signal->pal_context = context;
 
     if (preempt > 1 || __sigismember(&cur_thread->signal_mask, sig)) {
-        signal = malloc_copy(signal,sizeof(struct shim_signal));
-        if (signal) {
-            if (!append_thread_signal(cur_thread, signal)) {
-                debug("Signal %d queue of thread %u is full, dropping the incoming signal\n",
-                      sig, tcb->tid);
-                free(signal);
-            }
+        if (append_thread_signal(cur_thread, signal) == -EAGAIN) {
+            debug("Signal %d queue of thread %u is full, dropping the incoming signal\n",
+                  sig, tcb->tid);
         }
     } else {
         __handle_one_signal(tcb, signal);
@@ -796,14 +860,25 @@ void __handle_signals(shim_tcb_t* tcb) {
 
     while (__atomic_load_n(&thread->pending_signals, __ATOMIC_ACQUIRE)
            || __atomic_load_n(&process_pending_signals_cnt, __ATOMIC_ACQUIRE)) {
+        /* standard signals come first; the pending bitmaps tell which of them to look at without
+         * walking the queues */
+        struct shim_signal standard;
+        if (pop_wanted_standard_signal(thread, ~thread->signal_mask.__val[0], &standard.info)) {
+            standard.context_stored = false;
+            standard.pal_context = NULL;
+            __store_context(tcb, NULL, &standard);
+            __handle_one_signal(tcb, &standard);
+            continue;
+        }
+
         struct shim_signal* signal = NULL;
 
-        for (int sig = 1; sig <= NUM_SIGS; sig++) {
+        for (int sig = SIGRTMIN; sig <= NUM_SIGS; sig++) {
             if (!__sigismember(&thread->signal_mask, sig)) {
-                if ((signal = thread_pop_signal(thread, sig))) {
+                if ((signal = thread_pop_rt_signal(thread, sig))) {
                     break;
                 }
-                if ((signal = process_pop_signal(sig))) {
+                if ((signal = process_pop_rt_signal(sig))) {
                     break;
                 }
             }
@@ -822,10 +897,38 @@ void __handle_signals(shim_tcb_t* tcb) {
     }
 }
 
+bool dequeue_signal(struct shim_thread* thread, const __sigset_t* mask, siginfo_t* info) {
+    if (pop_wanted_standard_signal(thread, mask->__val[0], info))
+        return true;
+
+    for (int sig = SIGRTMIN; sig <= NUM_SIGS; sig++) {
+        if (!__sigismember(mask, sig))
+            continue;
+
+        struct shim_signal* signal = thread_pop_rt_signal(thread, sig);
+        if (!signal)
+            signal = process_pop_rt_signal(sig);
+        if (signal) {
+            memcpy(info, &signal->info, sizeof(*info));
+            free(signal);
+            return true;
+        }
+    }
+    return false;
+}
+
 void handle_signals(void) {
     shim_tcb_t * tcb = shim_get_tcb();
     assert(tcb);
 
+    /* this runs at the end of every system call, so check for work before touching preemption */
+    struct shim_thread* thread = tcb->tp;
+    if (thread && !__atomic_load_n(&thread->time_to_die, __ATOMIC_ACQUIRE)
+            && !__atomic_load_n(&thread->pending_signals, __ATOMIC_ACQUIRE)
+            && !__atomic_load_n(&process_pending_signals_cnt, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
     int64_t preempt = __disable_preempt(tcb);
 
     if (preempt > 1)
@@ -841,24 +944,15 @@ int append_signal(struct shim_thread* thread, siginfo_t* info) {
 
     // TODO: ignore SIGCHLD even if it's masked, when handler is set to SIG_IGN (probably not here)
 
-    struct shim_signal* signal = malloc(sizeof(*signal));
-    if (!signal) {
-        return -ENOMEM;
-    }
+    /* only copied to the heap if it is a real-time signal, see queue_append_signal() */
+    struct shim_signal signal;
+    __store_info(info, &signal);
+    signal.context_stored = false;
+    signal.pal_context = NULL;
 
-    /* save in signal */
-    __store_info(info, signal);
-    signal->context_stored = false;
-    signal->pal_context = NULL;
-
-    if (thread) {
-        if (append_thread_signal(thread, signal)) {
-            return 0;
-        }
-    } else {
-        if (append_process_signal(signal)) {
-            return 0;
-        }
+    int ret = thread ? append_thread_signal(thread, &signal) : append_process_signal(&signal);
+    if (ret != -EAGAIN) {
+        return ret;
     }
 
     debug("Signal %d queue of ", info->si_signo);
@@ -868,7 +962,6 @@ int append_signal(struct shim_thread* thread, siginfo_t* info) {
         debug("process");
     }
     debug(" is full, dropping the incoming signal\n");
-    free(signal);
     /* This is counter-intuitive, but we report success here: after all signal was successfully
      * delivered, just the queue was full. */
     return 0;
@@ -944,13 +1037,11 @@ BEGIN_CP_FUNC(pending_signals)
     memset(&infos, 0, sizeof(infos));
 
     for (int sig = 1; sig < SIGRTMIN && i < n; sig++) {
-        struct shim_signal** q = &process_signal_queue.standard_signals[sig - 1];
         /* This load might look racy, but the only scenario that this signal is removed from
          * the queue is another thread handling it. We are doing an execve, so we are the only
          * thread existing. */
-        struct shim_signal* signal = __atomic_load_n(q, __ATOMIC_ACQUIRE);
-        if (signal) {
-            memcpy(&infos[i], &signal->info, sizeof(infos[i]));
+        if (has_standard_signal(&process_signal_queue, sig)) {
+            memcpy(&infos[i], &process_signal_queue.standard_signals[sig - 1], sizeof(infos[i]));
             i++;
         }
     }
@@ -981,18 +1072,16 @@ BEGIN_RS_FUNC(pending_signals)
     size_t n = *(size_t*)((char*)base + off);
     siginfo_t* infos = (siginfo_t*)((char*)base + off + sizeof(n));
     for (size_t i = 0; i < n; i++) {
-        struct shim_signal* signal = malloc(sizeof(*signal));
-        if (!signal) {
-            return -ENOMEM;
-        }
+        struct shim_signal signal;
 
         assert(infos[i].si_signo);
 
-        memcpy(&signal->info, &infos[i], sizeof(signal->info));
-        signal->context_stored = false;
-        signal->pal_context = NULL;
-        if (!append_process_signal(signal)) {
-            return -EAGAIN;
+        memcpy(&signal.info, &infos[i], sizeof(signal.info));
+        signal.context_stored = false;
+        signal.pal_context = NULL;
+        int ret = append_process_signal(&signal);
+        if (ret < 0) {
+            return ret;
         }
     }
 }
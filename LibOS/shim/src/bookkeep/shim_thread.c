@@ -20,6 +20,7 @@
 #include <cpu.h>
 #include <list.h>
 #include <pal.h>
+#include <spinlock.h>
 
 #include <linux/signal.h>
 
@@ -30,6 +31,14 @@ struct shim_lock thread_list_lock;
 
 static IDTYPE internal_tid_alloc_idx = INTERNAL_TID_BASE;
 
+/* Freed threads are kept here together with their lock and PAL events, which are reused by the
+ * next get_new_thread(); thread-per-request workloads then create and destroy no PAL objects on
+ * clone() and exit(). */
+#define THREAD_CACHE_MAX 64
+static LISTP_TYPE(shim_thread) thread_cache = LISTP_INIT;
+static size_t thread_cache_num = 0;
+static spinlock_t thread_cache_lock = INIT_SPINLOCK_UNLOCKED;
+
 PAL_HANDLE thread_start_event = NULL;
 
 //#define DEBUG_REF
@@ -57,6 +66,11 @@ int init_thread (void)
     set_cur_thread(cur_thread);
     add_thread(cur_thread);
     cur_thread->pal_handle = PAL_CB(first_thread);
+
+    /* the host may have restricted the CPU affinity of Graphene itself (e.g. by taskset) */
+    __kernel_cpu_set_t host_affinity;
+    if (DkThreadGetCpuAffinity(cur_thread->pal_handle, sizeof(host_affinity), &host_affinity))
+        memcpy(&cur_thread->cpu_affinity, &host_affinity, sizeof(host_affinity));
     return 0;
 }
 
@@ -133,11 +147,76 @@ static IDTYPE get_internal_pid (void)
     return idx;
 }
 
+static void destroy_thread(struct shim_thread* thread) {
+    if (thread->scheduler_event)
+        DkObjectClose(thread->scheduler_event);
+    if (thread->exit_event)
+        DkObjectClose(thread->exit_event);
+    if (thread->child_exit_event)
+        DkObjectClose(thread->child_exit_event);
+
+    if (lock_created(&thread->lock)) {
+        destroy_lock(&thread->lock);
+    }
+
+    free(thread);
+}
+
+/* Returns true if `thread` was put into the thread cache; it must not hold references anymore. */
+static bool cache_thread(struct shim_thread* thread) {
+    if (is_internal(thread) || !lock_created(&thread->lock) || !thread->scheduler_event ||
+            !thread->exit_event || !thread->child_exit_event)
+        return false;
+
+    struct shim_lock lock         = thread->lock;
+    PAL_HANDLE scheduler_event    = thread->scheduler_event;
+    PAL_HANDLE exit_event         = thread->exit_event;
+    PAL_HANDLE child_exit_event   = thread->child_exit_event;
+
+    spinlock_lock_signal_off(&thread_cache_lock);
+    if (thread_cache_num >= THREAD_CACHE_MAX) {
+        spinlock_unlock_signal_on(&thread_cache_lock);
+        return false;
+    }
+    thread_cache_num++;
+    spinlock_unlock_signal_on(&thread_cache_lock);
+
+    /* back to the initial state of the events created in get_new_thread() */
+    DkEventSet(scheduler_event);
+    DkEventClear(exit_event);
+    DkEventClear(child_exit_event);
+
+    memset(thread, 0, sizeof(*thread));
+    thread->lock             = lock;
+    thread->scheduler_event  = scheduler_event;
+    thread->exit_event       = exit_event;
+    thread->child_exit_event = child_exit_event;
+    INIT_LIST_HEAD(thread, list);
+
+    spinlock_lock_signal_off(&thread_cache_lock);
+    LISTP_ADD(thread, &thread_cache, list);
+    spinlock_unlock_signal_on(&thread_cache_lock);
+    return true;
+}
+
 static struct shim_thread * alloc_new_thread (void)
 {
-    struct shim_thread * thread = calloc(1, sizeof(struct shim_thread));
-    if (!thread)
-        return NULL;
+    struct shim_thread * thread = NULL;
+
+    spinlock_lock_signal_off(&thread_cache_lock);
+    if (!LISTP_EMPTY(&thread_cache)) {
+        thread = LISTP_FIRST_ENTRY(&thread_cache, struct shim_thread, list);
+        LISTP_DEL(thread, &thread_cache, list);
+        thread_cache_num--;
+    }
+    spinlock_unlock_signal_on(&thread_cache_lock);
+
+    /* a cached thread is zeroed except for its lock and events, see cache_thread() */
+    if (!thread) {
+        thread = calloc(1, sizeof(struct shim_thread));
+        if (!thread)
+            return NULL;
+    }
 
     REF_SET(thread->ref_count, 1);
     INIT_LISTP(&thread->children);
@@ -212,6 +291,10 @@ struct shim_thread * get_new_thread (IDTYPE new_tid)
         memcpy(&thread->signal_mask, &cur_thread->signal_mask,
                sizeof(sigset_t));
 
+        lock(&cur_thread->lock);
+        memcpy(&thread->cpu_affinity, &cur_thread->cpu_affinity, sizeof(thread->cpu_affinity));
+        unlock(&cur_thread->lock);
+
         get_dentry(cur_thread->cwd);
         get_dentry(cur_thread->root);
 
@@ -238,16 +321,25 @@ struct shim_thread * get_new_thread (IDTYPE new_tid)
         if (!thread->signal_handles) {
             goto out_error;
         }
+
+        /* by default, a thread may run on any host CPU */
+        const size_t nbits = 8 * sizeof(thread->cpu_affinity.__bits[0]);
+        for (size_t i = 0; i < PAL_CB(cpu_info.cpu_num) && i < 8 * sizeof(thread->cpu_affinity);
+             i++)
+            thread->cpu_affinity.__bits[i / nbits] |= 1UL << (i % nbits);
     }
 
-    if (!create_lock(&thread->lock)) {
+    if (!lock_created(&thread->lock) && !create_lock(&thread->lock)) {
         goto out_error;
     }
 
     thread->vmid = cur_process.vmid;
-    thread->scheduler_event = DkNotificationEventCreate(PAL_TRUE);
-    thread->exit_event = DkNotificationEventCreate(PAL_FALSE);
-    thread->child_exit_event = DkNotificationEventCreate(PAL_FALSE);
+    if (!thread->scheduler_event)
+        thread->scheduler_event = DkNotificationEventCreate(PAL_TRUE);
+    if (!thread->exit_event)
+        thread->exit_event = DkNotificationEventCreate(PAL_FALSE);
+    if (!thread->child_exit_event)
+        thread->child_exit_event = DkNotificationEventCreate(PAL_FALSE);
     return thread;
 
 out_error:
@@ -267,7 +359,7 @@ out_error:
         put_handle(thread->exec);
     }
     release_pid(new_tid);
-    free(thread);
+    destroy_thread(thread);
     return NULL;
 }
 
@@ -285,11 +377,12 @@ struct shim_thread * get_new_internal_thread (void)
     thread->vmid  = cur_process.vmid;
     thread->tid   = new_tid;
     thread->in_vm = thread->is_alive = true;
-    if (!create_lock(&thread->lock)) {
-        free(thread);
+    if (!lock_created(&thread->lock) && !create_lock(&thread->lock)) {
+        destroy_thread(thread);
         return NULL;
     }
-    thread->exit_event = DkNotificationEventCreate(PAL_FALSE);
+    if (!thread->exit_event)
+        thread->exit_event = DkNotificationEventCreate(PAL_FALSE);
     return thread;
 }
 
@@ -309,6 +402,24 @@ void put_signal_handles(struct shim_signal_handles* handles) {
     }
 }
 
+/* returns a private copy of `handles` (with a single reference), e.g. for a vfork child */
+struct shim_signal_handles* dup_signal_handles(struct shim_signal_handles* handles) {
+    struct shim_signal_handles* new_handles = malloc(sizeof(*new_handles));
+    if (!new_handles)
+        return NULL;
+
+    if (!create_lock(&new_handles->lock)) {
+        free(new_handles);
+        return NULL;
+    }
+    REF_SET(new_handles->ref_count, 1);
+
+    lock(&handles->lock);
+    memcpy(new_handles->actions, handles->actions, sizeof(new_handles->actions));
+    unlock(&handles->lock);
+    return new_handles;
+}
+
 void get_thread(struct shim_thread* thread) {
     int ref_count = REF_INC(thread->ref_count);
     DEBUG_PRINT_REF_COUNT(ref_count);
@@ -324,13 +435,6 @@ void put_thread(struct shim_thread* thread) {
             thread->pal_handle != PAL_CB(first_thread))
             DkObjectClose(thread->pal_handle);
 
-        if (thread->scheduler_event)
-            DkObjectClose(thread->scheduler_event);
-        if (thread->exit_event)
-            DkObjectClose(thread->exit_event);
-        if (thread->child_exit_event)
-            DkObjectClose(thread->child_exit_event);
-
         if (thread->handle_map) {
             put_handle_map(thread->handle_map);
         }
@@ -345,17 +449,18 @@ void put_thread(struct shim_thread* thread) {
             put_signal_handles(thread->signal_handles);
         }
 
+        if (thread->syscall_profile) {
+            release_syscall_profile(thread->syscall_profile);
+        }
+
         if (thread->exec)
             put_handle(thread->exec);
 
         if (!is_internal(thread))
             release_pid(thread->tid);
 
-        if (lock_created(&thread->lock)) {
-            destroy_lock(&thread->lock);
-        }
-
-        free(thread);
+        if (!cache_thread(thread))
+            destroy_thread(thread);
     }
 }
 
@@ -596,6 +701,8 @@ BEGIN_CP_FUNC(thread)
         new_thread->cwd    = NULL;
         memset(&new_thread->signal_queue, 0, sizeof(new_thread->signal_queue));
         new_thread->robust_list = NULL;
+        new_thread->syscall_profile = NULL;
+        new_thread->vfork_state = NULL;
         REF_SET(new_thread->ref_count, 0);
 
         DO_CP_MEMBER(signal_handles, thread, new_thread, signal_handles);
@@ -775,6 +882,12 @@ BEGIN_RS_FUNC(running_thread)
         thread->pal_handle = PAL_CB(first_thread);
     }
 
+    /* the host thread does not necessarily run with the affinity of the migrated thread */
+    if (!DkThreadSetCpuAffinity(thread->pal_handle, sizeof(thread->cpu_affinity),
+                                &thread->cpu_affinity) &&
+        PAL_NATIVE_ERRNO() != PAL_ERROR_NOTIMPLEMENTED)
+        debug("failed to restore CPU affinity of thread %d\n", thread->tid);
+
     DEBUG_RS("tid=%d", thread->tid);
 }
 END_RS_FUNC(running_thread)
@@ -29,8 +29,9 @@
  * MAP_FIXED or unsupported flags. */
 static int filter_saved_flags(int flags) {
     return flags & (MAP_SHARED | MAP_SHARED_VALIDATE | MAP_PRIVATE | MAP_ANONYMOUS | MAP_FILE
-                    | MAP_GROWSDOWN | MAP_HUGETLB | MAP_HUGE_2MB | MAP_HUGE_1GB | MAP_STACK
-                    | VMA_UNMAPPED | VMA_INTERNAL | VMA_TAINTED);
+                    | MAP_GROWSDOWN | MAP_HUGETLB | MAP_POPULATE | MAP_NORESERVE | MAP_STACK
+                    | VMA_UNMAPPED | VMA_INTERNAL | VMA_TAINTED | VMA_DONTFORK | VMA_HUGEPAGE_1G
+                    | VMA_THP);
 }
 
 /* TODO: split flags into internal (Graphene) and Linux; also to consider: completely remove Linux
@@ -739,6 +740,126 @@ int bkeep_mmap_fixed(void* addr, size_t length, int prot, int flags,
     return ret;
 }
 
+int bkeep_mremap_extend(void* addr, size_t old_length, size_t new_length) {
+    if (!old_length || !IS_ALLOC_ALIGNED(old_length) || !IS_ALLOC_ALIGNED(new_length)
+            || !IS_ALLOC_ALIGNED_PTR(addr) || new_length <= old_length) {
+        return -EINVAL;
+    }
+
+    uintptr_t begin = (uintptr_t)addr;
+    uintptr_t old_end = begin + old_length;
+    uintptr_t new_end = begin + new_length;
+    if (old_end < begin || new_end < begin) {
+        return -ENOMEM;
+    }
+
+    int ret = 0;
+    spinlock_lock_signal_off(&vma_tree_lock);
+    struct shim_vma* vma = _lookup_vma(begin);
+    if (!vma || !is_addr_in_vma(begin, vma) || vma->end < old_end
+            || (vma->flags & (VMA_INTERNAL | VMA_UNMAPPED))) {
+        ret = -EFAULT;
+        goto out;
+    }
+
+    struct shim_vma* next = _get_next_vma(vma);
+    if (vma->end != old_end || (next && next->begin < new_end)) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    /* The tree is sorted by `end` and `new_end` does not reach the next vma, so the order of the
+     * tree is preserved. */
+    vma->end = new_end;
+
+out:
+    spinlock_unlock_signal_on(&vma_tree_lock);
+    return ret;
+}
+
+/* Splits the vma containing `addr` at `addr`, unless `addr` is its boundary. Might use the
+ * preallocated vma in `new_vma_ptr` (same rules as in `_vma_bkeep_remove`). */
+static void _vma_split_at(uintptr_t addr, struct shim_vma** new_vma_ptr) {
+    assert(spinlock_is_locked(&vma_tree_lock));
+
+    struct shim_vma* vma = _lookup_vma(addr);
+    if (!vma || addr <= vma->begin) {
+        return;
+    }
+
+    struct shim_vma* new_vma = *new_vma_ptr;
+    *new_vma_ptr = NULL;
+
+    split_vma(vma, new_vma, addr);
+    avl_tree_insert(&vma_tree, &new_vma->tree_node);
+}
+
+int bkeep_madvise_dontfork(void* addr, size_t length, bool dontfork) {
+    if (!length || !IS_ALLOC_ALIGNED(length) || !IS_ALLOC_ALIGNED_PTR(addr)) {
+        return -EINVAL;
+    }
+
+    uintptr_t begin = (uintptr_t)addr;
+    uintptr_t end = begin + length;
+
+    struct shim_vma* vma1 = alloc_vma();
+    if (!vma1) {
+        return -ENOMEM;
+    }
+    struct shim_vma* vma2 = alloc_vma();
+    if (!vma2) {
+        free_vma(vma1);
+        return -ENOMEM;
+    }
+
+    int ret = 0;
+    spinlock_lock_signal_off(&vma_tree_lock);
+
+    /* first check the whole range, so that nothing is changed on error */
+    struct shim_vma* vma = _lookup_vma(begin);
+    if (!vma || begin < vma->begin) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    while (1) {
+        if (vma->flags & (VMA_INTERNAL | VMA_UNMAPPED)) {
+            ret = -ENOMEM;
+            goto out;
+        }
+        if (end <= vma->end) {
+            break;
+        }
+        struct shim_vma* next = _get_next_vma(vma);
+        if (!next || next->begin != vma->end) {
+            ret = -ENOMEM;
+            goto out;
+        }
+        vma = next;
+    }
+
+    _vma_split_at(begin, &vma1);
+    _vma_split_at(end, &vma2);
+
+    for (vma = _lookup_vma(begin); vma && vma->begin < end; vma = _get_next_vma(vma)) {
+        if (dontfork) {
+            vma->flags |= VMA_DONTFORK;
+        } else {
+            vma->flags &= ~VMA_DONTFORK;
+        }
+    }
+
+out:
+    spinlock_unlock_signal_on(&vma_tree_lock);
+
+    if (vma1) {
+        free_vma(vma1);
+    }
+    if (vma2) {
+        free_vma(vma2);
+    }
+    return ret;
+}
+
 static void vma_update_prot(struct shim_vma* vma, int prot) {
     vma->prot = prot & (PROT_NONE | PROT_READ | PROT_WRITE | PROT_EXEC);
     if (vma->file && (prot & PROT_WRITE)) {
@@ -1172,6 +1293,8 @@ BEGIN_CP_FUNC(vma)
                 struct shim_mem_entry * mem;
                 DO_CP_SIZE(memory, send_addr, send_size, &mem);
                 mem->prot = LINUX_PROT_TO_PAL(vma->prot, /*map_flags=*/0);
+                /* prefaulting is pointless, the memory is filled with the checkpointed data */
+                mem->alloc_type = VMA_FLAGS_TO_PAL_ALLOC(vma->flags) & ~PAL_ALLOC_POPULATE;
 
                 need_mapped = vma->addr + vma->length;
             }
@@ -1234,7 +1357,7 @@ BEGIN_RS_FUNC(vma)
 
         if (need_mapped < vma->addr + vma->length) {
             if (DkVirtualMemoryAlloc(need_mapped, vma->addr + vma->length - need_mapped,
-                                     /*alloc_type=*/0,
+                                     VMA_FLAGS_TO_PAL_ALLOC(vma->flags),
                                      LINUX_PROT_TO_PAL(vma->prot, /*map_flags=*/0))) {
                 need_mapped += vma->length;
             }
@@ -1273,7 +1396,10 @@ BEGIN_CP_FUNC(all_vmas)
     }
 
     for (struct shim_vma_info* vma = &vmas[count - 1];; vma--) {
-        DO_CP(vma, vma, NULL);
+        /* vmas marked with MADV_DONTFORK do not exist in the child, SysV shared memory is
+         * re-attached by the child itself (see "all_shm_attaches") */
+        if (!(vma->flags & VMA_DONTFORK) && !(vma->file && vma->file->type == TYPE_SHM))
+            DO_CP(vma, vma, NULL);
         if (vma == vmas)
             break;
     }
@@ -275,6 +275,137 @@ static struct link_map* new_elf_object(const char* realname, int type) {
 #define FILEBUF_SIZE 832
 #endif
 
+/*
+ * Loader cache. Every execve() of an exec-heavy workload loads the same handful of ELF objects
+ * (the executable and ld.so) over and over again. For each such object we remember the validated
+ * layout derived from its program headers (load commands, dynamic section, interpreter, RELRO).
+ *
+ * An entry is keyed by the URI and by the exact bytes of the ELF header and program headers it was
+ * derived from. The loader reads these bytes anyway, so a lookup costs a memcmp() and never trusts
+ * stale metadata: if the file changed, its header no longer matches and the entry is replaced.
+ * Objects whose program headers do not fit into the header buffer are not cached. The cache holds
+ * at most MAX_CACHED_ELF_IMAGES entries of fixed size and is migrated to child processes (see
+ * `loader_cache` checkpoint function below).
+ *
+ * Symbols of the loaded objects resolved against LibOS (internal_map) are remembered by their index
+ * in the LibOS symbol table. This table is per-process and never migrated, so it always refers to
+ * the LibOS binary of the current process.
+ */
+#define MAX_CACHED_ELF_IMAGES 8
+
+struct elf_layout {
+    struct loadcmd loadcmds[MAX_LOADCMDS];
+    int nloadcmds;
+    bool has_holes;
+    ElfW(Dyn)* ld;
+    ElfW(Half) ldnum;
+    const char* interp_libname;
+    const ElfW(Phdr)* phdr;
+    ElfW(Addr) relro_addr;
+    size_t relro_size;
+};
+
+DEFINE_LIST(elf_image);
+struct elf_image {
+    LIST_TYPE(elf_image) list;
+    char* uri;
+    struct elf_layout layout;
+    int hdr_len;
+    char hdr[FILEBUF_SIZE];
+};
+DEFINE_LISTP(elf_image);
+static LISTP_TYPE(elf_image) elf_image_cache = LISTP_INIT;
+static int elf_image_cache_cnt = 0;
+
+#define RESOLVED_SYMS_SIZE 256 /* must be a power of two */
+
+/* symidx == 0 (STN_UNDEF) marks an empty slot */
+struct resolved_sym {
+    uint32_t hash;
+    uint32_t symidx;
+};
+
+static struct resolved_sym resolved_syms[RESOLVED_SYMS_SIZE];
+
+/* protects elf_image_cache, elf_image_cache_cnt and resolved_syms */
+static struct shim_lock loader_cache_lock;
+
+static void __free_elf_image(struct elf_image* img) {
+    assert(locked(&loader_cache_lock));
+    LISTP_DEL(img, &elf_image_cache, list);
+    elf_image_cache_cnt--;
+    free(img->uri);
+    free(img);
+}
+
+/* Copies the cached layout of FILE into LAYOUT if it was derived from exactly HDR. */
+static bool lookup_elf_layout(struct shim_handle* file, const void* hdr, int hdr_len,
+                              struct elf_layout* layout) {
+    if (qstrempty(&file->uri))
+        return false;
+
+    const char* uri = qstrgetstr(&file->uri);
+    bool found = false;
+
+    lock(&loader_cache_lock);
+    struct elf_image* img;
+    LISTP_FOR_EACH_ENTRY(img, &elf_image_cache, list) {
+        if (strcmp(img->uri, uri))
+            continue;
+
+        if (img->hdr_len != hdr_len || memcmp(img->hdr, hdr, hdr_len)) {
+            debug("loader cache: %s changed, invalidating\n", uri);
+            __free_elf_image(img);
+            break;
+        }
+
+        /* keep most recently used images at the head */
+        LISTP_DEL(img, &elf_image_cache, list);
+        LISTP_ADD(img, &elf_image_cache, list);
+        memcpy(layout, &img->layout, sizeof(*layout));
+        found = true;
+        break;
+    }
+    unlock(&loader_cache_lock);
+    return found;
+}
+
+static void cache_elf_layout(struct shim_handle* file, const void* hdr, int hdr_len,
+                             const struct elf_layout* layout) {
+    if (qstrempty(&file->uri))
+        return;
+
+    struct elf_image* img = malloc(sizeof(*img));
+    if (!img)
+        return;
+
+    img->uri = malloc_copy(qstrgetstr(&file->uri), file->uri.len + 1);
+    if (!img->uri) {
+        free(img);
+        return;
+    }
+
+    memcpy(&img->layout, layout, sizeof(*layout));
+    img->hdr_len = hdr_len;
+    memcpy(img->hdr, hdr, hdr_len);
+    INIT_LIST_HEAD(img, list);
+
+    lock(&loader_cache_lock);
+    struct elf_image* old;
+    struct elf_image* tmp;
+    LISTP_FOR_EACH_ENTRY_SAFE(old, tmp, &elf_image_cache, list) {
+        if (!strcmp(old->uri, img->uri))
+            __free_elf_image(old);
+    }
+
+    LISTP_ADD(img, &elf_image_cache, list);
+    elf_image_cache_cnt++;
+
+    if (elf_image_cache_cnt > MAX_CACHED_ELF_IMAGES)
+        __free_elf_image(LISTP_LAST_ENTRY(&elf_image_cache, struct elf_image, list));
+    unlock(&loader_cache_lock);
+}
+
 /* Cache the location of MAP's hash table.  */
 static void setup_elf_hash(struct link_map* map) {
     Elf_Symndx* hash;
@@ -332,9 +463,12 @@ static void setup_elf_hash(struct link_map* map) {
 /* TODO: This function needs a cleanup and to be split into smaller parts. It is impossible to do
  * a proper cleanup on any failure right now. */
 /* Map in the shared object NAME, actually located in REALNAME, and already
-   opened on FD */
+   opened on FD. If LAYOUT has load commands, they are used instead of scanning the program
+   headers; otherwise the scanned layout is stored into LAYOUT (if the program headers are in
+   FBP). */
 static struct link_map* __map_elf_object(struct shim_handle* file, const void* fbp, size_t fbp_len,
-                                         void* addr, int type, struct link_map* remap) {
+                                         void* addr, int type, struct link_map* remap,
+                                         struct elf_layout* layout) {
     ElfW(Phdr)* new_phdr = NULL;
 
     if (file && (!file->fs || !file->fs->fs_ops))
@@ -384,7 +518,22 @@ static struct link_map* __map_elf_object(struct shim_handle* file, const void* f
     if (type == OBJECT_REMAP)
         goto do_remap;
 
-    if (type == OBJECT_LOAD && header->e_phoff + maplength <= (size_t)fbp_len) {
+    bool has_holes = false;
+
+    if (layout && layout->nloadcmds) {
+        memcpy(l->loadcmds, layout->loadcmds, sizeof(l->loadcmds));
+        l->nloadcmds        = layout->nloadcmds;
+        has_holes           = layout->has_holes;
+        l->l_ld             = layout->ld;
+        l->l_ldnum          = layout->ldnum;
+        l->l_interp_libname = layout->interp_libname;
+        l->l_phdr           = layout->phdr;
+        l->l_relro_addr     = layout->relro_addr;
+        l->l_relro_size     = layout->relro_size;
+        goto scanned;
+    }
+
+    if (type == OBJECT_LOAD && header->e_phoff + maplength > (size_t)fbp_len) {
         new_phdr = (ElfW(Phdr)*)malloc(maplength);
         if (!new_phdr) {
             errstring = "new_phdr malloc failure";
@@ -398,8 +547,7 @@ static struct link_map* __map_elf_object(struct shim_handle* file, const void* f
         phdr = new_phdr;
     }
 
-    l->nloadcmds   = 0;
-    bool has_holes = false;
+    l->nloadcmds = 0;
 
     const ElfW(Phdr)* ph;
     for (ph = phdr; ph < &phdr[l->l_phnum]; ++ph) {
@@ -480,6 +628,19 @@ static struct link_map* __map_elf_object(struct shim_handle* file, const void* f
         goto call_lose;
     }
 
+    if (layout && phdr != new_phdr) {
+        memcpy(layout->loadcmds, l->loadcmds, sizeof(layout->loadcmds));
+        layout->nloadcmds      = l->nloadcmds;
+        layout->has_holes      = has_holes;
+        layout->ld             = l->l_ld;
+        layout->ldnum          = l->l_ldnum;
+        layout->interp_libname = l->l_interp_libname;
+        layout->phdr           = l->l_phdr;
+        layout->relro_addr     = l->l_relro_addr;
+        layout->relro_size     = l->l_relro_size;
+    }
+
+scanned:
     c = &l->loadcmds[0];
     /* Length of the sections to be loaded.  */
     maplength = l->loadcmds[l->nloadcmds - 1].allocend - c->mapstart;
@@ -955,13 +1116,21 @@ static int __load_elf_object(struct shim_handle* file, void* addr, int type,
             goto out;
     }
 
-    struct link_map* map = __map_elf_object(file, hdr, len, addr, type, remap);
+    /* only objects loaded from files can have a cached layout */
+    struct elf_layout layout = {0};
+    bool cached = type == OBJECT_LOAD && lookup_elf_layout(file, hdr, len, &layout);
+
+    struct link_map* map = __map_elf_object(file, hdr, len, addr, type, remap,
+                                            type == OBJECT_LOAD ? &layout : NULL);
 
     if (!map) {
         ret = -EINVAL;
         goto out;
     }
 
+    if (!cached && layout.nloadcmds)
+        cache_elf_layout(file, hdr, len, &layout);
+
     if (type != OBJECT_INTERNAL && type != OBJECT_VDSO)
         do_relocate_object(map);
 
@@ -1138,14 +1307,54 @@ static ElfW(Sym)* do_lookup_map(ElfW(Sym)* ref, const char* undef_name, const ui
    something bad happened.  */
 static ElfW(Sym)* __do_lookup(const char* undef_name, ElfW(Sym)* ref, struct link_map* map) {
     const uint_fast32_t fast_hash = elf_fast_hash(undef_name);
-    const long int hash           = elf_hash(undef_name);
+    /* the SysV hash is only needed for objects without a GNU hash table */
+    const long int hash = map->l_gnu_bitmask ? 0 : elf_hash(undef_name);
     return do_lookup_map(ref, undef_name, fast_hash, hash, map);
 }
 
+/* Look up UNDEF_NAME in LibOS, consulting the resolved-symbols cache first. */
+static ElfW(Sym)* __do_lookup_internal(const char* undef_name, ElfW(Sym)* ref) {
+    ElfW(Sym)* symtab  = (void*)D_PTR(internal_map->l_info[DT_SYMTAB]);
+    const char* strtab = (const void*)D_PTR(internal_map->l_info[DT_STRTAB]);
+    const uint32_t fast_hash = elf_fast_hash(undef_name);
+    size_t slot = fast_hash & (RESOLVED_SYMS_SIZE - 1);
+
+    lock(&loader_cache_lock);
+    for (size_t i = 0; i < RESOLVED_SYMS_SIZE; i++) {
+        struct resolved_sym* rs = &resolved_syms[(slot + i) & (RESOLVED_SYMS_SIZE - 1)];
+        if (rs->symidx == STN_UNDEF)
+            break;
+        if (rs->hash == fast_hash && !strcmp(strtab + symtab[rs->symidx].st_name, undef_name)) {
+            unlock(&loader_cache_lock);
+            return &symtab[rs->symidx];
+        }
+    }
+    unlock(&loader_cache_lock);
+
+    ElfW(Sym)* sym = __do_lookup(undef_name, ref, internal_map);
+    if (!sym)
+        return NULL;
+
+    lock(&loader_cache_lock);
+    for (size_t i = 0; i < RESOLVED_SYMS_SIZE; i++) {
+        struct resolved_sym* rs = &resolved_syms[(slot + i) & (RESOLVED_SYMS_SIZE - 1)];
+        if (rs->symidx == (uint32_t)(sym - symtab))
+            break;
+        if (rs->symidx == STN_UNDEF) {
+            rs->hash   = fast_hash;
+            rs->symidx = sym - symtab;
+            break;
+        }
+    }
+    unlock(&loader_cache_lock);
+
+    return sym;
+}
+
 static int do_lookup(const char* undef_name, ElfW(Sym)* ref, struct sym_val* result) {
     ElfW(Sym)* sym = NULL;
 
-    sym = __do_lookup(undef_name, ref, internal_map);
+    sym = __do_lookup_internal(undef_name, ref);
 
     if (!sym)
         return 0;
@@ -1442,6 +1651,9 @@ int vdso_map_migrate(void) {
 }
 
 int init_internal_map(void) {
+    if (!create_lock(&loader_cache_lock))
+        return -ENOMEM;
+
     __load_elf_object(NULL, &__load_address, OBJECT_INTERNAL, NULL);
     internal_map->l_name = "libsysdb.so";
     return 0;
@@ -1721,3 +1933,70 @@ BEGIN_RS_FUNC(loaded_libraries) {
     }
 }
 END_RS_FUNC(loaded_libraries)
+
+BEGIN_CP_FUNC(loader_cache) {
+    __UNUSED(obj);
+    __UNUSED(size);
+    __UNUSED(objp);
+
+    /* the images are chained through list.next */
+    size_t off = ADD_CP_OFFSET(sizeof(struct elf_image*));
+    struct elf_image** pnext = (struct elf_image**)(base + off);
+    *pnext = NULL;
+
+    lock(&loader_cache_lock);
+    struct elf_image* img;
+    LISTP_FOR_EACH_ENTRY(img, &elf_image_cache, list) {
+        struct elf_image* new_img =
+            (struct elf_image*)(base + ADD_CP_OFFSET(sizeof(struct elf_image)));
+        memcpy(new_img, img, sizeof(struct elf_image));
+        new_img->list.next = NULL;
+        new_img->list.prev = NULL;
+
+        size_t urilen = strlen(img->uri);
+        new_img->uri  = (char*)(base + ADD_CP_OFFSET(urilen + 1));
+        memcpy(new_img->uri, img->uri, urilen + 1);
+
+        *pnext = new_img;
+        pnext  = &new_img->list.next;
+    }
+    unlock(&loader_cache_lock);
+
+    ADD_CP_FUNC_ENTRY(off);
+}
+END_CP_FUNC(loader_cache)
+
+BEGIN_RS_FUNC(loader_cache) {
+    __UNUSED(offset);
+    struct elf_image** images = (void*)(base + GET_CP_FUNC_ENTRY());
+
+    CP_REBASE(*images);
+    struct elf_image* img = *images;
+    while (img) {
+        CP_REBASE(img->uri);
+        CP_REBASE(img->list.next);
+
+        /* checkpoint memory is never freed, so copy images out to allow their eviction */
+        struct elf_image* new_img = malloc(sizeof(*new_img));
+        if (!new_img)
+            return -ENOMEM;
+        memcpy(new_img, img, sizeof(*new_img));
+
+        new_img->uri = malloc_copy(img->uri, strlen(img->uri) + 1);
+        if (!new_img->uri) {
+            free(new_img);
+            return -ENOMEM;
+        }
+
+        INIT_LIST_HEAD(new_img, list);
+        lock(&loader_cache_lock);
+        LISTP_ADD_TAIL(new_img, &elf_image_cache, list);
+        elf_image_cache_cnt++;
+        unlock(&loader_cache_lock);
+
+        img = img->list.next;
+    }
+
+    DEBUG_RS("images=%d", elf_image_cache_cnt);
+}
+END_RS_FUNC(loader_cache)
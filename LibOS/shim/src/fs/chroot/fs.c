@@ -698,6 +698,100 @@ out:
     return ret;
 }
 
+static_assert(sizeof(PAL_IOVEC) == sizeof(struct iovec) &&
+              offsetof(PAL_IOVEC, buffer) == offsetof(struct iovec, iov_base) &&
+              offsetof(PAL_IOVEC, size) == offsetof(struct iovec, iov_len),
+              "PAL_IOVEC must have the layout of struct iovec");
+
+static ssize_t chroot_preadv(struct shim_handle* hdl, const struct iovec* iov, int iovcnt,
+                             off_t pos, int flags) {
+    ssize_t ret;
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & MAY_READ))
+        return -EBADF;
+
+    struct shim_file_handle* file = &hdl->info.file;
+
+    lock(&hdl->lock);
+
+    off_t offset = pos < 0 ? file->marker : pos;
+    PAL_NUM pal_ret = DkStreamReadV(hdl->pal_handle, offset, (PAL_IOVEC*)iov, iovcnt,
+                                    LINUX_RWF_TO_PAL(flags));
+    if (pal_ret != PAL_STREAM_ERROR) {
+        ret = pal_ret;
+        if (pos < 0 && file->type != FILE_TTY)
+            file->marker += pal_ret;
+    } else if (PAL_NATIVE_ERRNO() == PAL_ERROR_ENDOFSTREAM) {
+        ret = 0;
+    } else {
+        ret = PAL_NATIVE_ERRNO() == PAL_ERROR_NOTSUPPORT ? -EOPNOTSUPP : -PAL_ERRNO();
+    }
+
+    unlock(&hdl->lock);
+    return ret;
+}
+
+static ssize_t chroot_pwritev(struct shim_handle* hdl, const struct iovec* iov, int iovcnt,
+                              off_t pos, int flags) {
+    ssize_t ret;
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (!(hdl->acc_mode & MAY_WRITE))
+        return -EBADF;
+
+    struct shim_file_handle* file = &hdl->info.file;
+
+    lock(&hdl->lock);
+
+    off_t offset = pos < 0 ? file->marker : pos;
+    PAL_NUM pal_ret = DkStreamWriteV(hdl->pal_handle, offset, (PAL_IOVEC*)iov, iovcnt,
+                                     LINUX_RWF_TO_PAL(flags));
+    if (pal_ret != PAL_STREAM_ERROR) {
+        ret = pal_ret;
+        if (file->type != FILE_TTY) {
+            if (pos < 0)
+                file->marker += pal_ret;
+            if (offset + (off_t)pal_ret > file->size) {
+                file->size = offset + pal_ret;
+                chroot_update_size(hdl, file, FILE_HANDLE_DATA(hdl));
+            }
+        }
+    } else if (PAL_NATIVE_ERRNO() == PAL_ERROR_ENDOFSTREAM) {
+        ret = 0;
+    } else {
+        ret = PAL_NATIVE_ERRNO() == PAL_ERROR_NOTSUPPORT ? -EOPNOTSUPP : -PAL_ERRNO();
+    }
+
+    unlock(&hdl->lock);
+    return ret;
+}
+
+PAL_HANDLE chroot_direct_handle(struct shim_handle* hdl) {
+    assert(hdl->type == TYPE_FILE && hdl->fs && hdl->fs->fs_ops == &chroot_fs_ops);
+
+    if (NEED_RECREATE(hdl) && chroot_recreate(hdl) < 0)
+        return NULL;
+
+    if (hdl->info.file.type != FILE_REGULAR)
+        return NULL;
+
+    return hdl->pal_handle;
+}
+
+void chroot_direct_written(struct shim_handle* hdl, off_t end) {
+    struct shim_file_handle* file = &hdl->info.file;
+
+    lock(&hdl->lock);
+    if (end > file->size) {
+        file->size = end;
+        chroot_update_size(hdl, file, FILE_HANDLE_DATA(hdl));
+    }
+    unlock(&hdl->lock);
+}
+
 static int chroot_mmap (struct shim_handle * hdl, void ** addr, size_t size,
                         int prot, int flags, off_t offset)
 {
@@ -806,6 +900,62 @@ out:
     return ret;
 }
 
+static int chroot_fallocate(struct shim_handle* hdl, int mode, off_t offset, off_t len) {
+    int ret;
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    struct shim_file_handle* file = &hdl->info.file;
+    if (file->type != FILE_REGULAR)
+        return -ENODEV;
+
+    if (!DkStreamAllocate(hdl->pal_handle, LINUX_FALLOCATE_TO_PAL(mode), offset, len))
+        return PAL_NATIVE_ERRNO() == PAL_ERROR_NOTSUPPORT ? -EOPNOTSUPP : -PAL_ERRNO();
+
+    if (!(mode & FALLOC_FL_KEEP_SIZE)) {
+        lock(&hdl->lock);
+        if (offset + len > file->size) {
+            file->size = offset + len;
+            chroot_update_size(hdl, file, FILE_HANDLE_DATA(hdl));
+        }
+        unlock(&hdl->lock);
+    }
+    return 0;
+}
+
+static int chroot_fadvise(struct shim_handle* hdl, off_t offset, off_t len, int advice) {
+    int ret;
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (hdl->info.file.type != FILE_REGULAR)
+        return 0;
+
+    /* advice is only a hint, so hosts which cannot take it are not an error */
+    if (!DkStreamAdvise(hdl->pal_handle, offset, len, LINUX_FADVISE_TO_PAL(advice)) &&
+            PAL_NATIVE_ERRNO() != PAL_ERROR_NOTSUPPORT)
+        return -PAL_ERRNO();
+    return 0;
+}
+
+static int chroot_sync_range(struct shim_handle* hdl, off_t offset, off_t nbytes, int flags) {
+    int ret;
+    if (NEED_RECREATE(hdl) && (ret = chroot_recreate(hdl)) < 0)
+        return ret;
+
+    if (hdl->info.file.type != FILE_REGULAR || !flags)
+        return 0;
+
+    if (DkStreamFlushRange(hdl->pal_handle, offset, nbytes, LINUX_SYNC_FILE_RANGE_TO_PAL(flags)))
+        return 0;
+
+    if (PAL_NATIVE_ERRNO() != PAL_ERROR_NOTSUPPORT)
+        return -PAL_ERRNO();
+
+    /* the host cannot write back a range, the whole file is a superset of it */
+    return chroot_flush(hdl);
+}
+
 static int chroot_dput (struct shim_dentry * dent)
 {
     struct shim_file_data * data = FILE_DENTRY_DATA(dent);
@@ -1132,10 +1282,15 @@ struct shim_fs_ops chroot_fs_ops = {
         .close       = &chroot_close,
         .read        = &chroot_read,
         .write       = &chroot_write,
+        .preadv      = &chroot_preadv,
+        .pwritev     = &chroot_pwritev,
         .mmap        = &chroot_mmap,
         .seek        = &chroot_seek,
         .hstat       = &chroot_hstat,
         .truncate    = &chroot_truncate,
+        .fallocate   = &chroot_fallocate,
+        .fadvise     = &chroot_fadvise,
+        .sync_range  = &chroot_sync_range,
         .checkout    = &chroot_checkout,
         .checkpoint  = &chroot_checkpoint,
         .migrate     = &chroot_migrate,
@@ -4,7 +4,8 @@
 /*!
  * \file
  *
- * This file contains the implementation of `/proc/meminfo` and `/proc/cpuinfo`.
+ * This file contains the implementation of `/proc/meminfo`, `/proc/cpuinfo` and
+ * `/proc/syscall_profile`.
  */
 
 #include "shim_fs.h"
@@ -177,6 +178,32 @@ static int proc_cpuinfo_open(struct shim_handle* hdl, const char* name, int flag
     return 0;
 }
 
+static int proc_syscall_profile_open(struct shim_handle* hdl, const char* name, int flags) {
+    __UNUSED(name);
+    if (flags & (O_WRONLY | O_RDWR))
+        return -EACCES;
+
+    char* str;
+    size_t len;
+    int ret = format_syscall_profile(&str, &len);
+    if (ret < 0)
+        return ret;
+
+    struct shim_str_data* data = calloc(1, sizeof(struct shim_str_data));
+    if (!data) {
+        free(str);
+        return -ENOMEM;
+    }
+
+    data->str          = str;
+    data->len          = len;
+    hdl->type          = TYPE_STR;
+    hdl->flags         = flags & ~O_RDONLY;
+    hdl->acc_mode      = MAY_READ;
+    hdl->info.str.data = data;
+    return 0;
+}
+
 struct pseudo_fs_ops fs_meminfo = {
     .mode = &proc_info_mode,
     .stat = &proc_info_stat,
@@ -188,3 +215,9 @@ struct pseudo_fs_ops fs_cpuinfo = {
     .stat = &proc_info_stat,
     .open = &proc_cpuinfo_open,
 };
+
+struct pseudo_fs_ops fs_syscall_profile = {
+    .mode = &proc_info_mode,
+    .stat = &proc_info_stat,
+    .open = &proc_syscall_profile_open,
+};
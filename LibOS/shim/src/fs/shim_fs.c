@@ -49,6 +49,9 @@ struct shim_mount* builtin_fs[] = {
     &socket_builtin_fs,
     &epoll_builtin_fs,
     &eventfd_builtin_fs,
+    &timerfd_builtin_fs,
+    &mqueue_builtin_fs,
+    &signalfd_builtin_fs,
 };
 
 static struct shim_lock mount_mgr_lock;
@@ -4,6 +4,7 @@
 
 #include <shim_internal.h>
 #include <shim_tcb.h>
+#include <shim_thread.h>
 
 /* prototype needed due to -Wmissing-prototypes */
 void dummy(void);
@@ -12,6 +13,9 @@ void dummy(void)
 {
     OFFSET_T(SHIM_TCB_OFFSET, PAL_TCB, libos_tcb);
     OFFSET_T(TCB_REGS, shim_tcb_t, context.regs);
+    OFFSET_T(TCB_TP, shim_tcb_t, tp);
+    OFFSET(THREAD_PENDING_SIGNALS, shim_thread, pending_signals);
+    OFFSET(THREAD_TIME_TO_DIE, shim_thread, time_to_die);
     OFFSET(SHIM_REGS_RSP, shim_regs, rsp);
     OFFSET(SHIM_REGS_R15, shim_regs, r15);
     OFFSET(SHIM_REGS_RIP, shim_regs, rip);
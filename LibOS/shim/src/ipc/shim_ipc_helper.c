@@ -61,6 +61,7 @@ static ipc_callback ipc_callbacks[IPC_CODE_NUM] = {
     /* PID_RETMETA      */ &ipc_pid_retmeta_callback,
     /* PID_NOP          */ &ipc_pid_nop_callback,
     /* PID_SENDRPC      */ &ipc_pid_sendrpc_callback,
+    /* PID_MQNOTIFY     */ &ipc_pid_mqnotify_callback,
 
     /* sysv namespace */
     IPC_NS_CALLBACKS(sysv)
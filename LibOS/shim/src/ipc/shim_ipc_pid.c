@@ -702,3 +702,38 @@ out_unlock:
 out:
     return ret;
 }
+
+int ipc_pid_mqnotify_send(IDTYPE pid, IDTYPE sender, const char* name, int flags) {
+    int ret = 0;
+    IDTYPE dest;
+    struct shim_ipc_port* port = NULL;
+
+    if ((ret = get_pid_port(pid, &dest, &port)) < 0)
+        return ret;
+
+    size_t len = strlen(name) + 1;
+    size_t total_msg_size    = get_ipc_msg_size(sizeof(struct shim_ipc_pid_mqnotify) + len);
+    struct shim_ipc_msg* msg = __alloca(total_msg_size);
+    init_ipc_msg(msg, IPC_PID_MQNOTIFY, total_msg_size, dest);
+    struct shim_ipc_pid_mqnotify* msgin = (struct shim_ipc_pid_mqnotify*)&msg->msg;
+
+    debug("ipc send to %u: IPC_PID_MQNOTIFY(%u, %s, %d)\n", dest, sender, name, flags);
+    msgin->sender = sender;
+    msgin->flags  = flags;
+    memcpy(msgin->name, name, len);
+
+    ret = send_ipc_message(msg, port);
+    put_ipc_port(port);
+    return ret;
+}
+
+int ipc_pid_mqnotify_callback(IPC_CALLBACK_ARGS) {
+    __UNUSED(port);
+    struct shim_ipc_pid_mqnotify* msgin = (struct shim_ipc_pid_mqnotify*)msg->msg;
+
+    debug("ipc callback from %u: IPC_PID_MQNOTIFY(%u, %s, %d)\n", msg->src, msgin->sender,
+          msgin->name, msgin->flags);
+
+    mqueue_notified(msgin->sender, msgin->name, msgin->flags);
+    return 0;
+}
@@ -41,6 +41,10 @@ int init_ns_sysv(void) {
     return init_namespace();
 }
 
+int get_sysv_leader(IDTYPE* vmid) {
+    return connect_ns(vmid, NULL);
+}
+
 int ipc_sysv_delres_send(struct shim_ipc_port* port, IDTYPE dest, IDTYPE resid,
                          enum sysv_type type) {
     int ret    = 0;
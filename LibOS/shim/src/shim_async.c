@@ -4,7 +4,8 @@
 /*
  * shim_async.c
  *
- * This file contains functions to add asyncronous events triggered by timer.
+ * This file contains functions to add asyncronous events triggered by timers or by IO on host
+ * handles. All of them are serviced by a single async helper thread.
  */
 
 #include <list.h>
@@ -16,6 +17,8 @@
 #define IDLE_SLEEP_TIME 1000000
 #define MAX_IDLE_CYCLES 10000
 
+#define TIMER_HEAP_INIT_SIZE 64
+
 DEFINE_LIST(async_event);
 struct async_event {
     IDTYPE caller;  /* thread installing this event */
@@ -23,11 +26,20 @@ struct async_event {
     void (*callback)(IDTYPE caller, void* arg);
     void* arg;
     PAL_HANDLE object;     /* handle (async IO) to wait on */
-    uint64_t expire_time;  /* alarm/timer to wait on */
 };
 DEFINE_LISTP(async_event);
 static LISTP_TYPE(async_event) async_list;
 
+/* Armed timers, kept in a binary min-heap ordered by expiration time. Arming, re-arming and
+ * cancelling a timer are O(log n), and the async helper only looks at the top of the heap to find
+ * the next timeout, so thousands of timers (e.g. timerfds of an event loop) are cheap. */
+static struct async_timer** timer_heap;
+static size_t timer_heap_cnt;
+static size_t timer_heap_size;
+
+/* timer whose callback is currently executed by the async helper thread */
+static struct async_timer* running_timer;
+
 /* Should be accessed with async_helper_lock held. */
 static enum { HELPER_NOTALIVE, HELPER_ALIVE } async_helper_state;
 
@@ -38,87 +50,280 @@ static AEVENTTYPE install_new_event;
 
 static int create_async_helper(void);
 
-/* Threads register async events like alarm(), setitimer(), ioctl(FIOASYNC)
- * using this function. These events are enqueued in async_list and delivered
- * to Async Helper thread by triggering install_new_event. When event is
- * triggered in Async Helper thread, the corresponding event's callback with
- * arguments `arg` is called. This callback typically sends a signal to the
- * thread which registered the event (saved in `event->caller`).
+/* Threads register async IO events like ioctl(FIOASYNC) and cleanup events of exited threads
+ * using this function. These events are enqueued in async_list and delivered to Async Helper
+ * thread by triggering install_new_event. When event is triggered in Async Helper thread, the
+ * corresponding event's callback with arguments `arg` is called. This callback typically sends a
+ * signal to the thread which registered the event (saved in `event->caller`).
  *
- * We distinguish between alarm/timer events and async IO events:
- *   - alarm/timer events set object = NULL and time = seconds
- *     (time = 0 cancels all pending alarms/timers).
- *   - async IO events set object = handle and time = 0.
+ *   - async IO events set object = handle.
+ *   - cleanup events (callback = cleanup_thread) set object = NULL and are triggered immediately.
  *
- * Function returns remaining usecs for alarm/timer events (same as alarm())
- * or 0 for async IO events. On error, it returns a negated error code.
+ * Timers (alarm(), setitimer(), timerfd and POSIX timers) use set_async_timer() instead.
  */
-int64_t install_async_event(PAL_HANDLE object, uint64_t time,
-                            void (*callback)(IDTYPE caller, void* arg), void* arg) {
-    /* if event happens on object, time must be zero */
-    assert(!object || (object && !time));
-
-    uint64_t now = DkSystemTimeQuery();
-    if ((int64_t)now < 0) {
-        return (int64_t)now;
-    }
-
-    uint64_t max_prev_expire_time = now;
-
+int install_async_event(PAL_HANDLE object, void (*callback)(IDTYPE caller, void* arg),
+                        void* arg) {
     struct async_event* event = malloc(sizeof(struct async_event));
     if (!event) {
         return -ENOMEM;
     }
 
-    event->callback           = callback;
-    event->arg                = arg;
-    event->caller             = get_cur_tid();
-    event->object             = object;
-    event->expire_time        = time ? now + time : 0;
+    event->callback = callback;
+    event->arg      = arg;
+    event->caller   = get_cur_tid();
+    event->object   = object;
 
     lock(&async_helper_lock);
 
-    if (callback != &cleanup_thread && !object) {
-        /* This is alarm() or setitimer() emulation, treat both according to
-         * alarm() syscall semantics: cancel any pending alarm/timer. */
-        struct async_event* tmp;
-        struct async_event* n;
-        LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
-            if (tmp->expire_time) {
-                /* this is a pending alarm/timer, cancel it and save its expiration time */
-                if (max_prev_expire_time < tmp->expire_time)
-                    max_prev_expire_time = tmp->expire_time;
-
-                LISTP_DEL(tmp, &async_list, list);
-                free(tmp);
-            }
-        }
-
-        if (!time) {
-            /* This is alarm(0), we cancelled all pending alarms/timers
-             * and user doesn't want to set a new alarm: we are done. */
-            free(event);
-            unlock(&async_helper_lock);
-            return max_prev_expire_time - now;
-        }
-    }
-
     INIT_LIST_HEAD(event, list);
     LISTP_ADD_TAIL(event, &async_list, list);
 
     if (async_helper_state == HELPER_NOTALIVE) {
         int ret = create_async_helper();
         if (ret < 0) {
+            LISTP_DEL(event, &async_list, list);
             unlock(&async_helper_lock);
+            free(event);
             return ret;
         }
     }
 
     unlock(&async_helper_lock);
 
-    debug("Installed async event at %lu\n", now);
+    debug("Installed async event\n");
     set_event(&install_new_event, 1);
-    return max_prev_expire_time - now;
+    return 0;
+}
+
+static void timer_heap_set(size_t idx, struct async_timer* timer) {
+    timer_heap[idx] = timer;
+    timer->heap_idx = idx;
+}
+
+static void timer_heap_sift_up(size_t idx) {
+    struct async_timer* timer = timer_heap[idx];
+    while (idx) {
+        size_t parent = (idx - 1) / 2;
+        if (timer_heap[parent]->expire_time <= timer->expire_time)
+            break;
+        timer_heap_set(idx, timer_heap[parent]);
+        idx = parent;
+    }
+    timer_heap_set(idx, timer);
+}
+
+static void timer_heap_sift_down(size_t idx) {
+    struct async_timer* timer = timer_heap[idx];
+    while (true) {
+        size_t child = idx * 2 + 1;
+        if (child >= timer_heap_cnt)
+            break;
+        if (child + 1 < timer_heap_cnt &&
+                timer_heap[child + 1]->expire_time < timer_heap[child]->expire_time)
+            child++;
+        if (timer->expire_time <= timer_heap[child]->expire_time)
+            break;
+        timer_heap_set(idx, timer_heap[child]);
+        idx = child;
+    }
+    timer_heap_set(idx, timer);
+}
+
+static int timer_heap_insert(struct async_timer* timer) {
+    assert(locked(&async_helper_lock));
+
+    if (timer_heap_cnt == timer_heap_size) {
+        size_t new_size = timer_heap_size ? timer_heap_size * 2 : TIMER_HEAP_INIT_SIZE;
+        struct async_timer** new_heap = malloc(sizeof(*new_heap) * new_size);
+        if (!new_heap)
+            return -ENOMEM;
+        if (timer_heap) {
+            memcpy(new_heap, timer_heap, sizeof(*new_heap) * timer_heap_cnt);
+            free(timer_heap);
+        }
+        timer_heap      = new_heap;
+        timer_heap_size = new_size;
+    }
+
+    timer_heap_set(timer_heap_cnt++, timer);
+    timer_heap_sift_up(timer->heap_idx);
+    return 0;
+}
+
+static void timer_heap_remove(struct async_timer* timer) {
+    assert(locked(&async_helper_lock));
+    assert(timer->heap_idx < timer_heap_cnt && timer_heap[timer->heap_idx] == timer);
+
+    size_t idx = timer->heap_idx;
+    struct async_timer* last = timer_heap[--timer_heap_cnt];
+    if (last == timer)
+        return;
+
+    timer_heap_set(idx, last);
+    if (idx && timer_heap[(idx - 1) / 2]->expire_time > last->expire_time) {
+        timer_heap_sift_up(idx);
+    } else {
+        timer_heap_sift_down(idx);
+    }
+}
+
+/* Arms `timer` to expire at absolute time `expire_time` (in usecs) and then every `interval`
+ * usecs (if non-zero). An already armed timer is re-armed; `expire_time` = 0 disarms it. On
+ * expiration, the async helper thread calls `timer->callback` with the number of expirations since
+ * the last call (more than one if the helper could not keep up with a periodic timer). */
+int set_async_timer(struct async_timer* timer, uint64_t expire_time, uint64_t interval) {
+    bool wake_helper = false;
+    int ret = 0;
+
+    lock(&async_helper_lock);
+
+    if (timer->expire_time) {
+        timer_heap_remove(timer);
+        timer->expire_time = 0;
+    }
+
+    if (!expire_time)
+        goto out;
+
+    timer->expire_time = expire_time;
+    timer->interval    = interval;
+    ret = timer_heap_insert(timer);
+    if (ret < 0) {
+        timer->expire_time = 0;
+        goto out;
+    }
+
+    if (async_helper_state == HELPER_NOTALIVE) {
+        ret = create_async_helper();
+        if (ret < 0) {
+            timer_heap_remove(timer);
+            timer->expire_time = 0;
+            goto out;
+        }
+    }
+
+    /* the helper sleeps until the earliest expiration; wake it up if this timer is now first */
+    wake_helper = timer->heap_idx == 0;
+out:
+    unlock(&async_helper_lock);
+
+    if (wake_helper)
+        set_event(&install_new_event, 1);
+    return ret;
+}
+
+/* Returns usecs left until the next expiration of `timer` (0 if it is disarmed) and its period. */
+uint64_t get_async_timer(struct async_timer* timer, uint64_t* interval) {
+    uint64_t now = DkSystemTimeQuery();
+    uint64_t left = 0;
+
+    lock(&async_helper_lock);
+    if (timer->expire_time) {
+        /* an expired timer which the helper did not get to yet is reported as about to expire */
+        left = timer->expire_time > now ? timer->expire_time - now : 1;
+    }
+    if (interval)
+        *interval = timer->expire_time ? timer->interval : 0;
+    unlock(&async_helper_lock);
+
+    return left;
+}
+
+/* Disarms `timer` and waits until the async helper thread finishes running its callback, so that
+ * the caller may free the timer afterwards. */
+void cancel_async_timer(struct async_timer* timer) {
+    lock(&async_helper_lock);
+
+    if (timer->expire_time) {
+        timer_heap_remove(timer);
+        timer->expire_time = 0;
+    }
+
+    while (running_timer == timer && get_cur_thread() != async_helper_thread) {
+        unlock(&async_helper_lock);
+        DkThreadYieldExecution();
+        lock(&async_helper_lock);
+    }
+
+    unlock(&async_helper_lock);
+}
+
+static int timespec_to_usec(const struct __kernel_timespec* ts, uint64_t* usec) {
+    if (ts->tv_sec < 0 || ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000)
+        return -EINVAL;
+    /* round up so that a non-zero value never becomes a disarmed timer */
+    *usec = ts->tv_sec * 1000000ULL + (ts->tv_nsec + 999) / 1000;
+    return 0;
+}
+
+/* Converts a user-supplied itimerspec (as in timerfd_settime() and timer_settime()) into the
+ * absolute expiration time and the interval for set_async_timer(). */
+int itimerspec_to_async_timer(const struct __kernel_itimerspec* spec, bool abstime,
+                              uint64_t* expire_time, uint64_t* interval) {
+    uint64_t value;
+    int ret = timespec_to_usec(&spec->it_value, &value);
+    if (ret < 0)
+        return ret;
+    ret = timespec_to_usec(&spec->it_interval, interval);
+    if (ret < 0)
+        return ret;
+
+    if (!value) {
+        *expire_time = 0;
+        return 0;
+    }
+
+    if (abstime) {
+        /* all clocks are the same (see shim_time.c), so absolute times use DkSystemTimeQuery() */
+        *expire_time = value;
+        return 0;
+    }
+
+    uint64_t now = DkSystemTimeQuery();
+    if ((int64_t)now < 0)
+        return -PAL_ERRNO();
+    *expire_time = now + value;
+    return 0;
+}
+
+void async_timer_to_itimerspec(struct async_timer* timer, struct __kernel_itimerspec* spec) {
+    uint64_t interval;
+    uint64_t left = get_async_timer(timer, &interval);
+
+    spec->it_value.tv_sec     = left / 1000000;
+    spec->it_value.tv_nsec    = (left % 1000000) * 1000;
+    spec->it_interval.tv_sec  = interval / 1000000;
+    spec->it_interval.tv_nsec = (interval % 1000000) * 1000;
+}
+
+/* Called by the async helper thread to run callbacks of all timers that expired by `now`. */
+static void fire_expired_timers(uint64_t now) {
+    lock(&async_helper_lock);
+
+    while (timer_heap_cnt && timer_heap[0]->expire_time <= now) {
+        struct async_timer* timer = timer_heap[0];
+        uint64_t expirations = 1;
+
+        if (timer->interval) {
+            /* periodic timer: skip all periods which already passed and keep it in the heap */
+            expirations += (now - timer->expire_time) / timer->interval;
+            timer->expire_time += expirations * timer->interval;
+            timer_heap_sift_down(0);
+        } else {
+            timer_heap_remove(timer);
+            timer->expire_time = 0;
+        }
+
+        debug("Timer triggered at %lu (%lu expirations)\n", now, expirations);
+
+        running_timer = timer;
+        unlock(&async_helper_lock);
+        timer->callback(timer, expirations);
+        lock(&async_helper_lock);
+        running_timer = NULL;
+    }
+
+    unlock(&async_helper_lock);
 }
 
 int init_async(void) {
@@ -200,14 +405,13 @@ static void shim_async_helper(void* arg) {
             break;
         }
 
-        uint64_t next_expire_time = 0;
-        size_t pals_cnt            = 0;
+        size_t pals_cnt = 0;
 
         struct async_event* tmp;
         struct async_event* n;
         bool other_event = false;
         LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
-            /* repopulate `pals` with IO events and find the next expiring alarm/timer */
+            /* repopulate `pals` with IO events */
             if (tmp->object) {
                 if (pals_cnt == pals_max_cnt) {
                     /* grow `pals` to accommodate more objects */
@@ -241,26 +445,24 @@ static void shim_async_helper(void* arg) {
                 pal_events[pals_cnt + 1] = PAL_WAIT_READ;
                 ret_events[pals_cnt + 1] = 0;
                 pals_cnt++;
-            } else if (tmp->expire_time && tmp->expire_time > now) {
-                if (!next_expire_time || next_expire_time > tmp->expire_time) {
-                    /* use time of the next expiring alarm/timer */
-                    next_expire_time = tmp->expire_time;
-                }
             } else {
-                /* cleanup events do not have an object nor a timeout */
+                /* cleanup events do not have an object */
                 other_event = true;
             }
         }
 
+        /* the earliest expiring timer is on top of the heap */
+        uint64_t next_expire_time = timer_heap_cnt ? timer_heap[0]->expire_time : 0;
+
         uint64_t sleep_time;
         if (next_expire_time) {
-            sleep_time  = next_expire_time - now;
+            sleep_time  = next_expire_time > now ? next_expire_time - now : 0;
             idle_cycles = 0;
         } else if (pals_cnt || other_event) {
             sleep_time = NO_TIMEOUT;
             idle_cycles = 0;
         } else {
-            /* no async IO events and no timers/alarms: thread is idling */
+            /* no async IO events and no timers: thread is idling */
             sleep_time = IDLE_SLEEP_TIME;
             idle_cycles++;
         }
@@ -274,7 +476,7 @@ static void shim_async_helper(void* arg) {
         }
         unlock(&async_helper_lock);
 
-        /* wait on async IO events + install_new_event + next expiring alarm/timer */
+        /* wait on async IO events + install_new_event + next expiring timer */
         PAL_BOL polled = DkStreamsWaitEvents(pals_cnt + 1, pals, pal_events, ret_events, sleep_time);
 
         now = DkSystemTimeQuery();
@@ -309,16 +511,12 @@ static void shim_async_helper(void* arg) {
             }
         }
 
-        /* check if exit-child or alarm/timer events were triggered */
+        /* check if exit-child events were triggered */
         LISTP_FOR_EACH_ENTRY_SAFE(tmp, n, &async_list, list) {
             if (tmp->callback == &cleanup_thread) {
                 debug("Thread exited, cleaning up\n");
                 LISTP_DEL(tmp, &async_list, list);
                 LISTP_ADD_TAIL(tmp, &triggered, list);
-            } else if (tmp->expire_time && tmp->expire_time <= now) {
-                debug("Alarm/timer triggered at %lu (expired at %lu)\n", now, tmp->expire_time);
-                LISTP_DEL(tmp, &async_list, list);
-                LISTP_ADD_TAIL(tmp, &triggered, list);
             }
         }
 
@@ -330,11 +528,13 @@ static void shim_async_helper(void* arg) {
                 LISTP_DEL(tmp, &triggered, list);
                 tmp->callback(tmp->caller, tmp->arg);
                 if (!tmp->object) {
-                    /* this is a one-off exit-child or alarm/timer event */
+                    /* this is a one-off exit-child event */
                     free(tmp);
                 }
             }
         }
+
+        fire_expired_timers(now);
     }
 
     __disable_preempt(self->shim_tcb);
@@ -129,12 +129,13 @@ struct shim_cp_map_entry* get_cp_map_entry(void* _map, void* addr, bool create)
 BEGIN_CP_FUNC(memory) {
     struct shim_mem_entry* entry = (void*)(base + ADD_CP_OFFSET(sizeof(*entry)));
 
-    entry->addr  = obj;
-    entry->size  = size;
-    entry->paddr = NULL;
-    entry->prot  = PAL_PROT_READ | PAL_PROT_WRITE;
-    entry->data  = NULL;
-    entry->prev  = store->last_mem_entry;
+    entry->addr       = obj;
+    entry->size       = size;
+    entry->paddr      = NULL;
+    entry->prot       = PAL_PROT_READ | PAL_PROT_WRITE;
+    entry->alloc_type = 0;
+    entry->data       = NULL;
+    entry->prev       = store->last_mem_entry;
 
     store->last_mem_entry = entry;
     store->mem_entries_cnt++;
@@ -393,34 +394,65 @@ static int send_handles_on_stream(PAL_HANDLE stream, struct shim_cp_store* store
     if (!entries_cnt)
         return 0;
 
-    struct shim_palhdl_entry** entries = malloc(sizeof(*entries) * entries_cnt);
-    if (!entries)
+    PAL_HANDLE* handles = malloc(sizeof(*handles) * entries_cnt);
+    if (!handles)
         return -ENOMEM;
 
-    /* PAL-handle entries were added in reverse order, let's first populate them */
+    /* PAL-handle entries were added in reverse order, let's collect their handles in correct
+     * order at the end of the array (the child skips entries without a handle in the same way) */
+    size_t first = entries_cnt;
     struct shim_palhdl_entry* entry = store->last_palhdl_entry;
     for (size_t i = entries_cnt; i > 0; i--) {
         assert(entry);
-        entries[i - 1] = entry;
+        if (entry->handle)
+            handles[--first] = entry->handle;
         entry = entry->prev;
     }
     assert(!entry);
 
-    /* now we can traverse PAL-handle entries in correct order and send them one by one */
-    for (size_t i = 0; i < entries_cnt; i++) {
-        /* we need to abort migration if DkSendHandle() returned error, otherwise app may fail */
-        if (!DkSendHandle(stream, entries[i]->handle)) {
-            ret = -EINVAL;
-            goto out;
-        }
+    /* send all handles at once, so that their FDs are transferred in as few messages as possible;
+     * we need to abort migration if DkSendHandles() returned error, otherwise app may fail */
+    if (!DkSendHandles(stream, handles + first, entries_cnt - first)) {
+        ret = -EINVAL;
+        goto out;
     }
 
     ret = 0;
 out:
-    free(entries);
+    free(handles);
     return ret;
 }
 
+static bool is_zero_page(const void* page) {
+    const unsigned long* p = page;
+    for (size_t i = 0; i < g_pal_alloc_align / sizeof(*p); i++)
+        if (p[i])
+            return false;
+    return true;
+}
+
+/* Copies a migrated memory entry to freshly allocated (zero-filled) memory. Pages which are all
+ * zeros in the checkpoint (e.g. discarded with MADV_DONTNEED in the parent) are not touched, so
+ * they do not become resident in the child. */
+static void restore_memory(void* addr, const void* data, size_t size) {
+    char* dst = addr;
+    const char* src = data;
+    char* end = dst + size;
+
+    while (dst < end) {
+        char* next = ALLOC_ALIGN_DOWN_PTR(dst) + g_pal_alloc_align;
+        if (next > end)
+            next = end;
+
+        if (dst != ALLOC_ALIGN_DOWN_PTR(dst) || next != dst + g_pal_alloc_align
+                || !is_zero_page(src))
+            memcpy(dst, src, next - dst);
+
+        src += next - dst;
+        dst = next;
+    }
+}
+
 static int restore_checkpoint(struct checkpoint_hdr* hdr, uintptr_t base) {
     size_t cpoffset = hdr->offset;
     size_t* offset  = &cpoffset;
@@ -447,13 +479,23 @@ static int restore_checkpoint(struct checkpoint_hdr* hdr, uintptr_t base) {
             PAL_NUM size = ALLOC_ALIGN_UP_PTR(entry->addr + entry->size) - (void*)addr;
             PAL_FLG prot = entry->prot;
 
-            if (!DkVirtualMemoryAlloc(addr, size, 0, prot | PAL_PROT_WRITE)) {
+            PAL_PTR mem = DkVirtualMemoryAlloc(addr, size, entry->alloc_type,
+                                               prot | PAL_PROT_WRITE);
+            if (!mem && (entry->alloc_type & PAL_ALLOC_HUGEPAGE)) {
+                /* the host may have no free huge pages left; the contents matter more */
+                debug("no huge pages for %p-%p, falling back to normal pages\n", addr,
+                      addr + size);
+                mem = DkVirtualMemoryAlloc(addr, size, entry->alloc_type &
+                                           ~(PAL_ALLOC_HUGEPAGE | PAL_ALLOC_HUGEPAGE_1G),
+                                           prot | PAL_PROT_WRITE);
+            }
+            if (!mem) {
                 debug("failed allocating %p-%p\n", addr, addr + size);
                 return -PAL_ERRNO();
             }
 
             CP_REBASE(entry->data);
-            memcpy(entry->addr, entry->data, entry->size);
+            restore_memory(entry->addr, entry->data, entry->size);
 
             if (!(entry->prot & PAL_PROT_WRITE) && !DkVirtualMemoryProtect(addr, size, prot)) {
                 debug("failed protecting %p-%p (ignored)\n", addr, addr + size);
@@ -494,7 +536,10 @@ static int receive_handles_on_stream(struct checkpoint_hdr* hdr, void* base, ssi
 
     debug("receiving %lu PAL handles\n", entries_cnt);
 
+    PAL_HANDLE* handles = NULL;
     struct shim_palhdl_entry** entries = malloc(sizeof(*entries) * entries_cnt);
+    if (!entries)
+        return -ENOMEM;
 
     /* entries are extracted from checkpoint in reverse order, let's first populate them */
     struct shim_palhdl_entry* entry = palhdl_entries;
@@ -507,23 +552,34 @@ static int receive_handles_on_stream(struct checkpoint_hdr* hdr, void* base, ssi
     }
     assert(!entry);
 
-    /* now we can traverse PAL-handle entries in correct order and receive them one by one */
-    for (size_t i = 0; i < entries_cnt; i++) {
-        entry = entries[i];
-        if (!entry->handle)
-            continue;
+    /* now we can receive PAL handles for the entries which had one in the parent, in the order
+     * in which the parent sent them */
+    size_t handles_cnt = 0;
+    for (size_t i = 0; i < entries_cnt; i++)
+        if (entries[i]->handle)
+            entries[handles_cnt++] = entries[i];
 
-        PAL_HANDLE hdl = DkReceiveHandle(PAL_CB(parent_process));
-        /* need to abort migration if DkReceiveHandle() returned error, otherwise app may fail */
-        if (!hdl) {
-            ret = -EINVAL;
-            goto out;
-        }
-        *entry->phandle = hdl;
+    handles = malloc(sizeof(*handles) * (handles_cnt ?: 1));
+    if (!handles) {
+        ret = -ENOMEM;
+        goto out;
+    }
+
+    /* need to abort migration if DkReceiveHandles() returned error, otherwise app may fail */
+    if (!DkReceiveHandles(PAL_CB(parent_process), handles, handles_cnt)) {
+        for (size_t i = 0; i < handles_cnt; i++)
+            if (handles[i])
+                DkObjectClose(handles[i]);
+        ret = -EINVAL;
+        goto out;
     }
 
+    for (size_t i = 0; i < handles_cnt; i++)
+        *entries[i]->phandle = handles[i];
+
     ret = 0;
 out:
+    free(handles);
     free(entries);
     return ret;
 }
@@ -576,7 +632,7 @@ static void* cp_alloc(void* addr, size_t size) {
 }
 
 int create_process_and_send_checkpoint(migrate_func_t migrate_func, struct shim_handle* exec,
-                                       struct shim_thread* thread, ...) {
+                                       bool replace, struct shim_thread* thread, ...) {
     int ret = 0;
     struct shim_process* process = NULL;
 
@@ -591,7 +647,7 @@ int create_process_and_send_checkpoint(migrate_func_t migrate_func, struct shim_
     }
 
     /* create LibOS process object and IPC bookkeepings */
-    process = create_process(exec ? /*execve*/ true : /*fork*/ false);
+    process = create_process(/*dup_cur_process=*/replace);
     if (!process) {
         ret = -EACCES;
         goto out;
@@ -706,7 +762,7 @@ int create_process_and_send_checkpoint(migrate_func_t migrate_func, struct shim_
         goto out;
     }
 
-    if (exec) {
+    if (replace) {
         /* execve case: child process "replaces" this current process: no need to notify the leader
          * or establish IPC, so do nothing here */
     } else {
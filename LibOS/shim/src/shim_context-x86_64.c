@@ -12,6 +12,10 @@
 #include "shim_internal.h"
 
 void restore_context(struct shim_context* context) {
+    restore_context_with_retval(context, 0);
+}
+
+void restore_context_with_retval(struct shim_context* context, long retval) {
     assert(context->regs);
     struct shim_regs regs = *context->regs;
     debug("restore context: SP = 0x%08lx, IP = 0x%08lx\n", regs.rsp, regs.rip);
@@ -19,6 +23,7 @@ void restore_context(struct shim_context* context) {
     /* don't clobber redzone. If sigaltstack is used,
      * this area won't be clobbered by signal context */
     *(unsigned long*)(regs.rsp - RED_ZONE_SIZE - 8) = regs.rip;
+    *(long*)(regs.rsp - RED_ZONE_SIZE - 16) = retval;
 
     /* Ready to resume execution, re-enable preemption. */
     shim_tcb_t* tcb = shim_get_tcb();
@@ -46,7 +51,7 @@ void restore_context(struct shim_context* context) {
                      "popq %%rbp\r\n"
                      "popfq\r\n"
                      "movq "XSTRINGIFY(SHIM_REGS_RSP)" - "XSTRINGIFY(SHIM_REGS_RIP)"(%%rsp), %%rsp\r\n"
-                     "movq $0, %%rax\r\n"
+                     "movq -"XSTRINGIFY(RED_ZONE_SIZE)"-16(%%rsp), %%rax\r\n"
                      "jmp *-"XSTRINGIFY(RED_ZONE_SIZE)"-8(%%rsp)\r\n"
                      :: "g"(&regs) : "memory");
 }
@@ -69,3 +74,16 @@ void fixup_child_context(struct shim_regs* regs) {
         regs->rip = regs->rcx;
     }
 }
+
+/*
+ * Same as fixup_child_context(), but for a context which resumes on its own stack after the frame
+ * of syscall_wrapper was clobbered (by a vfork child running on the same stack).
+ */
+void fixup_resumed_context(struct shim_regs* regs) {
+    if (regs->rip == (unsigned long)&syscall_wrapper_after_syscalldb) {
+        /* syscall_wrapper moved %rsp below the red zone before calling syscalldb */
+        regs->rsp += RED_ZONE_SIZE;
+        regs->rflags = regs->r11;
+        regs->rip = regs->rcx;
+    }
+}
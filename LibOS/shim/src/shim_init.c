@@ -93,6 +93,7 @@ static int pal_errno_to_unix_errno [PAL_ERROR_NATIVE_COUNT + 1] = {
         /* PAL_ERROR_ADDRNOTEXIST    */  EADDRNOTAVAIL,
         /* PAL_ERROR_AFNOSUPPORT     */  EAFNOSUPPORT,
         /* PAL_ERROR_CONNFAILED_PIPE */  EPIPE,
+        /* PAL_ERROR_NOSPACE         */  ENOSPC,
     };
 
 long convert_pal_errno (long err)
@@ -487,6 +488,53 @@ fail:
     return ret;
 }
 
+/* The manifest is migrated to child processes in its binary form, which the child uses in place
+ * (the checkpoint memory is never unmapped), instead of re-reading and re-parsing the text. */
+BEGIN_CP_FUNC(manifest) {
+    __UNUSED(obj);
+    __UNUSED(size);
+    __UNUSED(objp);
+
+    if (!root_config)
+        return 0;
+
+    ssize_t cfg_size = write_config_binary(root_config, NULL, 0);
+    if (cfg_size < 0)
+        return -EINVAL;
+
+    size_t off = ADD_CP_OFFSET(sizeof(size_t) + cfg_size);
+    *(size_t*)(base + off) = cfg_size;
+    cfg_size = write_config_binary(root_config, (void*)(base + off + sizeof(size_t)), cfg_size);
+    if (cfg_size < 0)
+        return -EINVAL;
+
+    ADD_CP_FUNC_ENTRY(off);
+}
+END_CP_FUNC(manifest)
+
+BEGIN_RS_FUNC(manifest) {
+    __UNUSED(offset);
+    __UNUSED(rebase);
+    size_t* cfg_size = (void*)(base + GET_CP_FUNC_ENTRY());
+
+    struct config_store* new_root_config = malloc(sizeof(struct config_store));
+    if (!new_root_config)
+        return -ENOMEM;
+
+    new_root_config->malloc = __malloc;
+    new_root_config->free = __free;
+
+    int ret = read_config_binary(new_root_config, cfg_size + 1, *cfg_size);
+    if (ret < 0) {
+        free(new_root_config);
+        return -EINVAL;
+    }
+
+    root_config = new_root_config;
+    DEBUG_RS("entries=%lu", new_root_config->hash_cnt);
+}
+END_RS_FUNC(manifest)
+
 #define CALL_INIT(func, args ...)   func(args)
 
 #define RUN_INIT(func, ...)                                             \
@@ -504,6 +552,10 @@ noreturn void* shim_init(int argc, void* args) {
     debug_handle = PAL_CB(debug_stream);
     cur_process.vmid = (IDTYPE) PAL_CB(process_id);
 
+    /* the fast syscall path does not trace syscalls, so route everything through shim_table */
+    if (debug_handle)
+        memset(shim_fast_table, 0, sizeof(shim_fp) * LIBOS_SYSCALL_BOUND);
+
     /* create the initial TCB, shim can not be run without a tcb */
     shim_tcb_init();
     update_fs_base(0);
@@ -554,12 +606,18 @@ noreturn void* shim_init(int argc, void* args) {
         RUN_INIT(receive_checkpoint_and_restore, &hdr);
     }
 
-    if (PAL_CB(manifest_handle))
+    /* the manifest may already have been migrated from the parent process */
+    if (PAL_CB(manifest_handle) && !root_config)
         RUN_INIT(init_manifest, PAL_CB(manifest_handle));
 
+    RUN_INIT(init_syscall_profile);
+    RUN_INIT(init_mmap);
+    RUN_INIT(init_futex);
+
     RUN_INIT(init_mount_root);
     RUN_INIT(init_ipc);
     RUN_INIT(init_thread);
+    RUN_INIT(init_mqueue);
     RUN_INIT(init_mount);
     RUN_INIT(init_important_handles);
     RUN_INIT(init_async);
@@ -873,8 +931,12 @@ noreturn void shim_clean_and_exit(int exit_code) {
 
     cur_process.exit_code = exit_code;
     store_all_msg_persist();
+    detach_all_shm();
     del_all_ipc_ports();
 
+    if (g_syscall_profile)
+        dump_syscall_profile();
+
     if (shim_stdio && shim_stdio != (PAL_HANDLE) -1)
         DkObjectClose(shim_stdio);
 
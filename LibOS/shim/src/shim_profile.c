@@ -0,0 +1,233 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_profile.c
+ *
+ * This file contains the syscall profiler. Each application thread owns a table of per-syscall
+ * counters which only this thread updates, so recording a syscall needs neither locks nor atomic
+ * read-modify-write operations. Readers (the `/proc/syscall_profile` file and the dump at exit)
+ * sum the tables of all threads. Tables of exited threads are kept on the list and handed to new
+ * threads, so the sums also cover threads which are gone.
+ *
+ * For each syscall the profiler records the number of calls (and how many of them were served by
+ * the fast path), the cycles spent in the LibOS and in PAL calls, and a histogram of the total
+ * latency with log2-sized buckets.
+ */
+
+#include <list.h>
+#include <shim_internal.h>
+#include <shim_ipc.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+
+#define SYSCALL_PROFILE_BUCKETS 32
+
+struct shim_syscall_stat {
+    uint64_t calls;
+    uint64_t fast_calls;
+    uint64_t libos_cycles;
+    uint64_t pal_cycles;
+    uint64_t hist[SYSCALL_PROFILE_BUCKETS];
+};
+
+DEFINE_LIST(shim_syscall_profile);
+struct shim_syscall_profile {
+    LIST_TYPE(shim_syscall_profile) list;
+    bool in_use;
+    struct shim_syscall_stat stats[LIBOS_SYSCALL_BOUND];
+};
+DEFINE_LISTP(shim_syscall_profile);
+
+bool g_syscall_profile = false;
+
+/* protects the list, not the counters */
+static struct shim_lock profile_list_lock;
+static LISTP_TYPE(shim_syscall_profile) profile_list;
+
+int init_syscall_profile(void) {
+    char cfg[2];
+
+    if (!root_config || get_config(root_config, "sys.syscall_profile", cfg, sizeof(cfg)) != 1 ||
+            cfg[0] != '1')
+        return 0;
+
+    if (!create_lock(&profile_list_lock))
+        return -ENOMEM;
+
+    INIT_LISTP(&profile_list);
+    g_syscall_profile = true;
+    return 0;
+}
+
+static struct shim_syscall_profile* get_syscall_profile(void) {
+    struct shim_syscall_profile* prof;
+
+    lock(&profile_list_lock);
+    LISTP_FOR_EACH_ENTRY(prof, &profile_list, list) {
+        if (!prof->in_use) {
+            prof->in_use = true;
+            unlock(&profile_list_lock);
+            return prof;
+        }
+    }
+    unlock(&profile_list_lock);
+
+    prof = malloc(sizeof(*prof));
+    if (!prof)
+        return NULL;
+
+    memset(prof, 0, sizeof(*prof));
+    prof->in_use = true;
+    INIT_LIST_HEAD(prof, list);
+
+    lock(&profile_list_lock);
+    LISTP_ADD_TAIL(prof, &profile_list, list);
+    unlock(&profile_list_lock);
+    return prof;
+}
+
+void release_syscall_profile(struct shim_syscall_profile* prof) {
+    lock(&profile_list_lock);
+    prof->in_use = false;
+    unlock(&profile_list_lock);
+}
+
+void syscall_profile_begin(uint64_t* cycles, uint64_t* pal_cycles) {
+    PAL_TCB* pal_tcb = pal_get_tcb();
+    pal_tcb->profile_pal_calls = 1;
+    *pal_cycles = pal_tcb->pal_cycles;
+    *cycles = get_tsc();
+}
+
+/* the counters have a single writer, but are read concurrently */
+#define STAT_ADD(field, val) \
+    __atomic_store_n(&(field), (field) + (val), __ATOMIC_RELAXED)
+
+void syscall_profile_end(int sysno, bool fast, uint64_t cycles, uint64_t pal_cycles) {
+    cycles     = get_tsc() - cycles;
+    pal_cycles = pal_get_tcb()->pal_cycles - pal_cycles;
+    if (pal_cycles > cycles)
+        pal_cycles = cycles;
+
+    struct shim_thread* cur = get_cur_thread();
+    if (!cur || is_internal(cur))
+        return;
+
+    struct shim_syscall_profile* prof = cur->syscall_profile;
+    if (!prof) {
+        prof = get_syscall_profile();
+        if (!prof)
+            return;
+        cur->syscall_profile = prof;
+    }
+
+    int bucket = 63 - __builtin_clzl(cycles | 1);
+    if (bucket >= SYSCALL_PROFILE_BUCKETS)
+        bucket = SYSCALL_PROFILE_BUCKETS - 1;
+
+    struct shim_syscall_stat* stat = &prof->stats[sysno];
+    STAT_ADD(stat->calls, 1);
+    if (fast)
+        STAT_ADD(stat->fast_calls, 1);
+    STAT_ADD(stat->libos_cycles, cycles - pal_cycles);
+    STAT_ADD(stat->pal_cycles, pal_cycles);
+    STAT_ADD(stat->hist[bucket], 1);
+}
+
+static int print_profile(char** str, size_t* len, size_t* max, const char* fmt, ...) {
+    va_list ap;
+    int ret;
+
+retry:
+    va_start(ap, fmt);
+    ret = vsnprintf(*str + *len, *max - *len, fmt, ap);
+    va_end(ap);
+
+    if (ret < 0)
+        return -EINVAL;
+
+    if ((size_t)ret >= *max - *len) {
+        size_t new_max = *max * 2;
+        char* tmp = malloc(new_max);
+        if (!tmp)
+            return -ENOMEM;
+        memcpy(tmp, *str, *len);
+        free(*str);
+        *str = tmp;
+        *max = new_max;
+        goto retry;
+    }
+
+    *len += ret;
+    return 0;
+}
+
+int format_syscall_profile(char** str, size_t* len) {
+    size_t max = 4096;
+    *len = 0;
+    *str = malloc(max);
+    if (!*str)
+        return -ENOMEM;
+
+    struct shim_syscall_stat* total = calloc(LIBOS_SYSCALL_BOUND, sizeof(*total));
+    if (!total) {
+        free(*str);
+        return -ENOMEM;
+    }
+
+    if (g_syscall_profile) {
+        struct shim_syscall_profile* prof;
+        lock(&profile_list_lock);
+        LISTP_FOR_EACH_ENTRY(prof, &profile_list, list) {
+            for (int i = 0; i < LIBOS_SYSCALL_BOUND; i++) {
+                struct shim_syscall_stat* s = &prof->stats[i];
+                if (!__atomic_load_n(&s->calls, __ATOMIC_RELAXED))
+                    continue;
+                total[i].calls        += __atomic_load_n(&s->calls, __ATOMIC_RELAXED);
+                total[i].fast_calls   += __atomic_load_n(&s->fast_calls, __ATOMIC_RELAXED);
+                total[i].libos_cycles += __atomic_load_n(&s->libos_cycles, __ATOMIC_RELAXED);
+                total[i].pal_cycles   += __atomic_load_n(&s->pal_cycles, __ATOMIC_RELAXED);
+                for (int b = 0; b < SYSCALL_PROFILE_BUCKETS; b++)
+                    total[i].hist[b] += __atomic_load_n(&s->hist[b], __ATOMIC_RELAXED);
+            }
+        }
+        unlock(&profile_list_lock);
+    }
+
+    /* one line per syscall; the histogram lists "log2(cycles):count" for non-empty buckets */
+    int ret = print_profile(str, len, &max, "# nr calls fast_calls libos_cycles pal_cycles hist\n");
+    for (int i = 0; !ret && i < LIBOS_SYSCALL_BOUND; i++) {
+        if (!total[i].calls)
+            continue;
+
+        ret = print_profile(str, len, &max, "%d %lu %lu %lu %lu", i, total[i].calls,
+                            total[i].fast_calls, total[i].libos_cycles, total[i].pal_cycles);
+        for (int b = 0; !ret && b < SYSCALL_PROFILE_BUCKETS; b++)
+            if (total[i].hist[b])
+                ret = print_profile(str, len, &max, " %d:%lu", b, total[i].hist[b]);
+        if (!ret)
+            ret = print_profile(str, len, &max, "\n");
+    }
+
+    free(total);
+    if (ret < 0) {
+        free(*str);
+        *str = NULL;
+    }
+    return ret;
+}
+
+void dump_syscall_profile(void) {
+    char* str;
+    size_t len;
+
+    if (format_syscall_profile(&str, &len) < 0)
+        return;
+
+    __SYS_PRINTF("syscall profile of process %u:\n", cur_process.vmid & 0xFFFF);
+    PAL_HANDLE hdl = __open_shim_stdio();
+    if (hdl)
+        DkStreamWrite(hdl, 0, len, str, NULL);
+    free(str);
+}
@@ -7,6 +7,7 @@
  * This file contains the system call table used by application libraries.
  */
 
+#include <asm/unistd.h>
 #include <shim_internal.h>
 #include <shim_table.h>
 
@@ -326,6 +327,9 @@ shim_fp shim_table[LIBOS_SYSCALL_BOUND] = {
     (shim_fp)__shim_setns,
     (shim_fp)__shim_getcpu,
 
+    [__NR_preadv2]  = (shim_fp)__shim_preadv2,
+    [__NR_pwritev2] = (shim_fp)__shim_pwritev2,
+
     [LIBOS_SYSCALL_BASE] = (shim_fp)NULL,
 
     (shim_fp)__shim_msgpersist,
@@ -333,3 +337,19 @@ shim_fp shim_table[LIBOS_SYSCALL_BOUND] = {
     (shim_fp)__shim_send_rpc,
     (shim_fp)__shim_recv_rpc,
 };
+
+/* Syscalls dispatched by syscalldb without the full shim_regs frame and signal handling; see
+ * DEFINE_SHIM_FAST_SYSCALL. Empty entries go through shim_table. */
+shim_fp shim_fast_table[LIBOS_SYSCALL_BOUND] = {
+    [__NR_sched_yield]   = (shim_fp)__shim_fast_sched_yield,
+    [__NR_getpid]        = (shim_fp)__shim_fast_getpid,
+    [__NR_gettimeofday]  = (shim_fp)__shim_fast_gettimeofday,
+    [__NR_getuid]        = (shim_fp)__shim_fast_getuid,
+    [__NR_getgid]        = (shim_fp)__shim_fast_getgid,
+    [__NR_geteuid]       = (shim_fp)__shim_fast_geteuid,
+    [__NR_getegid]       = (shim_fp)__shim_fast_getegid,
+    [__NR_getppid]       = (shim_fp)__shim_fast_getppid,
+    [__NR_gettid]        = (shim_fp)__shim_fast_gettid,
+    [__NR_time]          = (shim_fp)__shim_fast_time,
+    [__NR_clock_gettime] = (shim_fp)__shim_fast_clock_gettime,
+};
@@ -0,0 +1,891 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_aio.c
+ *
+ * Implementation of system calls "io_setup", "io_destroy", "io_submit", "io_cancel" and
+ * "io_getevents".
+ *
+ * io_submit() only queues the requests; a small pool of internal I/O workers executes them. A
+ * worker takes all queued requests at once and hands the ones on regular host files to the PAL in
+ * a single DkStreamsBatchIo() call, so that the host can process them concurrently. If the PAL
+ * cannot batch (e.g. under SGX), workers take one request at a time and run in parallel instead.
+ * Requests on other kinds of handles always go through the filesystem operations.
+ *
+ * Completions are written to a ring in user memory which has the layout of the Linux
+ * `struct aio_ring`; its address is the context ID, as some libraries (libaio, fio) peek into the
+ * ring without a system call. A completion can also be signaled on an eventfd.
+ */
+
+#include <errno.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+#include <shim_vma.h>
+
+#ifndef IOCB_FLAG_IOPRIO
+#define IOCB_FLAG_IOPRIO (1 << 1)
+#endif
+
+#define AIO_RING_MAGIC       0xa10a10a1
+#define AIO_MAX_EVENTS       65536   /* default of /proc/sys/fs/aio-max-nr */
+#define AIO_MAX_IOVECS       1024    /* UIO_MAXIOV */
+#define AIO_MAX_WORKERS      4
+#define AIO_BATCH_MAX        64
+#define AIO_WORKER_IDLE_TIME 1000000 /* an idle worker exits after this many microseconds */
+
+struct aio_ring {
+    uint32_t id;
+    uint32_t nr; /* number of io_events */
+    uint32_t head;
+    uint32_t tail;
+    uint32_t magic;
+    uint32_t compat_features;
+    uint32_t incompat_features;
+    uint32_t header_length; /* size of aio_ring */
+    struct io_event io_events[];
+};
+
+DEFINE_LIST(shim_aio_ctx);
+struct shim_aio_ctx {
+    LIST_TYPE(shim_aio_ctx) list;
+    struct aio_ring* ring;
+    size_t ring_size;
+    uint32_t max_reqs;
+    uint32_t inflight; /* reserved by io_submit() or submitted, but not in the ring yet */
+    uint32_t waiters;  /* threads waiting in io_getevents() */
+    PAL_HANDLE event;  /* set on every completion */
+};
+DEFINE_LISTP(shim_aio_ctx);
+
+DEFINE_LIST(shim_aio_req);
+struct shim_aio_req {
+    LIST_TYPE(shim_aio_req) list;
+    struct shim_aio_ctx* ctx;
+    struct iocb* user_iocb;
+    uint64_t data;
+    uint16_t opcode;
+    struct shim_handle* hdl;
+    struct shim_handle* resfd;
+    off_t offset;
+    struct iovec* iov; /* points to `single_iov` unless vectored */
+    size_t iovcnt;
+    struct iovec single_iov;
+    long res;
+};
+DEFINE_LISTP(shim_aio_req);
+
+/* protects the contexts, their rings and the queue of requests */
+static struct shim_lock aio_lock;
+static LISTP_TYPE(shim_aio_ctx) aio_ctx_list;
+static LISTP_TYPE(shim_aio_req) aio_queue;
+static PAL_HANDLE aio_work_event;
+static unsigned int aio_workers;
+static unsigned int aio_idle_workers;
+
+/* cleared once the PAL reports that it cannot batch I/O */
+static bool aio_pal_batch = true;
+
+static int init_aio(void) {
+    if (!create_lock_runtime(&aio_lock))
+        return -ENOMEM;
+
+    int ret = 0;
+    lock(&aio_lock);
+    if (!aio_work_event) {
+        aio_work_event = DkSynchronizationEventCreate(PAL_FALSE);
+        if (!aio_work_event)
+            ret = -ENOMEM;
+    }
+    unlock(&aio_lock);
+    return ret;
+}
+
+static struct shim_aio_ctx* __lookup_aio_ctx(aio_context_t ctx_id) {
+    assert(locked(&aio_lock));
+
+    struct shim_aio_ctx* ctx;
+    LISTP_FOR_EACH_ENTRY(ctx, &aio_ctx_list, list) {
+        if ((aio_context_t)ctx->ring == ctx_id)
+            return ctx;
+    }
+    return NULL;
+}
+
+/* number of completions in the ring; the head may be moved by the application */
+static uint32_t ring_count(struct aio_ring* ring) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) % ring->nr;
+    return (ring->tail + ring->nr - head) % ring->nr;
+}
+
+static bool is_read_op(uint16_t opcode) {
+    return opcode == IOCB_CMD_PREAD || opcode == IOCB_CMD_PREADV;
+}
+
+static bool is_sync_op(uint16_t opcode) {
+    return opcode == IOCB_CMD_FSYNC || opcode == IOCB_CMD_FDSYNC;
+}
+
+static void free_aio_req(struct shim_aio_req* req) {
+    put_handle(req->hdl);
+    if (req->resfd)
+        put_handle(req->resfd);
+    if (req->iov != &req->single_iov)
+        free(req->iov);
+    free(req);
+}
+
+static void __post_aio_event(struct shim_aio_req* req) {
+    assert(locked(&aio_lock));
+
+    struct shim_aio_ctx* ctx = req->ctx;
+    struct aio_ring* ring    = ctx->ring;
+    uint32_t tail            = ring->tail;
+
+    struct io_event* event = &ring->io_events[tail];
+    event->data = req->data;
+    event->obj  = (uint64_t)req->user_iocb;
+    event->res  = req->res;
+    event->res2 = 0;
+    __atomic_store_n(&ring->tail, (tail + 1) % ring->nr, __ATOMIC_RELEASE);
+
+    ctx->inflight--;
+    DkEventSet(ctx->event);
+}
+
+/* Gives back ring slots reserved by io_submit() for requests that were not queued. */
+static void __unreserve_aio_reqs(struct shim_aio_ctx* ctx, long count) {
+    assert(locked(&aio_lock));
+    if (!count)
+        return;
+
+    ctx->inflight -= count;
+    /* destroy_aio_ctx() may be waiting for the reservation to go away */
+    DkEventSet(ctx->event);
+}
+
+/* Posts the completions of `reqs` and frees them. */
+static void complete_aio_reqs(struct shim_aio_req** reqs, size_t count) {
+    lock(&aio_lock);
+    for (size_t i = 0; i < count; i++)
+        __post_aio_event(reqs[i]);
+    unlock(&aio_lock);
+
+    for (size_t i = 0; i < count; i++) {
+        if (reqs[i]->resfd) {
+            uint64_t one = 1;
+            struct shim_handle* resfd = reqs[i]->resfd;
+            resfd->fs->fs_ops->write(resfd, &one, sizeof(one));
+        }
+        free_aio_req(reqs[i]);
+    }
+}
+
+static PAL_HANDLE aio_direct_handle(struct shim_aio_req* req) {
+    struct shim_handle* hdl = req->hdl;
+    if (is_sync_op(req->opcode) || hdl->type != TYPE_FILE || !hdl->fs
+            || hdl->fs->fs_ops != &chroot_fs_ops)
+        return NULL;
+
+    return chroot_direct_handle(hdl);
+}
+
+/* I/O at absolute offsets on the PAL handle of a regular file, one PAL call per iovec. */
+static long aio_direct_io(struct shim_aio_req* req, PAL_HANDLE pal_hdl) {
+    bool is_read = is_read_op(req->opcode);
+    off_t offset = req->offset;
+    long total   = 0;
+
+    for (size_t i = 0; i < req->iovcnt; i++) {
+        struct iovec* iov = &req->iov[i];
+        if (!iov->iov_len)
+            continue;
+
+        PAL_NUM bytes = is_read
+                        ? DkStreamRead(pal_hdl, offset, iov->iov_len, iov->iov_base, NULL, 0)
+                        : DkStreamWrite(pal_hdl, offset, iov->iov_len, iov->iov_base, NULL);
+        if (bytes == PAL_STREAM_ERROR) {
+            if (PAL_NATIVE_ERRNO() == PAL_ERROR_ENDOFSTREAM)
+                break;
+            return total ?: -PAL_ERRNO();
+        }
+
+        total  += bytes;
+        offset += bytes;
+        if (bytes < iov->iov_len)
+            break;
+    }
+    return total;
+}
+
+/* I/O through the filesystem operations; seekable handles are accessed at `req->offset` like in
+ * preadv(), without moving the file position the application sees. */
+static long aio_fs_io(struct shim_aio_req* req) {
+    struct shim_handle* hdl    = req->hdl;
+    struct shim_fs_ops* fs_ops = hdl->fs ? hdl->fs->fs_ops : NULL;
+    if (!fs_ops)
+        return -EINVAL;
+
+    if (is_sync_op(req->opcode))
+        return fs_ops->flush ? fs_ops->flush(hdl) : -EINVAL;
+
+    bool is_read = is_read_op(req->opcode);
+    off_t pos    = fs_ops->seek ? req->offset : -1;
+    if (is_read ? fs_ops->preadv : fs_ops->pwritev)
+        return is_read ? fs_ops->preadv(hdl, req->iov, req->iovcnt, pos, /*flags=*/0)
+                       : fs_ops->pwritev(hdl, req->iov, req->iovcnt, pos, /*flags=*/0);
+
+    if (is_read ? !fs_ops->read : !fs_ops->write)
+        return -EINVAL;
+
+    /* Without positional I/O, the file position is moved to `req->offset` and back. Filesystems
+     * that have seek() but no preadv() (str, dev) do not take the handle lock themselves, so it
+     * keeps the application's I/O and other workers from seeing the temporary position. */
+    off_t old_offset = 0;
+    if (fs_ops->seek) {
+        lock(&hdl->lock);
+        old_offset = fs_ops->seek(hdl, 0, SEEK_CUR);
+        if (old_offset < 0) {
+            unlock(&hdl->lock);
+            return old_offset;
+        }
+
+        off_t ret = fs_ops->seek(hdl, req->offset, SEEK_SET);
+        if (ret < 0) {
+            unlock(&hdl->lock);
+            return ret;
+        }
+    }
+
+    long total = 0;
+    for (size_t i = 0; i < req->iovcnt; i++) {
+        struct iovec* iov = &req->iov[i];
+        if (!iov->iov_len)
+            continue;
+
+        ssize_t bytes = is_read ? fs_ops->read(hdl, iov->iov_base, iov->iov_len)
+                                : fs_ops->write(hdl, iov->iov_base, iov->iov_len);
+        if (bytes < 0) {
+            total = total ?: bytes;
+            break;
+        }
+
+        total += bytes;
+        if ((size_t)bytes < iov->iov_len)
+            break;
+    }
+
+    if (fs_ops->seek) {
+        fs_ops->seek(hdl, old_offset, SEEK_SET);
+        unlock(&hdl->lock);
+    }
+    return total;
+}
+
+/* Result of a request from the results of its PAL requests, like a short read(v). */
+static long aio_batch_result(PAL_IO_REQUEST* pal_reqs, size_t count) {
+    long total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (pal_reqs[i].error)
+            return total ?: -convert_pal_errno(pal_reqs[i].error);
+
+        total += pal_reqs[i].result;
+        if (pal_reqs[i].result < pal_reqs[i].size)
+            break;
+    }
+    return total;
+}
+
+static void run_aio_reqs(struct shim_aio_req** reqs, size_t count) {
+    PAL_HANDLE pal_hdls[AIO_BATCH_MAX];
+    size_t nsegs[AIO_BATCH_MAX];
+    size_t total_segs = 0;
+
+    assert(count <= AIO_BATCH_MAX);
+
+    for (size_t i = 0; i < count; i++) {
+        struct shim_aio_req* req = reqs[i];
+        pal_hdls[i] = aio_direct_handle(req);
+        nsegs[i]    = 0;
+        if (!pal_hdls[i])
+            continue;
+
+        for (size_t j = 0; j < req->iovcnt; j++)
+            if (req->iov[j].iov_len)
+                nsegs[i]++;
+        total_segs += nsegs[i];
+    }
+
+    /* all requests on regular files in one PAL call */
+    PAL_IO_REQUEST* pal_reqs = NULL;
+    if (total_segs > 1 && __atomic_load_n(&aio_pal_batch, __ATOMIC_RELAXED))
+        pal_reqs = malloc(sizeof(*pal_reqs) * total_segs);
+
+    if (pal_reqs) {
+        size_t seg = 0;
+        for (size_t i = 0; i < count; i++) {
+            struct shim_aio_req* req = reqs[i];
+            off_t offset = req->offset;
+            for (size_t j = 0; pal_hdls[i] && j < req->iovcnt; j++) {
+                if (!req->iov[j].iov_len)
+                    continue;
+                pal_reqs[seg++] = (PAL_IO_REQUEST){
+                    .handle = pal_hdls[i],
+                    .op     = is_read_op(req->opcode) ? PAL_IO_READ : PAL_IO_WRITE,
+                    .offset = offset,
+                    .size   = req->iov[j].iov_len,
+                    .buffer = req->iov[j].iov_base,
+                };
+                offset += req->iov[j].iov_len;
+            }
+        }
+
+        if (DkStreamsBatchIo(pal_reqs, total_segs)) {
+            seg = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (!pal_hdls[i])
+                    continue;
+                reqs[i]->res = nsegs[i] ? aio_batch_result(&pal_reqs[seg], nsegs[i]) : 0;
+                seg += nsegs[i];
+            }
+        } else {
+            if (PAL_NATIVE_ERRNO() == PAL_ERROR_NOTIMPLEMENTED)
+                __atomic_store_n(&aio_pal_batch, false, __ATOMIC_RELAXED);
+            free(pal_reqs);
+            pal_reqs = NULL;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        struct shim_aio_req* req = reqs[i];
+        if (!pal_hdls[i])
+            req->res = aio_fs_io(req);
+        else if (!pal_reqs)
+            req->res = aio_direct_io(req, pal_hdls[i]);
+
+        if (pal_hdls[i] && !is_read_op(req->opcode) && req->res > 0)
+            chroot_direct_written(req->hdl, req->offset + req->res);
+    }
+
+    free(pal_reqs);
+}
+
+static void aio_worker(void* arg) {
+    struct shim_thread* self = (struct shim_thread*)arg;
+
+    shim_tcb_init();
+    set_cur_thread(self);
+    update_fs_base(0);
+    debug_setbuf(shim_get_tcb(), true);
+
+    struct shim_aio_req* reqs[AIO_BATCH_MAX];
+
+    lock(&aio_lock);
+    while (true) {
+        size_t max = __atomic_load_n(&aio_pal_batch, __ATOMIC_RELAXED) ? AIO_BATCH_MAX : 1;
+        size_t count = 0;
+        while (count < max && !LISTP_EMPTY(&aio_queue)) {
+            struct shim_aio_req* req = LISTP_FIRST_ENTRY(&aio_queue, struct shim_aio_req, list);
+            LISTP_DEL_INIT(req, &aio_queue, list);
+            reqs[count++] = req;
+        }
+
+        if (!count) {
+            aio_idle_workers++;
+            unlock(&aio_lock);
+            PAL_BOL woken = DkSynchronizationObjectWait(aio_work_event, AIO_WORKER_IDLE_TIME);
+            lock(&aio_lock);
+            aio_idle_workers--;
+            if (!woken && LISTP_EMPTY(&aio_queue))
+                break;
+            continue;
+        }
+
+        /* hand the rest of the queue to the next worker */
+        if (!LISTP_EMPTY(&aio_queue) && aio_idle_workers)
+            DkEventSet(aio_work_event);
+        unlock(&aio_lock);
+
+        run_aio_reqs(reqs, count);
+        complete_aio_reqs(reqs, count);
+
+        lock(&aio_lock);
+    }
+    aio_workers--;
+    unlock(&aio_lock);
+
+    __disable_preempt(self->shim_tcb);
+    put_thread(self);
+    DkThreadExit(/*clear_child_tid=*/NULL);
+}
+
+static int __spawn_aio_worker(void) {
+    assert(locked(&aio_lock));
+
+    struct shim_thread* thread = get_new_internal_thread();
+    if (!thread)
+        return -ENOMEM;
+
+    PAL_HANDLE handle = thread_create(aio_worker, thread);
+    if (!handle) {
+        put_thread(thread);
+        return -PAL_ERRNO();
+    }
+
+    thread->pal_handle = handle;
+    aio_workers++;
+    return 0;
+}
+
+int shim_do_io_setup(unsigned int nr_events, aio_context_t* ctxp) {
+    if (test_user_memory(ctxp, sizeof(*ctxp), /*write=*/true))
+        return -EFAULT;
+
+    if (*ctxp || !nr_events || nr_events > AIO_MAX_EVENTS)
+        return -EINVAL;
+
+    int ret = init_aio();
+    if (ret < 0)
+        return ret;
+
+    struct shim_aio_ctx* ctx = malloc(sizeof(*ctx));
+    if (!ctx)
+        return -ENOMEM;
+
+    /* one slot stays empty to tell a full ring from an empty one */
+    ctx->ring_size = ALLOC_ALIGN_UP(sizeof(struct aio_ring)
+                                    + sizeof(struct io_event) * (nr_events + 1));
+    ctx->max_reqs  = nr_events;
+    ctx->inflight  = 0;
+    ctx->waiters   = 0;
+    ctx->event     = DkNotificationEventCreate(PAL_FALSE);
+    if (!ctx->event) {
+        ret = -ENOMEM;
+        goto err;
+    }
+
+    /* like the ring of Linux, the ring is not inherited by children */
+    void* addr = NULL;
+    ret = bkeep_mmap_any_aslr(ctx->ring_size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | VMA_DONTFORK, NULL, 0, "aio_ring",
+                              &addr);
+    if (ret < 0)
+        goto err_event;
+
+    if (!DkVirtualMemoryAlloc(addr, ctx->ring_size, 0, PAL_PROT_READ | PAL_PROT_WRITE)) {
+        ret = -PAL_ERRNO();
+        void* tmp_vma = NULL;
+        if (bkeep_munmap(addr, ctx->ring_size, /*is_internal=*/false, &tmp_vma) < 0)
+            BUG();
+        bkeep_remove_tmp_vma(tmp_vma);
+        goto err_event;
+    }
+
+    struct aio_ring* ring = addr;
+    ring->nr            = (ctx->ring_size - sizeof(*ring)) / sizeof(struct io_event);
+    ring->magic         = AIO_RING_MAGIC;
+    ring->header_length = sizeof(*ring);
+    ctx->ring           = ring;
+
+    lock(&aio_lock);
+    INIT_LIST_HEAD(ctx, list);
+    LISTP_ADD_TAIL(ctx, &aio_ctx_list, list);
+    unlock(&aio_lock);
+
+    *ctxp = (aio_context_t)ring;
+    return 0;
+
+err_event:
+    DkObjectClose(ctx->event);
+err:
+    free(ctx);
+    return ret;
+}
+
+/* Destroys a context which was already removed from the list. */
+static void destroy_aio_ctx(struct shim_aio_ctx* ctx) {
+    struct shim_aio_req* reqs[AIO_BATCH_MAX];
+
+    lock(&aio_lock);
+
+    /* cancel what was not started yet, wait for the rest and for waiters to notice */
+    while (true) {
+        size_t count = 0;
+        struct shim_aio_req* req;
+        struct shim_aio_req* tmp;
+        LISTP_FOR_EACH_ENTRY_SAFE(req, tmp, &aio_queue, list) {
+            if (req->ctx != ctx || count == AIO_BATCH_MAX)
+                continue;
+            LISTP_DEL_INIT(req, &aio_queue, list);
+            req->res = -ECANCELED;
+            reqs[count++] = req;
+        }
+        if (count) {
+            unlock(&aio_lock);
+            complete_aio_reqs(reqs, count);
+            lock(&aio_lock);
+            continue;
+        }
+
+        if (ctx->inflight) {
+            DkEventClear(ctx->event);
+            unlock(&aio_lock);
+            DkSynchronizationObjectWait(ctx->event, NO_TIMEOUT);
+            lock(&aio_lock);
+            continue;
+        }
+
+        if (!ctx->waiters)
+            break;
+        DkEventSet(ctx->event);
+        unlock(&aio_lock);
+        DkThreadYieldExecution();
+        lock(&aio_lock);
+    }
+    unlock(&aio_lock);
+
+    void* tmp_vma = NULL;
+    if (bkeep_munmap(ctx->ring, ctx->ring_size, /*is_internal=*/false, &tmp_vma) < 0)
+        BUG();
+    DkVirtualMemoryFree(ctx->ring, ctx->ring_size);
+    bkeep_remove_tmp_vma(tmp_vma);
+
+    DkObjectClose(ctx->event);
+    free(ctx);
+}
+
+int shim_do_io_destroy(aio_context_t ctx_id) {
+    if (!lock_created(&aio_lock))
+        return -EINVAL;
+
+    lock(&aio_lock);
+    struct shim_aio_ctx* ctx = __lookup_aio_ctx(ctx_id);
+    if (ctx)
+        LISTP_DEL_INIT(ctx, &aio_ctx_list, list);
+    unlock(&aio_lock);
+
+    if (!ctx)
+        return -EINVAL;
+
+    /* `ctx` is off the list, so nobody else can destroy it or submit to it */
+    destroy_aio_ctx(ctx);
+    return 0;
+}
+
+void destroy_all_aio_contexts(void) {
+    if (!lock_created(&aio_lock))
+        return;
+
+    while (true) {
+        lock(&aio_lock);
+        struct shim_aio_ctx* ctx = LISTP_FIRST_ENTRY(&aio_ctx_list, struct shim_aio_ctx, list);
+        if (ctx)
+            LISTP_DEL_INIT(ctx, &aio_ctx_list, list);
+        unlock(&aio_lock);
+        if (!ctx)
+            break;
+        destroy_aio_ctx(ctx);
+    }
+}
+
+static int prepare_aio_req(struct iocb* user_iocb, struct shim_aio_req** reqp) {
+    if (test_user_memory(user_iocb, sizeof(*user_iocb), /*write=*/false))
+        return -EFAULT;
+
+    struct iocb iocb;
+    memcpy(&iocb, user_iocb, sizeof(iocb));
+
+    if (iocb.aio_reserved2 || (iocb.aio_flags & ~(IOCB_FLAG_RESFD | IOCB_FLAG_IOPRIO)))
+        return -EINVAL;
+
+    switch (iocb.aio_lio_opcode) {
+        case IOCB_CMD_PREAD:
+        case IOCB_CMD_PWRITE:
+        case IOCB_CMD_PREADV:
+        case IOCB_CMD_PWRITEV:
+            if ((ssize_t)iocb.aio_nbytes < 0 || iocb.aio_offset < 0)
+                return -EINVAL;
+            break;
+        case IOCB_CMD_FSYNC:
+        case IOCB_CMD_FDSYNC:
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    struct shim_aio_req* req = calloc(1, sizeof(*req));
+    if (!req)
+        return -ENOMEM;
+
+    req->user_iocb = user_iocb;
+    req->data      = iocb.aio_data;
+    req->opcode    = iocb.aio_lio_opcode;
+    req->offset    = iocb.aio_offset;
+    req->iov       = &req->single_iov;
+    INIT_LIST_HEAD(req, list);
+
+    int ret;
+    req->hdl = get_fd_handle(iocb.aio_fildes, NULL, NULL);
+    if (!req->hdl) {
+        free(req);
+        return -EBADF;
+    }
+
+    if (!is_sync_op(req->opcode)
+            && !(req->hdl->acc_mode & (is_read_op(req->opcode) ? MAY_READ : MAY_WRITE))) {
+        ret = -EBADF;
+        goto err;
+    }
+
+    if (iocb.aio_flags & IOCB_FLAG_RESFD) {
+        req->resfd = get_fd_handle(iocb.aio_resfd, NULL, NULL);
+        if (!req->resfd) {
+            ret = -EBADF;
+            goto err;
+        }
+        if (req->resfd->type != TYPE_EVENTFD) {
+            ret = -EINVAL;
+            goto err;
+        }
+    }
+
+    bool is_read = is_read_op(req->opcode);
+    if (req->opcode == IOCB_CMD_PREADV || req->opcode == IOCB_CMD_PWRITEV) {
+        struct iovec* user_iov = (struct iovec*)iocb.aio_buf;
+        if (iocb.aio_nbytes > AIO_MAX_IOVECS) {
+            ret = -EINVAL;
+            goto err;
+        }
+        if (test_user_memory(user_iov, sizeof(*user_iov) * iocb.aio_nbytes, /*write=*/false)) {
+            ret = -EFAULT;
+            goto err;
+        }
+
+        req->iov = malloc(sizeof(*req->iov) * (iocb.aio_nbytes ?: 1));
+        if (!req->iov) {
+            req->iov = &req->single_iov;
+            ret = -ENOMEM;
+            goto err;
+        }
+        memcpy(req->iov, user_iov, sizeof(*req->iov) * iocb.aio_nbytes);
+        req->iovcnt = iocb.aio_nbytes;
+    } else if (!is_sync_op(req->opcode)) {
+        req->single_iov.iov_base = (void*)iocb.aio_buf;
+        req->single_iov.iov_len  = iocb.aio_nbytes;
+        req->iovcnt = 1;
+    }
+
+    for (size_t i = 0; i < req->iovcnt; i++) {
+        if (req->iov[i].iov_len
+                && test_user_memory(req->iov[i].iov_base, req->iov[i].iov_len, is_read)) {
+            ret = -EFAULT;
+            goto err;
+        }
+    }
+
+    *reqp = req;
+    return 0;
+
+err:
+    free_aio_req(req);
+    return ret;
+}
+
+int shim_do_io_submit(aio_context_t ctx_id, long nr, struct iocb** iocbpp) {
+    if (nr < 0 || !lock_created(&aio_lock))
+        return -EINVAL;
+
+    /* Reserve ring slots for the requests up front, so that concurrent io_submit() calls cannot
+     * overcommit the ring while the requests are prepared without the lock. The reservation also
+     * keeps `ctx` alive: destroy_aio_ctx() waits for `inflight` to drop to zero. */
+    lock(&aio_lock);
+    struct shim_aio_ctx* ctx = __lookup_aio_ctx(ctx_id);
+    if (!ctx) {
+        unlock(&aio_lock);
+        return -EINVAL;
+    }
+    long avail = (long)ctx->max_reqs - ctx->inflight - ring_count(ctx->ring);
+    if (!nr || avail <= 0) {
+        unlock(&aio_lock);
+        return nr ? -EAGAIN : 0;
+    }
+    if (nr > avail)
+        nr = avail;
+    ctx->inflight += nr;
+    unlock(&aio_lock);
+
+    if (test_user_memory(iocbpp, sizeof(*iocbpp) * nr, /*write=*/false)) {
+        lock(&aio_lock);
+        __unreserve_aio_reqs(ctx, nr);
+        unlock(&aio_lock);
+        return -EFAULT;
+    }
+
+    /* prepare all requests first, so that they are queued under a single lock acquisition */
+    LISTP_TYPE(shim_aio_req) reqs = LISTP_INIT;
+    long submitted = 0;
+    int ret = 0;
+    for (; submitted < nr; submitted++) {
+        struct shim_aio_req* req;
+        ret = prepare_aio_req(iocbpp[submitted], &req);
+        if (ret < 0)
+            break;
+        LISTP_ADD_TAIL(req, &reqs, list);
+    }
+
+    lock(&aio_lock);
+    __unreserve_aio_reqs(ctx, nr - submitted);
+    if (__lookup_aio_ctx(ctx_id) != ctx) {
+        /* destroyed in the meantime */
+        __unreserve_aio_reqs(ctx, submitted);
+        unlock(&aio_lock);
+        struct shim_aio_req* req;
+        struct shim_aio_req* tmp;
+        LISTP_FOR_EACH_ENTRY_SAFE(req, tmp, &reqs, list) {
+            LISTP_DEL(req, &reqs, list);
+            free_aio_req(req);
+        }
+        return -EINVAL;
+    }
+
+    struct shim_aio_req* req;
+    struct shim_aio_req* tmp;
+    if (submitted && !aio_idle_workers && aio_workers < AIO_MAX_WORKERS) {
+        int spawn_ret = __spawn_aio_worker();
+        if (spawn_ret < 0 && !aio_workers) {
+            /* nobody would ever run the requests */
+            __unreserve_aio_reqs(ctx, submitted);
+            unlock(&aio_lock);
+            debug("[io_submit] Failed to create an I/O worker: %d\n", spawn_ret);
+            LISTP_FOR_EACH_ENTRY_SAFE(req, tmp, &reqs, list) {
+                LISTP_DEL(req, &reqs, list);
+                free_aio_req(req);
+            }
+            return -EAGAIN;
+        }
+    }
+
+    LISTP_FOR_EACH_ENTRY_SAFE(req, tmp, &reqs, list) {
+        LISTP_DEL_INIT(req, &reqs, list);
+        req->ctx = ctx;
+        LISTP_ADD_TAIL(req, &aio_queue, list);
+    }
+
+    if (submitted)
+        DkEventSet(aio_work_event);
+    unlock(&aio_lock);
+
+    return submitted ?: ret;
+}
+
+int shim_do_io_cancel(aio_context_t ctx_id, struct iocb* iocb, struct io_event* result) {
+    if (!lock_created(&aio_lock))
+        return -EINVAL;
+
+    if (test_user_memory(result, sizeof(*result), /*write=*/true))
+        return -EFAULT;
+
+    lock(&aio_lock);
+    struct shim_aio_ctx* ctx = __lookup_aio_ctx(ctx_id);
+    if (!ctx) {
+        unlock(&aio_lock);
+        return -EINVAL;
+    }
+
+    struct shim_aio_req* found = NULL;
+    struct shim_aio_req* req;
+    LISTP_FOR_EACH_ENTRY(req, &aio_queue, list) {
+        if (req->ctx == ctx && req->user_iocb == iocb) {
+            found = req;
+            break;
+        }
+    }
+    if (found) {
+        /* the completion of a cancelled request is returned in `result` instead of the ring */
+        LISTP_DEL_INIT(found, &aio_queue, list);
+        ctx->inflight--;
+    }
+    unlock(&aio_lock);
+
+    /* requests which already run cannot be cancelled */
+    if (!found)
+        return -EINVAL;
+
+    result->data = found->data;
+    result->obj  = (uint64_t)found->user_iocb;
+    result->res  = -ECANCELED;
+    result->res2 = 0;
+    free_aio_req(found);
+    return 0;
+}
+
+int shim_do_io_getevents(aio_context_t ctx_id, long min_nr, long nr, struct io_event* events,
+                         struct timespec* timeout) {
+    if (min_nr < 0 || nr < 0 || min_nr > nr || !lock_created(&aio_lock))
+        return -EINVAL;
+
+    if (nr && test_user_memory(events, sizeof(*events) * nr, /*write=*/true))
+        return -EFAULT;
+
+    uint64_t timeout_us = NO_TIMEOUT;
+    uint64_t deadline   = 0;
+    if (timeout) {
+        if (test_user_memory(timeout, sizeof(*timeout), /*write=*/false))
+            return -EFAULT;
+        if (timeout->tv_sec < 0 || timeout->tv_nsec < 0 || timeout->tv_nsec >= 1000000000)
+            return -EINVAL;
+        timeout_us = timeout->tv_sec * 1000000ULL + timeout->tv_nsec / 1000;
+        deadline   = DkSystemTimeQuery() + timeout_us;
+    }
+
+    long count = 0;
+    lock(&aio_lock);
+    while (true) {
+        struct shim_aio_ctx* ctx = __lookup_aio_ctx(ctx_id);
+        if (!ctx) {
+            unlock(&aio_lock);
+            return count ?: -EINVAL;
+        }
+
+        struct aio_ring* ring = ctx->ring;
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) % ring->nr;
+        uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        while (count < nr && head != tail) {
+            events[count++] = ring->io_events[head];
+            head = (head + 1) % ring->nr;
+        }
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+
+        if (count >= min_nr || (timeout && !timeout_us))
+            break;
+
+        if (timeout) {
+            uint64_t now = DkSystemTimeQuery();
+            if (now >= deadline)
+                break;
+            timeout_us = deadline - now;
+        }
+
+        /* the context stays alive while we wait, see destroy_aio_ctx() */
+        DkEventClear(ctx->event);
+        ctx->waiters++;
+        unlock(&aio_lock);
+        PAL_BOL woken = DkSynchronizationObjectWait(ctx->event, timeout_us);
+        lock(&aio_lock);
+        ctx->waiters--;
+
+        if (!woken && PAL_NATIVE_ERRNO() == PAL_ERROR_INTERRUPTED) {
+            unlock(&aio_lock);
+            return count ?: -EINTR;
+        }
+    }
+    unlock(&aio_lock);
+
+    return count;
+}
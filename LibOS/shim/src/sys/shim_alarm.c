@@ -4,7 +4,8 @@
 /*
  * shim_alarm.c
  *
- * Implementation of system call "alarm", "setitmer" and "getitimer".
+ * Implementation of system call "alarm", "setitmer" and "getitimer". Both alarm() and setitimer()
+ * use the single ITIMER_REAL timer of the process, which is serviced by the async helper.
  */
 
 #include <stdint.h>
@@ -15,46 +16,47 @@
 #include "shim_thread.h"
 #include "shim_utils.h"
 
-static void signal_alarm(IDTYPE caller, void* arg) {
-    (void)do_kill_proc(caller, (IDTYPE)(uintptr_t)arg, SIGALRM, /*use_ipc=*/false);
+/* ITIMER_REAL of this process, shared by alarm() and setitimer() */
+static struct async_timer real_itimer;
+static IDTYPE real_itimer_tgid;
+
+static void signal_alarm(struct async_timer* timer, uint64_t expirations) {
+    __UNUSED(timer);
+    __UNUSED(expirations);
+    (void)do_kill_proc(real_itimer_tgid, real_itimer_tgid, SIGALRM, /*use_ipc=*/false);
+}
+
+static int set_real_itimer(uint64_t value, uint64_t interval) {
+    real_itimer.callback = &signal_alarm;
+    real_itimer_tgid     = get_cur_thread()->tgid;
+
+    uint64_t expire_time = 0;
+    if (value) {
+        expire_time = DkSystemTimeQuery();
+        if ((int64_t)expire_time < 0)
+            return -PAL_ERRNO();
+        expire_time += value;
+    }
+    return set_async_timer(&real_itimer, expire_time, interval);
 }
 
 int shim_do_alarm(unsigned int seconds) {
     uint64_t usecs = 1000000ULL * seconds;
 
-    int64_t ret = install_async_event(NULL, usecs, &signal_alarm,
-                                      (void*)(uintptr_t)get_cur_thread()->tgid);
+    MASTER_LOCK();
+    uint64_t usecs_left = get_async_timer(&real_itimer, /*interval=*/NULL);
+    int ret = set_real_itimer(usecs, /*interval=*/0);
+    MASTER_UNLOCK();
+
     if (ret < 0)
         return ret;
 
-    uint64_t usecs_left = (uint64_t)ret;
-    int secs            = usecs_left / 1000000ULL;
+    int secs = usecs_left / 1000000ULL;
     if (usecs_left % 1000000ULL)
         secs++;
     return secs;
 }
 
-static struct {
-    unsigned long timeout;
-    unsigned long reset;
-} real_itimer;
-
-static void signal_itimer(IDTYPE target, void* arg) {
-    // XXX: Can we simplify this code or streamline with the other callback?
-    __UNUSED(target);
-
-    MASTER_LOCK();
-
-    if (real_itimer.timeout != (unsigned long)arg) {
-        MASTER_UNLOCK();
-        return;
-    }
-
-    real_itimer.timeout += real_itimer.reset;
-    real_itimer.reset = 0;
-    MASTER_UNLOCK();
-}
-
 #ifndef ITIMER_REAL
 #define ITIMER_REAL 0
 #endif
@@ -71,30 +73,21 @@ int shim_do_setitimer(int which, struct __kernel_itimerval* value,
     if (ovalue && test_user_memory(ovalue, sizeof(*ovalue), true))
         return -EFAULT;
 
-    uint64_t setup_time = DkSystemTimeQuery();
-
     uint64_t next_value = value->it_value.tv_sec * (uint64_t)1000000 + value->it_value.tv_usec;
     uint64_t next_reset = value->it_interval.tv_sec * (uint64_t)1000000 + value->it_interval.tv_usec;
 
     MASTER_LOCK();
 
-    uint64_t current_timeout =
-        real_itimer.timeout > setup_time ? real_itimer.timeout - setup_time : 0;
-    uint64_t current_reset = real_itimer.reset;
-
-    int64_t ret =
-        install_async_event(NULL, next_value, &signal_itimer, (void*)(setup_time + next_value));
-
-    if (ret < 0) {
-        MASTER_UNLOCK();
-        return ret;
-    }
+    uint64_t current_reset;
+    uint64_t current_timeout = get_async_timer(&real_itimer, &current_reset);
 
-    real_itimer.timeout = setup_time + next_value;
-    real_itimer.reset   = next_reset;
+    int ret = set_real_itimer(next_value, next_reset);
 
     MASTER_UNLOCK();
 
+    if (ret < 0)
+        return ret;
+
     if (ovalue) {
         ovalue->it_interval.tv_sec  = current_reset / 1000000;
         ovalue->it_interval.tv_usec = current_reset % 1000000;
@@ -114,13 +107,8 @@ int shim_do_getitimer(int which, struct __kernel_itimerval* value) {
     if (test_user_memory(value, sizeof(*value), true))
         return -EFAULT;
 
-    uint64_t setup_time = DkSystemTimeQuery();
-
-    MASTER_LOCK();
-    uint64_t current_timeout =
-        real_itimer.timeout > setup_time ? real_itimer.timeout - setup_time : 0;
-    uint64_t current_reset = real_itimer.reset;
-    MASTER_UNLOCK();
+    uint64_t current_reset;
+    uint64_t current_timeout = get_async_timer(&real_itimer, &current_reset);
 
     value->it_interval.tv_sec  = current_reset / 1000000;
     value->it_interval.tv_usec = current_reset % 1000000;
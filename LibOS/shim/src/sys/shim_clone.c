@@ -157,30 +157,10 @@ int shim_do_clone (int flags, void * user_stack_addr, int * parent_tidptr,
     int * set_parent_tid = NULL;
     int ret = 0;
 
-    /* special case of vfork: call shim_do_vfork() */
+    /* special case of vfork: call do_vfork() */
     if (flags == (CLONE_VFORK | CLONE_VM | SIGCHLD)) {
         /* some runtimes (e.g. Glibc 2.31+) specify user_stack_addr so that the child process
-         * must resume on this supplied stack; we mimic it by temporarily rewiring the current
-         * thread's stack values to the supplied user_stack_addr */
-        void* old_stack_top = self->stack_top;
-        void* old_stack_red = self->stack_red;
-        void* old_stack     = self->stack;
-        unsigned long old_stack_rsp = shim_context_get_sp(&self->shim_tcb->context);
-
-        if (user_stack_addr) {
-            struct shim_vma_info vma_info;
-            if (lookup_vma(ALLOC_ALIGN_DOWN_PTR(user_stack_addr), &vma_info) < 0) {
-                return -EFAULT;
-            }
-            self->stack_top = (char*)vma_info.addr + vma_info.length;
-            self->stack_red = vma_info.addr;
-            self->stack     = vma_info.addr;
-            shim_context_set_sp(&self->shim_tcb->context, (unsigned long)user_stack_addr);
-
-            if (vma_info.file) {
-                put_handle(vma_info.file);
-            }
-        }
+         * must resume on this supplied stack; do_vfork() switches the child to it */
 
         /* FIXME: we ignore parent_tidptr, child_tidptr and tls; no application seems to use a
          *        combination of clone(CLONE_VFORK) and these parameters */
@@ -196,16 +176,7 @@ int shim_do_clone (int flags, void * user_stack_addr, int * parent_tidptr,
             debug("\n");
         }
 
-        ret = shim_do_vfork();
-
-        /* parent process continues here, rewire stack values back to original ones */
-        if (user_stack_addr) {
-            self->stack_top = old_stack_top;
-            self->stack_red = old_stack_red;
-            self->stack     = old_stack;
-            shim_context_set_sp(&self->shim_tcb->context, old_stack_rsp);
-        }
-        return ret;
+        return do_vfork(user_stack_addr);
     }
 
     const int supported_flags =
@@ -357,7 +328,8 @@ int shim_do_clone (int flags, void * user_stack_addr, int * parent_tidptr,
         add_thread(thread);
         set_as_child(self, thread);
 
-        ret = create_process_and_send_checkpoint(&migrate_fork, /*exec=*/NULL, thread);
+        ret = create_process_and_send_checkpoint(&migrate_fork, /*exec=*/NULL, /*replace=*/false,
+                                                 thread);
         thread->shim_tcb = NULL; /* cpu context of forked thread isn't
                                   * needed any more */
         if (parent_stack)
@@ -18,6 +18,7 @@
 #include <shim_internal.h>
 #include <shim_table.h>
 #include <shim_thread.h>
+#include <shim_utils.h>
 
 /* Avoid duplicated definitions */
 #ifndef EPOLLIN
@@ -182,7 +183,9 @@ int shim_do_epoll_ctl(int epfd, int op, int fd, struct __kernel_epoll_event* eve
                 goto out;
             }
             /* note that pipe and socket may not have pal_handle yet (e.g. before bind()) */
-            if (hdl->type != TYPE_PIPE && hdl->type != TYPE_SOCK && hdl->type != TYPE_EVENTFD) {
+            if (hdl->type != TYPE_PIPE && hdl->type != TYPE_SOCK && hdl->type != TYPE_EVENTFD &&
+                    hdl->type != TYPE_TIMERFD && hdl->type != TYPE_MQUEUE &&
+                    hdl->type != TYPE_SIGNALFD) {
                 ret = -EPERM;
                 put_handle(hdl);
                 goto out;
@@ -332,6 +335,10 @@ int shim_do_epoll_wait(int epfd, struct __kernel_epoll_event* events, int maxeve
             if (!epoll_item->handle || !epoll_item->handle->pal_handle)
                 continue;
 
+            if (epoll_item->handle->type == TYPE_MQUEUE &&
+                    (epoll_item->events & (EPOLLIN | EPOLLRDNORM)))
+                mqueue_prepare_wait(epoll_item->handle);
+
             pal_handles[pal_cnt] = epoll_item->handle->pal_handle;
             pal_events[pal_cnt]  = (epoll_item->events & (EPOLLIN | EPOLLRDNORM)) ? PAL_WAIT_READ  : 0;
             pal_events[pal_cnt] |= (epoll_item->events & (EPOLLOUT | EPOLLWRNORM)) ? PAL_WAIT_WRITE : 0;
@@ -14,6 +14,7 @@
 
 #include <pal.h>
 #include <pal_error.h>
+#include <shim_fork.h>
 #include <shim_fs.h>
 #include <shim_internal.h>
 #include <shim_ipc.h>
@@ -80,6 +81,9 @@ noreturn static void __shim_do_execve_rtld(struct execve_rtld_arg* __arg) {
     clean_link_map_list();
 
     reset_brk();
+    detach_all_shm();
+    destroy_all_aio_contexts();
+    delete_all_posix_timers();
 
     size_t count;
     struct shim_vma_info* vmas;
@@ -161,34 +165,119 @@ static int shim_do_execve_rtld(struct shim_handle* hdl, const char** argv, const
 static BEGIN_MIGRATION_DEF(execve, struct shim_thread* thread, struct shim_process* proc,
                            const char** argv, const char** envp) {
     DEFINE_MIGRATE(process, proc, sizeof(struct shim_process));
+    DEFINE_MIGRATE(manifest, NULL, 0);
     DEFINE_MIGRATE(all_mounts, NULL, 0);
     DEFINE_MIGRATE(running_thread, thread, sizeof(struct shim_thread));
     DEFINE_MIGRATE(pending_signals, NULL, 0);
     DEFINE_MIGRATE(handle_map, thread->handle_map, sizeof(struct shim_handle_map));
     DEFINE_MIGRATE(migratable, NULL, 0);
+    DEFINE_MIGRATE(loader_cache, NULL, 0);
     DEFINE_MIGRATE(arguments, argv, 0);
     DEFINE_MIGRATE(environ, envp, 0);
 }
 END_MIGRATION_DEF(execve)
 
+/* the new process inherits a copy of the descriptor table without CLOEXEC descriptors */
+static int set_exec_handle_map(struct shim_thread* thread) {
+    struct shim_handle_map* handle_map;
+    int ret;
+
+    if ((ret = dup_handle_map(&handle_map, thread->handle_map)) < 0)
+        return ret;
+
+    set_handle_map(thread, handle_map);
+
+    return close_cloexec_handle(handle_map);
+}
+
 /* thread is cur_thread stripped off stack & tcb (see below func);
  * process is new process which is forked and waits for checkpoint. */
 static int migrate_execve(struct shim_cp_store* cpstore, struct shim_thread* thread,
                           struct shim_process* process, va_list ap) {
-    struct shim_handle_map* handle_map;
     const char** argv = va_arg(ap, const char**);
     const char** envp = va_arg(ap, const char**);
     int ret;
 
-    if ((ret = dup_handle_map(&handle_map, thread->handle_map)) < 0)
+    if ((ret = set_exec_handle_map(thread)) < 0)
         return ret;
 
-    set_handle_map(thread, handle_map);
+    return START_MIGRATE(cpstore, execve, thread, process, argv, envp);
+}
+
+/* Same as the execve migration, but the new process is a child of the current process rather than
+ * its replacement, so it does not take over the pending signals of the current process. */
+static BEGIN_MIGRATION_DEF(vfork_execve, struct shim_thread* thread, struct shim_process* proc,
+                           const char** argv, const char** envp) {
+    DEFINE_MIGRATE(process, proc, sizeof(struct shim_process));
+    DEFINE_MIGRATE(manifest, NULL, 0);
+    DEFINE_MIGRATE(all_mounts, NULL, 0);
+    DEFINE_MIGRATE(running_thread, thread, sizeof(struct shim_thread));
+    DEFINE_MIGRATE(handle_map, thread->handle_map, sizeof(struct shim_handle_map));
+    DEFINE_MIGRATE(migratable, NULL, 0);
+    DEFINE_MIGRATE(loader_cache, NULL, 0);
+    DEFINE_MIGRATE(arguments, argv, 0);
+    DEFINE_MIGRATE(environ, envp, 0);
+}
+END_MIGRATION_DEF(vfork_execve)
 
-    if ((ret = close_cloexec_handle(handle_map)) < 0)
+/* thread is the vfork child stripped off stack & tcb (see vfork_execve()) */
+static int migrate_vfork_execve(struct shim_cp_store* cpstore, struct shim_thread* thread,
+                                struct shim_process* process, va_list ap) {
+    const char** argv = va_arg(ap, const char**);
+    const char** envp = va_arg(ap, const char**);
+    int ret;
+
+    if ((ret = set_exec_handle_map(thread)) < 0)
         return ret;
 
-    return START_MIGRATE(cpstore, execve, thread, process, argv, envp);
+    return START_MIGRATE(cpstore, vfork_execve, thread, process, argv, envp);
+}
+
+/* execve() in a vfork child: the new process is created from `exec`, the descriptors and the
+ * credentials of the child only, without a checkpoint of the address space it shares with its
+ * parent. On success, the parent resumes and this function does not return. */
+static int vfork_execve(struct shim_handle* exec, const char** argv, const char** envp) {
+    struct shim_thread* cur_thread = get_cur_thread();
+    int ret;
+
+    lock(&cur_thread->lock);
+    struct shim_handle* old_exec = cur_thread->exec;
+    cur_thread->exec = exec;
+
+    void* stack          = cur_thread->stack;
+    void* stack_top      = cur_thread->stack_top;
+    void* stack_red      = cur_thread->stack_red;
+    shim_tcb_t* shim_tcb = cur_thread->shim_tcb;
+
+    cur_thread->stack     = NULL;
+    cur_thread->stack_top = NULL;
+    cur_thread->stack_red = NULL;
+    cur_thread->shim_tcb  = NULL;
+    unlock(&cur_thread->lock);
+
+    ret = create_process_and_send_checkpoint(&migrate_vfork_execve, exec, /*replace=*/false,
+                                             cur_thread, argv, envp);
+
+    lock(&cur_thread->lock);
+    cur_thread->stack     = stack;
+    cur_thread->stack_top = stack_top;
+    cur_thread->stack_red = stack_red;
+    cur_thread->shim_tcb  = shim_tcb;
+
+    if (ret < 0) {
+        /* execve failed, the vfork child continues with its old executable */
+        cur_thread->exec = old_exec;
+        unlock(&cur_thread->lock);
+        put_handle(exec);
+        return ret;
+    }
+    unlock(&cur_thread->lock);
+
+    if (old_exec)
+        put_handle(old_exec);
+
+    debug("execve() of vfork child %u in a new process\n", cur_thread->tid);
+    vfork_child_exec_done();
 }
 
 int shim_do_execve(const char* file, const char** argv, const char** envp) {
@@ -349,6 +438,31 @@ reopen:
         }
     }
 
+    /* arguments of a new process: the interpreter of a script comes first */
+    const char** new_argv = argv;
+    if (!LISTP_EMPTY(&shargs)) {
+        struct sharg* sh;
+        int shargc = 0, cnt = 0;
+        LISTP_FOR_EACH_ENTRY(sh, &shargs, list) {
+            shargc++;
+        }
+
+        new_argv = __alloca(sizeof(const char*) * (argc + shargc + 1));
+
+        LISTP_FOR_EACH_ENTRY(sh, &shargs, list) {
+            new_argv[cnt++] = sh->arg;
+        }
+
+        for (cnt = 0; cnt < argc; cnt++)
+            new_argv[shargc + cnt] = argv[cnt];
+
+        new_argv[shargc + argc] = NULL;
+    }
+
+    /* a vfork child becomes a new process while its parent (with all its threads) lives on */
+    if (cur_thread->vfork_state)
+        return vfork_execve(exec, new_argv, envp);
+
     /* If `execve` is invoked concurrently by multiple threads, let only one succeed. */
     static unsigned int first = 0;
     if (__atomic_exchange_n(&first, 1, __ATOMIC_RELAXED) != 0) {
@@ -385,26 +499,6 @@ reopen:
     }
     debug("execve() in a new process\n");
 
-    if (!LISTP_EMPTY(&shargs)) {
-        struct sharg* sh;
-        int shargc = 0, cnt = 0;
-        LISTP_FOR_EACH_ENTRY(sh, &shargs, list) {
-            shargc++;
-        }
-
-        const char** new_argv = __alloca(sizeof(const char*) * (argc + shargc + 1));
-
-        LISTP_FOR_EACH_ENTRY(sh, &shargs, list) {
-            new_argv[cnt++] = sh->arg;
-        }
-
-        for (cnt = 0; cnt < argc; cnt++)
-            new_argv[shargc + cnt] = argv[cnt];
-
-        new_argv[shargc + argc] = NULL;
-        argv                    = new_argv;
-    }
-
     lock(&cur_thread->lock);
     put_handle(cur_thread->exec);
     cur_thread->exec = exec;
@@ -421,7 +515,8 @@ reopen:
     cur_thread->in_vm     = false;
     unlock(&cur_thread->lock);
 
-    ret = create_process_and_send_checkpoint(&migrate_execve, exec, cur_thread, argv, envp);
+    ret = create_process_and_send_checkpoint(&migrate_execve, exec, /*replace=*/true, cur_thread,
+                                             new_argv, envp);
 
     lock(&cur_thread->lock);
     cur_thread->stack     = stack;
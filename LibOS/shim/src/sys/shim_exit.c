@@ -10,6 +10,7 @@
 #include "pal.h"
 #include "pal_error.h"
 
+#include "shim_fork.h"
 #include "shim_handle.h"
 #include "shim_internal.h"
 #include "shim_ipc.h"
@@ -71,6 +72,7 @@ int thread_destroy(struct shim_thread* thread, bool send_ipc) {
             if (append_signal(parent, &info) >= 0) {
                 thread_wakeup(thread);
                 DkThreadResume(thread->pal_handle);
+                wake_host_futex_waiter(parent);
             }
         }
 
@@ -123,6 +125,9 @@ static noreturn void libos_exit(int error_code, int term_signal) {
 noreturn void thread_exit(int error_code, int term_signal) {
     struct shim_thread* cur_thread = get_cur_thread();
 
+    if (cur_thread->vfork_state)
+        vfork_child_exit(error_code, term_signal);
+
     cur_thread->exit_code = -error_code;
     cur_thread->term_signal = term_signal;
 
@@ -131,10 +136,10 @@ noreturn void thread_exit(int error_code, int term_signal) {
     if (!mark_self_dead()) {
         /* ask Async Helper thread to cleanup this thread */
         cur_thread->clear_child_tid_pal = 1; /* any non-zero value suffices */
-        int64_t ret = install_async_event(NULL, 0, &cleanup_thread, cur_thread);
+        int ret = install_async_event(NULL, &cleanup_thread, cur_thread);
         if (ret < 0) {
             debug("failed to set up async cleanup_thread (exiting without clear child tid),"
-                  " return code: %ld\n", ret);
+                  " return code: %d\n", ret);
             DkThreadExit(NULL);
             /* UNREACHABLE */
         }
@@ -167,6 +172,7 @@ static int mark_thread_to_die(struct shim_thread* thread, void* arg) {
     if (need_wakeup) {
         thread_wakeup(thread);
         DkThreadResume(thread->pal_handle);
+        wake_host_futex_waiter(thread);
     }
     return 1;
 }
@@ -194,6 +200,10 @@ bool kill_other_threads(void) {
 }
 
 noreturn void process_exit(int error_code, int term_signal) {
+    /* a vfork child runs in its parent's process, whose other threads must survive its exit */
+    if (get_cur_thread()->vfork_state)
+        vfork_child_exit(error_code, term_signal);
+
     /* If process_exit is invoked multiple times, only a single invocation proceeds past this
      * point. */
     static int first = 0;
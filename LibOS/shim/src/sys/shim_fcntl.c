@@ -18,6 +18,34 @@
 #include <shim_thread.h>
 #include <shim_utils.h>
 
+/* capacity reported for pipes which are not host pipes (the default of Linux) */
+#define DEFAULT_PIPE_SIZE 65536
+
+/* Gets the capacity of pipe `hdl`, after changing it to at least `size` bytes if `size` is not 0.
+ * Only host pipes (see DkStreamOpenPipe()) can be resized; other pipes are backed by host sockets
+ * and keep reporting DEFAULT_PIPE_SIZE. */
+static int pipe_size(struct shim_handle* hdl, unsigned int size) {
+    if (hdl->type != TYPE_PIPE || !hdl->pal_handle)
+        return -EBADF;
+
+    PAL_STREAM_ATTR attr;
+    if (!DkStreamAttributesQueryByHandle(hdl->pal_handle, &attr))
+        return -PAL_ERRNO();
+
+    if (!attr.pipe.size)
+        return DEFAULT_PIPE_SIZE;
+
+    if (size && size != attr.pipe.size) {
+        attr.pipe.size = size;
+        if (!DkStreamAttributesSetByHandle(hdl->pal_handle, &attr))
+            return -PAL_ERRNO();
+        /* the host rounds the size up */
+        if (!DkStreamAttributesQueryByHandle(hdl->pal_handle, &attr))
+            return -PAL_ERRNO();
+    }
+    return attr.pipe.size;
+}
+
 int shim_do_fcntl(int fd, int cmd, unsigned long arg) {
     struct shim_handle_map* handle_map = get_cur_handle_map(NULL);
     int flags;
@@ -183,6 +211,22 @@ int shim_do_fcntl(int fd, int cmd, unsigned long arg) {
             ret = 0;
             /* XXX: DUMMY for now */
             break;
+
+        /* F_SETPIPE_SZ (int)
+         *   Change the capacity of the pipe referred to by fd to be at least arg bytes. On success,
+         *   the actual capacity is returned.
+         */
+        case F_SETPIPE_SZ:
+            /* a size of 0 is rounded up to the minimal capacity */
+            ret = pipe_size(hdl, (unsigned int)arg ?: 1);
+            break;
+
+        /* F_GETPIPE_SZ (void)
+         *   Return the capacity of the pipe referred to by fd.
+         */
+        case F_GETPIPE_SZ:
+            ret = pipe_size(hdl, 0);
+            break;
     }
 
     put_handle(hdl);
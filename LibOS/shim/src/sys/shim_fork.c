@@ -17,6 +17,7 @@
 #include "pal.h"
 #include "pal_error.h"
 #include "shim_checkpoint.h"
+#include "shim_context.h"
 #include "shim_internal.h"
 #include "shim_ipc.h"
 #include "shim_table.h"
@@ -24,12 +25,15 @@
 
 static BEGIN_MIGRATION_DEF(fork, struct shim_thread* thread, struct shim_process* process) {
     DEFINE_MIGRATE(process, process, sizeof(struct shim_process));
+    DEFINE_MIGRATE(manifest, NULL, 0);
     DEFINE_MIGRATE(all_mounts, NULL, 0);
     DEFINE_MIGRATE(all_vmas, NULL, 0);
+    DEFINE_MIGRATE(all_shm_attaches, NULL, 0);
     DEFINE_MIGRATE(running_thread, thread, sizeof(struct shim_thread));
     DEFINE_MIGRATE(handle_map, thread->handle_map, sizeof(struct shim_handle_map));
     DEFINE_MIGRATE(migratable, NULL, 0);
     DEFINE_MIGRATE(brk, NULL, 0);
+    DEFINE_MIGRATE(loader_cache, NULL, 0);
     DEFINE_MIGRATE(loaded_libraries, NULL, 0);
 #ifdef DEBUG
     DEFINE_MIGRATE(gdb_map, NULL, 0);
@@ -71,7 +75,8 @@ int shim_do_fork(void) {
     add_thread(new_thread);
     set_as_child(cur_thread, new_thread);
 
-    ret = create_process_and_send_checkpoint(&migrate_fork, /*exec=*/NULL, new_thread);
+    ret = create_process_and_send_checkpoint(&migrate_fork, /*exec=*/NULL, /*replace=*/false,
+                                             new_thread);
     if (ret < 0) {
         put_thread(new_thread);
         return ret;
@@ -90,11 +95,162 @@ int shim_do_fork(void) {
     return tid;
 }
 
-/* Instead of trying to support Linux semantics for vfork() -- which requires adding corner-cases in
- * signal handling and syscalls -- we simply treat vfork() as fork(). We assume that performance hit
- * is negligible (Graphene has to migrate internal state anyway which is slow) and apps do not rely
- * on insane Linux-specific semantics of vfork().  */
+/*
+ * vfork() is emulated without a checkpoint: the child runs in this process, on the host thread of
+ * its parent, until it calls execve() or exits. Meanwhile the parent is suspended, as on Linux.
+ *
+ * The child gets its own thread object (with its own TID, handle map, signal handlers, credentials
+ * and working directory), which becomes the current thread of the host thread, so that syscalls
+ * issued by the child between vfork() and execve() (dup2(), sigaction(), chdir(), ...) do not
+ * affect the parent. If the child calls execve(), a new process is created directly from the new
+ * executable, the (non-CLOEXEC) file descriptors and the credentials of the child, without copying
+ * the address space. This is what posix_spawn() and system() do, so spawning a process is much
+ * cheaper than fork() followed by execve().
+ *
+ * When the child execve()s or exits, the host thread switches back to the parent thread object and
+ * resumes the parent's vfork() with the child's TID. The parent's user context is saved in vfork()
+ * because the child may clobber the stack below the parent's stack pointer.
+ */
+struct shim_vfork_state {
+    struct shim_thread* parent;
+    struct shim_regs regs;
+};
+
+int do_vfork(void* child_stack) {
+    int ret;
+
+    if ((ret = prepare_ns_leaders()) < 0)
+        return ret;
+
+    struct shim_thread* cur_thread = get_cur_thread();
+    shim_tcb_t* tcb = shim_get_tcb();
+    assert(tcb->context.regs);
+
+    struct shim_vfork_state* state = malloc(sizeof(*state));
+    if (!state)
+        return -ENOMEM;
+
+    state->parent = cur_thread;
+    state->regs   = *tcb->context.regs;
+
+    struct shim_thread* new_thread = get_new_thread(0);
+    if (!new_thread) {
+        free(state);
+        return -ENOMEM;
+    }
+
+    /* unlike a thread, the child has its own copy of the descriptor table and signal handlers */
+    struct shim_handle_map* handle_map = NULL;
+    if ((ret = dup_handle_map(&handle_map, new_thread->handle_map)) < 0)
+        goto err;
+    set_handle_map(new_thread, handle_map);
+
+    struct shim_signal_handles* signal_handles = dup_signal_handles(new_thread->signal_handles);
+    if (!signal_handles) {
+        ret = -ENOMEM;
+        goto err;
+    }
+    put_signal_handles(new_thread->signal_handles);
+    new_thread->signal_handles = signal_handles;
+
+    if (child_stack) {
+        struct shim_vma_info vma_info;
+        if (lookup_vma(ALLOC_ALIGN_DOWN_PTR(child_stack), &vma_info) < 0) {
+            ret = -EFAULT;
+            goto err;
+        }
+        new_thread->stack_top = (char*)vma_info.addr + vma_info.length;
+        new_thread->stack_red = new_thread->stack = vma_info.addr;
+        if (vma_info.file)
+            put_handle(vma_info.file);
+    }
+
+    new_thread->tgid        = new_thread->tid;
+    new_thread->pal_handle  = cur_thread->pal_handle;
+    new_thread->in_vm       = true;
+    new_thread->is_alive    = true;
+    new_thread->vfork_state = state;
+    add_thread(new_thread);
+    set_as_child(cur_thread, new_thread);
+
+    debug("vfork: child %u runs in place of its parent until execve or exit\n", new_thread->tid);
+    set_cur_thread(new_thread);
+
+    if (child_stack) {
+        /* the child starts on the supplied stack, right after the syscall (see clone()) */
+        struct shim_regs regs = state->regs;
+        fixup_child_context(&regs);
+        shim_regs_set_sp(&regs, (unsigned long)child_stack);
+        tcb->context.regs = &regs;
+        __disable_preempt(tcb);
+        restore_context(&tcb->context);
+    }
+    return 0;
+
+err:
+    put_thread(new_thread);
+    free(state);
+    return ret;
+}
+
+/* Called on the vfork child's last syscall (execve() or exit); switches back to the parent. */
+static noreturn void vfork_resume_parent(struct shim_thread* child) {
+    struct shim_vfork_state* state = child->vfork_state;
+    assert(state && child == get_cur_thread());
+
+    lock(&child->lock);
+    struct shim_handle_map* handle_map = child->handle_map;
+    child->handle_map  = NULL;
+    child->vfork_state = NULL;
+    child->in_vm       = false;
+    child->pal_handle  = NULL;
+    child->shim_tcb    = NULL;
+    child->stack       = NULL;
+    child->stack_top   = NULL;
+    child->stack_red   = NULL;
+    unlock(&child->lock);
+    if (handle_map)
+        put_handle_map(handle_map);
+
+    set_cur_thread(state->parent);
+
+    struct shim_regs regs = state->regs;
+    free(state);
+
+    IDTYPE tid = child->tid;
+    put_thread(child);
+
+    debug("vfork: parent resumes with child %u\n", tid);
+    fixup_resumed_context(&regs);
+    shim_tcb_t* tcb = shim_get_tcb();
+    tcb->context.regs = &regs;
+    __disable_preempt(tcb);
+    restore_context_with_retval(&tcb->context, tid);
+    __builtin_unreachable();
+}
+
+/* The vfork child exits before execve(): it becomes an exited child of the parent, as if it were
+ * a child process which sent its exit notification. */
+noreturn void vfork_child_exit(int error_code, int term_signal) {
+    struct shim_thread* child = get_cur_thread();
+
+    lock(&child->lock);
+    child->exit_code   = error_code;
+    child->term_signal = term_signal;
+    child->in_vm       = false;
+    child->pal_handle  = NULL;
+    unlock(&child->lock);
+
+    thread_destroy(child, /*send_ipc=*/false);
+    vfork_resume_parent(child);
+}
+
+/* The vfork child became a new process in execve(): its thread object now stands for the remote
+ * child process. */
+noreturn void vfork_child_exec_done(void) {
+    vfork_resume_parent(get_cur_thread());
+}
+
 int shim_do_vfork(void) {
-    debug("vfork() was called by the application, implemented as alias to fork() in Graphene\n");
-    return shim_do_fork();
+    return do_vfork(/*child_stack=*/NULL);
 }
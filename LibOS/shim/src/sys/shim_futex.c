@@ -13,6 +13,16 @@
  * Current implementation is limited to one process i.e. threads calling futex syscall on the same
  * futex word must reside in the same process.
  * As a result we can distinguish futexes by their virtual address.
+ *
+ * With "sys.host_futex = 1" in the manifest, process-private futex operations are instead passed
+ * through to the host futex (DkFutexWait() and DkFutexWake()) if the PAL supports it for LibOS
+ * memory, which saves the waiter bookkeeping and the per-thread event of every handoff. Bitsets
+ * and requeues are then approximated by waking up more waiters, which is allowed because futex
+ * waiters have to cope with spurious wakeups anyway. The LibOS still wakes up host waiters on
+ * thread exit (clear_child_tid) and for robust futexes. A signal interrupts a host wait through
+ * DkThreadResume(), but that cannot interrupt a wait which has not started yet, so a waiter
+ * publishes its futex word in `host_futex_uaddr` before checking for pending signals and the
+ * signal sender wakes up that word after appending the signal (see `wake_host_futex_waiter()`).
  */
 
 #include <linux/futex.h>
@@ -24,6 +34,7 @@
 #include "list.h"
 #include "pal.h"
 #include "shim_internal.h"
+#include "shim_signal.h"
 #include "shim_table.h"
 #include "shim_thread.h"
 #include "shim_types.h"
@@ -59,6 +70,9 @@ struct shim_futex {
 static LISTP_TYPE(shim_futex) g_futex_list = LISTP_INIT;
 static spinlock_t g_futex_list_lock = INIT_SPINLOCK_UNLOCKED;
 
+/* process-private futexes are passed through to the host; set by "sys.host_futex" */
+static bool g_host_futex = false;
+
 static void get_futex(struct shim_futex* futex) {
     REF_INC(futex->_ref_count);
 }
@@ -472,21 +486,13 @@ static int wakeop_arg_extend(int x) {
     return x;
 }
 
-static int futex_wake_op(uint32_t* uaddr1, uint32_t* uaddr2, int to_wake1, int to_wake2, uint32_t val3) {
-    struct shim_futex* futex1 = NULL;
-    struct shim_futex* futex2 = NULL;
-    struct wake_queue_head queue = { .first = WAKE_QUEUE_TAIL };
-    int ret = 0;
-    bool needs_dequeue1 = false;
-    bool needs_dequeue2 = false;
-
-    spinlock_lock_signal_off(&g_futex_list_lock);
-    futex1 = find_futex(uaddr1);
-    futex2 = find_futex(uaddr2);
-
-    lock_two_futexes(futex1, futex2);
-    spinlock_unlock_signal_on(&g_futex_list_lock);
-
+/*
+ * Applies the operation encoded in `val3` of FUTEX_WAKE_OP to `*uaddr2`.
+ *
+ * Returns 1 if the comparison encoded in `val3` holds for the old value, 0 if it does not, negative
+ * value on error.
+ */
+static int futex_wake_op_apply(uint32_t* uaddr2, uint32_t val3) {
     unsigned int op = (val3 >> 28) & 0x7; // highest bit is for FUTEX_OP_OPARG_SHIFT
     unsigned int cmp = (val3 >> 24) & 0xf;
     int oparg = wakeop_arg_extend((val3 >> 12) & 0xfff);
@@ -525,8 +531,7 @@ static int futex_wake_op(uint32_t* uaddr1, uint32_t* uaddr2, int to_wake1, int t
             oldval = __atomic_fetch_xor(uaddr2, oparg, __ATOMIC_RELAXED);
             break;
         default:
-            ret = -ENOSYS;
-            goto out_unlock;
+            return -ENOSYS;
     }
 
     switch (cmp) {
@@ -549,10 +554,34 @@ static int futex_wake_op(uint32_t* uaddr1, uint32_t* uaddr2, int to_wake1, int t
             cmpval = oldval >= cmparg;
             break;
         default:
-            ret = -ENOSYS;
-            goto out_unlock;
+            return -ENOSYS;
     }
 
+    return cmpval;
+}
+
+static int futex_wake_op(uint32_t* uaddr1, uint32_t* uaddr2, int to_wake1, int to_wake2, uint32_t val3) {
+    struct shim_futex* futex1 = NULL;
+    struct shim_futex* futex2 = NULL;
+    struct wake_queue_head queue = { .first = WAKE_QUEUE_TAIL };
+    int ret = 0;
+    bool needs_dequeue1 = false;
+    bool needs_dequeue2 = false;
+
+    spinlock_lock_signal_off(&g_futex_list_lock);
+    futex1 = find_futex(uaddr1);
+    futex2 = find_futex(uaddr2);
+
+    lock_two_futexes(futex1, futex2);
+    spinlock_unlock_signal_on(&g_futex_list_lock);
+
+    ret = futex_wake_op_apply(uaddr2, val3);
+    if (ret < 0) {
+        goto out_unlock;
+    }
+    bool cmpval = ret;
+    ret = 0;
+
     if (futex1) {
         ret += move_to_wake_queue(futex1, 0, to_wake1, &queue);
         needs_dequeue1 = check_dequeue_futex(futex1);
@@ -679,6 +708,167 @@ out_unlock:
     return ret;
 }
 
+static bool has_unblocked_signal(struct shim_thread* thread) {
+    if (__atomic_load_n(&thread->time_to_die, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+
+    __sigset_t pending;
+    get_pending_signals(thread, &pending);
+
+    for (int sig = 1; sig <= NUM_SIGS; sig++) {
+        if (__sigismember(&pending, sig) && !__sigismember(&thread->signal_mask, sig)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Waits on the host futex. Host waiters have no bitset, they are woken up by any wake.
+ * Like `futex_wait`, returns 0 if woken up by a signal.
+ */
+static int host_futex_wait(uint32_t* uaddr, uint32_t val, uint64_t timeout, uint32_t bitset) {
+    struct shim_thread* cur_thread = get_cur_thread();
+    int ret = 0;
+
+    if (!bitset) {
+        return -EINVAL;
+    }
+
+    if (__atomic_load_n(uaddr, __ATOMIC_RELAXED) != val) {
+        return -EAGAIN;
+    }
+
+    /* Pairs with `wake_host_futex_waiter()`: either we see the signal appended by the sender or
+     * the sender sees `uaddr` and wakes it up until this wait is over. */
+    __atomic_add_fetch(&cur_thread->host_futex_waits, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&cur_thread->host_futex_uaddr, uaddr, __ATOMIC_SEQ_CST);
+
+    if (has_unblocked_signal(cur_thread)) {
+        goto out;
+    }
+
+    if (!DkFutexWait(uaddr, val, timeout, PAL_FUTEX_PRIVATE)) {
+        switch (PAL_NATIVE_ERRNO()) {
+            case PAL_ERROR_TRYAGAIN:
+                ret = -ETIMEDOUT;
+                break;
+            case PAL_ERROR_INTERRUPTED:
+                break;
+            default:
+                ret = -PAL_ERRNO();
+                break;
+        }
+    }
+
+out:
+    __atomic_store_n(&cur_thread->host_futex_uaddr, NULL, __ATOMIC_RELEASE);
+    return ret;
+}
+
+/*
+ * Called by signal senders after appending a signal to `thread` (or to the process on behalf of
+ * `thread`) and kicking it with DkThreadResume(), which does not interrupt a host futex wait that
+ * has not started yet. Wakes up the futex word published by `thread` until the host futex wait
+ * which published it is over. Waiters have to cope with the spurious wakeups of other waiters
+ * on the same word.
+ */
+void wake_host_futex_waiter(struct shim_thread* thread) {
+    if (thread == get_cur_thread()) {
+        return;
+    }
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    uint32_t* uaddr = __atomic_load_n(&thread->host_futex_uaddr, __ATOMIC_SEQ_CST);
+    if (!uaddr) {
+        /* the waiter has not published its futex word yet, so it will see the signal */
+        return;
+    }
+
+    uint64_t waits = __atomic_load_n(&thread->host_futex_waits, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&thread->host_futex_uaddr, __ATOMIC_ACQUIRE) == uaddr
+            && __atomic_load_n(&thread->host_futex_waits, __ATOMIC_RELAXED) == waits) {
+        DkFutexWake(uaddr, INT32_MAX, PAL_FUTEX_PRIVATE, /*woken=*/NULL);
+        DkThreadYieldExecution();
+    }
+}
+
+static int host_futex_wake(uint32_t* uaddr, int to_wake, uint32_t bitset) {
+    PAL_NUM woken = 0;
+
+    if (!bitset) {
+        return -EINVAL;
+    }
+
+    /* host waiters have no bitset, so a wake for some of them has to wake up all of them */
+    if (bitset != FUTEX_BITSET_MATCH_ANY) {
+        to_wake = INT32_MAX;
+    }
+
+    /* If to_wake is 0, the Linux kernel still wakes up one thread - so we do the same here. */
+    if (!DkFutexWake(uaddr, to_wake > 0 ? to_wake : 1, PAL_FUTEX_PRIVATE, &woken)) {
+        return -PAL_ERRNO();
+    }
+    return woken;
+}
+
+static int host_futex_wake_op(uint32_t* uaddr1, uint32_t* uaddr2, int to_wake1, int to_wake2,
+                              uint32_t val3) {
+    int ret = futex_wake_op_apply(uaddr2, val3);
+    if (ret < 0) {
+        return ret;
+    }
+    bool cmpval = ret;
+
+    ret = host_futex_wake(uaddr1, to_wake1, FUTEX_BITSET_MATCH_ANY);
+    if (ret < 0 || !cmpval) {
+        return ret;
+    }
+
+    int ret2 = host_futex_wake(uaddr2, to_wake2, FUTEX_BITSET_MATCH_ANY);
+    return ret2 < 0 ? ret2 : ret + ret2;
+}
+
+/*
+ * Host waiters cannot be moved to another futex word, so the waiters to be requeued are woken up
+ * instead; they will wait on the other word after re-checking their condition.
+ */
+static int host_futex_requeue(uint32_t* uaddr1, int to_wake, int to_requeue, uint32_t* val) {
+    PAL_NUM woken = 0;
+
+    if (to_wake < 0 || to_requeue < 0) {
+        return -EINVAL;
+    }
+
+    if (val != NULL) {
+        if (__atomic_load_n(uaddr1, __ATOMIC_RELAXED) != *val) {
+            return -EAGAIN;
+        }
+    }
+
+    int64_t to_wake_all = (int64_t)to_wake + to_requeue;
+    if (!to_wake_all) {
+        return 0;
+    }
+
+    if (!DkFutexWake(uaddr1, MIN(to_wake_all, INT32_MAX), PAL_FUTEX_PRIVATE, &woken)) {
+        return -PAL_ERRNO();
+    }
+    return woken;
+}
+
+/*
+ * Wakes up waiters on behalf of the LibOS itself (thread exit, robust futexes), which cannot know
+ * whether they wait in the LibOS or in the host.
+ */
+static void futex_wake_any(uint32_t* uaddr, int to_wake) {
+    futex_wake(uaddr, to_wake, FUTEX_BITSET_MATCH_ANY);
+    if (g_host_futex) {
+        (void)host_futex_wake(uaddr, to_wake, FUTEX_BITSET_MATCH_ANY);
+    }
+}
+
 #define FUTEX_CHECK_READ false
 #define FUTEX_CHECK_WRITE true
 static int is_valid_futex_ptr(uint32_t* ptr, bool check_write) {
@@ -734,6 +924,8 @@ static int _shim_do_futex(uint32_t* uaddr, int op, uint32_t val, void* utime, ui
         debug("Non-private futexes are not supported, assuming implicit FUTEX_PRIVATE_FLAG\n");
     }
 
+    bool host = g_host_futex && (op & FUTEX_PRIVATE_FLAG);
+
     int ret = 0;
 
     /* `uaddr` should be valid pointer in all cases. */
@@ -747,29 +939,44 @@ static int _shim_do_futex(uint32_t* uaddr, int op, uint32_t val, void* utime, ui
             val3 = FUTEX_BITSET_MATCH_ANY;
             /* fallthrough */
         case FUTEX_WAIT_BITSET:
+            if (host) {
+                return host_futex_wait(uaddr, val, timeout, val3);
+            }
             return futex_wait(uaddr, val, timeout, val3);
         case FUTEX_WAKE:
             val3 = FUTEX_BITSET_MATCH_ANY;
             /* fallthrough */
         case FUTEX_WAKE_BITSET:
+            if (host) {
+                return host_futex_wake(uaddr, val, val3);
+            }
             return futex_wake(uaddr, val, val3);
         case FUTEX_WAKE_OP:
             ret = is_valid_futex_ptr(uaddr2, FUTEX_CHECK_WRITE);
             if (ret) {
                 return ret;
             }
+            if (host) {
+                return host_futex_wake_op(uaddr, uaddr2, val, val2, val3);
+            }
             return futex_wake_op(uaddr, uaddr2, val, val2, val3);
         case FUTEX_REQUEUE:
             ret = is_valid_futex_ptr(uaddr2, FUTEX_CHECK_READ);
             if (ret) {
                 return ret;
             }
+            if (host) {
+                return host_futex_requeue(uaddr, val, val2, NULL);
+            }
             return futex_requeue(uaddr, uaddr2, val, val2, NULL);
         case FUTEX_CMP_REQUEUE:
             ret = is_valid_futex_ptr(uaddr2, FUTEX_CHECK_READ);
             if (ret) {
                 return ret;
             }
+            if (host) {
+                return host_futex_requeue(uaddr, val, val2, &val3);
+            }
             return futex_requeue(uaddr, uaddr2, val, val2, &val3);
         case FUTEX_LOCK_PI:
         case FUTEX_TRYLOCK_PI:
@@ -861,7 +1068,7 @@ static bool handle_futex_death(uint32_t* uaddr) {
 
     if (val & FUTEX_WAITERS) {
         /* There are waiters present, wake one of them. */
-        futex_wake(uaddr, 1, FUTEX_BITSET_MATCH_ANY);
+        futex_wake_any(uaddr, 1);
     }
 
     return 0;
@@ -948,5 +1155,24 @@ void release_clear_child_tid(int* clear_child_tid) {
 
     /* child thread exited, now parent can wake up */
     __atomic_store_n(clear_child_tid, 0, __ATOMIC_RELAXED);
-    futex_wake((uint32_t*)clear_child_tid, 1, FUTEX_BITSET_MATCH_ANY);
+    futex_wake_any((uint32_t*)clear_child_tid, 1);
+}
+
+int init_futex(void) {
+    char cfg[2];
+
+    if (!root_config || get_config(root_config, "sys.host_futex", cfg, sizeof(cfg)) != 1 ||
+            cfg[0] != '1') {
+        return 0;
+    }
+
+    /* the PAL may be unable to hand LibOS memory to the host futex (e.g. enclave memory on SGX) */
+    static uint32_t probe = 0;
+    if (!DkFutexWake(&probe, 1, PAL_FUTEX_PRIVATE, /*woken=*/NULL)) {
+        debug("Host futexes are not supported by this PAL, ignoring sys.host_futex\n");
+        return 0;
+    }
+
+    g_host_futex = true;
+    return 0;
 }
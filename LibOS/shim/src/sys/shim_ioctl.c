@@ -342,7 +342,7 @@ int shim_do_ioctl(int fd, unsigned long cmd, unsigned long arg) {
             ret = 0;
             break;
         case FIOASYNC:
-            ret = install_async_event(hdl->pal_handle, 0, &signal_io,
+            ret = install_async_event(hdl->pal_handle, &signal_io,
                                       (void*)(uintptr_t)get_cur_thread()->tgid);
             break;
         case TIOCSERCONFIG:
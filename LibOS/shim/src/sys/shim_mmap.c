@@ -6,7 +6,7 @@
 /*
  * shim_mmap.c
  *
- * Implementation of system calls "mmap", "munmap" and "mprotect".
+ * Implementation of system calls "mmap", "munmap", "mprotect", "mremap" and "madvise".
  */
 
 #include <errno.h>
@@ -46,6 +46,37 @@
                        | MAP_HUGE_2MB           \
                        | MAP_HUGE_1GB)
 
+#define HUGE_PAGE_SIZE_2M (2UL << 20)
+#define HUGE_PAGE_SIZE_1G (1UL << 30)
+
+/* private anonymous mappings of at least this size are advised to use transparent huge pages
+ * (0 means never); set by "sys.transparent_hugepage.min_size" in the manifest */
+static size_t thp_min_size = 0;
+
+int init_mmap(void) {
+    char cfg[CONFIG_MAX];
+
+    if (root_config && get_config(root_config, "sys.transparent_hugepage.min_size", cfg,
+                                  sizeof(cfg)) > 0)
+        thp_min_size = ALLOC_ALIGN_UP(parse_int(cfg));
+    return 0;
+}
+
+/* Returns the huge page size requested by MAP_HUGETLB and the MAP_HUGE_* bits of `flags`, or 0 if
+ * the size is not supported. */
+static size_t get_huge_page_size(int flags) {
+    switch ((flags >> MAP_HUGE_SHIFT) & MAP_HUGE_MASK) {
+        case 0:
+            /* host default size, which is 2MB on x86-64 */
+        case MAP_HUGE_2MB >> MAP_HUGE_SHIFT:
+            return HUGE_PAGE_SIZE_2M;
+        case MAP_HUGE_1GB >> MAP_HUGE_SHIFT:
+            return HUGE_PAGE_SIZE_1G;
+        default:
+            return 0;
+    }
+}
+
 void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset) {
     struct shim_handle* hdl = NULL;
     long ret                = 0;
@@ -66,14 +97,39 @@ void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t
     if (!IS_ALLOC_ALIGNED(length))
         length = ALLOC_ALIGN_UP(length);
 
+    /* The huge page size bits overlap with VMA_* flags, so they are decoded and cleared before the
+     * check below. As on Linux, MAP_HUGETLB is ignored for file mappings. */
+    size_t huge_page_size = 0;
+    if ((flags & (MAP_HUGETLB | MAP_ANONYMOUS)) == (MAP_HUGETLB | MAP_ANONYMOUS)) {
+        huge_page_size = get_huge_page_size(flags);
+        if (!huge_page_size)
+            return (void*)-EINVAL;
+        if ((flags & (MAP_FIXED | MAP_FIXED_NOREPLACE)) &&
+                !IS_ALIGNED_PTR_POW2(addr, huge_page_size))
+            return (void*)-EINVAL;
+        length = ALIGN_UP_POW2(length, huge_page_size);
+    }
+    if (flags & MAP_HUGETLB) {
+        flags &= ~(int)((unsigned int)MAP_HUGE_MASK << MAP_HUGE_SHIFT);
+        if (!huge_page_size)
+            flags &= ~MAP_HUGETLB;
+    }
+
     if (!length || !access_ok(addr, length))
         return (void*)-EINVAL;
 
     /* This check is Graphene specific. */
-    if (flags & (VMA_UNMAPPED | VMA_TAINTED | VMA_INTERNAL)) {
+    if (flags & (VMA_UNMAPPED | VMA_TAINTED | VMA_INTERNAL | VMA_DONTFORK | VMA_HUGEPAGE_1G
+                 | VMA_THP)) {
         return (void*)-EINVAL;
     }
 
+    if (huge_page_size == HUGE_PAGE_SIZE_1G)
+        flags |= VMA_HUGEPAGE_1G;
+    if (thp_min_size && length >= thp_min_size && !huge_page_size &&
+            (flags & (MAP_ANONYMOUS | MAP_TYPE)) == (MAP_ANONYMOUS | MAP_PRIVATE))
+        flags |= VMA_THP;
+
     if (flags & MAP_ANONYMOUS) {
         switch (flags & MAP_TYPE) {
             case MAP_SHARED:
@@ -143,8 +199,15 @@ void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t
             goto out_handle;
         }
     } else {
+        /* Huge pages need an address aligned at the huge page size, so a bigger area is bookkept
+         * and its unaligned head and tail are released below. */
+        size_t bkeep_length = length;
+        if (huge_page_size)
+            bkeep_length += huge_page_size - g_pal_alloc_align;
+
         /* We know that `addr + length` does not overflow (`access_ok` above). */
-        if (addr && ((uintptr_t)addr + length <= (uintptr_t)PAL_CB(user_address.end))) {
+        if (addr && ((uintptr_t)addr + length <= (uintptr_t)PAL_CB(user_address.end))
+                && bkeep_length == length) {
             ret = bkeep_mmap_any_in_range(PAL_CB(user_address.start), (char*)addr + length, length,
                                           prot, flags, hdl, offset, NULL, &addr);
         } else {
@@ -153,18 +216,38 @@ void* shim_do_mmap(void* addr, size_t length, int prot, int flags, int fd, off_t
         }
         if (ret < 0) {
             /* We either had no hinted address or could not allocate memory at it. */
-            ret = bkeep_mmap_any_aslr(length, prot, flags, hdl, offset, NULL, &addr);
+            ret = bkeep_mmap_any_aslr(bkeep_length, prot, flags, hdl, offset, NULL, &addr);
         }
         if (ret < 0) {
             ret = -ENOMEM;
             goto out_handle;
         }
+
+        if (bkeep_length != length) {
+            char* area_end = (char*)addr + bkeep_length;
+            void* aligned_addr = ALIGN_UP_PTR_POW2(addr, huge_page_size);
+            void* tmp_vma = NULL;
+            if (aligned_addr != addr) {
+                if (bkeep_munmap(addr, (char*)aligned_addr - (char*)addr, /*is_internal=*/false,
+                                 &tmp_vma) < 0)
+                    BUG();
+                bkeep_remove_tmp_vma(tmp_vma);
+            }
+            addr = aligned_addr;
+            if ((char*)addr + length != area_end) {
+                if (bkeep_munmap((char*)addr + length, area_end - ((char*)addr + length),
+                                 /*is_internal=*/false, &tmp_vma) < 0)
+                    BUG();
+                bkeep_remove_tmp_vma(tmp_vma);
+            }
+        }
     }
 
     /* From now on `addr` contains the actual address we want to map (and already bookkeeped). */
 
     if (!hdl) {
-        if (DkVirtualMemoryAlloc(addr, length, 0, LINUX_PROT_TO_PAL(prot, flags)) != addr) {
+        if (DkVirtualMemoryAlloc(addr, length, VMA_FLAGS_TO_PAL_ALLOC(flags),
+                                 LINUX_PROT_TO_PAL(prot, flags)) != addr) {
             if (PAL_NATIVE_ERRNO() == PAL_ERROR_DENIED) {
                 ret = -EPERM;
             } else {
@@ -289,6 +372,283 @@ int shim_do_munmap(void* addr, size_t length) {
     return 0;
 }
 
+/* Maps [`addr`, `addr` + `length`) the same way as the vma described by `vma_info`; `offset` is the
+ * file offset of `addr`. Used for the part of a vma which grows during mremap(). */
+static int mremap_map_range(struct shim_vma_info* vma_info, void* addr, size_t length,
+                            off_t offset) {
+    struct shim_handle* hdl = vma_info->file;
+
+    if (!hdl) {
+        if (DkVirtualMemoryAlloc(addr, length, VMA_FLAGS_TO_PAL_ALLOC(vma_info->flags),
+                                 LINUX_PROT_TO_PAL(vma_info->prot, vma_info->flags)) != addr) {
+            return PAL_NATIVE_ERRNO() == PAL_ERROR_DENIED ? -EPERM : -PAL_ERRNO();
+        }
+        return 0;
+    }
+
+    if (!hdl->fs || !hdl->fs->fs_ops || !hdl->fs->fs_ops->mmap)
+        return -ENODEV;
+
+    void* ret_addr = addr;
+    int flags = (vma_info->flags & ~(VMA_UNMAPPED | VMA_INTERNAL | VMA_TAINTED)) | MAP_FIXED;
+    int ret = hdl->fs->fs_ops->mmap(hdl, &ret_addr, length, vma_info->prot, flags, offset);
+    if (ret_addr != addr) {
+        debug("Requested address (%p) differs from allocated (%p)!\n", addr, ret_addr);
+        BUG();
+    }
+    return ret;
+}
+
+/* Moves the memory of [`old_addr`, `old_addr` + `old_len`) to `new_addr`. The PAL moves the pages
+ * without copying them; if it cannot do that (e.g. enclave memory), the contents are copied. */
+static int mremap_move(struct shim_vma_info* vma_info, void* old_addr, size_t old_len,
+                       void* new_addr, size_t new_len, off_t offset) {
+    if (DkVirtualMemoryMove(old_addr, old_len, new_addr, new_len))
+        return 0;
+
+    if (PAL_NATIVE_ERRNO() != PAL_ERROR_NOTIMPLEMENTED)
+        return -PAL_ERRNO();
+
+    size_t copy_len = old_len < new_len ? old_len : new_len;
+    int pal_prot = LINUX_PROT_TO_PAL(vma_info->prot, vma_info->flags);
+
+    if (DkVirtualMemoryAlloc(new_addr, copy_len, 0, PAL_PROT_READ | PAL_PROT_WRITE) != new_addr)
+        return -PAL_ERRNO();
+
+    if (!(vma_info->prot & PROT_READ))
+        DkVirtualMemoryProtect(old_addr, copy_len, PAL_PROT_READ);
+
+    memcpy(new_addr, old_addr, copy_len);
+
+    if (!DkVirtualMemoryProtect(new_addr, copy_len, pal_prot)) {
+        DkVirtualMemoryFree(new_addr, copy_len);
+        return -PAL_ERRNO();
+    }
+
+    if (new_len > old_len) {
+        int ret = mremap_map_range(vma_info, (char*)new_addr + old_len, new_len - old_len,
+                                   offset + old_len);
+        if (ret < 0) {
+            DkVirtualMemoryFree(new_addr, copy_len);
+            return ret;
+        }
+    }
+
+    DkVirtualMemoryFree(old_addr, old_len);
+    return 0;
+}
+
+void* shim_do_mremap(void* old_addr, size_t old_len, size_t new_len, int flags, void* new_addr) {
+    if (flags & ~(MREMAP_MAYMOVE | MREMAP_FIXED))
+        return (void*)-EINVAL;
+
+    if ((flags & MREMAP_FIXED) && !(flags & MREMAP_MAYMOVE))
+        return (void*)-EINVAL;
+
+    if (!IS_ALLOC_ALIGNED_PTR(old_addr))
+        return (void*)-EINVAL;
+
+    old_len = ALLOC_ALIGN_UP(old_len);
+    new_len = ALLOC_ALIGN_UP(new_len);
+
+    /* `old_len` == 0 asks for a second mapping of a shared mapping, which we do not support. */
+    if (!old_len || !new_len || !access_ok(old_addr, old_len))
+        return (void*)-EINVAL;
+
+    if (flags & MREMAP_FIXED) {
+        if (!IS_ALLOC_ALIGNED_PTR(new_addr) || !access_ok(new_addr, new_len))
+            return (void*)-EINVAL;
+
+        if (new_addr < PAL_CB(user_address.start)
+                || (uintptr_t)PAL_CB(user_address.end) < (uintptr_t)new_addr + new_len)
+            return (void*)-EINVAL;
+
+        if ((char*)old_addr < (char*)new_addr + new_len
+                && (char*)new_addr < (char*)old_addr + old_len)
+            return (void*)-EINVAL;
+    }
+
+    struct shim_vma_info vma_info;
+    if (lookup_vma(old_addr, &vma_info) < 0)
+        return (void*)-EFAULT;
+
+    long ret = 0;
+    void* tmp_vma = NULL;
+
+    /* The old range must lie within a single user vma. */
+    if ((vma_info.flags & (VMA_INTERNAL | VMA_UNMAPPED))
+            || (char*)vma_info.addr + vma_info.length < (char*)old_addr + old_len) {
+        ret = -EFAULT;
+        goto out;
+    }
+
+    /* SysV shared memory is attached with its size fixed at shmget(); like Linux, we do not resize
+     * huge page mappings either */
+    if ((vma_info.file && vma_info.file->type == TYPE_SHM) || (vma_info.flags & MAP_HUGETLB)) {
+        ret = -EINVAL;
+        goto out;
+    }
+
+    off_t offset = vma_info.file
+                   ? vma_info.file_offset + ((char*)old_addr - (char*)vma_info.addr)
+                   : 0;
+
+    if (!(flags & MREMAP_FIXED)) {
+        if (new_len <= old_len) {
+            if (new_len < old_len)
+                ret = shim_do_munmap((char*)old_addr + new_len, old_len - new_len);
+            new_addr = old_addr;
+            goto out;
+        }
+
+        /* Try to grow in place first. */
+        if ((uintptr_t)old_addr + new_len <= (uintptr_t)PAL_CB(user_address.end)) {
+            ret = bkeep_mremap_extend(old_addr, old_len, new_len);
+            if (ret == 0) {
+                ret = mremap_map_range(&vma_info, (char*)old_addr + old_len, new_len - old_len,
+                                       offset + old_len);
+                if (ret < 0) {
+                    if (bkeep_munmap((char*)old_addr + old_len, new_len - old_len,
+                                     /*is_internal=*/false, &tmp_vma) < 0) {
+                        debug("[mremap] Failed to remove bookkeeped memory that was not allocated "
+                              "at %p-%p!\n", (char*)old_addr + old_len, (char*)old_addr + new_len);
+                        BUG();
+                    }
+                    bkeep_remove_tmp_vma(tmp_vma);
+                }
+                new_addr = old_addr;
+                goto out;
+            }
+            if (ret != -ENOMEM)
+                goto out;
+        }
+
+        if (!(flags & MREMAP_MAYMOVE)) {
+            ret = -ENOMEM;
+            goto out;
+        }
+
+        ret = bkeep_mmap_any_aslr(new_len, vma_info.prot, vma_info.flags, vma_info.file, offset,
+                                  vma_info.comment, &new_addr);
+        if (ret < 0) {
+            ret = -ENOMEM;
+            goto out;
+        }
+    } else {
+        ret = bkeep_mmap_fixed(new_addr, new_len, vma_info.prot, vma_info.flags | MAP_FIXED,
+                               vma_info.file, offset, vma_info.comment);
+        if (ret < 0)
+            goto out;
+    }
+
+    /* From now on `new_addr` is bookkeeped; move the pages there and drop the old range. */
+    ret = mremap_move(&vma_info, old_addr, old_len, new_addr, new_len, offset);
+    if (ret < 0) {
+        if (bkeep_munmap(new_addr, new_len, /*is_internal=*/false, &tmp_vma) < 0) {
+            debug("[mremap] Failed to remove bookkeeped memory that was not allocated at %p-%p!\n",
+                  new_addr, (char*)new_addr + new_len);
+            BUG();
+        }
+        bkeep_remove_tmp_vma(tmp_vma);
+        goto out;
+    }
+
+    if (bkeep_munmap(old_addr, old_len, /*is_internal=*/false, &tmp_vma) < 0) {
+        debug("[mremap] Failed to remove bookkeeping of moved memory at %p-%p!\n", old_addr,
+              (char*)old_addr + old_len);
+        BUG();
+    }
+    bkeep_remove_tmp_vma(tmp_vma);
+
+out:
+    if (vma_info.file)
+        put_handle(vma_info.file);
+
+    if (ret < 0)
+        return (void*)ret;
+    return new_addr;
+}
+
+/* Discards the contents of user memory in [`addr`, `addr` + `length`), vma by vma. */
+static int madvise_discard(void* addr, size_t length) {
+    char* cur = addr;
+    char* end = (char*)addr + length;
+
+    while (cur < end) {
+        struct shim_vma_info vma_info;
+        if (lookup_vma(cur, &vma_info) < 0)
+            return -ENOMEM;
+
+        char* vma_end = (char*)vma_info.addr + vma_info.length;
+        size_t size = (vma_end < end ? vma_end : end) - cur;
+        int ret = 0;
+
+        if (!DkVirtualMemoryDiscard(cur, size)) {
+            if (PAL_NATIVE_ERRNO() != PAL_ERROR_NOTIMPLEMENTED) {
+                ret = -PAL_ERRNO();
+            } else if (!vma_info.file && (vma_info.flags & MAP_PRIVATE)
+                           && (vma_info.prot & PROT_WRITE)) {
+                /* The PAL cannot give the memory back (e.g. enclave memory), but private anonymous
+                 * memory still has to read as zeros afterwards. */
+                memset(cur, 0, size);
+            }
+        }
+
+        if (vma_info.file)
+            put_handle(vma_info.file);
+        if (ret < 0)
+            return ret;
+        cur += size;
+    }
+    return 0;
+}
+
+int shim_do_madvise(void* start, size_t len, int behavior) {
+    if (!IS_ALLOC_ALIGNED_PTR(start))
+        return -EINVAL;
+
+    if (!IS_ALLOC_ALIGNED(len))
+        len = ALLOC_ALIGN_UP(len);
+
+    if (!access_ok(start, len))
+        return -EINVAL;
+
+    switch (behavior) {
+        case MADV_NORMAL:
+        case MADV_RANDOM:
+        case MADV_SEQUENTIAL:
+        case MADV_WILLNEED:
+        case MADV_DONTNEED:
+        case MADV_FREE:
+        case MADV_DONTFORK:
+        case MADV_DOFORK:
+        case MADV_HUGEPAGE:
+        case MADV_NOHUGEPAGE:
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    if (!len)
+        return 0;
+
+    if (!is_in_adjacent_user_vmas(start, len))
+        return -ENOMEM;
+
+    switch (behavior) {
+        case MADV_DONTNEED:
+        case MADV_FREE:
+            /* Discarding immediately is a valid implementation of the lazy MADV_FREE. */
+            return madvise_discard(start, len);
+        case MADV_DONTFORK:
+        case MADV_DOFORK:
+            return bkeep_madvise_dontfork(start, len, behavior == MADV_DONTFORK);
+        default:
+            /* Access-pattern and huge-page hints; the host decides on its own. */
+            return 0;
+    }
+}
+
 /* This emulation of mincore() always tells that pages are _NOT_ in RAM
  * pessimistically due to lack of a good way to know it.
  * Possibly it may cause performance(or other) issue due to this lying.
@@ -0,0 +1,1046 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_mqueue.c
+ *
+ * Implementation of system calls "mq_open", "mq_unlink", "mq_timedsend", "mq_timedreceive",
+ * "mq_notify" and "mq_getsetattr" (POSIX message queues).
+ *
+ * A queue lives in a host shared-memory object (a file in /dev/shm) which every process that opens
+ * the queue maps with MAP_SHARED. The object holds a header protected by a spinlock, a binary heap
+ * of message slots ordered by priority (and by arrival for equal priorities) and the slots
+ * themselves, so sending and receiving copy each message exactly once and involve no IPC. Blocked
+ * senders and receivers sleep on futex words in the header (see DkFutexWait()).
+ *
+ * The PAL handle of a descriptor is a LibOS event which is readable while the queue is not empty,
+ * so descriptors can be waited on by poll(), select() and epoll. Every process that opened the
+ * queue has a slot in the header; when the queue becomes empty or non-empty, the process that
+ * caused it sends one IPC message to each other process which waits on a readable descriptor of the
+ * queue and has not been told yet, and those update the events of their descriptors. mq_notify()
+ * registrations are kept in the header and delivered the same way.
+ *
+ * Limitations: descriptors are always reported writable, as the event is a pipe; SIGEV_THREAD
+ * notifications (which glibc implements with a netlink socket) are not supported; at most
+ * MQ_MAX_OPENERS processes can have the same queue open; permission bits are stored but not
+ * checked. Message queues are not supported on SGX, where host objects cannot be mapped shared and
+ * writable into the enclave, so mq_open() fails there.
+ */
+
+#include <errno.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_ipc.h>
+#include <shim_ipc_sysv.h>
+#include <shim_signal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+#include <shim_vma.h>
+#include <spinlock.h>
+
+#ifndef NAME_MAX
+#define NAME_MAX 255
+#endif
+
+#define MQ_URI_PREFIX "file:/dev/shm/graphene_mq_"
+#define MQ_URI_LEN    (sizeof(MQ_URI_PREFIX) + 12 + NAME_MAX)
+
+#define MQ_MAGIC 0x4d515545 /* "MQUE" */
+
+/* same defaults and hard limits as Linux */
+#define MQ_DEFAULT_MAXMSG  10
+#define MQ_DEFAULT_MSGSIZE 8192
+#define MQ_MAXMSG_MAX      65536
+#define MQ_MSGSIZE_MAX     (16 * 1024 * 1024)
+#define MQ_PRIO_MAX        32768
+
+#define MQ_MAX_OPENERS 64
+#define MQ_NO_SLOT     UINT32_MAX
+
+/* how often to check whether a queue created by another process is initialized */
+#define MQ_OPEN_RETRIES 1000
+
+struct mq_opener {
+    IDTYPE pid;
+    uint32_t refcount;   /* number of descriptors of the queue in the process, 0 if slot is free */
+    uint32_t want_ready; /* whether the process wants to hear about the next change of emptiness */
+};
+
+struct mq_shared_hdr {
+    uint32_t magic;        /* set by the creator once the header is initialized */
+    spinlock_t lock;
+    uint32_t maxmsg;
+    uint32_t msgsize;
+    uint32_t mode;
+    uint32_t curmsgs;      /* size of `heap` */
+    uint32_t free_slot;    /* first free message slot, MQ_NO_SLOT if the queue is full */
+    uint64_t seq;          /* sequence number of the next message */
+    uint32_t recv_futex;   /* bumped on every send */
+    uint32_t send_futex;   /* bumped on every receive */
+    uint32_t recv_waiters;
+    uint32_t send_waiters;
+    IDTYPE notify_pid;     /* process registered with mq_notify(), 0 if none */
+    struct mq_opener openers[MQ_MAX_OPENERS];
+    uint32_t heap[];       /* `maxmsg` slot indices, followed by the slots */
+};
+
+struct mq_msg {
+    uint64_t seq;
+    uint32_t prio;
+    uint32_t len;
+    uint32_t next_free;
+    char data[];
+};
+
+#define MQ_TO_HANDLE(mqhdl) container_of((mqhdl), struct shim_handle, info.mqueue)
+
+/* Message queues opened in this process. The list does not hold references; a handle removes
+ * itself on close. Lock order: g_mq_list_lock, handle lock, queue lock. */
+DEFINE_LISTP(shim_mqueue_handle);
+static LISTP_TYPE(shim_mqueue_handle) g_mq_list;
+static struct shim_lock g_mq_list_lock;
+
+static size_t mq_slots_offset(uint32_t maxmsg) {
+    return ALIGN_UP(sizeof(struct mq_shared_hdr) + maxmsg * sizeof(uint32_t), 8);
+}
+
+static size_t mq_slot_size(uint32_t msgsize) {
+    return ALIGN_UP(sizeof(struct mq_msg) + msgsize, 8);
+}
+
+static size_t mq_map_size(uint32_t maxmsg, uint32_t msgsize) {
+    return ALLOC_ALIGN_UP(mq_slots_offset(maxmsg) + maxmsg * mq_slot_size(msgsize));
+}
+
+static struct mq_msg* mq_slot(struct mq_shared_hdr* hdr, uint32_t idx) {
+    return (void*)hdr + mq_slots_offset(hdr->maxmsg) + idx * mq_slot_size(hdr->msgsize);
+}
+
+/* whether message slot `a` has to be received before `b` */
+static bool mq_before(struct mq_shared_hdr* hdr, uint32_t a, uint32_t b) {
+    struct mq_msg* ma = mq_slot(hdr, a);
+    struct mq_msg* mb = mq_slot(hdr, b);
+    return ma->prio > mb->prio || (ma->prio == mb->prio && ma->seq < mb->seq);
+}
+
+static void mq_heap_push(struct mq_shared_hdr* hdr, uint32_t idx) {
+    uint32_t i = hdr->curmsgs;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!mq_before(hdr, idx, hdr->heap[parent]))
+            break;
+        hdr->heap[i] = hdr->heap[parent];
+        i = parent;
+    }
+    hdr->heap[i] = idx;
+    __atomic_store_n(&hdr->curmsgs, hdr->curmsgs + 1, __ATOMIC_SEQ_CST);
+}
+
+static uint32_t mq_heap_pop(struct mq_shared_hdr* hdr) {
+    assert(hdr->curmsgs > 0);
+    uint32_t top  = hdr->heap[0];
+    uint32_t n    = hdr->curmsgs - 1;
+    uint32_t last = hdr->heap[n];
+
+    uint32_t i = 0;
+    while (2 * i + 1 < n) {
+        uint32_t child = 2 * i + 1;
+        if (child + 1 < n && mq_before(hdr, hdr->heap[child + 1], hdr->heap[child]))
+            child++;
+        if (!mq_before(hdr, hdr->heap[child], last))
+            break;
+        hdr->heap[i] = hdr->heap[child];
+        i = child;
+    }
+    hdr->heap[i] = last;
+    __atomic_store_n(&hdr->curmsgs, n, __ATOMIC_SEQ_CST);
+    return top;
+}
+
+static void mq_init_hdr(struct mq_shared_hdr* hdr, uint32_t maxmsg, uint32_t msgsize,
+                        mode_t mode) {
+    spinlock_init(&hdr->lock);
+    hdr->maxmsg    = maxmsg;
+    hdr->msgsize   = msgsize;
+    hdr->mode      = mode & 0777;
+    hdr->free_slot = 0;
+    for (uint32_t i = 0; i < maxmsg; i++)
+        mq_slot(hdr, i)->next_free = i + 1 < maxmsg ? i + 1 : MQ_NO_SLOT;
+
+    __atomic_store_n(&hdr->magic, MQ_MAGIC, __ATOMIC_RELEASE);
+}
+
+/* Returns the slot of `pid` in the openers of the queue, allocating one if needed. */
+static int __mq_add_opener(struct mq_shared_hdr* hdr, IDTYPE pid) {
+    int free_idx = -1;
+    for (int i = 0; i < MQ_MAX_OPENERS; i++) {
+        struct mq_opener* opener = &hdr->openers[i];
+        if (opener->refcount && opener->pid == pid) {
+            opener->refcount++;
+            return i;
+        }
+        if (!opener->refcount && free_idx < 0)
+            free_idx = i;
+    }
+    if (free_idx < 0)
+        return -ENFILE;
+
+    hdr->openers[free_idx].pid        = pid;
+    hdr->openers[free_idx].refcount   = 1;
+    hdr->openers[free_idx].want_ready = 0;
+    return free_idx;
+}
+
+/* Forgets process `pid` (which is gone) as an opener of the queue. */
+static void mq_drop_opener(struct mq_shared_hdr* hdr, IDTYPE pid) {
+    spinlock_lock_signal_off(&hdr->lock);
+    for (int i = 0; i < MQ_MAX_OPENERS; i++) {
+        if (hdr->openers[i].refcount && hdr->openers[i].pid == pid) {
+            hdr->openers[i].refcount   = 0;
+            hdr->openers[i].want_ready = 0;
+        }
+    }
+    if (hdr->notify_pid == pid)
+        hdr->notify_pid = 0;
+    spinlock_unlock_signal_on(&hdr->lock);
+}
+
+/* Collects the other processes that want to know that the queue became empty or non-empty. Must
+ * be called with the queue lock held. */
+static int __mq_collect_openers(struct mq_shared_hdr* hdr, IDTYPE self, IDTYPE* pids) {
+    int n = 0;
+    for (int i = 0; i < MQ_MAX_OPENERS; i++) {
+        struct mq_opener* opener = &hdr->openers[i];
+        if (!opener->refcount || opener->pid == self)
+            continue;
+        if (__atomic_exchange_n(&opener->want_ready, 0, __ATOMIC_SEQ_CST))
+            pids[n++] = opener->pid;
+    }
+    return n;
+}
+
+/* Updates the event of `hdl` to the state of the queue. Must be called with the handle lock
+ * held. */
+static void __mq_refresh(struct shim_handle* hdl) {
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+    assert(locked(&hdl->lock));
+
+    if (!mq->hdr)
+        return;
+
+    /* announce interest before looking at the queue, so that a concurrent change of emptiness
+     * either is seen here or sends us a message; only descriptors which are waited on need the
+     * event, mq_timedreceive() and mq_timedsend() look at the queue itself */
+    if (mq->opener >= 0 && mq->waited)
+        __atomic_store_n(&mq->hdr->openers[mq->opener].want_ready, 1, __ATOMIC_SEQ_CST);
+
+    bool ready = __atomic_load_n(&mq->hdr->curmsgs, __ATOMIC_SEQ_CST) > 0;
+    if (ready == mq->ready)
+        return;
+
+    if (ready) {
+        set_event(&mq->event, 1);
+    } else {
+        clear_event(&mq->event);
+    }
+    mq->ready = ready;
+}
+
+/* Called by poll(), select() and epoll_wait() before waiting on the event of `hdl` for reading. The
+ * event is only kept up to date for descriptors which were waited on, so it is refreshed here. */
+void mqueue_prepare_wait(struct shim_handle* hdl) {
+    assert(hdl->type == TYPE_MQUEUE);
+    if (!(hdl->acc_mode & MAY_READ))
+        return;
+
+    lock(&hdl->lock);
+    hdl->info.mqueue.waited = true;
+    __mq_refresh(hdl);
+    unlock(&hdl->lock);
+}
+
+/* Updates the events of all descriptors of queue `path` in this process. */
+static void mq_update_ready(const char* path) {
+    lock(&g_mq_list_lock);
+    struct shim_mqueue_handle* mq;
+    LISTP_FOR_EACH_ENTRY(mq, &g_mq_list, list) {
+        struct shim_handle* hdl = MQ_TO_HANDLE(mq);
+        if (strcmp(qstrgetstr(&hdl->path), path))
+            continue;
+        lock(&hdl->lock);
+        __mq_refresh(hdl);
+        unlock(&hdl->lock);
+    }
+    unlock(&g_mq_list_lock);
+}
+
+/* Sends the mq_notify() notification registered in this process for queue `path`. */
+static void mq_deliver_notify(const char* path, IDTYPE sender) {
+    bool found = false;
+    int signo = 0;
+    sigval_t value;
+    IDTYPE tgid = 0;
+
+    lock(&g_mq_list_lock);
+    struct shim_mqueue_handle* mq;
+    LISTP_FOR_EACH_ENTRY(mq, &g_mq_list, list) {
+        struct shim_handle* hdl = MQ_TO_HANDLE(mq);
+        if (!mq->notify || strcmp(qstrgetstr(&hdl->path), path))
+            continue;
+        lock(&hdl->lock);
+        if (mq->notify) {
+            /* a notification is sent only once */
+            mq->notify = false;
+            found      = true;
+            signo      = mq->notify_signo;
+            value      = mq->notify_value;
+            tgid       = mq->notify_tgid;
+        }
+        unlock(&hdl->lock);
+        if (found)
+            break;
+    }
+    unlock(&g_mq_list_lock);
+
+    if (!found || !signo)
+        return;
+
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    info.si_signo = signo;
+    info.si_code  = SI_MESGQ;
+    info.si_pid   = sender;
+    info.si_value = value;
+
+    int ret = do_kill_proc_info(tgid, &info);
+    if (ret < 0)
+        debug("Cannot deliver notification of message queue %s: %d\n", path, ret);
+}
+
+void mqueue_notified(IDTYPE sender, const char* name, int flags) {
+    if (flags & MQNOTIFY_READY)
+        mq_update_ready(name);
+    if (flags & MQNOTIFY_SIGNAL)
+        mq_deliver_notify(name, sender);
+}
+
+/* Announces that the queue of `hdl` became empty or non-empty: to the descriptors in this process,
+ * to the processes in `pids` and with the notification of process `notify_pid` (if not 0). Must be
+ * called without locks held. */
+static void mq_announce(struct shim_handle* hdl, IDTYPE self, IDTYPE* pids, int npids,
+                        IDTYPE notify_pid) {
+    struct mq_shared_hdr* hdr = hdl->info.mqueue.hdr;
+    const char* path = qstrgetstr(&hdl->path);
+
+    mq_update_ready(path);
+
+    if (notify_pid == self) {
+        mq_deliver_notify(path, self);
+        notify_pid = 0;
+    }
+
+    for (int i = 0; i < npids; i++) {
+        int flags = MQNOTIFY_READY;
+        if (pids[i] == notify_pid) {
+            flags |= MQNOTIFY_SIGNAL;
+            notify_pid = 0;
+        }
+        if (ipc_pid_mqnotify_send(pids[i], self, path, flags) < 0)
+            mq_drop_opener(hdr, pids[i]);
+    }
+
+    if (notify_pid)
+        ipc_pid_mqnotify_send(notify_pid, self, path, MQNOTIFY_SIGNAL);
+}
+
+static int mq_map(PAL_HANDLE file, size_t size, struct mq_shared_hdr** hdrp) {
+    void* addr = NULL;
+    int ret = bkeep_mmap_any(size, PROT_READ | PROT_WRITE, MAP_SHARED | VMA_INTERNAL, NULL, 0,
+                             "mqueue", &addr);
+    if (ret < 0)
+        return ret;
+
+    if (DkStreamMap(file, addr, PAL_PROT_READ | PAL_PROT_WRITE, 0, size) != addr) {
+        ret = -PAL_ERRNO();
+        void* tmp_vma = NULL;
+        if (bkeep_munmap(addr, size, /*is_internal=*/true, &tmp_vma) < 0)
+            BUG();
+        bkeep_remove_tmp_vma(tmp_vma);
+        return ret;
+    }
+
+    *hdrp = addr;
+    return 0;
+}
+
+static void mq_unmap(struct mq_shared_hdr* hdr, size_t size) {
+    void* tmp_vma = NULL;
+    if (bkeep_munmap(hdr, size, /*is_internal=*/true, &tmp_vma) < 0)
+        BUG();
+    DkStreamUnmap(hdr, size);
+    bkeep_remove_tmp_vma(tmp_vma);
+}
+
+/* Maps a queue created by another process, waiting for the creator to initialize it. */
+static int mq_map_existing(PAL_HANDLE file, struct mq_shared_hdr** hdrp, size_t* sizep) {
+    size_t size = 0;
+    for (int i = 0; i < MQ_OPEN_RETRIES; i++) {
+        PAL_STREAM_ATTR attr;
+        if (!DkStreamAttributesQueryByHandle(file, &attr))
+            return -PAL_ERRNO();
+        if (attr.pending_size >= sizeof(struct mq_shared_hdr)) {
+            size = attr.pending_size;
+            break;
+        }
+        DkThreadYieldExecution();
+    }
+    if (!size)
+        return -EAGAIN;
+    if (!IS_ALLOC_ALIGNED(size))
+        return -EINVAL;
+
+    struct mq_shared_hdr* hdr;
+    int ret = mq_map(file, size, &hdr);
+    if (ret < 0)
+        return ret;
+
+    for (int i = 0; i < MQ_OPEN_RETRIES; i++) {
+        if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) == MQ_MAGIC)
+            break;
+        DkThreadYieldExecution();
+    }
+
+    if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != MQ_MAGIC) {
+        ret = -EAGAIN;
+        goto err;
+    }
+    if (mq_map_size(hdr->maxmsg, hdr->msgsize) != size) {
+        ret = -EINVAL;
+        goto err;
+    }
+
+    *hdrp  = hdr;
+    *sizep = size;
+    return 0;
+
+err:
+    mq_unmap(hdr, size);
+    return ret;
+}
+
+/* Opens (and creates, depending on `oflag`) the host object of the queue and maps it into `mq`. */
+static int mq_open_file(const char* uri, int oflag, uint32_t maxmsg, uint32_t msgsize,
+                        mode_t mode, struct shim_mqueue_handle* mq) {
+    for (;;) {
+        if (oflag & O_CREAT) {
+            if ((uint64_t)maxmsg * msgsize > get_rlimit_cur(RLIMIT_MSGQUEUE))
+                return -EMFILE;
+
+            PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDWR,
+                                           (mode & 0777) | PAL_SHARE_OWNER_R | PAL_SHARE_OWNER_W,
+                                           PAL_CREATE_ALWAYS, 0);
+            if (file) {
+                size_t size = mq_map_size(maxmsg, msgsize);
+                int ret = -ENOSPC;
+                if (DkStreamSetLength(file, size))
+                    goto err_delete;
+
+                ret = mq_map(file, size, &mq->hdr);
+                if (ret < 0)
+                    goto err_delete;
+
+                mq_init_hdr(mq->hdr, maxmsg, msgsize, mode);
+                mq->file     = file;
+                mq->map_size = size;
+                return 0;
+
+            err_delete:
+                DkStreamDelete(file, 0);
+                DkObjectClose(file);
+                return ret;
+            }
+
+            if (PAL_NATIVE_ERRNO() != PAL_ERROR_STREAMEXIST)
+                return -PAL_ERRNO();
+            if (oflag & O_EXCL)
+                return -EEXIST;
+        }
+
+        PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDWR, 0, 0, 0);
+        if (file) {
+            int ret = mq_map_existing(file, &mq->hdr, &mq->map_size);
+            if (ret < 0) {
+                DkObjectClose(file);
+                return ret;
+            }
+            mq->file = file;
+            return 0;
+        }
+
+        /* if the queue was unlinked in the meantime, try to create it again */
+        if (!(oflag & O_CREAT) || PAL_NATIVE_ERRNO() != PAL_ERROR_STREAMNOTEXIST)
+            return -PAL_ERRNO();
+    }
+}
+
+/* Registers the current process as an opener of the queue of `hdl`, if there is a current
+ * process already. */
+static int mq_register_opener(struct shim_handle* hdl) {
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+    struct shim_thread* cur = get_cur_thread();
+    if (!cur || mq->opener >= 0)
+        return 0;
+
+    spinlock_lock_signal_off(&mq->hdr->lock);
+    int ret = __mq_add_opener(mq->hdr, cur->tgid);
+    spinlock_unlock_signal_on(&mq->hdr->lock);
+    if (ret < 0)
+        return ret;
+
+    mq->opener = ret;
+    return 0;
+}
+
+/* Sets up the event and the opener slot of a mapped queue and adds it to the list. */
+static int mq_attach(struct shim_handle* hdl) {
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+
+    create_event(&mq->event);
+    if (!event_created(&mq->event))
+        return -ENOMEM;
+    hdl->pal_handle = event_handle(&mq->event);
+    mq->ready  = false;
+    mq->waited = false;
+
+    int ret = mq_register_opener(hdl);
+    if (ret < 0)
+        return ret;
+
+    lock(&g_mq_list_lock);
+    LISTP_ADD_TAIL(mq, &g_mq_list, list);
+    lock(&hdl->lock);
+    __mq_refresh(hdl);
+    unlock(&hdl->lock);
+    unlock(&g_mq_list_lock);
+    return 0;
+}
+
+static int mqueue_close(struct shim_handle* hdl) {
+    /* the event is closed together with the PAL handle of `hdl` */
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+
+    if (!LIST_EMPTY(mq, list)) {
+        lock(&g_mq_list_lock);
+        LISTP_DEL_INIT(mq, &g_mq_list, list);
+        unlock(&g_mq_list_lock);
+    }
+
+    if (mq->hdr) {
+        struct mq_shared_hdr* hdr = mq->hdr;
+        struct shim_thread* cur = get_cur_thread();
+
+        spinlock_lock_signal_off(&hdr->lock);
+        if (mq->notify && hdr->notify_pid == mq->notify_tgid)
+            hdr->notify_pid = 0;
+        if (mq->opener >= 0) {
+            struct mq_opener* opener = &hdr->openers[mq->opener];
+            if (opener->refcount && (!cur || opener->pid == cur->tgid) && !--opener->refcount)
+                opener->want_ready = 0;
+        }
+        spinlock_unlock_signal_on(&hdr->lock);
+
+        mq_unmap(hdr, mq->map_size);
+        mq->hdr = NULL;
+    }
+
+    if (mq->file) {
+        DkObjectClose(mq->file);
+        mq->file = NULL;
+    }
+    return 0;
+}
+
+static int mqueue_checkout(struct shim_handle* hdl) {
+    /* the child maps the migrated host object, creates its own event and becomes an opener; the
+     * mq_notify() registration stays with the parent */
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+    mq->hdr         = NULL;
+    mq->opener      = -1;
+    mq->ready       = false;
+    mq->notify      = false;
+    mq->event.event = NULL;
+    INIT_LIST_HEAD(mq, list);
+    hdl->pal_handle = NULL;
+    return 0;
+}
+
+static int mqueue_checkin(struct shim_handle* hdl) {
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+
+    if (!create_lock_runtime(&g_mq_list_lock))
+        return -ENOMEM;
+    if (!mq->file)
+        return -EINVAL;
+
+    int ret = mq_map(mq->file, mq->map_size, &mq->hdr);
+    if (ret < 0)
+        return ret;
+
+    /* while restoring a checkpoint there is no current thread yet; the opener slot is taken in
+     * init_mqueue() then */
+    return mq_attach(hdl);
+}
+
+struct shim_fs_ops mqueue_fs_ops = {
+    .close    = &mqueue_close,
+    .checkout = &mqueue_checkout,
+    .checkin  = &mqueue_checkin,
+};
+
+struct shim_mount mqueue_builtin_fs = {
+    .type   = "mqueue",
+    .fs_ops = &mqueue_fs_ops,
+};
+
+int init_mqueue(void) {
+    if (!create_lock_runtime(&g_mq_list_lock))
+        return -ENOMEM;
+
+    lock(&g_mq_list_lock);
+    struct shim_mqueue_handle* mq;
+    LISTP_FOR_EACH_ENTRY(mq, &g_mq_list, list) {
+        struct shim_handle* hdl = MQ_TO_HANDLE(mq);
+        lock(&hdl->lock);
+        int ret = mq_register_opener(hdl);
+        if (ret < 0) {
+            debug("Cannot register as opener of message queue %s: %d\n",
+                  qstrgetstr(&hdl->path), ret);
+        } else {
+            __mq_refresh(hdl);
+        }
+        unlock(&hdl->lock);
+    }
+    unlock(&g_mq_list_lock);
+    return 0;
+}
+
+/* `name` is the name of the queue without the leading slash (stripped by libc) */
+static int mq_check_name(const char* name) {
+    if (!name || test_user_string(name))
+        return -EFAULT;
+
+    size_t len = strnlen(name, NAME_MAX + 1);
+    if (!len)
+        return -ENOENT;
+    if (len > NAME_MAX)
+        return -ENAMETOOLONG;
+    if (strchr(name, '/'))
+        return -EACCES;
+    return 0;
+}
+
+static int mq_uri(const char* name, char* uri) {
+    IDTYPE leader;
+    int ret = get_sysv_leader(&leader);
+    if (ret < 0)
+        return ret;
+
+    snprintf(uri, MQ_URI_LEN, MQ_URI_PREFIX "%u_%s", leader, name);
+    return 0;
+}
+
+/* Converts `abs_timeout` into a deadline on the clock of DkSystemTimeQuery(), NO_TIMEOUT if
+ * `abs_timeout` is NULL. */
+static int mq_deadline(const struct timespec* abs_timeout, uint64_t* deadline) {
+    *deadline = NO_TIMEOUT;
+    if (!abs_timeout)
+        return 0;
+
+    if (test_user_memory((void*)abs_timeout, sizeof(*abs_timeout), false))
+        return -EFAULT;
+    if (abs_timeout->tv_sec < 0 || abs_timeout->tv_nsec < 0 || abs_timeout->tv_nsec >= 1000000000)
+        return -EINVAL;
+
+    uint64_t us;
+    if (__builtin_mul_overflow((uint64_t)abs_timeout->tv_sec, 1000000, &us) ||
+            __builtin_add_overflow(us, abs_timeout->tv_nsec / 1000, &us))
+        return 0;
+
+    *deadline = us;
+    return 0;
+}
+
+/* Waits until `*futex` changes or `deadline` passes. Must be called with the queue lock held,
+ * which is dropped while waiting. */
+static int mq_wait(struct mq_shared_hdr* hdr, uint32_t* futex, uint32_t* waiters,
+                   uint64_t deadline) {
+    PAL_NUM timeout_us = NO_TIMEOUT;
+    if (deadline != NO_TIMEOUT) {
+        uint64_t now = DkSystemTimeQuery();
+        if (now >= deadline)
+            return -ETIMEDOUT;
+        timeout_us = deadline - now;
+    }
+
+    uint32_t val = *futex;
+    (*waiters)++;
+    spinlock_unlock_signal_on(&hdr->lock);
+
+    int ret = 0;
+    if (!DkFutexWait(futex, val, timeout_us, /*flags=*/0)) {
+        switch (PAL_NATIVE_ERRNO()) {
+            case PAL_ERROR_TRYAGAIN:
+                ret = -ETIMEDOUT;
+                break;
+            case PAL_ERROR_INTERRUPTED:
+                ret = -EINTR;
+                break;
+            default:
+                ret = -PAL_ERRNO();
+                break;
+        }
+    }
+
+    spinlock_lock_signal_off(&hdr->lock);
+    (*waiters)--;
+    return ret;
+}
+
+static int get_mq_handle(__kernel_mqd_t mqdes, int acc_mode, struct shim_handle** hdl) {
+    *hdl = get_fd_handle(mqdes, NULL, NULL);
+    if (!*hdl)
+        return -EBADF;
+    if ((*hdl)->type != TYPE_MQUEUE || ((*hdl)->acc_mode & acc_mode) != acc_mode) {
+        put_handle(*hdl);
+        return -EBADF;
+    }
+    return 0;
+}
+
+int shim_do_mq_open(const char* name, int oflag, mode_t mode, struct __kernel_mq_attr* attr) {
+    int ret = mq_check_name(name);
+    if (ret < 0)
+        return ret;
+
+    int acc_mode;
+    switch (oflag & O_ACCMODE) {
+        case O_RDONLY:
+            acc_mode = MAY_READ;
+            break;
+        case O_WRONLY:
+            acc_mode = MAY_WRITE;
+            break;
+        case O_RDWR:
+            acc_mode = MAY_READ | MAY_WRITE;
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    long maxmsg  = MQ_DEFAULT_MAXMSG;
+    long msgsize = MQ_DEFAULT_MSGSIZE;
+    if ((oflag & O_CREAT) && attr) {
+        if (test_user_memory(attr, sizeof(*attr), false))
+            return -EFAULT;
+        maxmsg  = attr->mq_maxmsg;
+        msgsize = attr->mq_msgsize;
+        if (maxmsg <= 0 || maxmsg > MQ_MAXMSG_MAX || msgsize <= 0 || msgsize > MQ_MSGSIZE_MAX)
+            return -EINVAL;
+    }
+
+    char uri[MQ_URI_LEN];
+    ret = mq_uri(name, uri);
+    if (ret < 0)
+        return ret;
+
+    if (!create_lock_runtime(&g_mq_list_lock))
+        return -ENOMEM;
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    hdl->type = TYPE_MQUEUE;
+    set_handle_fs(hdl, &mqueue_builtin_fs);
+    hdl->flags    = oflag & (O_ACCMODE | O_NONBLOCK);
+    hdl->acc_mode = acc_mode;
+    qstrsetstr(&hdl->uri, uri, strlen(uri));
+
+    char path[NAME_MAX + 2];
+    snprintf(path, sizeof(path), "/%s", name);
+    qstrsetstr(&hdl->path, path, strlen(path));
+
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+    memset(mq, 0, sizeof(*mq));
+    mq->opener = -1;
+    INIT_LIST_HEAD(mq, list);
+
+    ret = mq_open_file(uri, oflag, maxmsg, msgsize, mode, mq);
+    if (ret < 0)
+        goto out;
+
+    ret = mq_attach(hdl);
+    if (ret < 0)
+        goto out;
+
+    ret = set_new_fd_handle(hdl, oflag & O_CLOEXEC ? FD_CLOEXEC : 0, NULL);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_mq_unlink(const char* name) {
+    int ret = mq_check_name(name);
+    if (ret < 0)
+        return ret;
+
+    char uri[MQ_URI_LEN];
+    ret = mq_uri(name, uri);
+    if (ret < 0)
+        return ret;
+
+    /* descriptors which are still open keep their mapping of the removed object */
+    PAL_HANDLE file = DkStreamOpen(uri, PAL_ACCESS_RDWR, 0, 0, 0);
+    if (!file)
+        return -PAL_ERRNO();
+
+    DkStreamDelete(file, 0);
+    DkObjectClose(file);
+    return 0;
+}
+
+int shim_do_mq_timedsend(__kernel_mqd_t mqdes, const char* msg_ptr, size_t msg_len,
+                         unsigned int msg_prio, const struct timespec* abs_timeout) {
+    if (msg_prio >= MQ_PRIO_MAX)
+        return -EINVAL;
+    if (msg_len && (!msg_ptr || test_user_memory((void*)msg_ptr, msg_len, false)))
+        return -EFAULT;
+
+    uint64_t deadline;
+    int ret = mq_deadline(abs_timeout, &deadline);
+    if (ret < 0)
+        return ret;
+
+    struct shim_handle* hdl;
+    ret = get_mq_handle(mqdes, MAY_WRITE, &hdl);
+    if (ret < 0)
+        return ret;
+
+    struct mq_shared_hdr* hdr = hdl->info.mqueue.hdr;
+    IDTYPE self = get_cur_thread()->tgid;
+    IDTYPE pids[MQ_MAX_OPENERS];
+    int npids = 0;
+    IDTYPE notify_pid = 0;
+
+    if (msg_len > hdr->msgsize) {
+        ret = -EMSGSIZE;
+        goto out;
+    }
+
+    spinlock_lock_signal_off(&hdr->lock);
+    while (hdr->free_slot == MQ_NO_SLOT) {
+        if (hdl->flags & O_NONBLOCK) {
+            ret = -EAGAIN;
+            goto out_unlock;
+        }
+        ret = mq_wait(hdr, &hdr->send_futex, &hdr->send_waiters, deadline);
+        if (ret < 0 && hdr->free_slot == MQ_NO_SLOT)
+            goto out_unlock;
+    }
+
+    uint32_t idx = hdr->free_slot;
+    struct mq_msg* msg = mq_slot(hdr, idx);
+    hdr->free_slot = msg->next_free;
+
+    msg->seq  = hdr->seq++;
+    msg->prio = msg_prio;
+    msg->len  = msg_len;
+    memcpy(msg->data, msg_ptr, msg_len);
+
+    bool was_empty = !hdr->curmsgs;
+    mq_heap_push(hdr, idx);
+    hdr->recv_futex++;
+    bool wake = hdr->recv_waiters > 0;
+
+    if (was_empty) {
+        npids = __mq_collect_openers(hdr, self, pids);
+        /* as on Linux, a blocked receiver takes precedence over the notification */
+        if (hdr->notify_pid && !hdr->recv_waiters) {
+            notify_pid      = hdr->notify_pid;
+            hdr->notify_pid = 0;
+        }
+    }
+    spinlock_unlock_signal_on(&hdr->lock);
+
+    if (wake)
+        DkFutexWake(&hdr->recv_futex, 1, /*flags=*/0, /*woken=*/NULL);
+    if (was_empty)
+        mq_announce(hdl, self, pids, npids, notify_pid);
+    ret = 0;
+    goto out;
+
+out_unlock:
+    spinlock_unlock_signal_on(&hdr->lock);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_mq_timedreceive(__kernel_mqd_t mqdes, char* msg_ptr, size_t msg_len,
+                            unsigned int* msg_prio, const struct timespec* abs_timeout) {
+    if (msg_len && (!msg_ptr || test_user_memory(msg_ptr, msg_len, true)))
+        return -EFAULT;
+    if (msg_prio && test_user_memory(msg_prio, sizeof(*msg_prio), true))
+        return -EFAULT;
+
+    uint64_t deadline;
+    int ret = mq_deadline(abs_timeout, &deadline);
+    if (ret < 0)
+        return ret;
+
+    struct shim_handle* hdl;
+    ret = get_mq_handle(mqdes, MAY_READ, &hdl);
+    if (ret < 0)
+        return ret;
+
+    struct mq_shared_hdr* hdr = hdl->info.mqueue.hdr;
+    IDTYPE self = get_cur_thread()->tgid;
+    IDTYPE pids[MQ_MAX_OPENERS];
+    int npids = 0;
+
+    if (msg_len < hdr->msgsize) {
+        ret = -EMSGSIZE;
+        goto out;
+    }
+
+    spinlock_lock_signal_off(&hdr->lock);
+    while (!hdr->curmsgs) {
+        if (hdl->flags & O_NONBLOCK) {
+            ret = -EAGAIN;
+            goto out_unlock;
+        }
+        ret = mq_wait(hdr, &hdr->recv_futex, &hdr->recv_waiters, deadline);
+        if (ret < 0 && !hdr->curmsgs)
+            goto out_unlock;
+    }
+
+    uint32_t idx = mq_heap_pop(hdr);
+    struct mq_msg* msg = mq_slot(hdr, idx);
+    memcpy(msg_ptr, msg->data, msg->len);
+    ret = msg->len;
+    if (msg_prio)
+        *msg_prio = msg->prio;
+
+    msg->next_free = hdr->free_slot;
+    hdr->free_slot = idx;
+    hdr->send_futex++;
+    bool wake = hdr->send_waiters > 0;
+
+    bool now_empty = !hdr->curmsgs;
+    if (now_empty)
+        npids = __mq_collect_openers(hdr, self, pids);
+    spinlock_unlock_signal_on(&hdr->lock);
+
+    if (wake)
+        DkFutexWake(&hdr->send_futex, 1, /*flags=*/0, /*woken=*/NULL);
+    if (now_empty)
+        mq_announce(hdl, self, pids, npids, /*notify_pid=*/0);
+    goto out;
+
+out_unlock:
+    spinlock_unlock_signal_on(&hdr->lock);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_mq_notify(__kernel_mqd_t mqdes, const struct sigevent* notification) {
+    if (notification) {
+        if (test_user_memory((void*)notification, sizeof(*notification), false))
+            return -EFAULT;
+
+        switch (notification->sigev_notify) {
+            case SIGEV_NONE:
+                break;
+            case SIGEV_SIGNAL:
+                if (notification->sigev_signo <= 0 || notification->sigev_signo > NUM_SIGS)
+                    return -EINVAL;
+                break;
+            default:
+                return -EINVAL;
+        }
+    }
+
+    struct shim_handle* hdl;
+    int ret = get_mq_handle(mqdes, 0, &hdl);
+    if (ret < 0)
+        return ret;
+
+    struct shim_mqueue_handle* mq = &hdl->info.mqueue;
+    struct mq_shared_hdr* hdr = mq->hdr;
+    IDTYPE self = get_cur_thread()->tgid;
+
+    lock(&g_mq_list_lock);
+    spinlock_lock_signal_off(&hdr->lock);
+    if (!notification) {
+        if (hdr->notify_pid == self) {
+            hdr->notify_pid = 0;
+            /* the registration may have been made through another descriptor */
+            struct shim_mqueue_handle* tmp;
+            LISTP_FOR_EACH_ENTRY(tmp, &g_mq_list, list) {
+                if (tmp->hdr == hdr)
+                    tmp->notify = false;
+            }
+        }
+    } else if (hdr->notify_pid) {
+        ret = -EBUSY;
+    } else {
+        hdr->notify_pid  = self;
+        mq->notify       = true;
+        mq->notify_tgid  = self;
+        mq->notify_value = notification->sigev_value;
+        mq->notify_signo = notification->sigev_notify == SIGEV_SIGNAL
+                           ? notification->sigev_signo : 0;
+    }
+    spinlock_unlock_signal_on(&hdr->lock);
+    unlock(&g_mq_list_lock);
+
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_mq_getsetattr(__kernel_mqd_t mqdes, const struct __kernel_mq_attr* mqstat,
+                          struct __kernel_mq_attr* omqstat) {
+    if (mqstat && test_user_memory((void*)mqstat, sizeof(*mqstat), false))
+        return -EFAULT;
+    if (omqstat && test_user_memory(omqstat, sizeof(*omqstat), true))
+        return -EFAULT;
+    if (mqstat && (mqstat->mq_flags & ~O_NONBLOCK))
+        return -EINVAL;
+
+    struct shim_handle* hdl;
+    int ret = get_mq_handle(mqdes, 0, &hdl);
+    if (ret < 0)
+        return ret;
+
+    struct mq_shared_hdr* hdr = hdl->info.mqueue.hdr;
+
+    lock(&hdl->lock);
+    if (omqstat) {
+        memset(omqstat, 0, sizeof(*omqstat));
+        omqstat->mq_flags   = hdl->flags & O_NONBLOCK;
+        omqstat->mq_maxmsg  = hdr->maxmsg;
+        omqstat->mq_msgsize = hdr->msgsize;
+        omqstat->mq_curmsgs = __atomic_load_n(&hdr->curmsgs, __ATOMIC_SEQ_CST);
+    }
+    if (mqstat)
+        hdl->flags = (hdl->flags & ~O_NONBLOCK) | (mqstat->mq_flags & O_NONBLOCK);
+    unlock(&hdl->lock);
+
+    put_handle(hdl);
+    return 0;
+}
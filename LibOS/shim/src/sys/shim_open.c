@@ -6,7 +6,8 @@
  *
  * Implementation of system call "read", "write", "open", "creat", "openat",
  * "close", "lseek", "pread64", "pwrite64", "getdents", "getdents64",
- * "fsync", "truncate" and "ftruncate".
+ * "fsync", "truncate", "ftruncate", "fallocate", "fadvise64", "readahead" and
+ * "sync_file_range".
  */
 
 #include <shim_internal.h>
@@ -15,6 +16,7 @@
 #include <shim_thread.h>
 #include <shim_handle.h>
 #include <shim_fs.h>
+#include <shim_flags_conv.h>
 
 #include <pal.h>
 #include <pal_error.h>
@@ -632,3 +634,130 @@ out:
     put_handle(hdl);
     return ret;
 }
+
+int shim_do_fallocate(int fd, int mode, loff_t offset, loff_t len) {
+    if (offset < 0 || len <= 0)
+        return -EINVAL;
+
+    loff_t end;
+    if (__builtin_add_overflow(offset, len, &end))
+        return -EFBIG;
+
+    /* collapsing, inserting and unsharing ranges are not supported */
+    if (mode & ~(FALLOC_FL_KEEP_SIZE | FALLOC_FL_PUNCH_HOLE | FALLOC_FL_ZERO_RANGE))
+        return -EOPNOTSUPP;
+    if ((mode & FALLOC_FL_PUNCH_HOLE) &&
+            (!(mode & FALLOC_FL_KEEP_SIZE) || (mode & FALLOC_FL_ZERO_RANGE)))
+        return -EOPNOTSUPP;
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret = -EBADF;
+
+    if (!(hdl->acc_mode & MAY_WRITE))
+        goto out;
+
+    ret = -EPERM;
+    if ((mode & ~FALLOC_FL_KEEP_SIZE) && (hdl->flags & O_APPEND))
+        goto out;
+
+    ret = -ESPIPE;
+    if (hdl->type == TYPE_PIPE || hdl->type == TYPE_SOCK)
+        goto out;
+
+    ret = -EISDIR;
+    if (hdl->type == TYPE_DIR)
+        goto out;
+
+    ret = -ENODEV;
+    if (!fs || !fs->fs_ops || !fs->fs_ops->fallocate)
+        goto out;
+
+    ret = fs->fs_ops->fallocate(hdl, mode, offset, len);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+static bool is_fadvise_advice(int advice) {
+    return advice == POSIX_FADV_NORMAL || advice == POSIX_FADV_RANDOM ||
+           advice == POSIX_FADV_SEQUENTIAL || advice == POSIX_FADV_WILLNEED ||
+           advice == POSIX_FADV_DONTNEED || advice == POSIX_FADV_NOREUSE;
+}
+
+int shim_do_fadvise64(int fd, loff_t offset, size_t len, int advice) {
+    if ((loff_t)len < 0 || !is_fadvise_advice(advice))
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret = -ESPIPE;
+
+    if (hdl->type == TYPE_PIPE || hdl->type == TYPE_SOCK)
+        goto out;
+
+    /* hints for file systems without a host file behind them are ignored, like on Linux */
+    ret = 0;
+    if (!fs || !fs->fs_ops || !fs->fs_ops->fadvise)
+        goto out;
+
+    ret = fs->fs_ops->fadvise(hdl, offset, len, advice);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_readahead(int fd, loff_t offset, size_t count) {
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret = -EBADF;
+
+    if (!(hdl->acc_mode & MAY_READ))
+        goto out;
+
+    ret = -EINVAL;
+    if (hdl->type != TYPE_FILE || !fs || !fs->fs_ops || !fs->fs_ops->fadvise)
+        goto out;
+
+    ret = fs->fs_ops->fadvise(hdl, offset, count, POSIX_FADV_WILLNEED);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_sync_file_range(int fd, loff_t offset, loff_t nbytes, int flags) {
+    if (flags & ~(SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER))
+        return -EINVAL;
+
+    loff_t end;
+    if (offset < 0 || nbytes < 0 || __builtin_add_overflow(offset, nbytes, &end))
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    struct shim_mount* fs = hdl->fs;
+    int ret = -ESPIPE;
+
+    if (hdl->type != TYPE_FILE && hdl->type != TYPE_DIR)
+        goto out;
+
+    ret = 0;
+    if (hdl->type == TYPE_DIR || !fs || !fs->fs_ops || !fs->fs_ops->sync_range)
+        goto out;
+
+    ret = fs->fs_ops->sync_range(hdl, offset, nbytes, flags);
+out:
+    put_handle(hdl);
+    return ret;
+}
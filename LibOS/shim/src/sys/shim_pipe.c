@@ -68,6 +68,17 @@ out:
     return ret;
 }
 
+/* Anonymous pipes are host pipes if the PAL provides them (see DkStreamOpenPipe()), with host
+ * buffer sizes and host splice(). Returns -EOPNOTSUPP if it does not (e.g. Linux-SGX); the caller
+ * then connects a pair of PAL pipe streams with create_pipes(), as for named pipes. */
+static int create_host_pipes(PAL_HANDLE* rd, PAL_HANDLE* wr, int flags, struct shim_qstr* qstr) {
+    if (!DkStreamOpenPipe(rd, wr, LINUX_OPEN_FLAGS_TO_PAL_OPTIONS(flags & ~O_DIRECT)))
+        return PAL_NATIVE_ERRNO() == PAL_ERROR_NOTIMPLEMENTED ? -EOPNOTSUPP : -PAL_ERRNO();
+
+    qstrsetstr(qstr, URI_PREFIX_PIPE, static_strlen(URI_PREFIX_PIPE));
+    return 0;
+}
+
 static void undo_set_fd_handle(int fd) {
     if (fd >= 0) {
         struct shim_handle* hdl = detach_fd_handle(fd, NULL, NULL);
@@ -106,8 +117,10 @@ int shim_do_pipe2(int* filedes, int flags) {
     hdl1->info.pipe.ready_for_ops = true;
     hdl2->info.pipe.ready_for_ops = true;
 
-    ret = create_pipes(&hdl1->pal_handle, &hdl2->pal_handle, flags, hdl1->info.pipe.name,
-                       &hdl1->uri);
+    ret = create_host_pipes(&hdl1->pal_handle, &hdl2->pal_handle, flags, &hdl1->uri);
+    if (ret == -EOPNOTSUPP)
+        ret = create_pipes(&hdl1->pal_handle, &hdl2->pal_handle, flags, hdl1->info.pipe.name,
+                           &hdl1->uri);
     if (ret < 0)
         goto out;
 
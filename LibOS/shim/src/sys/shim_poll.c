@@ -135,6 +135,9 @@ static int _shim_do_poll(struct pollfd* fds, nfds_t nfds, int timeout_ms) {
             continue;
         }
 
+        if (hdl->type == TYPE_MQUEUE && (allowed_events & PAL_WAIT_READ))
+            mqueue_prepare_wait(hdl);
+
         get_handle(hdl);
         fds_mapping[i].hdl = hdl;
         fds_mapping[i].idx = pal_cnt;
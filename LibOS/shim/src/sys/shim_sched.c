@@ -15,8 +15,11 @@
 #include <linux/resource.h>
 #include <linux/sched.h>
 #include <pal.h>
+#include <pal_error.h>
 #include <shim_internal.h>
+#include <shim_ipc.h>
 #include <shim_table.h>
+#include <shim_thread.h>
 
 int shim_do_sched_yield(void) {
     DkThreadYieldExecution();
@@ -155,53 +158,105 @@ static int check_affinity_params(int ncpus, size_t len, __kernel_cpu_set_t* user
     return bitmask_size_in_bytes;
 }
 
-/* dummy implementation: ignore user-supplied mask and return success */
+static struct shim_thread* lookup_affinity_thread(pid_t pid) {
+    if (!pid) {
+        struct shim_thread* cur_thread = get_cur_thread();
+        get_thread(cur_thread);
+        return cur_thread;
+    }
+
+    /* only threads of the current process are supported */
+    struct shim_thread* thread = lookup_thread(pid);
+    if (thread && (thread->vmid != cur_process.vmid || !thread->pal_handle)) {
+        put_thread(thread);
+        return NULL;
+    }
+    return thread;
+}
+
 int shim_do_sched_setaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr) {
-    __UNUSED(pid);
     int ncpus = PAL_CB(cpu_info.cpu_num);
 
     int bitmask_size_in_bytes = check_affinity_params(ncpus, len, user_mask_ptr);
     if (bitmask_size_in_bytes < 0)
         return bitmask_size_in_bytes;
 
-    return 0;
+    /* ignore CPUs beyond the ones present on the host, like Linux does */
+    __kernel_cpu_set_t mask;
+    memset(&mask, 0, sizeof(mask));
+    memcpy(&mask, user_mask_ptr, MIN((size_t)bitmask_size_in_bytes, sizeof(mask)));
+
+    const int nbits = 8 * sizeof(mask.__bits[0]);
+    bool empty = true;
+    for (int i = 0; i < (int)(8 * sizeof(mask)); i++) {
+        if (i >= ncpus)
+            mask.__bits[i / nbits] &= ~(1UL << (i % nbits));
+        else if (mask.__bits[i / nbits] & (1UL << (i % nbits)))
+            empty = false;
+    }
+    if (empty)
+        return -EINVAL;
+
+    struct shim_thread* thread = lookup_affinity_thread(pid);
+    if (!thread)
+        return -ESRCH;
+
+    int ret = 0;
+    lock(&thread->lock);
+    if (!DkThreadSetCpuAffinity(thread->pal_handle, sizeof(mask), &mask) &&
+        PAL_NATIVE_ERRNO() != PAL_ERROR_NOTIMPLEMENTED) {
+        /* if the PAL cannot pin threads, keep the mask for bookkeeping only */
+        ret = -PAL_ERRNO();
+    } else {
+        memcpy(&thread->cpu_affinity, &mask, sizeof(mask));
+    }
+    unlock(&thread->lock);
+
+    put_thread(thread);
+    return ret;
 }
 
-/* dummy implementation: always return all-ones (as many as there are host CPUs)  */
 int shim_do_sched_getaffinity(pid_t pid, size_t len, __kernel_cpu_set_t* user_mask_ptr) {
-    __UNUSED(pid);
     int ncpus = PAL_CB(cpu_info.cpu_num);
 
     int bitmask_size_in_bytes = check_affinity_params(ncpus, len, user_mask_ptr);
     if (bitmask_size_in_bytes < 0)
         return bitmask_size_in_bytes;
 
+    struct shim_thread* thread = lookup_affinity_thread(pid);
+    if (!thread)
+        return -ESRCH;
+
     memset(user_mask_ptr, 0, len);
-    for (int i = 0; i < ncpus; i++) {
-        ((uint8_t*)user_mask_ptr)[i / 8] |= 1 << (i % 8);
-    }
+    lock(&thread->lock);
+    memcpy(user_mask_ptr, &thread->cpu_affinity,
+           MIN((size_t)bitmask_size_in_bytes, sizeof(thread->cpu_affinity)));
+    unlock(&thread->lock);
+
+    put_thread(thread);
     /* imitate the Linux kernel implementation
      * See SYSCALL_DEFINE3(sched_getaffinity) */
     return bitmask_size_in_bytes;
 }
 
-/* dummy implementation: always return cpu0  */
 int shim_do_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused) {
     __UNUSED(unused);
 
-    if (cpu) {
-        if (test_user_memory(cpu, sizeof(*cpu), /*write=*/true)) {
-            return -EFAULT;
-        }
-        *cpu = 0;
-    }
+    if (cpu && test_user_memory(cpu, sizeof(*cpu), /*write=*/true))
+        return -EFAULT;
 
-    if (node) {
-        if (test_user_memory(node, sizeof(*node), /*write=*/true)) {
-            return -EFAULT;
-        }
-        *node = 0;
-    }
+    if (node && test_user_memory(node, sizeof(*node), /*write=*/true))
+        return -EFAULT;
+
+    /* fall back to cpu0 / node0 if the PAL cannot tell where we run */
+    PAL_NUM host_cpu  = 0;
+    PAL_NUM host_node = 0;
+    DkThreadGetCpu(&host_cpu, &host_node);
+
+    if (cpu)
+        *cpu = host_cpu;
+    if (node)
+        *node = host_node;
 
     return 0;
 }
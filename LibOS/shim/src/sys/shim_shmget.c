@@ -0,0 +1,734 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_shmget.c
+ *
+ * Implementation of system calls "shmget", "shmat", "shmctl" and "shmdt".
+ *
+ * A segment is backed by a host shared-memory object (a file in /dev/shm), which every attaching
+ * process maps with MAP_SHARED, so the contents are never copied. The first page of the object
+ * holds the segment header (size, permissions, number of attaches, ...), the data follows. Keys
+ * are mapped to IDs by the leader of the SysV namespace, as for message queues and semaphores. The
+ * name of the host object is derived from the leader and the ID, so any process can open a segment
+ * knowing only its ID.
+ */
+
+#include <errno.h>
+#include <list.h>
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_checkpoint.h>
+#include <shim_flags_conv.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_ipc.h>
+#include <shim_ipc_sysv.h>
+#include <shim_sysv.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+#include <shim_vma.h>
+
+#ifndef SHM_DEST
+#define SHM_DEST 01000
+#endif
+
+#define SHM_HDR_SIZE   g_pal_alloc_align
+#define SHM_URI_PREFIX "file:/dev/shm/graphene_sysv_shm_"
+#define SHM_URI_LEN    64
+
+#define SHM_TO_HANDLE(shmhdl) container_of((shmhdl), struct shim_handle, info.shm)
+
+/* Segments opened by this process. The list holds a reference to each handle; a segment is
+ * dropped once it is removed and no longer attached in this process. */
+DEFINE_LISTP(shim_shm_handle);
+static LISTP_TYPE(shim_shm_handle) shm_list;
+
+DEFINE_LIST(shm_attach);
+struct shm_attach {
+    LIST_TYPE(shm_attach) list;
+    void* addr;
+    size_t length;
+    int prot;
+    struct shim_handle* hdl;
+};
+DEFINE_LISTP(shm_attach);
+static LISTP_TYPE(shm_attach) shm_attach_list;
+
+static struct shim_lock shm_list_lock;
+
+static uint64_t shm_time(void) {
+    return DkSystemTimeQuery() / 1000000;
+}
+
+static int shm_uri(IDTYPE shmid, char* uri) {
+    IDTYPE leader;
+    int ret = get_sysv_leader(&leader);
+    if (ret < 0)
+        return ret;
+
+    snprintf(uri, SHM_URI_LEN, SHM_URI_PREFIX "%u_%u", leader, shmid);
+    return 0;
+}
+
+static void unmap_shm_hdr(struct shm_segment_hdr* hdr) {
+    void* tmp_vma = NULL;
+    if (bkeep_munmap(hdr, SHM_HDR_SIZE, /*is_internal=*/true, &tmp_vma) < 0)
+        BUG();
+    DkStreamUnmap(hdr, SHM_HDR_SIZE);
+    bkeep_remove_tmp_vma(tmp_vma);
+}
+
+/* Adds the segment backed by the host object `pal_hdl` (opened from `uri`) to the list, and
+ * initializes it if `create` is true. A segment which is already removed is only accepted if
+ * `migrated` is true, i.e. `pal_hdl` was inherited from the parent. Takes over `pal_hdl`. Returns
+ * the segment in `*shmp` with a reference held for the caller. */
+static int __add_shm(PAL_HANDLE pal_hdl, const char* uri, IDTYPE shmid, bool create, bool migrated,
+                     unsigned long key, size_t size, int mode, struct shim_shm_handle** shmp) {
+    assert(locked(&shm_list_lock));
+
+    int ret;
+    if (create && DkStreamSetLength(pal_hdl, SHM_HDR_SIZE + size)) {
+        ret = -ENOSPC;
+        goto err_delete;
+    }
+
+    void* hdr_addr = NULL;
+    ret = bkeep_mmap_any(SHM_HDR_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | VMA_INTERNAL, NULL, 0,
+                         "shm_header", &hdr_addr);
+    if (ret < 0)
+        goto err_delete;
+
+    if (DkStreamMap(pal_hdl, hdr_addr, PAL_PROT_READ | PAL_PROT_WRITE, 0, SHM_HDR_SIZE) != hdr_addr) {
+        ret = -PAL_ERRNO();
+        void* tmp_vma = NULL;
+        if (bkeep_munmap(hdr_addr, SHM_HDR_SIZE, /*is_internal=*/true, &tmp_vma) < 0)
+            BUG();
+        bkeep_remove_tmp_vma(tmp_vma);
+        goto err_delete;
+    }
+
+    struct shm_segment_hdr* hdr = hdr_addr;
+    struct shim_thread* cur = get_cur_thread();
+    if (create) {
+        hdr->key    = key;
+        hdr->size   = size;
+        hdr->mode   = mode & 0777;
+        hdr->cpid   = cur->tgid;
+        hdr->cuid   = hdr->uid = cur->euid;
+        hdr->cgid   = hdr->gid = cur->egid;
+        hdr->ctime  = shm_time();
+    } else if (!hdr->size || (hdr->deleted && !migrated)) {
+        /* removed, or not yet initialized by its creator */
+        ret = -ENOENT;
+        goto err_unmap;
+    }
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl) {
+        ret = -ENOMEM;
+        goto err_unmap;
+    }
+
+    hdl->type       = TYPE_SHM;
+    hdl->flags      = O_RDWR;
+    hdl->acc_mode   = MAY_READ | MAY_WRITE;
+    hdl->pal_handle = pal_hdl;
+    qstrsetstr(&hdl->uri, uri, strlen(uri));
+
+    struct shim_shm_handle* shm = &hdl->info.shm;
+    shm->shmid   = shmid;
+    shm->shmkey  = hdr->key;
+    shm->size    = ALLOC_ALIGN_UP(hdr->size);
+    shm->hdr     = hdr;
+    shm->nattach = 0;
+
+    INIT_LIST_HEAD(shm, list);
+    LISTP_ADD_TAIL(shm, &shm_list, list);
+
+    /* one reference for the list, one for the caller */
+    get_handle(hdl);
+    *shmp = shm;
+    return 0;
+
+err_unmap:
+    unmap_shm_hdr(hdr_addr);
+err_delete:
+    if (create)
+        DkStreamDelete(pal_hdl, 0);
+    DkObjectClose(pal_hdl);
+    return ret;
+}
+
+/* Opens the host object at `uri` (creating it if `create` is true) and adds the segment to the
+ * list, see __add_shm(). */
+static int __open_shm(const char* uri, IDTYPE shmid, bool create, unsigned long key, size_t size,
+                      int mode, struct shim_shm_handle** shmp) {
+    assert(locked(&shm_list_lock));
+
+    PAL_HANDLE pal_hdl = DkStreamOpen(uri, PAL_ACCESS_RDWR, PAL_SHARE_OWNER_R | PAL_SHARE_OWNER_W,
+                                      create ? PAL_CREATE_ALWAYS : 0, 0);
+    if (!pal_hdl)
+        return -PAL_ERRNO();
+
+    return __add_shm(pal_hdl, uri, shmid, create, /*migrated=*/false, key, size, mode, shmp);
+}
+
+/* Drops the segment from the list if it was removed and is no longer attached here. */
+static void __release_shm_if_unused(struct shim_shm_handle* shm) {
+    assert(locked(&shm_list_lock));
+
+    if (!shm->hdr->deleted || shm->nattach || LIST_EMPTY(shm, list))
+        return;
+
+    LISTP_DEL_INIT(shm, &shm_list, list);
+    unmap_shm_hdr(shm->hdr);
+    shm->hdr = NULL;
+    put_handle(SHM_TO_HANDLE(shm));
+}
+
+static struct shim_shm_handle* __get_shm_by_key(unsigned long key) {
+    assert(locked(&shm_list_lock));
+
+    struct shim_shm_handle* shm;
+    struct shim_shm_handle* tmp;
+    LISTP_FOR_EACH_ENTRY_SAFE(shm, tmp, &shm_list, list) {
+        if (shm->shmkey != key)
+            continue;
+        if (shm->hdr->deleted) {
+            __release_shm_if_unused(shm);
+            continue;
+        }
+        get_handle(SHM_TO_HANDLE(shm));
+        return shm;
+    }
+    return NULL;
+}
+
+/* Finds the segment `shmid` in the list or opens its host object. */
+static int __get_shm_by_id(IDTYPE shmid, struct shim_shm_handle** shmp) {
+    assert(locked(&shm_list_lock));
+
+    struct shim_shm_handle* shm;
+    struct shim_shm_handle* tmp;
+    LISTP_FOR_EACH_ENTRY_SAFE(shm, tmp, &shm_list, list) {
+        if (shm->shmid != shmid)
+            continue;
+        if (shm->hdr->deleted) {
+            /* still attached here, but the ID may be in use by a new segment already */
+            __release_shm_if_unused(shm);
+            continue;
+        }
+        get_handle(SHM_TO_HANDLE(shm));
+        *shmp = shm;
+        return 0;
+    }
+
+    char uri[SHM_URI_LEN];
+    int ret = shm_uri(shmid, uri);
+    if (ret < 0)
+        return ret;
+
+    return __open_shm(uri, shmid, /*create=*/false, 0, 0, 0, shmp);
+}
+
+static void put_shm_handle(struct shim_shm_handle* shm) {
+    put_handle(SHM_TO_HANDLE(shm));
+}
+
+int shim_do_shmget(key_t key, size_t size, int shmflg) {
+    if (!create_lock_runtime(&shm_list_lock))
+        return -ENOMEM;
+
+    size_t aligned_size = ALLOC_ALIGN_UP(size);
+    struct sysv_key k = {.key = key, .type = SYSV_SHM};
+    struct shim_shm_handle* shm = NULL;
+    IDTYPE shmid;
+    int ret;
+
+retry:
+    shmid = 0;
+
+    if (key != IPC_PRIVATE) {
+        lock(&shm_list_lock);
+        shm = __get_shm_by_key(key);
+        if (!shm) {
+            /* ask the leader; the segment may be gone, then its ID is reused below */
+            ret = ipc_sysv_findkey_send(&k);
+            if (ret >= 0) {
+                shmid = ret;
+                ret = __get_shm_by_id(shmid, &shm);
+            }
+            if (ret < 0 && ret != -ENOENT) {
+                unlock(&shm_list_lock);
+                return ret;
+            }
+        }
+        unlock(&shm_list_lock);
+
+        if (shm) {
+            if ((shmflg & IPC_CREAT) && (shmflg & IPC_EXCL))
+                ret = -EEXIST;
+            else if (size > shm->hdr->size)
+                ret = -EINVAL;
+            else
+                ret = shm->shmid;
+            put_shm_handle(shm);
+            return ret;
+        }
+
+        if (!(shmflg & IPC_CREAT))
+            return -ENOENT;
+    }
+
+    if (!size || aligned_size < size)
+        return -EINVAL;
+
+    bool new_id = !shmid;
+    if (new_id) {
+        do {
+            shmid = allocate_sysv(0, 0);
+            if (!shmid)
+                ipc_sysv_lease_send(NULL);
+        } while (!shmid);
+    }
+
+    char uri[SHM_URI_LEN];
+    ret = shm_uri(shmid, uri);
+    if (ret < 0)
+        goto err_id;
+
+    lock(&shm_list_lock);
+    ret = __open_shm(uri, shmid, /*create=*/true, key, size, shmflg, &shm);
+    unlock(&shm_list_lock);
+    if (ret == -EEXIST && !new_id) {
+        /* somebody else re-created the segment under the same key */
+        goto retry;
+    }
+    if (ret < 0)
+        goto err_id;
+
+    if (new_id && key != IPC_PRIVATE) {
+        if ((ret = ipc_sysv_tellkey_send(NULL, 0, &k, shmid, 0)) < 0) {
+            lock(&shm_list_lock);
+            shm->hdr->deleted = true;
+            DkStreamDelete(SHM_TO_HANDLE(shm)->pal_handle, 0);
+            __release_shm_if_unused(shm);
+            unlock(&shm_list_lock);
+            put_shm_handle(shm);
+            goto err_id;
+        }
+    }
+
+    put_shm_handle(shm);
+    return shmid;
+
+err_id:
+    if (new_id)
+        release_sysv(shmid);
+    return ret;
+}
+
+/* Returns true if the page at `addr` inside the attachment `att` is still mapped from the segment
+ * at the offset where `att` mapped it; the application may have unmapped or replaced it since. */
+static bool __shm_attach_mapped_at(struct shm_attach* att, void* addr,
+                                   struct shim_vma_info* vma_info) {
+    if (lookup_vma(addr, vma_info) < 0) {
+        vma_info->addr = NULL;
+        return false;
+    }
+
+    bool ret = vma_info->file == att->hdl
+               && (size_t)vma_info->file_offset + (addr - vma_info->addr)
+                      == SHM_HDR_SIZE + (addr - att->addr);
+    if (vma_info->file)
+        put_handle(vma_info->file);
+    return ret;
+}
+
+/* Drops the record of the attachment `att` without touching memory. */
+static void __release_shm_attach(struct shm_attach* att) {
+    assert(locked(&shm_list_lock));
+
+    LISTP_DEL(att, &shm_attach_list, list);
+
+    struct shim_shm_handle* shm = &att->hdl->info.shm;
+    __atomic_sub_fetch(&shm->hdr->nattch, 1, __ATOMIC_SEQ_CST);
+    shm->hdr->dtime = shm_time();
+    struct shim_thread* cur = get_cur_thread();
+    if (cur)
+        shm->hdr->lpid = cur->tgid;
+    shm->nattach--;
+    __release_shm_if_unused(shm);
+
+    put_handle(att->hdl);
+    free(att);
+}
+
+/* Maps the segment at `addr` (which must already be bookkept) and records the attachment. */
+static int __attach_shm(struct shim_shm_handle* shm, void* addr, int prot) {
+    assert(locked(&shm_list_lock));
+
+    struct shim_handle* hdl = SHM_TO_HANDLE(shm);
+    struct shm_attach* att = malloc(sizeof(*att));
+    if (!att)
+        return -ENOMEM;
+
+    if (DkStreamMap(hdl->pal_handle, addr, LINUX_PROT_TO_PAL(prot, MAP_SHARED), SHM_HDR_SIZE,
+                    shm->size) != addr) {
+        free(att);
+        return -PAL_ERRNO();
+    }
+
+    get_handle(hdl);
+    att->addr   = addr;
+    att->length = shm->size;
+    att->prot   = prot;
+    att->hdl    = hdl;
+    INIT_LIST_HEAD(att, list);
+    LISTP_ADD_TAIL(att, &shm_attach_list, list);
+    shm->nattach++;
+
+    __atomic_add_fetch(&shm->hdr->nattch, 1, __ATOMIC_SEQ_CST);
+    shm->hdr->atime = shm_time();
+    /* no current thread yet while restoring a checkpoint */
+    struct shim_thread* cur = get_cur_thread();
+    if (cur)
+        shm->hdr->lpid = cur->tgid;
+
+    /* attachments which started inside the new one were replaced by it (SHM_REMAP, or unmapped by
+     * the application and the range reused), so they can no longer be detached */
+    struct shm_attach* old;
+    struct shm_attach* tmp;
+    LISTP_FOR_EACH_ENTRY_SAFE(old, tmp, &shm_attach_list, list) {
+        if (old != att && old->addr >= addr && old->addr < addr + att->length)
+            __release_shm_attach(old);
+    }
+    return 0;
+}
+
+void* shim_do_shmat(int shmid, const void* shmaddr, int shmflg) {
+    if (!create_lock_runtime(&shm_list_lock))
+        return (void*)-ENOMEM;
+
+    if (shmid < 0)
+        return (void*)-EINVAL;
+
+    void* addr = (void*)shmaddr;
+    if (addr) {
+        if (shmflg & SHM_RND)
+            addr = ALLOC_ALIGN_DOWN_PTR(addr);
+        else if (!IS_ALLOC_ALIGNED_PTR(addr))
+            return (void*)-EINVAL;
+    } else if (shmflg & SHM_REMAP) {
+        return (void*)-EINVAL;
+    }
+
+    int prot = PROT_READ;
+    if (!(shmflg & SHM_RDONLY))
+        prot |= PROT_WRITE;
+    if (shmflg & SHM_EXEC)
+        prot |= PROT_EXEC;
+
+    lock(&shm_list_lock);
+
+    struct shim_shm_handle* shm;
+    long ret = __get_shm_by_id(shmid, &shm);
+    if (ret < 0) {
+        unlock(&shm_list_lock);
+        return (void*)(ret == -ENOENT ? -EINVAL : ret);
+    }
+
+    struct shim_handle* hdl = SHM_TO_HANDLE(shm);
+    size_t size = shm->size;
+
+    if (addr) {
+        if (!access_ok(addr, size) || addr < PAL_CB(user_address.start)
+                || (uintptr_t)PAL_CB(user_address.end) < (uintptr_t)addr + size) {
+            ret = -EINVAL;
+            goto out;
+        }
+        ret = bkeep_mmap_fixed(addr, size, prot,
+                               MAP_SHARED | ((shmflg & SHM_REMAP) ? MAP_FIXED : MAP_FIXED_NOREPLACE),
+                               hdl, SHM_HDR_SIZE, "shm");
+        if (ret == -EEXIST)
+            ret = -EINVAL;
+    } else {
+        ret = bkeep_mmap_any_aslr(size, prot, MAP_SHARED, hdl, SHM_HDR_SIZE, "shm", &addr);
+        if (ret < 0)
+            ret = -ENOMEM;
+    }
+    if (ret < 0)
+        goto out;
+
+    ret = __attach_shm(shm, addr, prot);
+    if (ret < 0) {
+        void* tmp_vma = NULL;
+        if (bkeep_munmap(addr, size, /*is_internal=*/false, &tmp_vma) < 0) {
+            debug("[shmat] Failed to remove bookkeeped memory that was not allocated at %p-%p!\n",
+                  addr, (char*)addr + size);
+            BUG();
+        }
+        bkeep_remove_tmp_vma(tmp_vma);
+    }
+
+out:
+    unlock(&shm_list_lock);
+    put_shm_handle(shm);
+    return ret < 0 ? (void*)ret : addr;
+}
+
+/* Unmaps the parts of the attachment `att` which are still mapped from the segment and drops it. */
+static void __detach_shm(struct shm_attach* att) {
+    assert(locked(&shm_list_lock));
+
+    char* addr = att->addr;
+    char* end  = addr + att->length;
+    while (addr < end) {
+        struct shim_vma_info vma_info;
+        if (!__shm_attach_mapped_at(att, addr, &vma_info)) {
+            addr = vma_info.addr ? MIN(end, (char*)vma_info.addr + vma_info.length)
+                                 : addr + g_pal_alloc_align;
+            continue;
+        }
+
+        char* next = MIN(end, (char*)vma_info.addr + vma_info.length);
+        void* tmp_vma = NULL;
+        if (bkeep_munmap(addr, next - addr, /*is_internal=*/false, &tmp_vma) < 0)
+            BUG();
+        DkStreamUnmap(addr, next - addr);
+        bkeep_remove_tmp_vma(tmp_vma);
+        addr = next;
+    }
+
+    __release_shm_attach(att);
+}
+
+int shim_do_shmdt(const void* shmaddr) {
+    if (!create_lock_runtime(&shm_list_lock))
+        return -ENOMEM;
+
+    int ret = -EINVAL;
+    struct shm_attach* att;
+
+    lock(&shm_list_lock);
+    LISTP_FOR_EACH_ENTRY(att, &shm_attach_list, list) {
+        if (att->addr != shmaddr)
+            continue;
+        /* like Linux, fail if the segment is no longer mapped at its start address */
+        struct shim_vma_info vma_info;
+        if (__shm_attach_mapped_at(att, att->addr, &vma_info)) {
+            __detach_shm(att);
+            ret = 0;
+        }
+        break;
+    }
+    unlock(&shm_list_lock);
+    return ret;
+}
+
+void detach_all_shm(void) {
+    if (!lock_created(&shm_list_lock))
+        return;
+
+    struct shm_attach* att;
+    struct shm_attach* tmp;
+
+    lock(&shm_list_lock);
+    LISTP_FOR_EACH_ENTRY_SAFE(att, tmp, &shm_attach_list, list) {
+        __detach_shm(att);
+    }
+    unlock(&shm_list_lock);
+}
+
+int shim_do_shmctl(int shmid, int cmd, struct shmid_ds* buf) {
+    if (!create_lock_runtime(&shm_list_lock))
+        return -ENOMEM;
+
+    if (shmid < 0)
+        return -EINVAL;
+
+    /* x86-64 always uses the 64-bit layout */
+    struct shmid64_ds* ds = (struct shmid64_ds*)buf;
+
+    switch (cmd) {
+        case IPC_STAT:
+            if (test_user_memory(ds, sizeof(*ds), /*write=*/true))
+                return -EFAULT;
+            break;
+        case IPC_SET:
+            if (test_user_memory(ds, sizeof(*ds), /*write=*/false))
+                return -EFAULT;
+            break;
+        case IPC_RMID:
+        case SHM_LOCK:
+        case SHM_UNLOCK:
+            break;
+        default:
+            return -EINVAL;
+    }
+
+    lock(&shm_list_lock);
+
+    struct shim_shm_handle* shm;
+    int ret = __get_shm_by_id(shmid, &shm);
+    if (ret < 0) {
+        unlock(&shm_list_lock);
+        return ret == -ENOENT ? -EINVAL : ret;
+    }
+
+    struct shm_segment_hdr* hdr = shm->hdr;
+
+    switch (cmd) {
+        case IPC_STAT:
+            memset(ds, 0, sizeof(*ds));
+            ds->shm_perm.key  = hdr->key;
+            ds->shm_perm.uid  = hdr->uid;
+            ds->shm_perm.gid  = hdr->gid;
+            ds->shm_perm.cuid = hdr->cuid;
+            ds->shm_perm.cgid = hdr->cgid;
+            ds->shm_perm.mode = hdr->mode | (hdr->deleted ? SHM_DEST : 0);
+            ds->shm_segsz     = hdr->size;
+            ds->shm_atime     = hdr->atime;
+            ds->shm_dtime     = hdr->dtime;
+            ds->shm_ctime     = hdr->ctime;
+            ds->shm_cpid      = hdr->cpid;
+            ds->shm_lpid      = hdr->lpid;
+            ds->shm_nattch    = __atomic_load_n(&hdr->nattch, __ATOMIC_SEQ_CST);
+            break;
+
+        case IPC_SET:
+            hdr->uid   = ds->shm_perm.uid;
+            hdr->gid   = ds->shm_perm.gid;
+            hdr->mode  = ds->shm_perm.mode & 0777;
+            hdr->ctime = shm_time();
+            break;
+
+        case IPC_RMID:
+            /* The host object is unlinked right away; the host frees the memory when the last
+             * process closes it, which gives the Linux semantics of a destroyed segment. Children
+             * forked later inherit the open host object (see the checkpoint of attachments). */
+            hdr->deleted = true;
+            hdr->key     = IPC_PRIVATE;
+            hdr->ctime   = shm_time();
+            DkStreamDelete(SHM_TO_HANDLE(shm)->pal_handle, 0);
+            __release_shm_if_unused(shm);
+            break;
+
+        default:
+            /* SHM_LOCK and SHM_UNLOCK: memory is never swapped out by us */
+            break;
+    }
+
+    unlock(&shm_list_lock);
+    put_shm_handle(shm);
+    return 0;
+}
+
+struct shm_attach_cp {
+    IDTYPE shmid;
+    void* addr;
+    size_t length;
+    int prot;
+    /* Only the first attachment of each segment carries the host object, which is migrated
+     * because it may already be unlinked; the others point to that first attachment. */
+    PAL_HANDLE pal_handle;
+    struct shm_attach_cp* first;
+    struct shim_shm_handle* shm; /* set when the first attachment is restored */
+    char uri[];
+};
+
+BEGIN_CP_FUNC(shm_attach) {
+    __UNUSED(size);
+    assert(size == sizeof(struct shm_attach));
+
+    struct shm_attach* att = (struct shm_attach*)obj;
+    const char* uri = qstrgetstr(&att->hdl->uri);
+    size_t uri_len  = strlen(uri);
+
+    size_t off = ADD_CP_OFFSET(sizeof(struct shm_attach_cp) + uri_len + 1);
+    struct shm_attach_cp* new_att = (struct shm_attach_cp*)(base + off);
+
+    new_att->shmid      = att->hdl->info.shm.shmid;
+    new_att->addr       = att->addr;
+    new_att->length     = att->length;
+    new_att->prot       = att->prot;
+    new_att->pal_handle = NULL;
+    new_att->first      = NULL;
+    new_att->shm        = NULL;
+    memcpy(new_att->uri, uri, uri_len + 1);
+
+    /* the segment (not the handle, which is not migrated as such) identifies the first attach */
+    size_t first_off = GET_FROM_CP_MAP(&att->hdl->info.shm);
+    if (first_off) {
+        new_att->first = (struct shm_attach_cp*)(base + first_off);
+    } else {
+        ADD_TO_CP_MAP(&att->hdl->info.shm, off);
+        struct shim_palhdl_entry* entry;
+        DO_CP(palhdl, att->hdl->pal_handle, &entry);
+        entry->phandle = &new_att->pal_handle;
+    }
+
+    ADD_CP_FUNC_ENTRY(off);
+
+    if (objp)
+        *objp = (void*)new_att;
+}
+END_CP_FUNC(shm_attach)
+
+BEGIN_RS_FUNC(shm_attach) {
+    __UNUSED(offset);
+    struct shm_attach_cp* att = (void*)(base + GET_CP_FUNC_ENTRY());
+    CP_REBASE(att->first);
+
+    if (!create_lock_runtime(&shm_list_lock))
+        return -ENOMEM;
+
+    lock(&shm_list_lock);
+
+    int ret;
+    struct shim_shm_handle* shm;
+    if (att->first) {
+        /* restored before this one, as it was checkpointed first */
+        shm = att->first->shm;
+        get_handle(SHM_TO_HANDLE(shm));
+    } else {
+        ret = __add_shm(att->pal_handle, att->uri, att->shmid, /*create=*/false,
+                        /*migrated=*/true, 0, 0, 0, &shm);
+        if (ret < 0) {
+            unlock(&shm_list_lock);
+            return ret;
+        }
+        att->shm = shm;
+    }
+
+    ret = bkeep_mmap_fixed(att->addr, att->length, att->prot, MAP_SHARED | MAP_FIXED,
+                           SHM_TO_HANDLE(shm), SHM_HDR_SIZE, "shm");
+    if (ret >= 0)
+        ret = __attach_shm(shm, att->addr, att->prot);
+
+    unlock(&shm_list_lock);
+    put_shm_handle(shm);
+
+    DEBUG_RS("shmid=%u,addr=%p,length=%lu", att->shmid, att->addr, att->length);
+    return ret;
+}
+END_RS_FUNC(shm_attach)
+
+BEGIN_CP_FUNC(all_shm_attaches) {
+    __UNUSED(obj);
+    __UNUSED(size);
+    __UNUSED(objp);
+
+    if (!lock_created(&shm_list_lock))
+        return 0;
+
+    struct shm_attach* att;
+    lock(&shm_list_lock);
+    LISTP_FOR_EACH_ENTRY(att, &shm_attach_list, list) {
+        DO_CP(shm_attach, att, NULL);
+    }
+    unlock(&shm_list_lock);
+}
+END_CP_FUNC_NO_RS(all_shm_attaches)
@@ -217,6 +217,7 @@ struct signal_thread_arg {
     IDTYPE cmp_val;
     enum signal_thread_arg_type cmp_type;
     bool sent;
+    siginfo_t* info; /* if not NULL, used instead of a siginfo built from `sig` and `sender` */
 };
 
 static int _signal_one_thread(struct shim_thread* thread, void* _arg) {
@@ -258,7 +259,7 @@ static int _signal_one_thread(struct shim_thread* thread, void* _arg) {
             .si_signo = arg->sig,
             .si_pid   = arg->sender,
         };
-        ret = append_signal(NULL, &info);
+        ret = append_signal(NULL, arg->info ? arg->info : &info);
         if (ret < 0) {
             goto out;
         }
@@ -266,12 +267,18 @@ static int _signal_one_thread(struct shim_thread* thread, void* _arg) {
     }
     if (arg->sent && !__sigismember(&thread->signal_mask, arg->sig)) {
         if (thread == get_cur_thread()) {
+            if (__atomic_load_n(&thread->host_futex_uaddr, __ATOMIC_RELAXED)) {
+                /* We are a host signal handler which interrupted our own host futex wait before
+                 * it started, so it would not notice the signal; let another thread handle it. */
+                goto out;
+            }
             /* We are ending this walk anyway, lets reuse sent field to mark that current thread
              * needs to handle a signal. */
             arg->sent = false;
         } else {
             thread_wakeup(thread);
             DkThreadResume(thread->pal_handle);
+            wake_host_futex_waiter(thread);
         }
         ret = 1;
     }
@@ -318,6 +325,27 @@ int do_kill_proc(IDTYPE sender, IDTYPE tgid, int sig, bool use_ipc) {
     return -ESRCH;
 }
 
+int do_kill_proc_info(IDTYPE tgid, siginfo_t* info) {
+    struct signal_thread_arg arg = {
+        .sig = info->si_signo,
+        .sender = tgid,
+        .cmp_val = tgid,
+        .cmp_type = TGID,
+        .sent = false,
+        .info = info,
+    };
+    int ret = walk_thread_list(_signal_one_thread, &arg, /*one_shot=*/true);
+    if (ret < 0 && ret != -ESRCH)
+        return ret;
+
+    if (ret == 0 && !arg.sent) {
+        /* We delivered the signal to self, now need to handle it. */
+        handle_signals();
+    }
+
+    return (ret == 0 || arg.sent) ? 0 : -ESRCH;
+}
+
 int do_kill_pgroup(IDTYPE sender, IDTYPE pgid, int sig, bool use_ipc) {
     struct shim_thread* cur = get_cur_thread();
     int ret = 0;
@@ -415,6 +443,7 @@ int do_kill_thread(IDTYPE sender, IDTYPE tgid, IDTYPE tid, int sig, bool use_ipc
                 if (ret >= 0) {
                     thread_wakeup(thread);
                     DkThreadResume(thread->pal_handle);
+                    wake_host_futex_waiter(thread);
                 }
             }
             use_ipc = false;
@@ -433,6 +462,26 @@ int do_kill_thread(IDTYPE sender, IDTYPE tgid, IDTYPE tid, int sig, bool use_ipc
     return ipc_pid_kill_send(sender, tid, KILL_THREAD, sig);
 }
 
+int do_kill_thread_info(IDTYPE tgid, IDTYPE tid, siginfo_t* info) {
+    struct shim_thread* thread = lookup_thread(tid);
+    if (!thread)
+        return -ESRCH;
+
+    int ret = -ESRCH;
+    lock(&thread->lock);
+    if (thread->in_vm && thread->is_alive && thread->tgid == tgid) {
+        ret = append_signal(thread, info);
+        if (ret >= 0) {
+            thread_wakeup(thread);
+            DkThreadResume(thread->pal_handle);
+            wake_host_futex_waiter(thread);
+        }
+    }
+    unlock(&thread->lock);
+    put_thread(thread);
+    return ret;
+}
+
 int shim_do_tkill(pid_t tid, int sig) {
     if (tid <= 0)
         return -EINVAL;
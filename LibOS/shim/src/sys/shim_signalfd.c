@@ -0,0 +1,349 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_signalfd.c
+ *
+ * Implementation of system calls "signalfd" and "signalfd4".
+ *
+ * Reading a signalfd pops pending signals in its mask from the queues of the calling thread and of
+ * the process (see dequeue_signal() in shim_signal.c), without running their handlers. The PAL
+ * handle of a signalfd is a LibOS event which is set when a signal in the mask is appended to any
+ * queue of the process, so signalfds can be waited on by poll(), select() and epoll like any other
+ * PAL-backed handle, and a signal arrival costs one wakeup.
+ *
+ * Limitation: a signal sent to another thread also makes the signalfd readable, so a thread may
+ * see the signalfd readable and then find nothing to read (read() then blocks or fails with
+ * EAGAIN, as after a race with another reader on Linux).
+ */
+
+#include <asm/fcntl.h>
+#include <linux/signalfd.h>
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_signal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+
+/* Signalfds of this process, as a list of notifiers. signalfd_notify() runs when a signal is
+ * appended, possibly in a host signal handler which interrupted a holder of any LibOS lock, so it
+ * walks the list without a lock:
+ * - notifiers are only ever added at the head (under g_signalfd_list_lock) and never freed, so
+ *   `next` pointers stay valid; a notifier whose signalfd was closed is reused by the next one;
+ * - a notifier references its signalfd without holding a reference; signalfd_notify() announces
+ *   itself in `users` before loading `sfd`, and a closing signalfd clears `sfd` and then waits
+ *   until `users` drops to zero.
+ * The lock serializes the writers and also protects the masks of the signalfds. `g_signalfd_sigs`
+ * is the union of all masks, so that appending a signal nobody waits for costs nothing. */
+struct signalfd_notifier {
+    struct signalfd_notifier* next;
+    struct shim_signalfd_handle* sfd; /* NULL if unused */
+    uint64_t mask;                    /* signals of `sfd` */
+    uint32_t users;                   /* signalfd_notify() calls looking at `sfd` */
+};
+
+static struct signalfd_notifier* g_signalfd_notifiers;
+static struct shim_lock g_signalfd_list_lock;
+static uint64_t g_signalfd_sigs;
+
+/* must be called with g_signalfd_list_lock held */
+static void __update_signalfd_sigs(void) {
+    assert(locked(&g_signalfd_list_lock));
+
+    uint64_t sigs = 0;
+    for (struct signalfd_notifier* n = g_signalfd_notifiers; n; n = n->next)
+        sigs |= __atomic_load_n(&n->mask, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_signalfd_sigs, sigs, __ATOMIC_RELEASE);
+}
+
+static void signalfd_set_ready(struct shim_signalfd_handle* sfd) {
+    if (!__atomic_exchange_n(&sfd->ready, true, __ATOMIC_SEQ_CST))
+        set_event(&sfd->event, 1);
+}
+
+/* Clears the event of `sfd` unless a signal in its mask is pending for the current thread. The
+ * event is drained before `ready` is reset, so that a concurrent signalfd_notify() either sees
+ * `ready` unset and sets the event again, or appended its signal before the check below. */
+static void signalfd_refresh(struct shim_signalfd_handle* sfd, const __sigset_t* mask) {
+    clear_event(&sfd->event);
+    __atomic_store_n(&sfd->ready, false, __ATOMIC_SEQ_CST);
+
+    __sigset_t pending;
+    get_pending_signals(get_cur_thread(), &pending);
+    if (pending.__val[0] & mask->__val[0])
+        signalfd_set_ready(sfd);
+}
+
+/* Lock-free, see the comment on struct signalfd_notifier. */
+void signalfd_notify(int sig) {
+    uint64_t sigmask = __sigmask(sig);
+    if (!(__atomic_load_n(&g_signalfd_sigs, __ATOMIC_ACQUIRE) & sigmask))
+        return;
+
+    struct signalfd_notifier* n = __atomic_load_n(&g_signalfd_notifiers, __ATOMIC_ACQUIRE);
+    for (; n; n = n->next) {
+        if (!(__atomic_load_n(&n->mask, __ATOMIC_ACQUIRE) & sigmask))
+            continue;
+
+        __atomic_add_fetch(&n->users, 1, __ATOMIC_SEQ_CST);
+        struct shim_signalfd_handle* sfd = __atomic_load_n(&n->sfd, __ATOMIC_SEQ_CST);
+        if (sfd)
+            signalfd_set_ready(sfd);
+        __atomic_sub_fetch(&n->users, 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void siginfo_to_signalfd_siginfo(const siginfo_t* info, struct signalfd_siginfo* ssi) {
+    memset(ssi, 0, sizeof(*ssi));
+    ssi->ssi_signo = info->si_signo;
+    ssi->ssi_errno = info->si_errno;
+    ssi->ssi_code  = info->si_code;
+
+    /* the meaningful members of the siginfo union depend on the signal and on its origin */
+    if (info->si_code == SI_TIMER) {
+        ssi->ssi_tid     = info->si_tid;
+        ssi->ssi_overrun = info->si_overrun;
+        ssi->ssi_ptr     = (uint64_t)(uintptr_t)info->si_ptr;
+        ssi->ssi_int     = info->si_int;
+    } else if (info->si_signo == SIGCHLD) {
+        ssi->ssi_pid    = info->si_pid;
+        ssi->ssi_uid    = info->si_uid;
+        ssi->ssi_status = info->si_status;
+        ssi->ssi_utime  = info->si_utime;
+        ssi->ssi_stime  = info->si_stime;
+    } else if (info->si_code > 0 && (info->si_signo == SIGSEGV || info->si_signo == SIGBUS ||
+                                     info->si_signo == SIGILL || info->si_signo == SIGFPE ||
+                                     info->si_signo == SIGTRAP)) {
+        ssi->ssi_addr = (uint64_t)(uintptr_t)info->si_addr;
+    } else if (info->si_code > 0 && info->si_signo == SIGIO) {
+        ssi->ssi_band = info->si_band;
+        ssi->ssi_fd   = info->si_fd;
+    } else {
+        ssi->ssi_pid = info->si_pid;
+        ssi->ssi_uid = info->si_uid;
+        ssi->ssi_ptr = (uint64_t)(uintptr_t)info->si_ptr;
+        ssi->ssi_int = info->si_int;
+    }
+}
+
+static ssize_t signalfd_read(struct shim_handle* hdl, void* buf, size_t count) {
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+    struct signalfd_siginfo* ssi = buf;
+    size_t max = count / sizeof(*ssi);
+    size_t n = 0;
+
+    if (!max)
+        return -EINVAL;
+
+    struct shim_thread* cur = get_cur_thread();
+
+    while (true) {
+        lock(&g_signalfd_list_lock);
+        __sigset_t mask = sfd->mask;
+        unlock(&g_signalfd_list_lock);
+
+        siginfo_t info;
+        while (n < max && dequeue_signal(cur, &mask, &info)) {
+            siginfo_to_signalfd_siginfo(&info, &ssi[n]);
+            n++;
+        }
+
+        signalfd_refresh(sfd, &mask);
+        if (n)
+            break;
+
+        lock(&hdl->lock);
+        bool nonblock = hdl->flags & O_NONBLOCK;
+        PAL_HANDLE pal_handle = hdl->pal_handle;
+        unlock(&hdl->lock);
+        if (nonblock)
+            return -EAGAIN;
+
+        PAL_FLG events = PAL_WAIT_READ;
+        PAL_FLG ret_events = 0;
+        if (!DkStreamsWaitEvents(1, &pal_handle, &events, &ret_events, NO_TIMEOUT))
+            return -PAL_ERRNO();
+    }
+
+    return n * sizeof(*ssi);
+}
+
+static ssize_t signalfd_write(struct shim_handle* hdl, const void* buf, size_t count) {
+    __UNUSED(hdl);
+    __UNUSED(buf);
+    __UNUSED(count);
+    return -EINVAL;
+}
+
+/* must be called with g_signalfd_list_lock held */
+static void __set_signalfd_mask(struct shim_signalfd_handle* sfd, const __sigset_t* mask) {
+    assert(locked(&g_signalfd_list_lock));
+
+    sfd->mask = *mask;
+    if (sfd->notifier)
+        __atomic_store_n(&sfd->notifier->mask, mask->__val[0], __ATOMIC_RELEASE);
+    __update_signalfd_sigs();
+}
+
+static int signalfd_attach(struct shim_signalfd_handle* sfd) {
+    lock(&g_signalfd_list_lock);
+    struct signalfd_notifier* n = g_signalfd_notifiers;
+    while (n && __atomic_load_n(&n->sfd, __ATOMIC_RELAXED))
+        n = n->next;
+
+    if (!n) {
+        n = malloc(sizeof(*n));
+        if (!n) {
+            unlock(&g_signalfd_list_lock);
+            return -ENOMEM;
+        }
+        n->sfd   = NULL;
+        n->mask  = 0;
+        n->users = 0;
+        n->next  = g_signalfd_notifiers;
+        __atomic_store_n(&g_signalfd_notifiers, n, __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&n->sfd, sfd, __ATOMIC_SEQ_CST);
+    sfd->notifier = n;
+    __set_signalfd_mask(sfd, &sfd->mask);
+    unlock(&g_signalfd_list_lock);
+    return 0;
+}
+
+static int signalfd_close(struct shim_handle* hdl) {
+    /* the event is closed together with the PAL handle of `hdl` */
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+    struct signalfd_notifier* n = sfd->notifier;
+    if (!n)
+        return 0;
+
+    lock(&g_signalfd_list_lock);
+    __atomic_store_n(&n->mask, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&n->sfd, NULL, __ATOMIC_SEQ_CST);
+    sfd->notifier = NULL;
+    __update_signalfd_sigs();
+    unlock(&g_signalfd_list_lock);
+
+    /* a signalfd_notify() which loaded `sfd` before it was cleared may still set its event */
+    while (__atomic_load_n(&n->users, __ATOMIC_SEQ_CST))
+        DkThreadYieldExecution();
+    return 0;
+}
+
+static int signalfd_checkout(struct shim_handle* hdl) {
+    /* the child creates its own event */
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+    sfd->ready       = false;
+    sfd->event.event = NULL;
+    sfd->notifier    = NULL;
+    hdl->pal_handle = NULL;
+    return 0;
+}
+
+static int signalfd_checkin(struct shim_handle* hdl) {
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+
+    if (!create_lock_runtime(&g_signalfd_list_lock))
+        return -ENOMEM;
+
+    create_event(&sfd->event);
+    if (!event_created(&sfd->event))
+        return -ENOMEM;
+    hdl->pal_handle = event_handle(&sfd->event);
+
+    /* there is no current thread to check pending signals for yet; start readable, the first
+     * read() clears the event if nothing is pending */
+    signalfd_set_ready(sfd);
+    return signalfd_attach(sfd);
+}
+
+struct shim_fs_ops signalfd_fs_ops = {
+    .read     = &signalfd_read,
+    .write    = &signalfd_write,
+    .close    = &signalfd_close,
+    .checkout = &signalfd_checkout,
+    .checkin  = &signalfd_checkin,
+};
+
+struct shim_mount signalfd_builtin_fs = {
+    .type   = "signalfd",
+    .fs_ops = &signalfd_fs_ops,
+};
+
+int shim_do_signalfd4(int ufd, __sigset_t* user_mask, size_t sizemask, int flags) {
+    if (flags & ~(SFD_NONBLOCK | SFD_CLOEXEC))
+        return -EINVAL;
+    if (sizemask != sizeof(__sigset_t))
+        return -EINVAL;
+    if (!user_mask || test_user_memory(user_mask, sizemask, false))
+        return -EFAULT;
+
+    __sigset_t mask = *user_mask;
+    /* SIGKILL and SIGSTOP cannot be received through a signalfd */
+    __sigdelset(&mask, SIGKILL);
+    __sigdelset(&mask, SIGSTOP);
+
+    if (!create_lock_runtime(&g_signalfd_list_lock))
+        return -ENOMEM;
+
+    struct shim_handle* hdl;
+    int ret;
+
+    if (ufd != -1) {
+        hdl = get_fd_handle(ufd, NULL, NULL);
+        if (!hdl)
+            return -EBADF;
+        if (hdl->type != TYPE_SIGNALFD) {
+            put_handle(hdl);
+            return -EINVAL;
+        }
+
+        lock(&g_signalfd_list_lock);
+        __set_signalfd_mask(&hdl->info.signalfd, &mask);
+        unlock(&g_signalfd_list_lock);
+
+        signalfd_refresh(&hdl->info.signalfd, &mask);
+        put_handle(hdl);
+        return ufd;
+    }
+
+    hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    hdl->type = TYPE_SIGNALFD;
+    set_handle_fs(hdl, &signalfd_builtin_fs);
+    hdl->flags    = O_RDWR | (flags & SFD_NONBLOCK ? O_NONBLOCK : 0);
+    hdl->acc_mode = MAY_READ;
+
+    struct shim_signalfd_handle* sfd = &hdl->info.signalfd;
+    memset(sfd, 0, sizeof(*sfd));
+    sfd->mask = mask;
+
+    create_event(&sfd->event);
+    if (!event_created(&sfd->event)) {
+        ret = -ENOMEM;
+        goto out;
+    }
+    hdl->pal_handle = event_handle(&sfd->event);
+
+    /* signals which are already pending make the new signalfd readable right away */
+    ret = signalfd_attach(sfd);
+    if (ret < 0)
+        goto out;
+    signalfd_refresh(sfd, &mask);
+
+    ret = set_new_fd_handle(hdl, flags & SFD_CLOEXEC ? FD_CLOEXEC : 0, NULL);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_signalfd(int ufd, __sigset_t* user_mask, size_t sizemask) {
+    return shim_do_signalfd4(ufd, user_mask, sizemask, 0);
+}
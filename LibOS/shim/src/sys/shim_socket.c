@@ -83,9 +83,6 @@ static int init_port_rebase(void) {
     return 0;
 }
 
-static int inet_parse_addr(int domain, int type, const char* uri, struct addr_inet* bind,
-                           struct addr_inet* conn);
-
 static int __process_pending_options(struct shim_handle* hdl);
 
 int shim_do_socket(int family, int type, int protocol) {
@@ -326,6 +323,8 @@ static size_t inet_copy_addr(int domain, struct sockaddr* saddr, size_t saddr_le
     struct sockaddr_in6* in6;
     size_t len = 0;
 
+    memset(&ss, 0, sizeof(ss));
+
     switch (domain) {
       case AF_INET:
         in = (struct sockaddr_in*)&ss;
@@ -380,6 +379,34 @@ static void inet_save_addr(int domain, struct addr_inet* addr, const struct sock
     }
 }
 
+/* Host socket addresses exchanged with the PAL carry the external (rebased) port */
+static void inet_load_host_addr(int domain, struct addr_inet* addr,
+                                const struct sockaddr* host_addr, bool local) {
+    inet_save_addr(domain, addr, host_addr);
+    addr->ext_port = addr->port;
+    inet_rebase_port(true, domain, addr, local);
+}
+
+static size_t inet_make_host_addr(int domain, struct sockaddr_storage* host_addr,
+                                  const struct addr_inet* addr) {
+    struct addr_inet ext_addr = *addr;
+    ext_addr.port = addr->ext_port;
+    return inet_copy_addr(domain, (struct sockaddr*)host_addr, sizeof(*host_addr), &ext_addr);
+}
+
+/* read back an address the host chose for a socket (e.g., an ephemeral port) */
+static int inet_get_host_addr(PAL_HANDLE pal_hdl, int which, int domain, struct addr_inet* addr,
+                              bool local) {
+    struct sockaddr_storage host_addr;
+    PAL_NUM host_addrlen = sizeof(host_addr);
+
+    if (!DkStreamGetSockAddr(pal_hdl, which, &host_addr, &host_addrlen))
+        return -PAL_ERRNO();
+
+    inet_load_host_addr(domain, addr, (struct sockaddr*)&host_addr, local);
+    return 0;
+}
+
 static inline bool inet_comp_addr(int domain, const struct addr_inet* addr,
                                   const struct sockaddr* saddr) {
     if (domain == AF_INET) {
@@ -542,18 +569,9 @@ int shim_do_bind(int sockfd, struct sockaddr* addr, int _addrlen) {
     }
 
     if (sock->domain == AF_INET || sock->domain == AF_INET6) {
-        char uri[SOCK_URI_SIZE];
-
-        if (!DkStreamGetName(pal_hdl, uri, SOCK_URI_SIZE)) {
-            ret = -PAL_ERRNO();
-            goto out;
-        }
-
-        if ((ret = inet_parse_addr(sock->domain, sock->sock_type, uri, &sock->addr.in.bind, NULL)) <
-            0)
+        if ((ret = inet_get_host_addr(pal_hdl, PAL_SOCKADDR_LOCAL, sock->domain,
+                                      &sock->addr.in.bind, /*local=*/true)) < 0)
             goto out;
-
-        inet_rebase_port(true, sock->domain, &sock->addr.in.bind, true);
     }
 
     hdl->pal_handle = pal_hdl;
@@ -576,76 +594,6 @@ out:
     return ret;
 }
 
-static int inet_parse_addr(int domain, int type, const char* uri, struct addr_inet* bind,
-                           struct addr_inet* conn) {
-    char* ip_str;
-    char* port_str;
-    char* next_str;
-    int ip_len = 0;
-
-    if (!(next_str = strchr(uri, ':')))
-        return -EINVAL;
-    next_str++;
-
-    enum { UDP, UDPSRV, TCP, TCPSRV } prefix;
-
-    if (strstartswith_static(uri, URI_PREFIX_UDP))
-        prefix = UDP;
-    else if (strstartswith_static(uri, URI_PREFIX_UDP_SRV))
-        prefix = UDPSRV;
-    else if (strstartswith_static(uri, URI_PREFIX_TCP))
-        prefix = TCP;
-    else if (strstartswith_static(uri, URI_PREFIX_TCP_SRV))
-        prefix = TCPSRV;
-    else
-        return -EINVAL;
-
-    if ((prefix == UDP || prefix == UDPSRV) && type != SOCK_DGRAM)
-        return -EINVAL;
-
-    if ((prefix == TCP || prefix == TCPSRV) && type != SOCK_STREAM)
-        return -EINVAL;
-
-    for (int round = 0; (ip_str = next_str); round++) {
-        if (ip_str[0] == '[') {
-            ip_str++;
-            if (domain != AF_INET6)
-                return -EINVAL;
-            if (!(port_str = strchr(ip_str, ']')))
-                return -EINVAL;
-            ip_len = port_str - ip_str;
-            port_str++;
-            if (*port_str != ':')
-                return -EINVAL;
-        } else {
-            if (domain != AF_INET)
-                return -EINVAL;
-            if (!(port_str = strchr(ip_str, ':')))
-                return -EINVAL;
-            ip_len = port_str - ip_str;
-        }
-
-        port_str++;
-        next_str = strchr(port_str, ':');
-        if (next_str)
-            next_str++;
-
-        struct addr_inet* addr = round ? conn : bind;
-
-        if (domain == AF_INET) {
-            inet_pton4(ip_str, ip_len, &addr->addr.v4);
-            addr->ext_port = atoi(port_str);
-        }
-
-        if (domain == AF_INET6) {
-            inet_pton6(ip_str, ip_len, &addr->addr.v6);
-            addr->ext_port = atoi(port_str);
-        }
-    }
-
-    return 0;
-}
-
 int shim_do_listen(int sockfd, int backlog) {
     if (backlog < 0)
         return -EINVAL;
@@ -820,19 +768,15 @@ int shim_do_connect(int sockfd, struct sockaddr* addr, int _addrlen) {
     }
 
     if (sock->domain == AF_INET || sock->domain == AF_INET6) {
-        char uri[SOCK_URI_SIZE];
-
-        if (!DkStreamGetName(pal_hdl, uri, SOCK_URI_SIZE)) {
-            ret = -PAL_ERRNO();
+        /* the host may not know the local address of a socket connected without binding */
+        ret = inet_get_host_addr(pal_hdl, PAL_SOCKADDR_LOCAL, sock->domain, &sock->addr.in.bind,
+                                 /*local=*/true);
+        if (ret < 0 && ret != -ENOTCONN)
             goto out;
-        }
 
-        if ((ret = inet_parse_addr(sock->domain, sock->sock_type, uri, &sock->addr.in.bind,
-                                   &sock->addr.in.conn)) < 0)
+        if ((ret = inet_get_host_addr(pal_hdl, PAL_SOCKADDR_PEER, sock->domain,
+                                      &sock->addr.in.conn, /*local=*/false)) < 0)
             goto out;
-
-        inet_rebase_port(true, sock->domain, &sock->addr.in.bind, true);
-        inet_rebase_port(true, sock->domain, &sock->addr.in.conn, false);
     }
 
     hdl->acc_mode = MAY_READ | MAY_WRITE;
@@ -946,25 +890,19 @@ static int __do_accept(struct shim_handle* hdl, int flags, struct sockaddr* addr
     }
 
     if (sock->domain == AF_INET || sock->domain == AF_INET6) {
-        char uri[SOCK_URI_SIZE];
-        int uri_len;
-
-        if (!(uri_len = DkStreamGetName(cli->pal_handle, uri, SOCK_URI_SIZE))) {
-            ret = -PAL_ERRNO();
+        if ((ret = inet_get_host_addr(cli->pal_handle, PAL_SOCKADDR_LOCAL, cli_sock->domain,
+                                      &cli_sock->addr.in.bind, /*local=*/true)) < 0)
             goto out_cli;
-        }
 
-        if ((ret = inet_parse_addr(cli_sock->domain, cli_sock->sock_type, uri,
-                                   &cli_sock->addr.in.bind, &cli_sock->addr.in.conn)) < 0)
+        if ((ret = inet_get_host_addr(cli->pal_handle, PAL_SOCKADDR_PEER, cli_sock->domain,
+                                      &cli_sock->addr.in.conn, /*local=*/false)) < 0)
             goto out_cli;
 
-        qstrsetstr(&cli->uri, uri, uri_len);
-
-        inet_rebase_port(true, cli_sock->domain, &cli_sock->addr.in.bind, true);
-        inet_rebase_port(true, cli_sock->domain, &cli_sock->addr.in.conn, false);
+        if ((ret = create_socket_uri(cli)) < 0)
+            goto out_cli;
 
         if (addr)
-            *addrlen = inet_copy_addr(sock->domain, addr, *addrlen, &sock->addr.in.conn);
+            *addrlen = inet_copy_addr(cli_sock->domain, addr, *addrlen, &cli_sock->addr.in.conn);
     }
 
     ret = set_new_fd_handle(cli, flags & O_CLOEXEC ? FD_CLOEXEC : 0, NULL);
@@ -1004,9 +942,6 @@ int shim_do_accept4(int fd, struct sockaddr* addr, int* addrlen, int flags) {
 
 static ssize_t do_sendmsg(int fd, struct iovec* bufs, int nbufs, int flags,
                           const struct sockaddr* addr, int addrlen) {
-    // Issue #752 - https://github.com/oscarlab/graphene/issues/752
-    __UNUSED(flags);
-
     struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
     if (!hdl)
         return -EBADF;
@@ -1032,7 +967,7 @@ static ssize_t do_sendmsg(int fd, struct iovec* bufs, int nbufs, int flags,
     lock(&hdl->lock);
 
     PAL_HANDLE pal_hdl = hdl->pal_handle;
-    char* uri          = NULL;
+    bool send_to       = false;
 
     /* Data gram sock need not be conneted or bound at all */
     if (sock->sock_type == SOCK_STREAM && sock->sock_state != SOCK_CONNECTED &&
@@ -1074,54 +1009,46 @@ static ssize_t do_sendmsg(int fd, struct iovec* bufs, int nbufs, int flags,
             goto out_locked;
         }
 
-        uri = __alloca(SOCK_URI_SIZE);
+        send_to = true;
     }
 
     unlock(&hdl->lock);
 
-    if (uri) {
+    /* the destination goes to the PAL as a host socket address, not as a URI */
+    struct sockaddr_storage host_addr;
+    size_t host_addrlen = 0;
+
+    if (send_to) {
         struct addr_inet addr_buf;
         inet_save_addr(sock->domain, &addr_buf, addr);
         inet_rebase_port(false, sock->domain, &addr_buf, false);
-        size_t prefix_len = static_strlen(URI_PREFIX_UDP);
-        memcpy(uri, URI_PREFIX_UDP, prefix_len + 1);
-        if ((ret = inet_translate_addr(sock->domain,
-                                       uri + prefix_len,
-                                       SOCK_URI_SIZE - prefix_len,
-                                       &addr_buf)) < 0) {
-            lock(&hdl->lock);
-            goto out_locked;
-        }
-
-        debug("next packet send to %s\n", uri);
-    }
-
-    int bytes = 0;
-    ret       = 0;
-
-    for (int i = 0; i < nbufs; i++) {
-        PAL_NUM pal_ret = DkStreamWrite(pal_hdl, 0, bufs[i].iov_len, bufs[i].iov_base, uri);
-
-        if (pal_ret == PAL_STREAM_ERROR) {
-            if (PAL_ERRNO() == EPIPE) {
-                struct shim_thread* cur = get_cur_thread();
-                assert(cur);
-                (void)do_kill_proc(cur->tid, cur->tgid, SIGPIPE, /*use_ipc=*/false);
-            }
-
-            ret = (PAL_NATIVE_ERRNO() == PAL_ERROR_STREAMEXIST) ? -ECONNABORTED : -PAL_ERRNO();
-            break;
+        host_addrlen = inet_make_host_addr(sock->domain, &host_addr, &addr_buf);
+    }
+
+    /* UNIX domain sockets are PAL pipes, which ignore the send flags as before; other flags
+     * (e.g. MSG_EOR) are still silently ignored */
+    int pal_flags = 0;
+    if (sock->domain != AF_UNIX)
+        pal_flags = (flags & MSG_DONTWAIT ? PAL_MSG_DONTWAIT : 0) |
+                    (flags & MSG_MORE ? PAL_MSG_MORE : 0);
+
+    /* all buffers go to the host in one call, so they leave as one TCP send or one UDP datagram
+     * (PAL_IOVEC has the layout of struct iovec, see fs/chroot/fs.c) */
+    PAL_NUM pal_ret = DkStreamSendTo(pal_hdl, (PAL_IOVEC*)bufs, nbufs,
+                                     send_to ? &host_addr : NULL, host_addrlen, pal_flags);
+    if (pal_ret == PAL_STREAM_ERROR) {
+        if (PAL_ERRNO() == EPIPE && !(flags & MSG_NOSIGNAL)) {
+            struct shim_thread* cur = get_cur_thread();
+            assert(cur);
+            (void)do_kill_proc(cur->tid, cur->tgid, SIGPIPE, /*use_ipc=*/false);
         }
 
-        bytes += pal_ret;
-    }
-
-    if (bytes)
-        ret = bytes;
-    if (ret < 0) {
+        ret = (PAL_NATIVE_ERRNO() == PAL_ERROR_STREAMEXIST) ? -ECONNABORTED : -PAL_ERRNO();
         lock(&hdl->lock);
         goto out_locked;
     }
+
+    ret = pal_ret;
     goto out;
 
 out_locked:
@@ -1213,8 +1140,20 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
         expected_size += bufs[i].iov_len;
     }
 
-    if (flags & ~MSG_PEEK) {
-        debug("recvmsg()/recvmmsg()/recvfrom(): unknown flag (only MSG_PEEK is supported).\n");
+    if (flags & ~(MSG_PEEK | MSG_DONTWAIT | MSG_WAITALL | MSG_TRUNC)) {
+        debug("recvmsg()/recvmmsg()/recvfrom(): unknown flag (only MSG_PEEK, MSG_DONTWAIT, "
+              "MSG_WAITALL and MSG_TRUNC are supported).\n");
+        ret = -EOPNOTSUPP;
+        goto out;
+    }
+
+    int pal_flags = (flags & MSG_DONTWAIT ? PAL_MSG_DONTWAIT : 0) |
+                    (flags & MSG_WAITALL ? PAL_MSG_WAITALL : 0) |
+                    (flags & MSG_TRUNC ? PAL_MSG_TRUNC : 0);
+
+    /* UNIX domain sockets are PAL pipes, which only support MSG_PEEK through the peek buffer */
+    if (pal_flags && sock->domain == AF_UNIX) {
+        debug("recvmsg()/recvmmsg()/recvfrom(): UNIX domain sockets only support MSG_PEEK.\n");
         ret = -EOPNOTSUPP;
         goto out;
     }
@@ -1223,7 +1162,7 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
     peek_buffer        = sock->peek_buffer;
     sock->peek_buffer  = NULL;
     PAL_HANDLE pal_hdl = hdl->pal_handle;
-    char* uri          = NULL;
+    bool recv_from     = false;
 
     if (sock->sock_type == SOCK_STREAM && sock->sock_state != SOCK_CONNECTED &&
         sock->sock_state != SOCK_BOUNDCONNECTED && sock->sock_state != SOCK_ACCEPTED) {
@@ -1236,19 +1175,30 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
         goto out_locked;
     }
 
-    if (addr && sock->sock_type == SOCK_DGRAM && sock->sock_state != SOCK_CONNECTED &&
+    /* unconnected datagram sockets always receive with the source address, so that it is also
+     * kept in the peek buffer for a later recvfrom() */
+    if (sock->sock_type == SOCK_DGRAM && sock->sock_state != SOCK_CONNECTED &&
         sock->sock_state != SOCK_BOUNDCONNECTED) {
-        if (sock->sock_state == SOCK_CREATED) {
+        if (addr && !pal_hdl) {
             ret = -EINVAL;
             goto out_locked;
         }
 
-        uri = __alloca(SOCK_URI_SIZE);
+        recv_from = pal_hdl != NULL;
     }
 
     unlock(&hdl->lock);
 
-    if (flags & MSG_PEEK) {
+    /* the source comes from the PAL as a host socket address, not as a URI */
+    struct sockaddr_storage host_addr;
+    PAL_NUM host_addrlen = sizeof(host_addr);
+
+    /* with nothing buffered yet, the host peeks directly into a single user buffer; the peek
+     * buffer is only needed for UNIX domain sockets and for scattered reads */
+    if ((flags & MSG_PEEK) && !peek_buffer && nbufs == 1 && sock->domain != AF_UNIX)
+        pal_flags |= PAL_MSG_PEEK;
+
+    if ((flags & MSG_PEEK) && !(pal_flags & PAL_MSG_PEEK)) {
         if (!peek_buffer) {
             /* create new peek buffer with expected read size */
             peek_buffer = malloc(sizeof(*peek_buffer) + expected_size);
@@ -1257,9 +1207,10 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
                 lock(&hdl->lock);
                 goto out_locked;
             }
-            peek_buffer->size  = expected_size;
-            peek_buffer->start = 0;
-            peek_buffer->end   = 0;
+            peek_buffer->size    = expected_size;
+            peek_buffer->start   = 0;
+            peek_buffer->end     = 0;
+            peek_buffer->addrlen = 0;
         } else {
             /* realloc peek buffer to accommodate expected read size */
             if (expected_size > peek_buffer->size - peek_buffer->start) {
@@ -1281,9 +1232,10 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
             /* fill peek buffer if this MSG_PEEK read request cannot be satisfied with data already
              * present in peek buffer; note that buffer can hold expected read size at this point */
             size_t left_to_read = expected_size - (peek_buffer->end - peek_buffer->start);
-            PAL_NUM pal_ret = DkStreamRead(pal_hdl, /*offset=*/0, left_to_read,
-                                           &peek_buffer->buf[peek_buffer->end],
-                                           uri, uri ? SOCK_URI_SIZE : 0);
+            PAL_NUM pal_ret = DkStreamRecvFrom(pal_hdl, &peek_buffer->buf[peek_buffer->end],
+                                               left_to_read, recv_from ? &host_addr : NULL,
+                                               recv_from ? &host_addrlen : NULL,
+                                               pal_flags & PAL_MSG_DONTWAIT);
             if (pal_ret == PAL_STREAM_ERROR) {
                 ret = PAL_NATIVE_ERRNO() == PAL_ERROR_STREAMNOTEXIST
                       ? -ECONNABORTED
@@ -1293,8 +1245,10 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
             }
 
             peek_buffer->end += pal_ret;
-            if (uri)
-                memcpy(peek_buffer->uri, uri, SOCK_URI_SIZE);
+            if (recv_from) {
+                memcpy(&peek_buffer->addr, &host_addr, sizeof(host_addr));
+                peek_buffer->addrlen = host_addrlen;
+            }
         }
     }
 
@@ -1310,9 +1264,14 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
             assert(total_bytes < peek_buffer->end - peek_buffer->start);
             iov_bytes = MIN(bufs[i].iov_len, peek_buffer->end - peek_buffer->start - total_bytes);
             memcpy(bufs[i].iov_base, &peek_buffer->buf[peek_buffer->start + total_bytes], iov_bytes);
-            uri = peek_buffer->uri;
+            if (recv_from) {
+                memcpy(&host_addr, &peek_buffer->addr, sizeof(host_addr));
+                host_addrlen = peek_buffer->addrlen;
+            }
         } else {
-            PAL_NUM pal_ret = DkStreamRead(pal_hdl, 0, bufs[i].iov_len, bufs[i].iov_base, uri, uri ? SOCK_URI_SIZE : 0);
+            PAL_NUM pal_ret = DkStreamRecvFrom(pal_hdl, bufs[i].iov_base, bufs[i].iov_len,
+                                               recv_from ? &host_addr : NULL,
+                                               recv_from ? &host_addrlen : NULL, pal_flags);
             if (pal_ret == PAL_STREAM_ERROR) {
                 ret = PAL_NATIVE_ERRNO() == PAL_ERROR_STREAMNOTEXIST
                       ? -ECONNABORTED
@@ -1331,17 +1290,18 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
             }
 
             if (sock->domain == AF_INET || sock->domain == AF_INET6) {
-                if (uri) {
+                if (recv_from) {
                     struct addr_inet conn;
 
-                    if ((ret = inet_parse_addr(sock->domain, sock->sock_type, uri, &conn, NULL)) < 0) {
+                    if (host_addrlen > sizeof(host_addr)
+                            || host_addrlen < minimal_addrlen(sock->domain)) {
+                        ret = -EINVAL;
                         lock(&hdl->lock);
                         goto out_locked;
                     }
 
-                    debug("last packet received from %s\n", uri);
-
-                    inet_rebase_port(true, sock->domain, &conn, false);
+                    inet_load_host_addr(sock->domain, &conn, (struct sockaddr*)&host_addr,
+                                        /*local=*/false);
                     *addrlen = inet_copy_addr(sock->domain, addr, *addrlen, &conn);
                 } else {
                     *addrlen = inet_copy_addr(sock->domain, addr, *addrlen, &sock->addr.in.conn);
@@ -1352,8 +1312,9 @@ static ssize_t do_recvmsg(int fd, struct iovec* bufs, size_t nbufs, int flags,
         }
 
         /* gap in iovecs is not allowed, return a partial read to user; it is the responsibility of
-         * user application to deal with partial reads */
-        if (iov_bytes < bufs[i].iov_len)
+         * user application to deal with partial reads; with MSG_TRUNC, a datagram socket returns
+         * the real length of a datagram longer than the buffer */
+        if (iov_bytes != bufs[i].iov_len)
             break;
 
         /* we read from peek_buffer and exhausted it, return a partial read to user; it is the
@@ -0,0 +1,409 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_splice.c
+ *
+ * Implementation of system calls "splice", "tee" and "vmsplice".
+ *
+ * If both ends are backed by host streams (pipes, UNIX and TCP stream sockets, regular chroot
+ * files), the data is moved by DkStreamSplice() and never enters LibOS buffers. Otherwise (e.g.
+ * for emulated files, sockets with MSG_PEEK'ed data, or on SGX) it is copied through a bounded
+ * LibOS buffer with the read and write callbacks of the handles. vmsplice() cannot hand user pages
+ * to the host, so it is a readv() or writev() on the pipe.
+ */
+
+#include <errno.h>
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_signal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+
+#ifndef SPLICE_F_MOVE
+#define SPLICE_F_MOVE     1
+#define SPLICE_F_NONBLOCK 2
+#define SPLICE_F_MORE     4
+#define SPLICE_F_GIFT     8
+#endif
+
+#define SPLICE_FLAGS_MASK (SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE | SPLICE_F_GIFT)
+
+/* same as UIO_MAXIOV */
+#define SPLICE_MAX_IOVECS 1024
+
+/* upper bound of the LibOS buffer used when the host cannot move the data */
+#define SPLICE_BUF_SIZE (64 * 1024)
+
+/* same as PIPE_BUF: a writable pipe accepts at least this many bytes */
+#define SPLICE_ATOMIC_SIZE 4096
+
+/* Returns the PAL handle through which DkStreamSplice() may move data of `hdl`, or NULL if the data
+ * has to be copied by LibOS. `*is_file` is set if the PAL handle takes file offsets. */
+static PAL_HANDLE splice_pal_handle(struct shim_handle* hdl, bool* is_file) {
+    *is_file = false;
+
+    switch (hdl->type) {
+        case TYPE_PIPE:
+            return hdl->info.pipe.ready_for_ops ? hdl->pal_handle : NULL;
+
+        case TYPE_SOCK: {
+            struct shim_sock_handle* sock = &hdl->info.sock;
+            PAL_HANDLE pal_handle = NULL;
+
+            lock(&hdl->lock);
+            /* data received by MSG_PEEK is buffered in LibOS and must be read first */
+            bool peeked = sock->peek_buffer && sock->peek_buffer->start < sock->peek_buffer->end;
+            if (sock->sock_type == SOCK_STREAM && !peeked &&
+                    (sock->sock_state == SOCK_CONNECTED || sock->sock_state == SOCK_ACCEPTED))
+                pal_handle = hdl->pal_handle;
+            unlock(&hdl->lock);
+            return pal_handle;
+        }
+
+        case TYPE_FILE:
+            if (!hdl->fs || hdl->fs->fs_ops != &chroot_fs_ops)
+                return NULL;
+            *is_file = true;
+            return chroot_direct_handle(hdl);
+
+        default:
+            return NULL;
+    }
+}
+
+static void splice_raise_sigpipe(void) {
+    struct shim_thread* cur = get_cur_thread();
+    (void)do_kill_proc(cur->tid, cur->tgid, SIGPIPE, /*use_ipc=*/false);
+}
+
+static ssize_t splice_by_host(struct shim_handle* hdl_in, PAL_HANDLE pal_in, bool file_in,
+                              loff_t* off_in, struct shim_handle* hdl_out, PAL_HANDLE pal_out,
+                              bool file_out, loff_t* off_out, size_t len, int pal_flags) {
+    /* One of the ends is a pipe, so at most one is a file. Its position is read and advanced
+     * under the handle lock, like the chroot read and write callbacks do. */
+    struct shim_handle* file_hdl = file_in ? hdl_in : file_out ? hdl_out : NULL;
+    loff_t* file_off = file_in ? off_in : off_out;
+    off_t pos = 0;
+
+    if (file_hdl) {
+        if (file_off) {
+            pos = *file_off;
+        } else {
+            lock(&file_hdl->lock);
+            pos = file_hdl->info.file.marker;
+        }
+    }
+
+    PAL_NUM bytes = DkStreamSplice(pal_in, file_in ? pos : 0, pal_out, file_out ? pos : 0, len,
+                                   pal_flags);
+    ssize_t ret = bytes;
+    if (bytes == PAL_STREAM_ERROR) {
+        switch (PAL_NATIVE_ERRNO()) {
+            case PAL_ERROR_ENDOFSTREAM:
+                ret = 0;
+                break;
+            case PAL_ERROR_NOTSUPPORT:
+            case PAL_ERROR_NOTIMPLEMENTED:
+                /* the caller has to copy the data */
+                ret = -EOPNOTSUPP;
+                break;
+            default:
+                ret = -PAL_ERRNO();
+                break;
+        }
+    }
+
+    if (file_hdl) {
+        /* tee() never has a file end, so the data is always consumed */
+        if (ret > 0) {
+            if (file_off)
+                *file_off = pos + ret;
+            else
+                file_hdl->info.file.marker = pos + ret;
+        }
+        if (!file_off)
+            unlock(&file_hdl->lock);
+        if (file_out && ret > 0)
+            chroot_direct_written(hdl_out, pos + ret);
+    }
+    return ret;
+}
+
+/* Reads at `*off` (if given) without changing the file position, like pread(). */
+static ssize_t splice_read(struct shim_handle* hdl, loff_t* off, void* buf, size_t count) {
+    struct shim_fs_ops* fs_ops = hdl->fs->fs_ops;
+    if (!off)
+        return fs_ops->read(hdl, buf, count);
+
+    off_t old_pos = fs_ops->seek(hdl, 0, SEEK_CUR);
+    if (old_pos < 0)
+        return old_pos;
+    off_t ret = fs_ops->seek(hdl, *off, SEEK_SET);
+    if (ret < 0)
+        return ret;
+
+    ssize_t bytes = fs_ops->read(hdl, buf, count);
+    fs_ops->seek(hdl, old_pos, SEEK_SET);
+    return bytes;
+}
+
+/* Waits until `hdl` can be read or written (`events`), or only checks it if `nonblock` is true.
+ * Handles without a PAL handle are always ready. A write end whose reader is gone fails with
+ * -EPIPE. */
+static int splice_wait(struct shim_handle* hdl, PAL_FLG events, bool nonblock) {
+    lock(&hdl->lock);
+    PAL_HANDLE pal_handle = hdl->pal_handle;
+    unlock(&hdl->lock);
+    if (!pal_handle || (hdl->type != TYPE_PIPE && hdl->type != TYPE_SOCK))
+        return 0;
+
+    PAL_FLG ret_events = 0;
+    if (DkStreamsWaitEvents(1, &pal_handle, &events, &ret_events, nonblock ? 0 : NO_TIMEOUT))
+        return (events & PAL_WAIT_WRITE) && (ret_events & PAL_WAIT_ERROR) ? -EPIPE : 0;
+    return PAL_NATIVE_ERRNO() == PAL_ERROR_TRYAGAIN ? -EAGAIN : -PAL_ERRNO();
+}
+
+/* Writes `buf` at `*off` (if given) without changing the file position, like pwrite(). Stops at
+ * the first error, and when the destination is full if `nonblock` is true. If `keep_data` is true,
+ * `buf` cannot be put back into the source, so a write which was interrupted or found the
+ * destination full is resumed (waiting for the destination even if `nonblock` is true). Returns
+ * the number of bytes written, or the error if nothing was written. */
+static ssize_t splice_write(struct shim_handle* hdl, loff_t* off, const void* buf, size_t count,
+                            bool nonblock, bool keep_data) {
+    struct shim_fs_ops* fs_ops = hdl->fs->fs_ops;
+    off_t old_pos = 0;
+
+    if (off) {
+        old_pos = fs_ops->seek(hdl, 0, SEEK_CUR);
+        if (old_pos < 0)
+            return old_pos;
+        off_t ret = fs_ops->seek(hdl, *off, SEEK_SET);
+        if (ret < 0)
+            return ret;
+    }
+
+    size_t done = 0;
+    ssize_t ret = 0;
+    while (done < count) {
+        ret = fs_ops->write(hdl, (const char*)buf + done, count - done);
+        if (ret == -EAGAIN && (!nonblock || keep_data)) {
+            /* O_NONBLOCK destination, but splice() was asked to block or the data is consumed */
+            ret = splice_wait(hdl, PAL_WAIT_WRITE, /*nonblock=*/false);
+            if (ret < 0)
+                break;
+            continue;
+        }
+        if (ret == -EINTR && keep_data)
+            continue;
+        if (ret <= 0)
+            break;
+        done += ret;
+    }
+
+    if (off)
+        fs_ops->seek(hdl, old_pos, SEEK_SET);
+    return done ? (ssize_t)done : ret;
+}
+
+/* Moves at most SPLICE_BUF_SIZE bytes through a LibOS buffer. Data read from the source but not
+ * written is put back if the source is a file. A pipe or socket cannot take it back, so then the
+ * destination is checked first and only as much is read as it is known to accept; the data read
+ * is then written completely unless the destination fails. */
+static ssize_t splice_by_copy(struct shim_handle* hdl_in, loff_t* off_in,
+                              struct shim_handle* hdl_out, loff_t* off_out, size_t len,
+                              unsigned int flags) {
+    struct shim_fs_ops* ops_in  = hdl_in->fs ? hdl_in->fs->fs_ops : NULL;
+    struct shim_fs_ops* ops_out = hdl_out->fs ? hdl_out->fs->fs_ops : NULL;
+    if (!ops_in || !ops_in->read || !ops_out || !ops_out->write)
+        return -EINVAL;
+    if ((off_in && !ops_in->seek) || (off_out && !ops_out->seek))
+        return -ESPIPE;
+
+    bool stream_in  = hdl_in->type == TYPE_PIPE || hdl_in->type == TYPE_SOCK;
+    bool stream_out = hdl_out->type == TYPE_PIPE || hdl_out->type == TYPE_SOCK;
+    if (!stream_in && !ops_in->seek)
+        stream_in = true;
+
+    lock(&hdl_out->lock);
+    bool nonblock_out = (flags & SPLICE_F_NONBLOCK) || (hdl_out->flags & O_NONBLOCK);
+    unlock(&hdl_out->lock);
+
+    size_t buf_size = len < SPLICE_BUF_SIZE ? len : SPLICE_BUF_SIZE;
+
+    /* the read and write callbacks block unless the handles are O_NONBLOCK, so with
+     * SPLICE_F_NONBLOCK both ends are checked first */
+    ssize_t ret;
+    if ((flags & SPLICE_F_NONBLOCK) && stream_in) {
+        ret = splice_wait(hdl_in, PAL_WAIT_READ, /*nonblock=*/true);
+        if (ret < 0)
+            return ret;
+    }
+    if (stream_out && (nonblock_out || stream_in)) {
+        /* a writable pipe takes at least PIPE_BUF bytes without blocking; a broken one fails here
+         * and not after data was consumed from a stream source */
+        ret = splice_wait(hdl_out, PAL_WAIT_WRITE, nonblock_out);
+        if (ret < 0)
+            return ret;
+        if (nonblock_out)
+            buf_size = MIN(buf_size, (size_t)SPLICE_ATOMIC_SIZE);
+    }
+
+    char* buf = malloc(buf_size);
+    if (!buf)
+        return -ENOMEM;
+
+    ssize_t bytes = splice_read(hdl_in, off_in, buf, buf_size);
+    if (bytes <= 0) {
+        ret = bytes;
+        goto out;
+    }
+
+    ret = splice_write(hdl_out, off_out, buf, bytes, nonblock_out, stream_in);
+    ssize_t written = ret > 0 ? ret : 0;
+    if (off_out)
+        *off_out += written;
+
+    if (off_in)
+        *off_in += written;
+    else if (!stream_in && written < bytes)
+        ops_in->seek(hdl_in, written - bytes, SEEK_CUR);
+
+out:
+    free(buf);
+    return ret;
+}
+
+static int splice_check_offset(struct shim_handle* hdl, loff_t* off) {
+    if (!off)
+        return 0;
+    if (hdl->type == TYPE_PIPE || hdl->type == TYPE_SOCK)
+        return -ESPIPE;
+    if (test_user_memory(off, sizeof(*off), true))
+        return -EFAULT;
+    if (*off < 0)
+        return -EINVAL;
+    return 0;
+}
+
+ssize_t shim_do_splice(int fd_in, loff_t* off_in, int fd_out, loff_t* off_out, size_t len,
+                       unsigned int flags) {
+    if (flags & ~SPLICE_FLAGS_MASK)
+        return -EINVAL;
+
+    struct shim_handle* hdl_in  = get_fd_handle(fd_in, NULL, NULL);
+    struct shim_handle* hdl_out = get_fd_handle(fd_out, NULL, NULL);
+    ssize_t ret = -EBADF;
+
+    if (!hdl_in || !hdl_out)
+        goto out;
+    if (!(hdl_in->acc_mode & MAY_READ) || !(hdl_out->acc_mode & MAY_WRITE))
+        goto out;
+
+    /* as on Linux, one of the ends has to be a pipe */
+    ret = -EINVAL;
+    if ((hdl_in->type != TYPE_PIPE && hdl_out->type != TYPE_PIPE) || hdl_in == hdl_out)
+        goto out;
+    if (hdl_out->flags & O_APPEND)
+        goto out;
+
+    if ((ret = splice_check_offset(hdl_in, off_in)) < 0 ||
+            (ret = splice_check_offset(hdl_out, off_out)) < 0)
+        goto out;
+
+    ret = 0;
+    if (!len)
+        goto out;
+
+    bool file_in;
+    bool file_out;
+    PAL_HANDLE pal_in  = splice_pal_handle(hdl_in, &file_in);
+    PAL_HANDLE pal_out = splice_pal_handle(hdl_out, &file_out);
+
+    ret = -EOPNOTSUPP;
+    if (pal_in && pal_out)
+        ret = splice_by_host(hdl_in, pal_in, file_in, off_in, hdl_out, pal_out, file_out, off_out,
+                             len, flags & SPLICE_F_NONBLOCK ? PAL_SPLICE_NONBLOCK : 0);
+    if (ret == -EOPNOTSUPP)
+        ret = splice_by_copy(hdl_in, off_in, hdl_out, off_out, len, flags);
+
+    if (ret == -EPIPE)
+        splice_raise_sigpipe();
+out:
+    if (hdl_in)
+        put_handle(hdl_in);
+    if (hdl_out)
+        put_handle(hdl_out);
+    return ret;
+}
+
+ssize_t shim_do_tee(int fd_in, int fd_out, size_t len, unsigned int flags) {
+    if (flags & ~SPLICE_FLAGS_MASK)
+        return -EINVAL;
+
+    struct shim_handle* hdl_in  = get_fd_handle(fd_in, NULL, NULL);
+    struct shim_handle* hdl_out = get_fd_handle(fd_out, NULL, NULL);
+    ssize_t ret = -EBADF;
+
+    if (!hdl_in || !hdl_out)
+        goto out;
+    if (!(hdl_in->acc_mode & MAY_READ) || !(hdl_out->acc_mode & MAY_WRITE))
+        goto out;
+
+    ret = -EINVAL;
+    if (hdl_in->type != TYPE_PIPE || hdl_out->type != TYPE_PIPE || hdl_in == hdl_out)
+        goto out;
+
+    ret = 0;
+    if (!len)
+        goto out;
+
+    /* duplicating data without consuming it needs to peek into the source pipe, which only the
+     * host can do, so there is no copy fallback */
+    bool is_file;
+    PAL_HANDLE pal_in  = splice_pal_handle(hdl_in, &is_file);
+    PAL_HANDLE pal_out = splice_pal_handle(hdl_out, &is_file);
+    ret = -EINVAL;
+    if (pal_in && pal_out)
+        ret = splice_by_host(hdl_in, pal_in, false, NULL, hdl_out, pal_out, false, NULL, len,
+                             PAL_SPLICE_PEEK
+                                 | (flags & SPLICE_F_NONBLOCK ? PAL_SPLICE_NONBLOCK : 0));
+    if (ret == -EOPNOTSUPP)
+        ret = -EINVAL;
+
+    if (ret == -EPIPE)
+        splice_raise_sigpipe();
+out:
+    if (hdl_in)
+        put_handle(hdl_in);
+    if (hdl_out)
+        put_handle(hdl_out);
+    return ret;
+}
+
+ssize_t shim_do_vmsplice(int fd, const struct iovec* iov, unsigned long nr_segs,
+                         unsigned int flags) {
+    if (flags & ~SPLICE_FLAGS_MASK)
+        return -EINVAL;
+    if (nr_segs > SPLICE_MAX_IOVECS)
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
+    if (!hdl)
+        return -EBADF;
+
+    int acc_mode = hdl->acc_mode;
+    bool is_pipe = hdl->type == TYPE_PIPE;
+    put_handle(hdl);
+
+    if (!is_pipe)
+        return -EBADF;
+
+    /* the write end is filled from user memory, the read end is drained into it */
+    if (acc_mode & MAY_WRITE)
+        return shim_do_writev(fd, iov, nr_segs);
+    return shim_do_readv(fd, iov, nr_segs);
+}
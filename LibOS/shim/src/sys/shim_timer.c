@@ -0,0 +1,309 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_timer.c
+ *
+ * Implementation of system calls "timer_create", "timer_settime", "timer_gettime",
+ * "timer_getoverrun" and "timer_delete" (POSIX per-process timers).
+ *
+ * Each POSIX timer is backed by a timer of the async helper (see shim_async.c). On expiration, the
+ * helper sends the timer's signal with si_code = SI_TIMER either to the process (SIGEV_SIGNAL) or
+ * to a single thread (SIGEV_THREAD_ID, which is also what glibc uses to implement SIGEV_THREAD).
+ * Timer IDs index a per-process table. As on Linux, timers are not inherited by forked children
+ * and are deleted by execve().
+ */
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_internal.h>
+#include <shim_signal.h>
+#include <shim_table.h>
+#include <shim_thread.h>
+#include <shim_utils.h>
+
+#ifndef TIMER_ABSTIME
+#define TIMER_ABSTIME 1
+#endif
+
+#ifndef CLOCK_REALTIME
+#define CLOCK_REALTIME       0
+#define CLOCK_MONOTONIC      1
+#define CLOCK_BOOTTIME       7
+#define CLOCK_REALTIME_ALARM 8
+#define CLOCK_BOOTTIME_ALARM 9
+#endif
+
+/* same as DELAYTIMER_MAX of glibc */
+#define MAX_TIMER_OVERRUN 0x7fffffff
+
+#define POSIX_TIMERS_INIT_SIZE 32
+
+struct posix_timer {
+    timer_t id;
+    struct async_timer timer;
+    int notify;      /* SIGEV_SIGNAL, SIGEV_NONE or SIGEV_THREAD_ID */
+    int signo;
+    sigval_t value;
+    IDTYPE tgid;
+    IDTYPE tid;      /* target thread for SIGEV_THREAD_ID */
+    int overrun;     /* overrun count of the last expiration */
+};
+
+static struct shim_lock posix_timers_lock;
+static struct posix_timer** posix_timers;
+static size_t posix_timers_size;
+
+static void posix_timer_expired(struct async_timer* timer, uint64_t expirations) {
+    struct posix_timer* ptimer = container_of(timer, struct posix_timer, timer);
+
+    uint64_t overrun = expirations - 1;
+    if (overrun > MAX_TIMER_OVERRUN)
+        overrun = MAX_TIMER_OVERRUN;
+    __atomic_store_n(&ptimer->overrun, (int)overrun, __ATOMIC_RELAXED);
+
+    if (ptimer->notify == SIGEV_NONE)
+        return;
+
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    info.si_signo   = ptimer->signo;
+    info.si_code    = SI_TIMER;
+    info.si_tid     = ptimer->id;
+    info.si_overrun = ptimer->overrun;
+    info.si_value   = ptimer->value;
+
+    int ret;
+    if (ptimer->notify == SIGEV_THREAD_ID) {
+        ret = do_kill_thread_info(ptimer->tgid, ptimer->tid, &info);
+    } else {
+        ret = do_kill_proc_info(ptimer->tgid, &info);
+    }
+    if (ret < 0)
+        debug("Cannot deliver signal of POSIX timer %d: %d\n", ptimer->id, ret);
+}
+
+static bool is_supported_clock(clockid_t clockid) {
+    /* process and thread CPU-time clocks cannot be emulated, all other clocks are the same */
+    return clockid == CLOCK_REALTIME || clockid == CLOCK_MONOTONIC ||
+           clockid == CLOCK_BOOTTIME || clockid == CLOCK_REALTIME_ALARM ||
+           clockid == CLOCK_BOOTTIME_ALARM;
+}
+
+/* must be called with posix_timers_lock held */
+static int alloc_posix_timer_id(struct posix_timer* ptimer) {
+    assert(locked(&posix_timers_lock));
+
+    for (size_t i = 0; i < posix_timers_size; i++) {
+        if (!posix_timers[i]) {
+            posix_timers[i] = ptimer;
+            ptimer->id = i;
+            return 0;
+        }
+    }
+
+    size_t new_size = posix_timers_size ? posix_timers_size * 2 : POSIX_TIMERS_INIT_SIZE;
+    if (new_size > INT32_MAX)
+        return -EAGAIN;
+
+    struct posix_timer** new_timers = malloc(sizeof(*new_timers) * new_size);
+    if (!new_timers)
+        return -EAGAIN;
+
+    memset(new_timers, 0, sizeof(*new_timers) * new_size);
+    if (posix_timers) {
+        memcpy(new_timers, posix_timers, sizeof(*new_timers) * posix_timers_size);
+        free(posix_timers);
+    }
+
+    ptimer->id = posix_timers_size;
+    new_timers[posix_timers_size] = ptimer;
+    posix_timers      = new_timers;
+    posix_timers_size = new_size;
+    return 0;
+}
+
+/* must be called with posix_timers_lock held */
+static struct posix_timer* lookup_posix_timer(timer_t timer_id) {
+    assert(locked(&posix_timers_lock));
+
+    if (timer_id < 0 || (size_t)timer_id >= posix_timers_size)
+        return NULL;
+    return posix_timers[timer_id];
+}
+
+int shim_do_timer_create(clockid_t which_clock, struct sigevent* timer_event_spec,
+                         timer_t* created_timer_id) {
+    if (!is_supported_clock(which_clock))
+        return -EINVAL;
+
+    if (timer_event_spec &&
+            test_user_memory(timer_event_spec, sizeof(*timer_event_spec), false))
+        return -EFAULT;
+    if (!created_timer_id ||
+            test_user_memory(created_timer_id, sizeof(*created_timer_id), true))
+        return -EFAULT;
+
+    struct shim_thread* cur = get_cur_thread();
+
+    struct posix_timer* ptimer = malloc(sizeof(*ptimer));
+    if (!ptimer)
+        return -EAGAIN;
+
+    memset(ptimer, 0, sizeof(*ptimer));
+    ptimer->timer.callback = &posix_timer_expired;
+    ptimer->tgid = cur->tgid;
+
+    if (timer_event_spec) {
+        ptimer->notify = timer_event_spec->sigev_notify;
+        ptimer->signo  = timer_event_spec->sigev_signo;
+        ptimer->value  = timer_event_spec->sigev_value;
+    } else {
+        /* default is SIGEV_SIGNAL with SIGALRM and the timer ID as the value (set below) */
+        ptimer->notify = SIGEV_SIGNAL;
+        ptimer->signo  = SIGALRM;
+    }
+
+    int ret = -EINVAL;
+    switch (ptimer->notify) {
+        case SIGEV_NONE:
+            break;
+        case SIGEV_THREAD_ID: {
+            ptimer->tid = timer_event_spec->sigev_notify_thread_id;
+            struct shim_thread* thread = lookup_thread(ptimer->tid);
+            if (!thread)
+                goto err;
+            bool same_process = thread->tgid == cur->tgid;
+            put_thread(thread);
+            if (!same_process)
+                goto err;
+        }
+        /* fallthrough */
+        case SIGEV_SIGNAL:
+            if (ptimer->signo <= 0 || ptimer->signo > NUM_SIGS)
+                goto err;
+            break;
+        default:
+            goto err;
+    }
+
+    if (!create_lock_runtime(&posix_timers_lock)) {
+        ret = -ENOMEM;
+        goto err;
+    }
+
+    lock(&posix_timers_lock);
+    ret = alloc_posix_timer_id(ptimer);
+    unlock(&posix_timers_lock);
+    if (ret < 0)
+        goto err;
+
+    if (!timer_event_spec)
+        ptimer->value.sival_int = ptimer->id;
+
+    *created_timer_id = ptimer->id;
+    return 0;
+
+err:
+    free(ptimer);
+    return ret;
+}
+
+int shim_do_timer_settime(timer_t timer_id, int flags,
+                          const struct __kernel_itimerspec* new_setting,
+                          struct __kernel_itimerspec* old_setting) {
+    if (!new_setting || test_user_memory((void*)new_setting, sizeof(*new_setting), false))
+        return -EFAULT;
+    if (old_setting && test_user_memory(old_setting, sizeof(*old_setting), true))
+        return -EFAULT;
+
+    uint64_t expire_time;
+    uint64_t interval;
+    int ret = itimerspec_to_async_timer(new_setting, flags & TIMER_ABSTIME, &expire_time,
+                                        &interval);
+    if (ret < 0)
+        return ret;
+
+    if (!lock_created(&posix_timers_lock))
+        return -EINVAL;
+
+    /* the lock keeps the timer from being deleted; the callback never takes it */
+    lock(&posix_timers_lock);
+    struct posix_timer* ptimer = lookup_posix_timer(timer_id);
+    if (!ptimer) {
+        unlock(&posix_timers_lock);
+        return -EINVAL;
+    }
+
+    if (old_setting)
+        async_timer_to_itimerspec(&ptimer->timer, old_setting);
+
+    ret = set_async_timer(&ptimer->timer, expire_time, interval);
+    unlock(&posix_timers_lock);
+    return ret;
+}
+
+int shim_do_timer_gettime(timer_t timer_id, struct __kernel_itimerspec* setting) {
+    if (!setting || test_user_memory(setting, sizeof(*setting), true))
+        return -EFAULT;
+
+    if (!lock_created(&posix_timers_lock))
+        return -EINVAL;
+
+    lock(&posix_timers_lock);
+    struct posix_timer* ptimer = lookup_posix_timer(timer_id);
+    if (ptimer)
+        async_timer_to_itimerspec(&ptimer->timer, setting);
+    unlock(&posix_timers_lock);
+
+    return ptimer ? 0 : -EINVAL;
+}
+
+int shim_do_timer_getoverrun(timer_t timer_id) {
+    if (!lock_created(&posix_timers_lock))
+        return -EINVAL;
+
+    lock(&posix_timers_lock);
+    struct posix_timer* ptimer = lookup_posix_timer(timer_id);
+    int ret = ptimer ? __atomic_load_n(&ptimer->overrun, __ATOMIC_RELAXED) : -EINVAL;
+    unlock(&posix_timers_lock);
+    return ret;
+}
+
+int shim_do_timer_delete(timer_t timer_id) {
+    if (!lock_created(&posix_timers_lock))
+        return -EINVAL;
+
+    lock(&posix_timers_lock);
+    struct posix_timer* ptimer = lookup_posix_timer(timer_id);
+    if (ptimer)
+        posix_timers[timer_id] = NULL;
+    unlock(&posix_timers_lock);
+
+    if (!ptimer)
+        return -EINVAL;
+
+    /* waits for a running callback, so the timer can be freed afterwards */
+    cancel_async_timer(&ptimer->timer);
+    free(ptimer);
+    return 0;
+}
+
+void delete_all_posix_timers(void) {
+    if (!lock_created(&posix_timers_lock))
+        return;
+
+    lock(&posix_timers_lock);
+    struct posix_timer** timers = posix_timers;
+    size_t size = posix_timers_size;
+    posix_timers      = NULL;
+    posix_timers_size = 0;
+    unlock(&posix_timers_lock);
+
+    for (size_t i = 0; i < size; i++) {
+        if (!timers[i])
+            continue;
+        cancel_async_timer(&timers[i]->timer);
+        free(timers[i]);
+    }
+    free(timers);
+}
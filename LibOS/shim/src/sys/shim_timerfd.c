@@ -0,0 +1,226 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * shim_timerfd.c
+ *
+ * Implementation of system calls "timerfd_create", "timerfd_settime" and "timerfd_gettime".
+ *
+ * A timerfd is backed by a timer of the async helper (see shim_async.c). Expirations are counted
+ * in the handle; the PAL handle of a timerfd is a LibOS event which is readable while there are
+ * unread expirations, so timerfds can be waited on by poll(), select() and epoll like any other
+ * PAL-backed handle.
+ *
+ * Limitation: a forked child gets its own copy of the timerfd (with the pending expirations), but
+ * the copy is disarmed instead of sharing the timer with the parent.
+ */
+
+#include <asm/fcntl.h>
+
+#include <pal.h>
+#include <pal_error.h>
+#include <shim_fs.h>
+#include <shim_handle.h>
+#include <shim_internal.h>
+#include <shim_table.h>
+#include <shim_utils.h>
+
+#ifndef TFD_TIMER_ABSTIME
+#define TFD_TIMER_ABSTIME       (1 << 0)
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#define TFD_CLOEXEC             O_CLOEXEC
+#define TFD_NONBLOCK            O_NONBLOCK
+#endif
+
+#ifndef CLOCK_REALTIME
+#define CLOCK_REALTIME       0
+#define CLOCK_MONOTONIC      1
+#define CLOCK_BOOTTIME       7
+#define CLOCK_REALTIME_ALARM 8
+#define CLOCK_BOOTTIME_ALARM 9
+#endif
+
+static void timerfd_expired(struct async_timer* timer, uint64_t expirations) {
+    struct shim_handle* hdl = container_of(timer, struct shim_handle, info.timerfd.timer);
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+
+    lock(&hdl->lock);
+    if (!timerfd->expirations)
+        set_event(&timerfd->event, 1);
+    timerfd->expirations += expirations;
+    unlock(&hdl->lock);
+}
+
+static ssize_t timerfd_read(struct shim_handle* hdl, void* buf, size_t count) {
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+
+    if (count < sizeof(uint64_t))
+        return -EINVAL;
+
+    lock(&hdl->lock);
+    while (!timerfd->expirations) {
+        if (hdl->flags & O_NONBLOCK) {
+            unlock(&hdl->lock);
+            return -EAGAIN;
+        }
+
+        PAL_HANDLE pal_handle = hdl->pal_handle;
+        unlock(&hdl->lock);
+
+        PAL_FLG events = PAL_WAIT_READ;
+        PAL_FLG ret_events = 0;
+        if (!DkStreamsWaitEvents(1, &pal_handle, &events, &ret_events, NO_TIMEOUT))
+            return -PAL_ERRNO();
+
+        lock(&hdl->lock);
+    }
+
+    *(uint64_t*)buf = timerfd->expirations;
+    timerfd->expirations = 0;
+    clear_event(&timerfd->event);
+    unlock(&hdl->lock);
+    return sizeof(uint64_t);
+}
+
+static ssize_t timerfd_write(struct shim_handle* hdl, const void* buf, size_t count) {
+    __UNUSED(hdl);
+    __UNUSED(buf);
+    __UNUSED(count);
+    return -EINVAL;
+}
+
+static int timerfd_close(struct shim_handle* hdl) {
+    /* the event is closed together with the PAL handle of `hdl` */
+    cancel_async_timer(&hdl->info.timerfd.timer);
+    return 0;
+}
+
+static int timerfd_checkout(struct shim_handle* hdl) {
+    /* the child creates its own event and gets a disarmed timer */
+    hdl->info.timerfd.timer.expire_time = 0;
+    hdl->info.timerfd.event.event = NULL;
+    hdl->pal_handle = NULL;
+    return 0;
+}
+
+static int timerfd_checkin(struct shim_handle* hdl) {
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+
+    timerfd->timer.callback = &timerfd_expired;
+    create_event(&timerfd->event);
+    if (!event_created(&timerfd->event))
+        return -ENOMEM;
+    if (timerfd->expirations)
+        set_event(&timerfd->event, 1);
+
+    hdl->pal_handle = event_handle(&timerfd->event);
+    return 0;
+}
+
+struct shim_fs_ops timerfd_fs_ops = {
+    .read     = &timerfd_read,
+    .write    = &timerfd_write,
+    .close    = &timerfd_close,
+    .checkout = &timerfd_checkout,
+    .checkin  = &timerfd_checkin,
+};
+
+struct shim_mount timerfd_builtin_fs = {
+    .type   = "timerfd",
+    .fs_ops = &timerfd_fs_ops,
+};
+
+int shim_do_timerfd_create(int clockid, int flags) {
+    if (clockid != CLOCK_REALTIME && clockid != CLOCK_MONOTONIC && clockid != CLOCK_BOOTTIME &&
+            clockid != CLOCK_REALTIME_ALARM && clockid != CLOCK_BOOTTIME_ALARM)
+        return -EINVAL;
+
+    if (flags & ~(TFD_NONBLOCK | TFD_CLOEXEC))
+        return -EINVAL;
+
+    struct shim_handle* hdl = get_new_handle();
+    if (!hdl)
+        return -ENOMEM;
+
+    hdl->type = TYPE_TIMERFD;
+    set_handle_fs(hdl, &timerfd_builtin_fs);
+    hdl->flags    = O_RDWR | (flags & TFD_NONBLOCK ? O_NONBLOCK : 0);
+    hdl->acc_mode = MAY_READ;
+
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+    memset(timerfd, 0, sizeof(*timerfd));
+    timerfd->timer.callback = &timerfd_expired;
+
+    int ret = timerfd_checkin(hdl);
+    if (ret < 0)
+        goto out;
+
+    ret = set_new_fd_handle(hdl, flags & TFD_CLOEXEC ? FD_CLOEXEC : 0, NULL);
+out:
+    put_handle(hdl);
+    return ret;
+}
+
+static int get_timerfd_handle(int fd, struct shim_handle** hdl) {
+    *hdl = get_fd_handle(fd, NULL, NULL);
+    if (!*hdl)
+        return -EBADF;
+    if ((*hdl)->type != TYPE_TIMERFD) {
+        put_handle(*hdl);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+int shim_do_timerfd_settime(int ufd, int flags, const struct __kernel_itimerspec* utmr,
+                            struct __kernel_itimerspec* otmr) {
+    if (flags & ~(TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET))
+        return -EINVAL;
+
+    if (!utmr || test_user_memory((void*)utmr, sizeof(*utmr), false))
+        return -EFAULT;
+    if (otmr && test_user_memory(otmr, sizeof(*otmr), true))
+        return -EFAULT;
+
+    uint64_t expire_time;
+    uint64_t interval;
+    int ret = itimerspec_to_async_timer(utmr, flags & TFD_TIMER_ABSTIME, &expire_time, &interval);
+    if (ret < 0)
+        return ret;
+
+    struct shim_handle* hdl;
+    ret = get_timerfd_handle(ufd, &hdl);
+    if (ret < 0)
+        return ret;
+
+    struct shim_timerfd_handle* timerfd = &hdl->info.timerfd;
+
+    if (otmr)
+        async_timer_to_itimerspec(&timerfd->timer, otmr);
+
+    /* wait for a concurrently running callback before resetting the expirations, it must not be
+     * called with the handle lock held */
+    cancel_async_timer(&timerfd->timer);
+
+    lock(&hdl->lock);
+    timerfd->expirations = 0;
+    clear_event(&timerfd->event);
+    ret = set_async_timer(&timerfd->timer, expire_time, interval);
+    unlock(&hdl->lock);
+
+    put_handle(hdl);
+    return ret;
+}
+
+int shim_do_timerfd_gettime(int ufd, struct __kernel_itimerspec* otmr) {
+    if (!otmr || test_user_memory(otmr, sizeof(*otmr), true))
+        return -EFAULT;
+
+    struct shim_handle* hdl;
+    int ret = get_timerfd_handle(ufd, &hdl);
+    if (ret < 0)
+        return ret;
+
+    async_timer_to_itimerspec(&hdl->info.timerfd.timer, otmr);
+    put_handle(hdl);
+    return 0;
+}
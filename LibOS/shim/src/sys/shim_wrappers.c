@@ -4,63 +4,155 @@
 /*
  * shim_wrapper.c
  *
- * Implementation of system call "readv" and "writev".
+ * Implementation of system call "readv", "writev", "preadv", "pwritev", "preadv2" and
+ * "pwritev2".
+ *
+ * File systems with the preadv/pwritev operations get all buffers of a call in a single operation
+ * (one handle lock and one PAL call for chroot files); all others get one read or write per
+ * buffer.
  */
 
 #include <errno.h>
 #include <pal.h>
 #include <pal_error.h>
+#include <shim_flags_conv.h>
 #include <shim_fs.h>
 #include <shim_handle.h>
 #include <shim_internal.h>
 #include <shim_table.h>
 #include <shim_utils.h>
 
-ssize_t shim_do_readv(int fd, const struct iovec* vec, int vlen) {
+/* same as UIO_MAXIOV */
+#define MAX_IOVECS 1024
+
+#define SUPPORTED_RWF_FLAGS (RWF_HIPRI | RWF_DSYNC | RWF_SYNC | RWF_NOWAIT)
+
+static int check_iovec(const struct iovec* vec, int vlen, bool to_user) {
+    if (vlen < 0 || vlen > MAX_IOVECS)
+        return -EINVAL;
+
     if (!vec || test_user_memory((void*)vec, sizeof(*vec) * vlen, false))
         return -EINVAL;
 
+    size_t total = 0;
     for (int i = 0; i < vlen; i++) {
+        if (__builtin_add_overflow(total, vec[i].iov_len, &total) || (ssize_t)total < 0)
+            return -EINVAL;
         if (vec[i].iov_base) {
-            if (vec[i].iov_base + vec[i].iov_len <= vec[i].iov_base)
+            if (vec[i].iov_base + vec[i].iov_len < vec[i].iov_base)
                 return -EINVAL;
-            if (test_user_memory(vec[i].iov_base, vec[i].iov_len, true))
+            if (test_user_memory(vec[i].iov_base, vec[i].iov_len, to_user))
                 return -EFAULT;
         }
     }
+    return 0;
+}
+
+/* one read or write per buffer at the file position, for file systems without preadv/pwritev */
+static ssize_t do_rw_each(struct shim_handle* hdl, const struct iovec* vec, int vlen, bool write) {
+    ssize_t bytes = 0;
+
+    for (int i = 0; i < vlen; i++) {
+        ssize_t b_vec;
+
+        if (!vec[i].iov_base)
+            continue;
+
+        if (write) {
+            b_vec = hdl->fs->fs_ops->write(hdl, vec[i].iov_base, vec[i].iov_len);
+        } else {
+            b_vec = hdl->fs->fs_ops->read(hdl, vec[i].iov_base, vec[i].iov_len);
+        }
+        if (b_vec < 0)
+            return bytes ?: b_vec;
+
+        bytes += b_vec;
+        if ((size_t)b_vec < vec[i].iov_len)
+            break;
+    }
+
+    return bytes;
+}
+
+/* vectored read or write at `pos`, or at the file position if `pos` is -1 */
+static ssize_t do_rw(int fd, const struct iovec* vec, int vlen, off_t pos, int flags, bool write) {
+    int ret = check_iovec(vec, vlen, /*to_user=*/!write);
+    if (ret < 0)
+        return ret;
+
+    if (flags & ~SUPPORTED_RWF_FLAGS)
+        return -EOPNOTSUPP;
 
     struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
     if (!hdl)
         return -EBADF;
 
-    int ret = 0;
+    struct shim_mount* fs = hdl->fs;
+    ssize_t bytes = -EBADF;
 
-    if (!(hdl->acc_mode & MAY_READ) || !hdl->fs || !hdl->fs->fs_ops || !hdl->fs->fs_ops->read) {
-        ret = -EACCES;
+    if (!(hdl->acc_mode & (write ? MAY_WRITE : MAY_READ)))
+        goto out;
+
+    bytes = -EISDIR;
+    if (hdl->type == TYPE_DIR)
+        goto out;
+
+    bytes = -EACCES;
+    if (!fs || !fs->fs_ops || (write ? !fs->fs_ops->write : !fs->fs_ops->read))
+        goto out;
+
+    if (pos >= 0 && (hdl->type == TYPE_PIPE || hdl->type == TYPE_SOCK || !fs->fs_ops->seek)) {
+        bytes = -ESPIPE;
         goto out;
     }
 
-    ssize_t bytes = 0;
+    int pass_flags = flags & (RWF_NOWAIT | RWF_HIPRI);
+    bool vectored = write ? fs->fs_ops->pwritev != NULL : fs->fs_ops->preadv != NULL;
 
-    for (int i = 0; i < vlen; i++) {
-        int b_vec;
+    if (vectored) {
+        bytes = write ? fs->fs_ops->pwritev(hdl, vec, vlen, pos, pass_flags)
+                      : fs->fs_ops->preadv(hdl, vec, vlen, pos, pass_flags);
+    } else if (flags & RWF_NOWAIT) {
+        /* no way to tell whether the file system would block */
+        bytes = -EOPNOTSUPP;
+        goto out;
+    } else if (pos < 0) {
+        bytes = do_rw_each(hdl, vec, vlen, write);
+    } else {
+        off_t offset = fs->fs_ops->seek(hdl, 0, SEEK_CUR);
+        if (offset < 0) {
+            bytes = offset;
+            goto out;
+        }
 
-        if (!vec[i].iov_base)
-            continue;
+        off_t seek_ret = fs->fs_ops->seek(hdl, pos, SEEK_SET);
+        if (seek_ret < 0) {
+            bytes = seek_ret;
+            goto out;
+        }
+
+        bytes = do_rw_each(hdl, vec, vlen, write);
 
-        b_vec = hdl->fs->fs_ops->read(hdl, vec[i].iov_base, vec[i].iov_len);
-        if (b_vec < 0) {
-            ret = bytes ?: b_vec;
+        seek_ret = fs->fs_ops->seek(hdl, offset, SEEK_SET);
+        if (seek_ret < 0) {
+            bytes = seek_ret;
             goto out;
         }
+    }
 
-        bytes += b_vec;
+    if (write && bytes > 0 && (flags & (RWF_DSYNC | RWF_SYNC)) && fs->fs_ops->flush) {
+        ret = fs->fs_ops->flush(hdl);
+        if (ret < 0)
+            bytes = ret;
     }
 
-    ret = bytes;
 out:
     put_handle(hdl);
-    return ret;
+    return bytes;
+}
+
+ssize_t shim_do_readv(int fd, const struct iovec* vec, int vlen) {
+    return do_rw(fd, vec, vlen, /*pos=*/-1, /*flags=*/0, /*write=*/false);
 }
 
 /*
@@ -79,48 +171,38 @@ out:
  * shall remain unchanged, and errno shall be set to indicate an error
  */
 ssize_t shim_do_writev(int fd, const struct iovec* vec, int vlen) {
-    if (!vec || test_user_memory((void*)vec, sizeof(*vec) * vlen, false))
-        return -EINVAL;
-
-    for (int i = 0; i < vlen; i++) {
-        if (vec[i].iov_base) {
-            if (vec[i].iov_base + vec[i].iov_len < vec[i].iov_base)
-                return -EINVAL;
-            if (test_user_memory(vec[i].iov_base, vec[i].iov_len, false))
-                return -EFAULT;
-        }
-    }
-
-    struct shim_handle* hdl = get_fd_handle(fd, NULL, NULL);
-    if (!hdl)
-        return -EBADF;
-
-    int ret = 0;
-
-    if (!(hdl->acc_mode & MAY_WRITE) || !hdl->fs || !hdl->fs->fs_ops || !hdl->fs->fs_ops->write) {
-        ret = -EACCES;
-        goto out;
-    }
-
-    ssize_t bytes = 0;
-
-    for (int i = 0; i < vlen; i++) {
-        int b_vec;
+    return do_rw(fd, vec, vlen, /*pos=*/-1, /*flags=*/0, /*write=*/true);
+}
 
-        if (!vec[i].iov_base)
-            continue;
+/* `pos_h` carries the upper half of the offset only for 32-bit callers */
+ssize_t shim_do_preadv(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                       unsigned long pos_h) {
+    __UNUSED(pos_h);
+    if ((off_t)pos_l < 0)
+        return -EINVAL;
+    return do_rw(fd, vec, vlen, pos_l, /*flags=*/0, /*write=*/false);
+}
 
-        b_vec = hdl->fs->fs_ops->write(hdl, vec[i].iov_base, vec[i].iov_len);
-        if (b_vec < 0) {
-            ret = bytes ?: b_vec;
-            goto out;
-        }
+ssize_t shim_do_pwritev(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h) {
+    __UNUSED(pos_h);
+    if ((off_t)pos_l < 0)
+        return -EINVAL;
+    return do_rw(fd, vec, vlen, pos_l, /*flags=*/0, /*write=*/true);
+}
 
-        bytes += b_vec;
-    }
+ssize_t shim_do_preadv2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                        unsigned long pos_h, int flags) {
+    __UNUSED(pos_h);
+    if ((off_t)pos_l < -1)
+        return -EINVAL;
+    return do_rw(fd, vec, vlen, pos_l, flags, /*write=*/false);
+}
 
-    ret = bytes;
-out:
-    put_handle(hdl);
-    return ret;
+ssize_t shim_do_pwritev2(int fd, const struct iovec* vec, int vlen, unsigned long pos_l,
+                         unsigned long pos_h, int flags) {
+    __UNUSED(pos_h);
+    if ((off_t)pos_l < -1)
+        return -EINVAL;
+    return do_rw(fd, vec, vlen, pos_l, flags, /*write=*/true);
 }
@@ -15,7 +15,7 @@
 static int (*shim_clock_gettime)(clockid_t clock, struct timespec* t)    = NULL;
 static int (*shim_gettimeofday)(struct timeval* tv, struct timezone* tz) = NULL;
 static time_t (*shim_time)(time_t* t)                                    = NULL;
-static long (*shim_getcpu)(unsigned* cpu, struct getcpu_cache* unused)   = NULL;
+static long (*shim_getcpu)(unsigned* cpu, unsigned* node, struct getcpu_cache* unused) = NULL;
 
 EXPORT_SYMBOL(shim_clock_gettime);
 EXPORT_SYMBOL(shim_gettimeofday);
@@ -46,9 +46,9 @@ time_t __vdso_time(time_t* t) {
 }
 EXPORT_WEAK_SYMBOL(time);
 
-long __vdso_getcpu(unsigned* cpu, struct getcpu_cache* unused) {
+long __vdso_getcpu(unsigned* cpu, unsigned* node, struct getcpu_cache* unused) {
     if (shim_getcpu)
-        return (*shim_getcpu)(cpu, unused);
+        return (*shim_getcpu)(cpu, node, unused);
     return -ENOSYS;
 }
 EXPORT_WEAK_SYMBOL(getcpu);
@@ -0,0 +1,76 @@
+/* Measures the cost of creating and joining a thread, once for a thread that exits immediately
+ * and once for a batch of threads that are alive at the same time (thread-per-request servers).
+ * Freed thread stacks and thread objects are recycled, so only the first round should be slow. */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define DEFAULT_ROUNDS 1000
+#define BATCH          16
+
+#define XSTR(x) #x
+#define STR(x)  XSTR(x)
+
+static void* thread_func(void* arg) {
+    return arg;
+}
+
+static double now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static int create_and_join(int nthreads) {
+    pthread_t threads[BATCH];
+
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&threads[i], NULL, thread_func, (void*)(intptr_t)i)) {
+            printf("pthread_create failed\n");
+            return -1;
+        }
+    }
+    for (int i = 0; i < nthreads; i++) {
+        void* ret;
+        if (pthread_join(threads[i], &ret) || ret != (void*)(intptr_t)i) {
+            printf("pthread_join failed\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int run(const char* name, int rounds, int nthreads) {
+    double start = now_us();
+    if (create_and_join(nthreads) < 0)
+        return -1;
+    double first = now_us() - start;
+
+    start = now_us();
+    for (int i = 1; i < rounds; i++)
+        if (create_and_join(nthreads) < 0)
+            return -1;
+    double rest = now_us() - start;
+
+    printf("%s: first round %.0f us, then %.3f us per thread over %d rounds\n", name, first,
+           rounds > 1 ? rest / ((rounds - 1) * nthreads) : 0.0, rounds - 1);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int rounds = DEFAULT_ROUNDS;
+
+    if (argc >= 2)
+        rounds = atoi(argv[1]);
+    if (rounds <= 0)
+        return 1;
+
+    if (run("clone+join", rounds, 1) < 0)
+        return 1;
+    if (run("clone+join (" STR(BATCH) " at a time)", rounds / BATCH + 1, BATCH) < 0)
+        return 1;
+    return 0;
+}
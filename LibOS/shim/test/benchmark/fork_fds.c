@@ -0,0 +1,60 @@
+/* Measures how the cost of fork() grows with the number of open file descriptors: every pipe end
+ * is backed by a PAL handle which must be migrated to the child along with its host FDs. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define DEFAULT_PIPES 128
+#define NTRIES        100
+
+static double now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
+
+static void fork_and_wait(int open_fds) {
+    double start = now_us();
+
+    for (int i = 0; i < NTRIES; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            exit(1);
+        }
+        if (!pid)
+            _exit(0);
+        if (waitpid(pid, NULL, 0) != pid) {
+            perror("waitpid");
+            exit(1);
+        }
+    }
+
+    double us = now_us() - start;
+    printf("fork with %d extra fds: %.1f us per fork+exit+wait\n", open_fds, us / NTRIES);
+}
+
+int main(int argc, char** argv) {
+    int npipes = DEFAULT_PIPES;
+
+    if (argc >= 2)
+        npipes = atoi(argv[1]);
+    if (npipes <= 0)
+        return 1;
+
+    fork_and_wait(0);
+
+    for (int i = 0; i < npipes; i++) {
+        int fds[2];
+        if (pipe(fds) < 0) {
+            perror("pipe");
+            return 1;
+        }
+    }
+
+    fork_and_wait(2 * npipes);
+    return 0;
+}
@@ -42,6 +42,46 @@ static void sighand2(int signum, siginfo_t* sinfo, void* ucontext) {
 
 void (*sighand)(int signum, siginfo_t* sinfo, void* ucontext) = NULL;
 
+volatile int self_count = 0;
+
+static void self_handler(int signum) {
+    self_count++;
+}
+
+/* latency of a signal a process sends to itself, handled right away or after being unblocked */
+static void self_latency(void) {
+    struct timeval timevals[2];
+    sigset_t set;
+
+    struct sigaction action = {.sa_handler = self_handler};
+    sigaction(SIGUSR2, &action, NULL);
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR2);
+
+    gettimeofday(&timevals[0], NULL);
+    for (int i = 0; i < NTRIES; i++)
+        kill(getpid(), SIGUSR2);
+    gettimeofday(&timevals[1], NULL);
+    printf("latency of a signal sent to self: %lf us\n",
+           ((timevals[1].tv_sec - timevals[0].tv_sec) * 1000000.0 + timevals[1].tv_usec
+            - timevals[0].tv_usec) / NTRIES);
+
+    gettimeofday(&timevals[0], NULL);
+    for (int i = 0; i < NTRIES; i++) {
+        sigprocmask(SIG_BLOCK, &set, NULL);
+        kill(getpid(), SIGUSR2);
+        sigprocmask(SIG_UNBLOCK, &set, NULL);
+    }
+    gettimeofday(&timevals[1], NULL);
+    printf("latency of a blocked signal sent to self: %lf us\n",
+           ((timevals[1].tv_sec - timevals[0].tv_sec) * 1000000.0 + timevals[1].tv_usec
+            - timevals[0].tv_usec) / NTRIES);
+
+    if (self_count != 2 * NTRIES)
+        printf("only %d of %d signals sent to self were handled\n", self_count, 2 * NTRIES);
+}
+
 static void sigact(int signum, siginfo_t* sinfo, void* ucontext) {
     if (sighand)
         sighand(signum, sinfo, ucontext);
@@ -60,6 +100,8 @@ int main(int argc, char** argv) {
 
     setvbuf(stdout, NULL, _IONBF, 0);
 
+    self_latency();
+
     signal(SIGUSR1, (void*)sigact);
 
     if (pipe(&pipes[0]) < 0 || pipe(&pipes[2]) < 0 || pipe(&pipes[4]) < 0 || pipe(&pipes[6]) < 0) {
@@ -0,0 +1,209 @@
+/* Relays data between two TCP loopback connections, either with splice() through a pipe or with a
+ * read()/write() copy, and reports the throughput. Usage: splice_relay [MB] [copy] */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define PORT       8000
+#define CHUNK_SIZE (64 * 1024)
+#define DEFAULT_MB 256
+
+static char buf[CHUNK_SIZE];
+
+static int connect_server(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        exit(1);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(PORT);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+static void run_sender(size_t total) {
+    int fd = connect_server();
+    memset(buf, 'a', sizeof(buf));
+
+    while (total > 0) {
+        size_t size = total < CHUNK_SIZE ? total : CHUNK_SIZE;
+        ssize_t ret = write(fd, buf, size);
+        if (ret <= 0) {
+            perror("write");
+            exit(1);
+        }
+        total -= ret;
+    }
+    close(fd);
+    exit(0);
+}
+
+static void run_sink(size_t total) {
+    int fd = connect_server();
+    size_t received = 0;
+
+    while (1) {
+        ssize_t ret = read(fd, buf, sizeof(buf));
+        if (ret < 0) {
+            perror("read");
+            exit(1);
+        }
+        if (ret == 0)
+            break;
+        received += ret;
+    }
+    close(fd);
+    exit(received == total ? 0 : 1);
+}
+
+static size_t relay_splice(int in, int out) {
+    int pipefd[2];
+    if (pipe(pipefd) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+
+    size_t relayed = 0;
+    while (1) {
+        ssize_t ret = splice(in, NULL, pipefd[1], NULL, CHUNK_SIZE, SPLICE_F_MOVE);
+        if (ret < 0) {
+            perror("splice from socket");
+            exit(1);
+        }
+        if (ret == 0)
+            break;
+
+        ssize_t left = ret;
+        while (left > 0) {
+            ssize_t written = splice(pipefd[0], NULL, out, NULL, left, SPLICE_F_MOVE);
+            if (written <= 0) {
+                perror("splice to socket");
+                exit(1);
+            }
+            left -= written;
+        }
+        relayed += ret;
+    }
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return relayed;
+}
+
+static size_t relay_copy(int in, int out) {
+    size_t relayed = 0;
+    while (1) {
+        ssize_t ret = read(in, buf, sizeof(buf));
+        if (ret < 0) {
+            perror("read");
+            exit(1);
+        }
+        if (ret == 0)
+            break;
+
+        for (ssize_t done = 0; done < ret;) {
+            ssize_t written = write(out, buf + done, ret - done);
+            if (written <= 0) {
+                perror("write");
+                exit(1);
+            }
+            done += written;
+        }
+        relayed += ret;
+    }
+    return relayed;
+}
+
+int main(int argc, char** argv) {
+    size_t total = (size_t)DEFAULT_MB * 1024 * 1024;
+    int use_copy = 0;
+
+    if (argc >= 2)
+        total = (size_t)atoi(argv[1]) * 1024 * 1024;
+    if (argc >= 3 && !strcmp(argv[2], "copy"))
+        use_copy = 1;
+
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    int enable = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(PORT);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd, 2) < 0) {
+        perror("bind/listen");
+        return 1;
+    }
+
+    /* accept the sender first, so the two connections cannot be mixed up */
+    int sender = fork();
+    if (sender < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (sender == 0)
+        run_sender(total);
+    int in = accept(listen_fd, NULL, NULL);
+
+    int sink = fork();
+    if (sink < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (sink == 0)
+        run_sink(total);
+    int out = accept(listen_fd, NULL, NULL);
+
+    if (in < 0 || out < 0) {
+        perror("accept");
+        return 1;
+    }
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    size_t relayed = use_copy ? relay_copy(in, out) : relay_splice(in, out);
+    close(out);
+    gettimeofday(&end, NULL);
+
+    int status_sender, status_sink;
+    waitpid(sender, &status_sender, 0);
+    waitpid(sink, &status_sink, 0);
+    if (!WIFEXITED(status_sink) || WEXITSTATUS(status_sink)) {
+        printf("sink did not receive all data\n");
+        return 1;
+    }
+
+    double secs = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+    printf("%s relay: %lu MB in %.3f s, %.1f MB/s\n", use_copy ? "copy" : "splice",
+           relayed / (1024 * 1024), secs, relayed / (1024 * 1024) / secs);
+
+    close(in);
+    close(listen_fd);
+    return 0;
+}
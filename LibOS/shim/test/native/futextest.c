@@ -1,40 +1,86 @@
+/* Measures the cost of handing control back and forth between two threads through process-private
+ * futexes, once directly and once through a pthread mutex and condition variable. Compare the
+ * results with "sys.host_futex" set to 1 (see futextest.manifest.template) and to 0. */
+
+#include <linux/futex.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
 #include <unistd.h>
 
-static void* print1(void* arg) {
-    printf("This is Function 1 - go to sleep\n");
-    sleep(5);
-    printf("Function1 out of sleep\n");
-    printf("%s", (char*)arg);
-    return NULL;
+#define DEFAULT_ROUNDS 100000
+
+static int g_rounds = DEFAULT_ROUNDS;
+
+static int g_turn;
+
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond   = PTHREAD_COND_INITIALIZER;
+static int g_cond_turn;
+
+static long futex(int* uaddr, int op, int val) {
+    return syscall(SYS_futex, uaddr, op, val, NULL, NULL, 0);
+}
+
+/* waits until it is `me`'s turn, then passes the turn to the other thread */
+static void futex_handoff(int me) {
+    while (__atomic_load_n(&g_turn, __ATOMIC_ACQUIRE) != me)
+        futex(&g_turn, FUTEX_WAIT_PRIVATE, !me);
+    __atomic_store_n(&g_turn, !me, __ATOMIC_RELEASE);
+    futex(&g_turn, FUTEX_WAKE_PRIVATE, 1);
 }
 
-static void* print2(void* arg) {
-    printf("This is Function 2 - go to sleep\n");
-    sleep(5);
-    printf("Function2 out of sleep\n");
-    printf("%s", (char*)arg);
+static void cond_handoff(int me) {
+    pthread_mutex_lock(&g_mutex);
+    while (g_cond_turn != me)
+        pthread_cond_wait(&g_cond, &g_mutex);
+    g_cond_turn = !me;
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_mutex);
+}
+
+static void* futex_thread(void* arg) {
+    (void)arg;
+    for (int i = 0; i < g_rounds; i++)
+        futex_handoff(1);
     return NULL;
 }
 
-static void* func(void* arg) {
-    int* ptr = (int*)arg;
-    printf("Parent gave %d\n", *ptr);
+static void* cond_thread(void* arg) {
+    (void)arg;
+    for (int i = 0; i < g_rounds; i++)
+        cond_handoff(1);
     return NULL;
 }
 
+static void run(const char* name, void* (*thread_func)(void*), void (*handoff)(int)) {
+    struct timeval start, end;
+    pthread_t thread;
+
+    gettimeofday(&start, NULL);
+    if (pthread_create(&thread, NULL, thread_func, NULL)) {
+        printf("pthread_create failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < g_rounds; i++)
+        handoff(0);
+    pthread_join(thread, NULL);
+    gettimeofday(&end, NULL);
+
+    double us = (end.tv_sec - start.tv_sec) * 1000000.0 + (end.tv_usec - start.tv_usec);
+    printf("%s: %d round trips in %.0f us, %.3f us per handoff\n", name, g_rounds, us,
+           us / (2.0 * g_rounds));
+}
+
 int main(int argc, char** argv) {
-    pthread_t thread1, thread2, thread3;
-    int intvar = 12;
-
-    pthread_create(&thread1, NULL, print1, "Thread1 Executing ...\n");
-    pthread_create(&thread2, NULL, print2, "Thread2 Executing ...\n");
-    pthread_create(&thread3, NULL, func, &intvar);
-    printf("going to sleep\n");
-    printf("out of sleep\n");
-    pthread_join(thread1, NULL);
-    pthread_join(thread2, NULL);
-    pthread_join(thread3, NULL);
+    if (argc >= 2)
+        g_rounds = atoi(argv[1]);
+    if (g_rounds <= 0)
+        return 1;
+
+    run("futex", futex_thread, futex_handoff);
+    run("mutex+condvar", cond_thread, cond_handoff);
     return 0;
 }
@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,6 +10,77 @@
 #define NTRIES     10000
 #define TEST_TIMES 32
 
+#define BULK_BYTES (256 * 1024 * 1024)
+#define BULK_CHUNK (64 * 1024)
+
+/* Measures the throughput of a child streaming BULK_BYTES to the parent through one pipe, with the
+ * pipe capacity changed to `pipe_size` bytes (if not 0). */
+static int bulk_throughput(int pipe_size) {
+    static char buf[BULK_CHUNK];
+    int fds[2];
+
+    if (pipe(fds) < 0) {
+        perror("pipe error");
+        return -1;
+    }
+
+    if (pipe_size && fcntl(fds[1], F_SETPIPE_SZ, pipe_size) < 0) {
+        perror("fcntl(F_SETPIPE_SZ) error");
+        return -1;
+    }
+    int actual_size = fcntl(fds[0], F_GETPIPE_SZ);
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        printf("fork failed\n");
+        return -1;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        for (size_t sent = 0; sent < BULK_BYTES;) {
+            ssize_t ret = write(fds[1], buf, BULK_CHUNK);
+            if (ret < 0) {
+                perror("write error");
+                exit(1);
+            }
+            sent += ret;
+        }
+        close(fds[1]);
+        exit(0);
+    }
+
+    close(fds[1]);
+
+    struct timeval start, end;
+    size_t received = 0;
+    gettimeofday(&start, NULL);
+    for (;;) {
+        ssize_t ret = read(fds[0], buf, sizeof(buf));
+        if (ret < 0) {
+            perror("read error");
+            return -1;
+        }
+        if (!ret)
+            break;
+        received += ret;
+    }
+    gettimeofday(&end, NULL);
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+
+    if (received != BULK_BYTES) {
+        printf("received %zu bytes instead of %d\n", received, BULK_BYTES);
+        return -1;
+    }
+
+    double us = (end.tv_sec - start.tv_sec) * 1000000.0 + (end.tv_usec - start.tv_usec);
+    printf("bulk throughput with pipe size %d: %.1f MB/second\n", actual_size,
+           BULK_BYTES / us * 1000000.0 / (1024 * 1024));
+    return 0;
+}
+
 int main(int argc, char** argv) {
     int times = TEST_TIMES;
     int pipes[6];
@@ -176,5 +249,8 @@ int main(int argc, char** argv) {
     printf("throughput for %d processes to send %d message: %lf bytes/second\n", times, NTRIES,
            1.0 * NTRIES * 2 * times * 1000000 / (end_time - start_time));
 
+    if (bulk_throughput(/*pipe_size=*/0) < 0 || bulk_throughput(1024 * 1024) < 0)
+        return 1;
+
     return 0;
 }
@@ -1,34 +1,116 @@
+/* Measures the latency of spawning a process that exits right away, through vfork() + execve(),
+ * posix_spawn() and fork() + execve(). The first two do not copy the address space of the parent.
+ * Also checks that descriptors closed by the vfork child stay open in the parent. */
+
 #define _GNU_SOURCE
 #include <errno.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
-int main(int argc, const char** argv, const char** envp) {
-    int newfd = dup(1), outfd = dup(1);
-    char fd_argv[4];
-    snprintf(fd_argv, 4, "%d", newfd);
-    char* const new_argv[] = {"./exec_victim", fd_argv, NULL};
+#define DEFAULT_ROUNDS 100
+
+extern char** environ;
+
+static double now_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000.0 + tv.tv_usec;
+}
 
-    setenv("IN_EXECVE", "1", 1);
+static void wait_child(pid_t pid) {
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        printf("child %d did not exit cleanly\n", pid);
+        exit(1);
+    }
+}
 
-    int pid = vfork();
+static pid_t spawn_vfork(char* const* argv) {
+    pid_t pid = vfork();
     if (pid == 0) {
-        close(outfd);
-        execv(new_argv[0], new_argv);
+        execv(argv[0], argv);
+        _exit(127);
     }
+    return pid;
+}
 
-    wait(NULL);
+static pid_t spawn_fork(char* const* argv) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t spawn_posix(char* const* argv) {
+    pid_t pid;
+    int ret = posix_spawn(&pid, argv[0], NULL, NULL, argv, environ);
+    if (ret) {
+        errno = ret;
+        return -1;
+    }
+    return pid;
+}
+
+static void run(const char* name, pid_t (*spawn)(char* const*), char* const* argv, int rounds) {
+    double start = now_us();
+
+    for (int i = 0; i < rounds; i++) {
+        pid_t pid = spawn(argv);
+        if (pid < 0) {
+            printf("%s failed (%s)\n", name, strerror(errno));
+            exit(1);
+        }
+        wait_child(pid);
+    }
+
+    double us = now_us() - start;
+    printf("%s: %d processes in %.0f us, %.1f us per spawn\n", name, rounds, us, us / rounds);
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && !strcmp(argv[1], "child"))
+        return 0;
+
+    int rounds = DEFAULT_ROUNDS;
+    if (argc >= 2)
+        rounds = atoi(argv[1]);
+    if (rounds <= 0)
+        return 1;
+
+    char* const child_argv[] = {argv[0], "child", NULL};
+
+    /* the vfork child has its own copy of the descriptor table */
+    int outfd = dup(1);
+    pid_t pid = vfork();
+    if (pid == 0) {
+        close(outfd);
+        execv(child_argv[0], child_argv);
+        _exit(127);
+    }
+    if (pid < 0) {
+        printf("vfork failed (%s)\n", strerror(errno));
+        return 1;
+    }
+    wait_child(pid);
 
     FILE* out = fdopen(outfd, "a");
     if (!out) {
-        printf("cannot open file descriptor\n");
-        return -1;
+        printf("descriptor closed by the vfork child is closed in the parent\n");
+        return 1;
     }
+    fprintf(out, "vfork child closed its own descriptor only\n");
+    fclose(out);
 
-    fprintf(out, "Goodbye world!\n");
+    run("vfork+execve", spawn_vfork, child_argv, rounds);
+    run("posix_spawn", spawn_posix, child_argv, rounds);
+    run("fork+execve", spawn_fork, child_argv, rounds);
     return 0;
 }
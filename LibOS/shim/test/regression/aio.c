@@ -0,0 +1,127 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/aio_abi.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define NR_REQS  8
+#define REQ_SIZE 4096
+
+static char bufs[NR_REQS][REQ_SIZE];
+
+static void submit_and_wait(aio_context_t ctx, struct iocb* iocbs, int nr, long expected_res) {
+    struct iocb* iocbps[NR_REQS];
+    for (int i = 0; i < nr; i++)
+        iocbps[i] = &iocbs[i];
+
+    /* all requests are submitted with one system call */
+    long ret = syscall(SYS_io_submit, ctx, nr, iocbps);
+    if (ret != nr)
+        err(1, "io_submit returned %ld", ret);
+
+    struct io_event events[NR_REQS];
+    int done = 0;
+    while (done < nr) {
+        ret = syscall(SYS_io_getevents, ctx, 1, NR_REQS, events, NULL);
+        if (ret < 0)
+            err(1, "io_getevents");
+        for (int i = 0; i < ret; i++) {
+            struct iocb* iocb = (struct iocb*)events[i].obj;
+            if (events[i].data != iocb->aio_data || events[i].res != expected_res)
+                errx(1, "wrong event for request %llu: res %lld", events[i].data, events[i].res);
+        }
+        done += ret;
+    }
+}
+
+int main(void) {
+    int fd = open("tmp/aio_test", O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        err(1, "open");
+
+    int efd = eventfd(0, 0);
+    if (efd < 0)
+        err(1, "eventfd");
+
+    aio_context_t ctx = 0;
+    if (syscall(SYS_io_setup, NR_REQS, &ctx) < 0)
+        err(1, "io_setup");
+
+    struct iocb iocbs[NR_REQS];
+    memset(iocbs, 0, sizeof(iocbs));
+    for (int i = 0; i < NR_REQS; i++) {
+        memset(bufs[i], 'a' + i, REQ_SIZE);
+        iocbs[i].aio_data       = i;
+        iocbs[i].aio_lio_opcode = IOCB_CMD_PWRITE;
+        iocbs[i].aio_fildes     = fd;
+        iocbs[i].aio_buf        = (uint64_t)bufs[i];
+        iocbs[i].aio_nbytes     = REQ_SIZE;
+        iocbs[i].aio_offset     = (int64_t)i * REQ_SIZE;
+        iocbs[i].aio_flags      = IOCB_FLAG_RESFD;
+        iocbs[i].aio_resfd      = efd;
+    }
+    submit_and_wait(ctx, iocbs, NR_REQS, REQ_SIZE);
+
+    uint64_t count = 0;
+    if (read(efd, &count, sizeof(count)) != sizeof(count) || count != NR_REQS)
+        errx(1, "eventfd counted %lu completions instead of %d", count, NR_REQS);
+
+    if (lseek(fd, 0, SEEK_END) != NR_REQS * REQ_SIZE)
+        errx(1, "wrong file size after asynchronous writes");
+    if (lseek(fd, 0, SEEK_SET) != 0)
+        err(1, "lseek");
+
+    /* read back in reverse order, the last request with two iovecs */
+    memset(bufs, 0, sizeof(bufs));
+    struct iovec iov[2] = {
+        {.iov_base = bufs[NR_REQS - 1], .iov_len = REQ_SIZE / 2},
+        {.iov_base = bufs[NR_REQS - 1] + REQ_SIZE / 2, .iov_len = REQ_SIZE / 2},
+    };
+    memset(iocbs, 0, sizeof(iocbs));
+    for (int i = 0; i < NR_REQS; i++) {
+        iocbs[i].aio_data       = i;
+        iocbs[i].aio_lio_opcode = IOCB_CMD_PREAD;
+        iocbs[i].aio_fildes     = fd;
+        iocbs[i].aio_buf        = (uint64_t)bufs[i];
+        iocbs[i].aio_nbytes     = REQ_SIZE;
+        iocbs[i].aio_offset     = (int64_t)(NR_REQS - 1 - i) * REQ_SIZE;
+    }
+    iocbs[NR_REQS - 1].aio_lio_opcode = IOCB_CMD_PREADV;
+    iocbs[NR_REQS - 1].aio_buf        = (uint64_t)iov;
+    iocbs[NR_REQS - 1].aio_nbytes     = 2;
+    submit_and_wait(ctx, iocbs, NR_REQS, REQ_SIZE);
+
+    for (int i = 0; i < NR_REQS; i++)
+        for (int j = 0; j < REQ_SIZE; j++)
+            if (bufs[i][j] != 'a' + NR_REQS - 1 - i)
+                errx(1, "wrong data in request %d at offset %d", i, j);
+
+    /* the file position is not affected */
+    if (lseek(fd, 0, SEEK_CUR) != 0)
+        errx(1, "asynchronous I/O moved the file position");
+
+    struct io_event event;
+    struct timespec timeout = {0};
+    if (syscall(SYS_io_getevents, ctx, 1, 1, &event, &timeout) != 0)
+        errx(1, "io_getevents returned an event although none is pending");
+
+    if (syscall(SYS_io_destroy, ctx) < 0)
+        err(1, "io_destroy");
+    if (syscall(SYS_io_destroy, ctx) != -1 || errno != EINVAL)
+        errx(1, "io_destroy of a destroyed context did not fail with EINVAL");
+
+    close(efd);
+    close(fd);
+    if (unlink("tmp/aio_test") < 0)
+        err(1, "unlink");
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,57 @@
+/* Checks that execve() deletes the POSIX timers of the process. The timer is armed with SIGUSR1,
+ * whose handler is reset by execve(), so a timer surviving execve() would kill the new image. */
+
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static void handler(int sig) {
+    (void)sig;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && !strcmp(argv[1], "child")) {
+        /* let the timer fire a few times if it survived */
+        struct timespec ts = {.tv_sec = 0, .tv_nsec = 100 * 1000 * 1000};
+        while (nanosleep(&ts, &ts) < 0 && errno == EINTR)
+            ;
+
+        int timer_id = atoi(argv[2]);
+        struct itimerspec its;
+        if (syscall(SYS_timer_gettime, timer_id, &its) != -1 || errno != EINVAL)
+            errx(1, "timer %d survived execve", timer_id);
+
+        printf("TEST OK\n");
+        return 0;
+    }
+
+    struct sigaction act = {.sa_handler = handler};
+    if (sigaction(SIGUSR1, &act, NULL) < 0)
+        err(1, "sigaction");
+
+    /* raw syscalls, so that the kernel timer ID can be passed to the new image */
+    struct sigevent sev = {.sigev_notify = SIGEV_SIGNAL, .sigev_signo = SIGUSR1};
+    int timer_id;
+    if (syscall(SYS_timer_create, CLOCK_MONOTONIC, &sev, &timer_id) < 0)
+        err(1, "timer_create");
+
+    struct itimerspec its = {
+        .it_value    = {.tv_sec = 0, .tv_nsec = 10 * 1000 * 1000},
+        .it_interval = {.tv_sec = 0, .tv_nsec = 10 * 1000 * 1000},
+    };
+    if (syscall(SYS_timer_settime, timer_id, 0, &its, NULL) < 0)
+        err(1, "timer_settime");
+
+    char id_str[16];
+    snprintf(id_str, sizeof(id_str), "%d", timer_id);
+    char* new_argv[] = {argv[0], "child", id_str, NULL};
+    execv(argv[0], new_argv);
+    err(1, "execve");
+}
@@ -0,0 +1,124 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_FILE "tmp/fallocate_test"
+#define SIZE      (1024 * 1024)
+
+static off_t file_size(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+        err(1, "fstat");
+    return st.st_size;
+}
+
+static void test_fallocate(int fd) {
+    if (fallocate(fd, 0, 0, SIZE) < 0)
+        err(1, "fallocate");
+    if (file_size(fd) != SIZE)
+        errx(1, "fallocate did not extend the file: %ld", (long)file_size(fd));
+
+    /* the new size must also be visible through lseek */
+    if (lseek(fd, 0, SEEK_END) != SIZE)
+        errx(1, "lseek(SEEK_END) after fallocate returned a wrong offset");
+
+    if (fallocate(fd, FALLOC_FL_KEEP_SIZE, SIZE, SIZE) < 0)
+        err(1, "fallocate(FALLOC_FL_KEEP_SIZE)");
+    if (file_size(fd) != SIZE)
+        errx(1, "fallocate(FALLOC_FL_KEEP_SIZE) changed the file size");
+
+    /* punching a hole zeroes the data (if the host file system supports it) */
+    char buf[4096];
+    memset(buf, 'a', sizeof(buf));
+    if (pwrite(fd, buf, sizeof(buf), 8192) != sizeof(buf))
+        err(1, "pwrite");
+    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 8192, sizeof(buf)) == 0) {
+        if (pread(fd, buf, sizeof(buf), 8192) != sizeof(buf))
+            err(1, "pread");
+        for (size_t i = 0; i < sizeof(buf); i++)
+            if (buf[i])
+                errx(1, "punched hole is not zeroed");
+    } else if (errno != EOPNOTSUPP) {
+        err(1, "fallocate(FALLOC_FL_PUNCH_HOLE)");
+    }
+
+    if (fallocate(fd, 0, -1, 1) != -1 || errno != EINVAL)
+        errx(1, "fallocate with a negative offset did not fail with EINVAL");
+    if (fallocate(fd, 0, 0, 0) != -1 || errno != EINVAL)
+        errx(1, "fallocate with zero length did not fail with EINVAL");
+    if (fallocate(fd, FALLOC_FL_PUNCH_HOLE, 0, 1) != -1 || errno != EOPNOTSUPP)
+        errx(1, "fallocate(FALLOC_FL_PUNCH_HOLE) without FALLOC_FL_KEEP_SIZE did not fail");
+
+    printf("fallocate OK\n");
+}
+
+static void test_hints(int fd) {
+    if (posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL))
+        errx(1, "posix_fadvise(POSIX_FADV_SEQUENTIAL) failed");
+    if (posix_fadvise(fd, 0, SIZE, POSIX_FADV_WILLNEED))
+        errx(1, "posix_fadvise(POSIX_FADV_WILLNEED) failed");
+    if (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED))
+        errx(1, "posix_fadvise(POSIX_FADV_DONTNEED) failed");
+    if (posix_fadvise(fd, 0, 0, 12345) != EINVAL)
+        errx(1, "posix_fadvise with an invalid advice did not fail with EINVAL");
+
+    if (readahead(fd, 0, SIZE) < 0)
+        err(1, "readahead");
+
+    int pipefd[2];
+    if (pipe(pipefd) < 0)
+        err(1, "pipe");
+    if (posix_fadvise(pipefd[0], 0, 0, POSIX_FADV_NORMAL) != ESPIPE)
+        errx(1, "posix_fadvise on a pipe did not fail with ESPIPE");
+    if (readahead(pipefd[0], 0, 1) != -1 || errno != EINVAL)
+        errx(1, "readahead on a pipe did not fail with EINVAL");
+    if (sync_file_range(pipefd[1], 0, 0, SYNC_FILE_RANGE_WRITE) != -1 || errno != ESPIPE)
+        errx(1, "sync_file_range on a pipe did not fail with ESPIPE");
+    close(pipefd[0]);
+    close(pipefd[1]);
+
+    printf("fadvise and readahead OK\n");
+}
+
+static void test_sync_file_range(int fd) {
+    char buf[4096];
+    memset(buf, 'b', sizeof(buf));
+    if (pwrite(fd, buf, sizeof(buf), 0) != sizeof(buf))
+        err(1, "pwrite");
+
+    if (sync_file_range(fd, 0, sizeof(buf), SYNC_FILE_RANGE_WRITE) < 0)
+        err(1, "sync_file_range(SYNC_FILE_RANGE_WRITE)");
+    if (sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                                  SYNC_FILE_RANGE_WAIT_AFTER) < 0)
+        err(1, "sync_file_range(SYNC_FILE_RANGE_WAIT_AFTER)");
+    if (sync_file_range(fd, 0, 0, 0x100) != -1 || errno != EINVAL)
+        errx(1, "sync_file_range with invalid flags did not fail with EINVAL");
+    if (sync_file_range(fd, -1, 0, SYNC_FILE_RANGE_WRITE) != -1 || errno != EINVAL)
+        errx(1, "sync_file_range with a negative offset did not fail with EINVAL");
+
+    printf("sync_file_range OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    int fd = open(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        err(1, "open");
+
+    test_fallocate(fd);
+    test_hints(fd);
+    test_sync_file_range(fd);
+
+    close(fd);
+    if (unlink(TEST_FILE) < 0)
+        err(1, "unlink");
+
+    printf("TEST OK\n");
+    return 0;
+}
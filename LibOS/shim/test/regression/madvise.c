@@ -0,0 +1,122 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+int main(void) {
+    errno = 0;
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size == -1 && errno) {
+        err(1, "sysconf");
+    }
+
+    char* ptr = mmap(NULL, 4 * page_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE,
+                     -1, 0);
+    if (ptr == MAP_FAILED) {
+        err(1, "mmap");
+    }
+    memset(ptr, 'a', 4 * page_size);
+
+    if (madvise(ptr + page_size, 2 * page_size, MADV_DONTNEED) < 0) {
+        err(1, "madvise(MADV_DONTNEED)");
+    }
+    for (long i = 0; i < 4 * page_size; i++) {
+        char expected = (i < page_size || i >= 3 * page_size) ? 'a' : 0;
+        if (ptr[i] != expected) {
+            errx(1, "wrong byte at offset %ld after MADV_DONTNEED", i);
+        }
+    }
+
+    if (madvise(ptr, 4 * page_size, MADV_WILLNEED) < 0) {
+        err(1, "madvise(MADV_WILLNEED)");
+    }
+    if (madvise(ptr, page_size, 12345) != -1 || errno != EINVAL) {
+        errx(1, "madvise with invalid advice did not fail with EINVAL");
+    }
+    if (madvise(ptr + 1, page_size, MADV_DONTNEED) != -1 || errno != EINVAL) {
+        errx(1, "madvise with unaligned address did not fail with EINVAL");
+    }
+
+    if (madvise(ptr + 2 * page_size, page_size, MADV_DONTFORK) < 0) {
+        err(1, "madvise(MADV_DONTFORK)");
+    }
+
+    /* prefaulted, non-reserved memory must behave as normal memory (also after fork) */
+    char* populated = mmap(NULL, 4 * page_size, PROT_READ | PROT_WRITE,
+                           MAP_ANONYMOUS | MAP_PRIVATE | MAP_POPULATE | MAP_NORESERVE, -1, 0);
+    if (populated == MAP_FAILED) {
+        err(1, "mmap(MAP_POPULATE | MAP_NORESERVE)");
+    }
+    if (populated[0] != 0 || populated[4 * page_size - 1] != 0) {
+        errx(1, "MAP_POPULATE memory is not zeroed");
+    }
+    if (madvise(populated, 4 * page_size, MADV_HUGEPAGE) < 0 && errno != EINVAL) {
+        err(1, "madvise(MADV_HUGEPAGE)");
+    }
+    memset(populated, 'b', 4 * page_size);
+
+    /* huge pages may be unavailable on the host, but a successful mapping must be aligned */
+    size_t huge_size = 2UL << 20;
+    char* huge = mmap(NULL, page_size, PROT_READ | PROT_WRITE,
+                      MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+    if (huge != MAP_FAILED) {
+        if ((unsigned long)huge % huge_size) {
+            errx(1, "MAP_HUGETLB mapping at %p is not aligned to 2MB", huge);
+        }
+        huge[0] = 'c';
+        if (munmap(huge, huge_size) < 0) {
+            err(1, "munmap of huge page mapping");
+        }
+    } else if (errno != ENOMEM) {
+        err(1, "mmap(MAP_HUGETLB)");
+    }
+    if (mmap(NULL, page_size, PROT_READ | PROT_WRITE,
+             MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB | (5 << MAP_HUGE_SHIFT), -1, 0)
+            != MAP_FAILED || errno != EINVAL) {
+        errx(1, "mmap with invalid huge page size did not fail with EINVAL");
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        err(1, "fork");
+    }
+    if (pid == 0) {
+        unsigned char vec;
+        if (mincore(ptr, page_size, &vec) < 0) {
+            err(1, "child: mincore of inherited memory");
+        }
+        if (mincore(ptr + 2 * page_size, page_size, &vec) != -1 || errno != ENOMEM) {
+            errx(1, "child: MADV_DONTFORK memory was inherited");
+        }
+        if (ptr[0] != 'a' || ptr[page_size] != 0 || ptr[3 * page_size] != 'a') {
+            errx(1, "child: wrong memory contents");
+        }
+        if (populated[0] != 'b' || populated[4 * page_size - 1] != 'b') {
+            errx(1, "child: wrong contents of MAP_POPULATE memory");
+        }
+        return 0;
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        err(1, "waitpid");
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        errx(1, "child failed");
+    }
+
+    if (munmap(ptr, 4 * page_size) < 0 || munmap(populated, 4 * page_size) < 0) {
+        err(1, "munmap");
+    }
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,248 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define QUEUE_NAME "/graphene_test_mqueue"
+#define MSG_SIZE   64
+
+static volatile sig_atomic_t g_notified;
+static volatile int g_notify_value;
+
+static void notify_handler(int sig, siginfo_t* info, void* ucontext) {
+    (void)sig;
+    (void)ucontext;
+    if (info->si_code == SI_MESGQ) {
+        g_notify_value = info->si_value.sival_int;
+        g_notified = 1;
+    }
+}
+
+static mqd_t open_queue(int flags) {
+    struct mq_attr attr = {.mq_maxmsg = 4, .mq_msgsize = MSG_SIZE};
+    mqd_t mqd = mq_open(QUEUE_NAME, flags | O_CREAT, 0600, &attr);
+    if (mqd == (mqd_t)-1)
+        err(1, "mq_open");
+    return mqd;
+}
+
+static void send_msg(mqd_t mqd, const char* msg, unsigned int prio) {
+    if (mq_send(mqd, msg, strlen(msg) + 1, prio) < 0)
+        err(1, "mq_send(%s)", msg);
+}
+
+static void expect_msg(mqd_t mqd, const char* expected, unsigned int expected_prio) {
+    char buf[MSG_SIZE];
+    unsigned int prio;
+    ssize_t len = mq_receive(mqd, buf, sizeof(buf), &prio);
+    if (len < 0)
+        err(1, "mq_receive");
+    if ((size_t)len != strlen(expected) + 1 || strcmp(buf, expected) || prio != expected_prio)
+        errx(1, "received \"%s\" (prio %u) instead of \"%s\" (prio %u)", buf, prio, expected,
+             expected_prio);
+}
+
+static void test_priorities(void) {
+    mqd_t mqd = open_queue(O_RDWR);
+
+    send_msg(mqd, "low", 1);
+    send_msg(mqd, "high", 10);
+    send_msg(mqd, "low2", 1);
+    send_msg(mqd, "mid", 5);
+
+    struct mq_attr attr;
+    if (mq_getattr(mqd, &attr) < 0)
+        err(1, "mq_getattr");
+    if (attr.mq_maxmsg != 4 || attr.mq_msgsize != MSG_SIZE || attr.mq_curmsgs != 4)
+        errx(1, "mq_getattr returned wrong attributes");
+
+    expect_msg(mqd, "high", 10);
+    expect_msg(mqd, "mid", 5);
+    expect_msg(mqd, "low", 1);
+    expect_msg(mqd, "low2", 1);
+
+    if (mq_close(mqd) < 0)
+        err(1, "mq_close");
+    printf("priority order OK\n");
+}
+
+static void test_nonblock_and_timeout(void) {
+    mqd_t mqd = open_queue(O_RDWR | O_NONBLOCK);
+    char buf[MSG_SIZE];
+
+    if (mq_receive(mqd, buf, sizeof(buf), NULL) != -1 || errno != EAGAIN)
+        errx(1, "mq_receive on an empty non-blocking queue did not fail with EAGAIN");
+    if (mq_receive(mqd, buf, MSG_SIZE - 1, NULL) != -1 || errno != EMSGSIZE)
+        errx(1, "mq_receive with a short buffer did not fail with EMSGSIZE");
+
+    for (int i = 0; i < 4; i++)
+        send_msg(mqd, "fill", 0);
+    if (mq_send(mqd, "full", 5, 0) != -1 || errno != EAGAIN)
+        errx(1, "mq_send to a full non-blocking queue did not fail with EAGAIN");
+    if (mq_send(mqd, "prio", 5, 32768) != -1 || errno != EINVAL)
+        errx(1, "mq_send with an invalid priority did not fail with EINVAL");
+
+    struct mq_attr attr = {.mq_flags = 0};
+    struct mq_attr old_attr;
+    if (mq_setattr(mqd, &attr, &old_attr) < 0)
+        err(1, "mq_setattr");
+    if (!(old_attr.mq_flags & O_NONBLOCK))
+        errx(1, "mq_setattr did not return the old O_NONBLOCK flag");
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 100 * 1000 * 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    if (mq_timedsend(mqd, "full", 5, 0, &ts) != -1 || errno != ETIMEDOUT)
+        errx(1, "mq_timedsend to a full queue did not fail with ETIMEDOUT");
+
+    for (int i = 0; i < 4; i++)
+        expect_msg(mqd, "fill", 0);
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (mq_timedreceive(mqd, buf, sizeof(buf), NULL, &ts) != -1 || errno != ETIMEDOUT)
+        errx(1, "mq_timedreceive on an empty queue did not fail with ETIMEDOUT");
+    ts.tv_nsec = 1000000000;
+    if (mq_timedreceive(mqd, buf, sizeof(buf), NULL, &ts) != -1 || errno != EINVAL)
+        errx(1, "mq_timedreceive with an invalid timeout did not fail with EINVAL");
+
+    if (mq_close(mqd) < 0)
+        err(1, "mq_close");
+    printf("non-blocking and timed operations OK\n");
+}
+
+static void test_fork_and_epoll(void) {
+    mqd_t mqd = open_queue(O_RDWR);
+
+    int efd = epoll_create1(0);
+    if (efd < 0)
+        err(1, "epoll_create1");
+    struct epoll_event event = {.events = EPOLLIN, .data.fd = mqd};
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, mqd, &event) < 0)
+        err(1, "epoll_ctl");
+
+    pid_t pid = fork();
+    if (pid < 0)
+        err(1, "fork");
+    if (pid == 0) {
+        /* give the parent time to block in epoll_wait */
+        usleep(100 * 1000);
+        send_msg(mqd, "from child", 3);
+        /* blocks until the parent received the first message and the queue has space */
+        for (int i = 0; i < 5; i++)
+            send_msg(mqd, "more", 0);
+        exit(0);
+    }
+
+    struct epoll_event ret_event;
+    int n = epoll_wait(efd, &ret_event, 1, 10 * 1000);
+    if (n < 0)
+        err(1, "epoll_wait");
+    if (n != 1 || ret_event.data.fd != mqd || !(ret_event.events & EPOLLIN))
+        errx(1, "epoll_wait did not report the queue as readable");
+
+    expect_msg(mqd, "from child", 3);
+    for (int i = 0; i < 5; i++)
+        expect_msg(mqd, "more", 0);
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0)
+        err(1, "waitpid");
+    if (!WIFEXITED(status) || WEXITSTATUS(status))
+        errx(1, "child failed");
+
+    close(efd);
+    if (mq_close(mqd) < 0)
+        err(1, "mq_close");
+    printf("fork and epoll OK\n");
+}
+
+static void test_notify(void) {
+    mqd_t mqd = open_queue(O_RDWR);
+
+    struct sigaction sa = {.sa_sigaction = notify_handler, .sa_flags = SA_SIGINFO};
+    if (sigaction(SIGUSR1, &sa, NULL) < 0)
+        err(1, "sigaction");
+
+    struct sigevent sev = {
+        .sigev_notify = SIGEV_SIGNAL,
+        .sigev_signo = SIGUSR1,
+        .sigev_value.sival_int = 42,
+    };
+    if (mq_notify(mqd, &sev) < 0)
+        err(1, "mq_notify");
+    if (mq_notify(mqd, &sev) != -1 || errno != EBUSY)
+        errx(1, "second mq_notify did not fail with EBUSY");
+
+    send_msg(mqd, "notify", 0);
+    for (int i = 0; i < 100 && !g_notified; i++)
+        usleep(10 * 1000);
+    if (!g_notified || g_notify_value != 42)
+        errx(1, "mq_notify notification was not delivered");
+    expect_msg(mqd, "notify", 0);
+
+    /* the registration is removed by the notification */
+    if (mq_notify(mqd, &sev) < 0)
+        err(1, "mq_notify after notification");
+    if (mq_notify(mqd, NULL) < 0)
+        err(1, "mq_notify(NULL)");
+
+    if (mq_close(mqd) < 0)
+        err(1, "mq_close");
+    printf("mq_notify OK\n");
+}
+
+static void test_unlink(void) {
+    if (mq_unlink(QUEUE_NAME) < 0)
+        err(1, "mq_unlink");
+    if (mq_unlink(QUEUE_NAME) != -1 || errno != ENOENT)
+        errx(1, "second mq_unlink did not fail with ENOENT");
+    if (mq_open(QUEUE_NAME, O_RDONLY) != (mqd_t)-1 || errno != ENOENT)
+        errx(1, "mq_open of an unlinked queue did not fail with ENOENT");
+
+    mqd_t mqd = mq_open(QUEUE_NAME, O_RDWR | O_CREAT | O_EXCL, 0600, NULL);
+    if (mqd == (mqd_t)-1)
+        err(1, "mq_open(O_EXCL)");
+    if (mq_open(QUEUE_NAME, O_RDWR | O_CREAT | O_EXCL, 0600, NULL) != (mqd_t)-1 ||
+            errno != EEXIST)
+        errx(1, "mq_open(O_EXCL) of an existing queue did not fail with EEXIST");
+
+    struct mq_attr attr;
+    if (mq_getattr(mqd, &attr) < 0)
+        err(1, "mq_getattr");
+    if (attr.mq_maxmsg != 10 || attr.mq_msgsize != 8192)
+        errx(1, "queue created without attributes has wrong limits");
+
+    if (mq_close(mqd) < 0)
+        err(1, "mq_close");
+    if (mq_unlink(QUEUE_NAME) < 0)
+        err(1, "mq_unlink");
+    printf("mq_unlink OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    mq_unlink(QUEUE_NAME);
+
+    test_priorities();
+    test_nonblock_and_timeout();
+    test_fork_and_epoll();
+    test_notify();
+    test_unlink();
+
+    printf("TEST OK\n");
+    return 0;
+}
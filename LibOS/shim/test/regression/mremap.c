@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static void check_pattern(const char* ptr, size_t len, const char* msg) {
+    for (size_t i = 0; i < len; i++) {
+        if (ptr[i] != (char)i) {
+            errx(1, "%s: wrong byte at offset %zu", msg, i);
+        }
+    }
+}
+
+int main(void) {
+    errno = 0;
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size == -1 && errno) {
+        err(1, "sysconf");
+    }
+
+    /* reserve 8 pages and give back the upper half, so that the range after `ptr` is free */
+    char* ptr = mmap(NULL, 8 * page_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE,
+                     -1, 0);
+    if (ptr == MAP_FAILED) {
+        err(1, "mmap");
+    }
+    if (munmap(ptr + 4 * page_size, 4 * page_size) < 0) {
+        err(1, "munmap");
+    }
+    for (long i = 0; i < 4 * page_size; i++) {
+        ptr[i] = (char)i;
+    }
+
+    /* grow in place */
+    char* new_ptr = mremap(ptr, 4 * page_size, 8 * page_size, 0);
+    if (new_ptr != ptr) {
+        err(1, "mremap in place");
+    }
+    check_pattern(new_ptr, 4 * page_size, "grow in place");
+    for (long i = 4 * page_size; i < 8 * page_size; i++) {
+        if (new_ptr[i] != 0) {
+            errx(1, "grown part is not zeroed");
+        }
+    }
+
+    /* shrink */
+    new_ptr = mremap(ptr, 8 * page_size, 2 * page_size, 0);
+    if (new_ptr != ptr) {
+        err(1, "mremap shrink");
+    }
+    check_pattern(new_ptr, 2 * page_size, "shrink");
+
+    /* block the range after the mapping, growing without MREMAP_MAYMOVE must fail */
+    char* blocker = mmap(ptr + 2 * page_size, page_size, PROT_READ,
+                         MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED, -1, 0);
+    if (blocker == MAP_FAILED) {
+        err(1, "mmap blocker");
+    }
+    if (mremap(ptr, 2 * page_size, 4 * page_size, 0) != MAP_FAILED || errno != ENOMEM) {
+        errx(1, "mremap without MREMAP_MAYMOVE did not fail with ENOMEM");
+    }
+
+    /* move */
+    new_ptr = mremap(ptr, 2 * page_size, 4 * page_size, MREMAP_MAYMOVE);
+    if (new_ptr == MAP_FAILED || new_ptr == ptr) {
+        err(1, "mremap move");
+    }
+    check_pattern(new_ptr, 2 * page_size, "move");
+    new_ptr[4 * page_size - 1] = 1;
+
+    /* move to a fixed address, replacing the mapping there */
+    char* target = mmap(NULL, 4 * page_size, PROT_READ, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (target == MAP_FAILED) {
+        err(1, "mmap target");
+    }
+    char* fixed = mremap(new_ptr, 4 * page_size, 4 * page_size, MREMAP_MAYMOVE | MREMAP_FIXED,
+                         target);
+    if (fixed != target) {
+        err(1, "mremap fixed");
+    }
+    check_pattern(fixed, 2 * page_size, "fixed");
+    if (fixed[4 * page_size - 1] != 1) {
+        errx(1, "fixed: lost the last byte");
+    }
+
+    if (mremap(fixed, 4 * page_size, 4 * page_size, MREMAP_FIXED, ptr) != MAP_FAILED
+            || errno != EINVAL) {
+        errx(1, "MREMAP_FIXED without MREMAP_MAYMOVE did not fail with EINVAL");
+    }
+
+    if (munmap(fixed, 4 * page_size) < 0 || munmap(blocker, page_size) < 0) {
+        err(1, "munmap");
+    }
+
+    puts("TEST OK");
+    return 0;
+}
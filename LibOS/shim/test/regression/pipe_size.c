@@ -0,0 +1,92 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BIG_PIPE_SIZE (1024 * 1024)
+
+static void test_pipe_size(void) {
+    int fds[2];
+    if (pipe(fds) < 0)
+        err(1, "pipe");
+
+    int size = fcntl(fds[0], F_GETPIPE_SZ);
+    if (size <= 0)
+        err(1, "fcntl(F_GETPIPE_SZ)");
+
+    /* the capacity is shared by both ends */
+    int new_size = fcntl(fds[1], F_SETPIPE_SZ, BIG_PIPE_SIZE);
+    if (new_size < 0)
+        err(1, "fcntl(F_SETPIPE_SZ)");
+    if (fcntl(fds[0], F_GETPIPE_SZ) != new_size)
+        errx(1, "F_GETPIPE_SZ does not return the size set by F_SETPIPE_SZ");
+
+    int fd = open("/dev/null", O_RDONLY);
+    if (fd < 0)
+        err(1, "open");
+    if (fcntl(fd, F_GETPIPE_SZ) != -1 || errno != EBADF)
+        errx(1, "F_GETPIPE_SZ on a non-pipe did not fail with EBADF");
+    close(fd);
+
+    close(fds[0]);
+    close(fds[1]);
+    printf("pipe size OK\n");
+}
+
+static void test_pipe_ends(void) {
+    int fds[2];
+    char buf[16];
+
+    if (pipe2(fds, O_NONBLOCK) < 0)
+        err(1, "pipe2");
+
+    if (read(fds[0], buf, sizeof(buf)) != -1 || errno != EAGAIN)
+        errx(1, "read on an empty non-blocking pipe did not fail with EAGAIN");
+
+    pid_t pid = fork();
+    if (pid < 0)
+        err(1, "fork");
+    if (pid == 0) {
+        close(fds[0]);
+        if (write(fds[1], "hello", 5) != 5)
+            err(1, "write");
+        _exit(0);
+    }
+
+    close(fds[1]);
+    if (waitpid(pid, NULL, 0) < 0)
+        err(1, "waitpid");
+
+    /* the data stays readable after the writer is gone, then the pipe reports the hangup */
+    struct pollfd pfd = {.fd = fds[0], .events = POLLIN};
+    if (poll(&pfd, 1, 1000) != 1 || !(pfd.revents & POLLIN))
+        errx(1, "poll did not report data of a closed pipe");
+
+    memset(buf, 0, sizeof(buf));
+    if (read(fds[0], buf, sizeof(buf)) != 5 || strcmp(buf, "hello"))
+        errx(1, "read returned wrong data");
+
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 1000) != 1 || !(pfd.revents & (POLLHUP | POLLERR)))
+        errx(1, "poll did not report the hangup of the writer");
+    if (read(fds[0], buf, sizeof(buf)) != 0)
+        errx(1, "read on a closed pipe did not return EOF");
+
+    close(fds[0]);
+    printf("pipe ends OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    test_pipe_size();
+    test_pipe_ends();
+
+    printf("TEST OK\n");
+    return 0;
+}
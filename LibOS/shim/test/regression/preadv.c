@@ -0,0 +1,140 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define TEST_FILE "tmp/preadv_test"
+
+static void check_offset(int fd, off_t expected) {
+    off_t off = lseek(fd, 0, SEEK_CUR);
+    if (off != expected)
+        errx(1, "file offset is %ld, expected %ld", (long)off, (long)expected);
+}
+
+static void test_preadv_pwritev(int fd) {
+    char a[] = "hello ";
+    char b[] = "world";
+    struct iovec wiov[] = {
+        {.iov_base = a, .iov_len = strlen(a)},
+        {.iov_base = NULL, .iov_len = 0},
+        {.iov_base = b, .iov_len = strlen(b)},
+    };
+
+    if (pwritev(fd, wiov, 3, 100) != 11)
+        err(1, "pwritev");
+    check_offset(fd, 0);
+
+    char r1[4] = {0}, r2[16] = {0};
+    struct iovec riov[] = {
+        {.iov_base = r1, .iov_len = 3},
+        {.iov_base = r2, .iov_len = sizeof(r2) - 1},
+    };
+    /* short read at the end of file */
+    if (preadv(fd, riov, 2, 100) != 11)
+        err(1, "preadv");
+    if (strcmp(r1, "hel") || strcmp(r2, "lo world"))
+        errx(1, "preadv returned wrong data: \"%s\" \"%s\"", r1, r2);
+    check_offset(fd, 0);
+
+    if (preadv(fd, riov, 2, 200) != 0)
+        errx(1, "preadv past the end of file did not return 0");
+
+    printf("preadv and pwritev OK\n");
+}
+
+static void test_preadv2_pwritev2(int fd) {
+    char data[] = "0123456789";
+    struct iovec wiov[] = {
+        {.iov_base = data, .iov_len = 4},
+        {.iov_base = data + 4, .iov_len = 6},
+    };
+
+    if (lseek(fd, 0, SEEK_SET) != 0)
+        err(1, "lseek");
+    /* offset -1 uses and advances the file offset */
+    if (pwritev2(fd, wiov, 2, -1, 0) != 10)
+        err(1, "pwritev2");
+    check_offset(fd, 10);
+    if (pwritev2(fd, wiov, 1, 20, RWF_DSYNC) != 4)
+        err(1, "pwritev2(RWF_DSYNC)");
+    check_offset(fd, 10);
+
+    char r[11] = {0};
+    struct iovec riov[] = {
+        {.iov_base = r, .iov_len = 5},
+        {.iov_base = r + 5, .iov_len = 5},
+    };
+    if (lseek(fd, 0, SEEK_SET) != 0)
+        err(1, "lseek");
+    if (preadv2(fd, riov, 2, -1, 0) != 10)
+        err(1, "preadv2");
+    if (strcmp(r, data))
+        errx(1, "preadv2 returned wrong data: \"%s\"", r);
+    check_offset(fd, 10);
+
+    memset(r, 0, sizeof(r));
+    ssize_t ret = preadv2(fd, riov, 1, 20, RWF_NOWAIT);
+    /* bytes 20..23 are "0123", followed by the hole before offset 100 */
+    if (ret == 5) {
+        if (strcmp(r, "0123"))
+            errx(1, "preadv2(RWF_NOWAIT) returned wrong data: \"%s\"", r);
+    } else if (ret != -1 || (errno != EAGAIN && errno != EOPNOTSUPP)) {
+        err(1, "preadv2(RWF_NOWAIT)");
+    }
+    check_offset(fd, 10);
+
+    printf("preadv2 and pwritev2 OK\n");
+}
+
+static struct iovec g_many_iovs[1025];
+
+static void test_errors(int fd) {
+    char buf[8];
+    struct iovec iov = {.iov_base = buf, .iov_len = sizeof(buf)};
+
+    if (preadv(fd, &iov, 1, -1) != -1 || errno != EINVAL)
+        errx(1, "preadv with a negative offset did not fail with EINVAL");
+    if (preadv2(fd, &iov, 1, -2, 0) != -1 || errno != EINVAL)
+        errx(1, "preadv2 with offset -2 did not fail with EINVAL");
+    if (preadv(fd, g_many_iovs, 1025, 0) != -1 || errno != EINVAL)
+        errx(1, "preadv with too many iovecs did not fail with EINVAL");
+    if (preadv2(fd, &iov, 1, 0, 0x1000) != -1 || errno != EOPNOTSUPP)
+        errx(1, "preadv2 with invalid flags did not fail with EOPNOTSUPP");
+
+    int pipefd[2];
+    if (pipe(pipefd) < 0)
+        err(1, "pipe");
+    if (pwritev(pipefd[1], &iov, 1, 0) != -1 || errno != ESPIPE)
+        errx(1, "pwritev on a pipe did not fail with ESPIPE");
+    if (pwritev2(pipefd[1], &iov, 1, -1, 0) != sizeof(buf))
+        err(1, "pwritev2 on a pipe");
+    if (preadv2(pipefd[0], &iov, 1, -1, 0) != sizeof(buf))
+        err(1, "preadv2 on a pipe");
+    close(pipefd[0]);
+    close(pipefd[1]);
+
+    printf("error cases OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    int fd = open(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        err(1, "open");
+
+    test_preadv_pwritev(fd);
+    test_preadv2_pwritev2(fd);
+    test_errors(fd);
+
+    close(fd);
+    if (unlink(TEST_FILE) < 0)
+        err(1, "unlink");
+
+    printf("TEST OK\n");
+    return 0;
+}
@@ -0,0 +1,51 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PROFILE_FILE "/proc/syscall_profile"
+#define NCALLS       100
+
+int main(void) {
+    for (int i = 0; i < NCALLS; i++)
+        syscall(SYS_getpid);
+
+    FILE* fp = fopen(PROFILE_FILE, "r");
+    if (!fp) {
+        perror("fopen");
+        return 1;
+    }
+
+    char line[1024];
+    int found = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        int nr;
+        unsigned long calls, fast_calls, libos_cycles, pal_cycles;
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%d %lu %lu %lu %lu", &nr, &calls, &fast_calls, &libos_cycles,
+                   &pal_cycles) != 5) {
+            fprintf(stderr, "malformed line: %s", line);
+            return 1;
+        }
+        if (nr != SYS_getpid)
+            continue;
+
+        found = 1;
+        if (calls < NCALLS || fast_calls > calls || !strchr(line, ':')) {
+            fprintf(stderr, "unexpected getpid statistics: %s", line);
+            return 1;
+        }
+    }
+    fclose(fp);
+
+    if (!found) {
+        fprintf(stderr, "no getpid statistics in " PROFILE_FILE "\n");
+        return 1;
+    }
+
+    printf("syscall profile test passed\n");
+    return 0;
+}
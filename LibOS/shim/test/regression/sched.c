@@ -6,7 +6,8 @@
 #include <sys/time.h>
 
 /* This test checks that our dummy implementations work correctly. None of the
- * below syscalls are actually propagated to the host OS or change anything.
+ * below syscalls except sched_setaffinity() are actually propagated to the host
+ * OS or change anything.
  * NOTE: This test works correctly only on Graphene (not on Linux). */
 
 int main(int argc, char** argv) {
@@ -27,8 +28,15 @@ int main(int argc, char** argv) {
         return 1;
     }
 
+    /* like Linux, reject a mask without any CPU */
     cpu_set_t my_set;
     CPU_ZERO(&my_set);
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &my_set) != -1 || errno != EINVAL) {
+        fprintf(stderr, "Setting an empty affinity mask did not fail with EINVAL\n");
+        return 1;
+    }
+
+    CPU_SET(0, &my_set);
     if (sched_setaffinity(0, sizeof(cpu_set_t), &my_set) == -1) {
         perror("Error setting affinity");
         return 1;
@@ -50,10 +58,16 @@ int main(int argc, char** argv) {
         return 2;
     }
 
-    if (sched_getaffinity(0, sizeof(cpu_set_t), &my_set) == -1) {
+    cpu_set_t got_set;
+    CPU_ZERO(&got_set);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &got_set) == -1) {
         perror("Error getting affinity");
         return 2;
     }
+    if (!CPU_EQUAL(&got_set, &my_set)) {
+        fprintf(stderr, "Affinity mask did not round-trip\n");
+        return 2;
+    }
 
     if (sched_get_priority_max(SCHED_FIFO) != 99) {
         perror("Error getting max priority of SCHED_FIFO");
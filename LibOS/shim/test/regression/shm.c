@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/mman.h>
+#include <sys/shm.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SHM_SIZE 8192
+
+/* a segment removed while attached stays usable, also in children forked afterwards */
+static void test_rmid_fork(void) {
+    int shmid = shmget(IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0600);
+    if (shmid < 0) {
+        err(1, "shmget");
+    }
+    char* ptr = shmat(shmid, NULL, 0);
+    if (ptr == (void*)-1) {
+        err(1, "shmat");
+    }
+    if (shmctl(shmid, IPC_RMID, NULL) < 0) {
+        err(1, "shmctl(IPC_RMID)");
+    }
+    memset(ptr, 'c', SHM_SIZE);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        err(1, "fork");
+    }
+    if (pid == 0) {
+        if (ptr[0] != 'c' || ptr[SHM_SIZE - 1] != 'c') {
+            errx(1, "child: removed segment has wrong contents");
+        }
+        ptr[0] = 'd';
+        if (shmdt(ptr) < 0) {
+            err(1, "child: shmdt of removed segment");
+        }
+        exit(0);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        err(1, "waitpid");
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+        errx(1, "child of removed segment failed");
+    }
+    if (ptr[0] != 'd') {
+        errx(1, "parent: removed segment is not shared with the child");
+    }
+    if (shmdt(ptr) < 0) {
+        err(1, "shmdt of removed segment");
+    }
+}
+
+/* shmdt() must not unmap memory which replaced an attachment */
+static void test_shmdt_after_remap(void) {
+    int shmid = shmget(IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0600);
+    if (shmid < 0) {
+        err(1, "shmget");
+    }
+    char* ptr = shmat(shmid, NULL, 0);
+    if (ptr == (void*)-1) {
+        err(1, "shmat");
+    }
+    if (shmctl(shmid, IPC_RMID, NULL) < 0) {
+        err(1, "shmctl(IPC_RMID)");
+    }
+    if (munmap(ptr, SHM_SIZE) < 0) {
+        err(1, "munmap");
+    }
+    if (mmap(ptr, SHM_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1,
+             0) != ptr) {
+        err(1, "mmap");
+    }
+    if (shmdt(ptr) != -1 || errno != EINVAL) {
+        errx(1, "shmdt of an address remapped by mmap did not fail with EINVAL");
+    }
+    ptr[SHM_SIZE - 1] = 'e';
+    if (munmap(ptr, SHM_SIZE) < 0) {
+        err(1, "munmap");
+    }
+}
+
+int main(void) {
+    int shmid = shmget(IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0600);
+    if (shmid < 0) {
+        err(1, "shmget");
+    }
+
+    char* ptr = shmat(shmid, NULL, 0);
+    if (ptr == (void*)-1) {
+        err(1, "shmat");
+    }
+    memset(ptr, 'a', SHM_SIZE);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        err(1, "fork");
+    }
+
+    if (pid == 0) {
+        /* the attachment is inherited and shares memory with the parent */
+        for (size_t i = 0; i < SHM_SIZE; i++) {
+            if (ptr[i] != 'a') {
+                errx(1, "child: wrong byte at offset %zu", i);
+            }
+        }
+        memset(ptr, 'b', SHM_SIZE / 2);
+
+        /* a second attachment maps the same memory */
+        char* ptr2 = shmat(shmid, NULL, SHM_RDONLY);
+        if (ptr2 == (void*)-1) {
+            err(1, "child: shmat");
+        }
+        if (ptr2[0] != 'b' || ptr2[SHM_SIZE - 1] != 'a') {
+            errx(1, "child: second attachment does not share memory");
+        }
+        if (shmdt(ptr2) < 0 || shmdt(ptr) < 0) {
+            err(1, "child: shmdt");
+        }
+        return 0;
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        err(1, "waitpid");
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status)) {
+        errx(1, "child failed");
+    }
+
+    for (size_t i = 0; i < SHM_SIZE; i++) {
+        char expected = i < SHM_SIZE / 2 ? 'b' : 'a';
+        if (ptr[i] != expected) {
+            errx(1, "parent: wrong byte at offset %zu", i);
+        }
+    }
+
+    struct shmid_ds ds;
+    if (shmctl(shmid, IPC_STAT, &ds) < 0) {
+        err(1, "shmctl(IPC_STAT)");
+    }
+    if (ds.shm_segsz != SHM_SIZE || ds.shm_nattch != 1) {
+        errx(1, "shmctl(IPC_STAT): wrong size %zu or nattch %lu", ds.shm_segsz,
+             (unsigned long)ds.shm_nattch);
+    }
+
+    if (shmdt(ptr) < 0) {
+        err(1, "shmdt");
+    }
+    if (shmdt(ptr) != -1 || errno != EINVAL) {
+        errx(1, "shmdt of a detached address did not fail with EINVAL");
+    }
+    if (shmctl(shmid, IPC_RMID, NULL) < 0) {
+        err(1, "shmctl(IPC_RMID)");
+    }
+    if (shmat(shmid, NULL, 0) != (void*)-1 || errno != EINVAL) {
+        errx(1, "shmat of a removed segment did not fail with EINVAL");
+    }
+
+    test_rmid_fork();
+    test_shmdt_after_remap();
+
+    puts("TEST OK");
+    return 0;
+}
@@ -0,0 +1,202 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t handler_cnt;
+
+static void handler(int sig) {
+    (void)sig;
+    handler_cnt++;
+}
+
+static void read_one(int fd, int signo, struct signalfd_siginfo* ssi) {
+    ssize_t ret = read(fd, ssi, sizeof(*ssi));
+    if (ret != sizeof(*ssi))
+        err(1, "read from signalfd returned %ld", ret);
+    if ((int)ssi->ssi_signo != signo)
+        errx(1, "signalfd returned signal %u instead of %d", ssi->ssi_signo, signo);
+}
+
+static void expect_empty(int fd) {
+    struct signalfd_siginfo ssi;
+    if (read(fd, &ssi, sizeof(ssi)) != -1 || errno != EAGAIN)
+        errx(1, "read from a signalfd without pending signals did not fail with EAGAIN");
+}
+
+static void test_read(void) {
+    struct sigaction act = {.sa_handler = handler};
+    if (sigaction(SIGUSR1, &act, NULL) < 0)
+        err(1, "sigaction");
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0)
+        err(1, "signalfd");
+
+    struct signalfd_siginfo ssi;
+    if (read(fd, &ssi, sizeof(ssi) - 1) != -1 || errno != EINVAL)
+        errx(1, "short read from signalfd did not fail with EINVAL");
+    expect_empty(fd);
+
+    if (kill(getpid(), SIGUSR1) < 0)
+        err(1, "kill");
+    read_one(fd, SIGUSR1, &ssi);
+    if ((pid_t)ssi.ssi_pid != getpid())
+        errx(1, "signalfd reported sender %u instead of %d", ssi.ssi_pid, getpid());
+    expect_empty(fd);
+
+    /* the signal was consumed by the read, so unblocking it must not run the handler */
+    if (sigprocmask(SIG_UNBLOCK, &mask, NULL) < 0)
+        err(1, "sigprocmask");
+    if (handler_cnt)
+        errx(1, "handler ran for a signal read from signalfd");
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0)
+        err(1, "sigprocmask");
+
+    /* a signal pending before the signalfd is created can be read from it */
+    if (kill(getpid(), SIGUSR1) < 0)
+        err(1, "kill");
+    int fd2 = signalfd(-1, &mask, SFD_NONBLOCK);
+    if (fd2 < 0)
+        err(1, "signalfd");
+    read_one(fd2, SIGUSR1, &ssi);
+    expect_empty(fd);
+
+    close(fd2);
+    close(fd);
+    printf("signalfd read OK\n");
+}
+
+static void test_mask_update(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR2);
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK);
+    if (fd < 0)
+        err(1, "signalfd");
+
+    /* real-time signals are queued, each instance is read separately */
+    for (int i = 0; i < 3; i++) {
+        if (kill(getpid(), SIGRTMIN) < 0)
+            err(1, "kill");
+    }
+    expect_empty(fd);
+
+    sigaddset(&mask, SIGRTMIN);
+    if (signalfd(fd, &mask, 0) != fd)
+        err(1, "signalfd update");
+
+    struct signalfd_siginfo ssi[4];
+    ssize_t ret = read(fd, ssi, sizeof(ssi));
+    if (ret != 3 * sizeof(ssi[0]))
+        errx(1, "read of queued signals returned %ld", ret);
+    for (int i = 0; i < 3; i++) {
+        if ((int)ssi[i].ssi_signo != SIGRTMIN)
+            errx(1, "queued signal %d was read as %u", i, ssi[i].ssi_signo);
+    }
+    expect_empty(fd);
+
+    close(fd);
+    printf("signalfd mask update and queued signals OK\n");
+}
+
+static void test_epoll_poll(void) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGCHLD);
+
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK);
+    if (fd < 0)
+        err(1, "signalfd");
+
+    int epfd = epoll_create1(0);
+    if (epfd < 0)
+        err(1, "epoll_create1");
+    struct epoll_event ev = {.events = EPOLLIN, .data.fd = fd};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        err(1, "epoll_ctl");
+
+    if (epoll_wait(epfd, &ev, 1, 0) != 0)
+        errx(1, "signalfd without pending signals is readable");
+
+    pid_t parent = getpid();
+    pid_t pid = fork();
+    if (pid < 0)
+        err(1, "fork");
+    if (pid == 0) {
+        if (kill(parent, SIGUSR1) < 0)
+            err(1, "kill");
+        _exit(0);
+    }
+
+    /* wait for both the signal from the child and SIGCHLD */
+    int seen_usr1 = 0;
+    int seen_chld = 0;
+    while (!seen_usr1 || !seen_chld) {
+        int n = epoll_wait(epfd, &ev, 1, 10000);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n != 1 || ev.data.fd != fd || !(ev.events & EPOLLIN))
+            errx(1, "epoll_wait on signalfd returned %d", n);
+
+        struct signalfd_siginfo ssi;
+        ssize_t ret;
+        while ((ret = read(fd, &ssi, sizeof(ssi))) == sizeof(ssi)) {
+            if (ssi.ssi_signo == SIGUSR1 && (pid_t)ssi.ssi_pid == pid)
+                seen_usr1 = 1;
+            else if (ssi.ssi_signo == SIGCHLD && (pid_t)ssi.ssi_pid == pid)
+                seen_chld = 1;
+        }
+        if (ret != -1 || errno != EAGAIN)
+            err(1, "read from signalfd");
+    }
+
+    if (waitpid(pid, NULL, 0) != pid)
+        err(1, "waitpid");
+
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    if (poll(&pfd, 1, 0) != 0)
+        errx(1, "drained signalfd is readable");
+    if (kill(getpid(), SIGUSR1) < 0)
+        err(1, "kill");
+    if (poll(&pfd, 1, 10000) != 1 || !(pfd.revents & POLLIN))
+        errx(1, "poll did not report a pending signal on signalfd");
+    struct signalfd_siginfo ssi;
+    read_one(fd, SIGUSR1, &ssi);
+
+    close(epfd);
+    close(fd);
+    printf("signalfd with epoll and poll OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGRTMIN);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0)
+        err(1, "sigprocmask");
+
+    test_read();
+    test_mask_update();
+    test_epoll_poll();
+
+    printf("TEST OK\n");
+    return 0;
+}
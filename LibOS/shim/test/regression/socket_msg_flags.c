@@ -0,0 +1,149 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <err.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+static int bound_socket(int type, struct sockaddr_in* addr) {
+    int fd = socket(AF_INET, type, 0);
+    if (fd < 0)
+        err(1, "socket");
+
+    socklen_t addrlen = sizeof(*addr);
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family      = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr*)addr, addrlen) < 0)
+        err(1, "bind");
+    if (getsockname(fd, (struct sockaddr*)addr, &addrlen) < 0)
+        err(1, "getsockname");
+    return fd;
+}
+
+static void test_udp(void) {
+    struct sockaddr_in srv_addr;
+    char buf[16];
+
+    int srv = bound_socket(SOCK_DGRAM, &srv_addr);
+    int cli = socket(AF_INET, SOCK_DGRAM, 0);
+    if (cli < 0)
+        err(1, "socket");
+
+    if (recv(srv, buf, sizeof(buf), MSG_DONTWAIT) != -1 || errno != EAGAIN)
+        errx(1, "recv(MSG_DONTWAIT) on an empty socket did not fail with EAGAIN");
+
+    /* MSG_MORE: both sends end up in a single datagram */
+    if (sendto(cli, "abc", 3, MSG_MORE, (struct sockaddr*)&srv_addr, sizeof(srv_addr)) != 3)
+        err(1, "sendto(MSG_MORE)");
+    if (sendto(cli, "defgh", 6, 0, (struct sockaddr*)&srv_addr, sizeof(srv_addr)) != 6)
+        err(1, "sendto");
+
+    /* MSG_PEEK into a short buffer, then MSG_TRUNC reports the full datagram length */
+    if (recv(srv, buf, 4, MSG_PEEK) != 4 || memcmp(buf, "abcd", 4))
+        errx(1, "recv(MSG_PEEK) returned wrong data");
+    memset(buf, 0, sizeof(buf));
+    if (recv(srv, buf, 4, MSG_PEEK | MSG_TRUNC) != 9 || memcmp(buf, "abcd", 4))
+        errx(1, "recv(MSG_PEEK | MSG_TRUNC) did not return the datagram length");
+    if (recv(srv, buf, sizeof(buf), 0) != 9 || strcmp(buf, "abcdefgh"))
+        errx(1, "recv after MSG_PEEK returned wrong data");
+
+    /* a message scattered over several buffers is still one datagram */
+    struct iovec iov[2] = {{.iov_base = "xy", .iov_len = 2}, {.iov_base = "zw", .iov_len = 2}};
+    struct msghdr msg = {
+        .msg_name    = &srv_addr,
+        .msg_namelen = sizeof(srv_addr),
+        .msg_iov     = iov,
+        .msg_iovlen  = 2,
+    };
+    if (sendmsg(cli, &msg, 0) != 4)
+        err(1, "sendmsg");
+    memset(buf, 0, sizeof(buf));
+    if (recv(srv, buf, 2, MSG_TRUNC) != 4 || memcmp(buf, "xy", 2))
+        errx(1, "recv(MSG_TRUNC) did not return the datagram length");
+    if (recv(srv, buf, sizeof(buf), MSG_DONTWAIT) != -1 || errno != EAGAIN)
+        errx(1, "the rest of a truncated datagram was not discarded");
+
+    /* a scattered datagram which is too large fails as a whole and leaves nothing behind */
+    static char big[70000];
+    iov[1].iov_base = big;
+    iov[1].iov_len  = sizeof(big);
+    if (sendmsg(cli, &msg, 0) != -1)
+        errx(1, "sendmsg of an oversized datagram did not fail");
+    if (sendto(cli, "ok", 2, 0, (struct sockaddr*)&srv_addr, sizeof(srv_addr)) != 2)
+        err(1, "sendto");
+    memset(buf, 0, sizeof(buf));
+    if (recv(srv, buf, sizeof(buf), 0) != 2 || strcmp(buf, "ok"))
+        errx(1, "data of a failed sendmsg was prepended to the next datagram");
+
+    close(cli);
+    close(srv);
+    printf("UDP flags OK\n");
+}
+
+static void test_tcp(void) {
+    struct sockaddr_in srv_addr;
+    char buf[16];
+
+    int lfd = bound_socket(SOCK_STREAM, &srv_addr);
+    if (listen(lfd, 1) < 0)
+        err(1, "listen");
+
+    int cli = socket(AF_INET, SOCK_STREAM, 0);
+    if (cli < 0)
+        err(1, "socket");
+    if (connect(cli, (struct sockaddr*)&srv_addr, sizeof(srv_addr)) < 0)
+        err(1, "connect");
+    int srv = accept(lfd, NULL, NULL);
+    if (srv < 0)
+        err(1, "accept");
+
+    if (recv(srv, buf, sizeof(buf), MSG_DONTWAIT) != -1 || errno != EAGAIN)
+        errx(1, "recv(MSG_DONTWAIT) on an empty connection did not fail with EAGAIN");
+
+    if (send(cli, "hello ", 6, MSG_MORE) != 6)
+        err(1, "send(MSG_MORE)");
+    if (send(cli, "world", 5, 0) != 5)
+        err(1, "send");
+
+    /* MSG_WAITALL waits until the whole buffer is filled */
+    memset(buf, 0, sizeof(buf));
+    if (recv(srv, buf, 11, MSG_WAITALL) != 11 || strcmp(buf, "hello world"))
+        errx(1, "recv(MSG_WAITALL) returned wrong data");
+
+    if (send(cli, "peek", 4, 0) != 4)
+        err(1, "send(peek)");
+    memset(buf, 0, sizeof(buf));
+    if (recv(srv, buf, 4, MSG_PEEK | MSG_WAITALL) != 4 || strcmp(buf, "peek"))
+        errx(1, "recv(MSG_PEEK) returned wrong data");
+    memset(buf, 0, sizeof(buf));
+    if (recv(srv, buf, sizeof(buf), 0) != 4 || strcmp(buf, "peek"))
+        errx(1, "recv after MSG_PEEK returned wrong data");
+
+    /* the peer is gone: MSG_NOSIGNAL turns SIGPIPE into a plain EPIPE */
+    close(srv);
+    close(lfd);
+    ssize_t ret;
+    do {
+        ret = send(cli, "x", 1, MSG_NOSIGNAL);
+    } while (ret == 1);
+    if (ret != -1 || (errno != EPIPE && errno != ECONNRESET))
+        err(1, "send(MSG_NOSIGNAL) to a closed connection");
+
+    close(cli);
+    printf("TCP flags OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    test_udp();
+    test_tcp();
+
+    printf("TEST OK\n");
+    return 0;
+}
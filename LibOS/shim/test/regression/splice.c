@@ -0,0 +1,228 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define TEST_FILE "tmp/splice_test"
+#define DATA_SIZE (256 * 1024)
+
+static char data[DATA_SIZE];
+static char buf[DATA_SIZE];
+
+static void read_exactly(int fd, char* ptr, size_t size) {
+    while (size > 0) {
+        ssize_t ret = read(fd, ptr, size);
+        if (ret <= 0)
+            err(1, "read");
+        ptr += ret;
+        size -= ret;
+    }
+}
+
+/* splices exactly `size` bytes, the kernel may move less per call */
+static void splice_exactly(int fd_in, loff_t* off_in, int fd_out, size_t size) {
+    while (size > 0) {
+        ssize_t ret = splice(fd_in, off_in, fd_out, NULL, size, SPLICE_F_MOVE);
+        if (ret <= 0)
+            err(1, "splice");
+        size -= ret;
+    }
+}
+
+static void test_file_to_socket(void) {
+    int fd = open(TEST_FILE, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0)
+        err(1, "open");
+    if (write(fd, data, DATA_SIZE) != DATA_SIZE)
+        err(1, "write");
+
+    int pipefd[2];
+    int sv[2];
+    if (pipe(pipefd) < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+        err(1, "pipe/socketpair");
+
+    /* file -> pipe -> socket, at an explicit offset which must not move the file position */
+    loff_t off = 4096;
+    size_t size = 16384;
+    splice_exactly(fd, &off, pipefd[1], size);
+    if (off != 4096 + (loff_t)size)
+        errx(1, "splice did not advance the offset: %ld", (long)off);
+    if (lseek(fd, 0, SEEK_CUR) != DATA_SIZE)
+        errx(1, "splice with an offset moved the file position");
+
+    splice_exactly(pipefd[0], NULL, sv[0], size);
+    read_exactly(sv[1], buf, size);
+    if (memcmp(buf, data + 4096, size))
+        errx(1, "wrong data after file -> pipe -> socket");
+
+    /* socket -> pipe -> file at the current file position */
+    if (lseek(fd, 0, SEEK_SET) < 0)
+        err(1, "lseek");
+    if (write(sv[1], data + DATA_SIZE - size, size) != (ssize_t)size)
+        err(1, "write");
+    splice_exactly(sv[0], NULL, pipefd[1], size);
+    size_t left = size;
+    while (left > 0) {
+        ssize_t ret = splice(pipefd[0], NULL, fd, NULL, left, 0);
+        if (ret <= 0)
+            err(1, "splice to file");
+        left -= ret;
+    }
+    if (lseek(fd, 0, SEEK_CUR) != (off_t)size)
+        errx(1, "splice did not advance the file position");
+    if (pread(fd, buf, size, 0) != (ssize_t)size || memcmp(buf, data + DATA_SIZE - size, size))
+        errx(1, "wrong data after socket -> pipe -> file");
+
+    close(sv[0]);
+    close(sv[1]);
+    close(pipefd[0]);
+    close(pipefd[1]);
+    close(fd);
+    unlink(TEST_FILE);
+    printf("splice between file, pipe and socket OK\n");
+}
+
+static void test_errors(void) {
+    int pipefd[2];
+    int sv[2];
+    if (pipe(pipefd) < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+        err(1, "pipe/socketpair");
+
+    if (splice(sv[0], NULL, sv[1], NULL, 1, 0) != -1 || errno != EINVAL)
+        errx(1, "splice without a pipe did not fail with EINVAL");
+
+    loff_t off = 0;
+    if (splice(pipefd[0], &off, sv[0], NULL, 1, 0) != -1 || errno != ESPIPE)
+        errx(1, "splice with a pipe offset did not fail with ESPIPE");
+
+    if (splice(pipefd[0], NULL, sv[0], NULL, 1, SPLICE_F_NONBLOCK) != -1 || errno != EAGAIN)
+        errx(1, "non-blocking splice from an empty pipe did not fail with EAGAIN");
+
+    if (splice(pipefd[1], NULL, sv[0], NULL, 1, 0) != -1 || errno != EBADF)
+        errx(1, "splice from the write end of a pipe did not fail with EBADF");
+
+    close(sv[0]);
+    close(sv[1]);
+    close(pipefd[0]);
+    close(pipefd[1]);
+    printf("splice errors OK\n");
+}
+
+/* non-blocking splice into a full socket must not consume data it cannot write */
+static void test_nonblock_full_socket(void) {
+    int pipefd[2];
+    int sv[2];
+    if (pipe(pipefd) < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+        err(1, "pipe/socketpair");
+    if (fcntl(sv[0], F_SETFL, O_NONBLOCK) < 0)
+        err(1, "fcntl");
+
+    char chunk[4096] = {0};
+    size_t filled = 0;
+    while (true) {
+        ssize_t ret = write(sv[0], chunk, sizeof(chunk));
+        if (ret < 0 && errno == EAGAIN)
+            break;
+        if (ret <= 0)
+            err(1, "write to socket");
+        filled += ret;
+    }
+
+    size_t size = 32768;
+    if (write(pipefd[1], data, size) != (ssize_t)size)
+        err(1, "write to pipe");
+
+    size_t spliced  = 0;
+    size_t received = 0;
+    while (received < filled + size) {
+        if (spliced < size) {
+            ssize_t ret = splice(pipefd[0], NULL, sv[0], NULL, size - spliced, SPLICE_F_NONBLOCK);
+            if (ret > 0)
+                spliced += ret;
+            else if (ret == 0 || errno != EAGAIN)
+                err(1, "non-blocking splice to a socket");
+        }
+        if (received == filled + spliced)
+            continue;
+
+        size_t count = filled + spliced - received;
+        ssize_t ret = read(sv[1], chunk, count < sizeof(chunk) ? count : sizeof(chunk));
+        if (ret <= 0)
+            err(1, "read from socket");
+        for (ssize_t i = 0; i < ret; i++) {
+            size_t pos = received + i;
+            if (pos >= filled && chunk[i] != data[pos - filled])
+                errx(1, "wrong data after non-blocking splice at %zu", pos - filled);
+        }
+        received += ret;
+    }
+
+    close(sv[0]);
+    close(sv[1]);
+    close(pipefd[0]);
+    close(pipefd[1]);
+    printf("non-blocking splice into a full socket OK\n");
+}
+
+static void test_tee_vmsplice(void) {
+    int p1[2];
+    int p2[2];
+    if (pipe(p1) < 0 || pipe(p2) < 0)
+        err(1, "pipe");
+
+    struct iovec iov[2] = {
+        {.iov_base = data, .iov_len = 100},
+        {.iov_base = data + 100, .iov_len = 200},
+    };
+    if (vmsplice(p1[1], iov, 2, 0) != 300)
+        err(1, "vmsplice to a pipe");
+
+    /* tee duplicates the data without consuming it */
+    ssize_t ret = tee(p1[0], p2[1], 300, 0);
+    if (ret <= 0)
+        err(1, "tee");
+    read_exactly(p2[0], buf, ret);
+    if (memcmp(buf, data, ret))
+        errx(1, "wrong data after tee");
+
+    char out[300];
+    struct iovec out_iov = {.iov_base = out, .iov_len = sizeof(out)};
+    size_t got = 0;
+    while (got < sizeof(out)) {
+        out_iov.iov_base = out + got;
+        out_iov.iov_len  = sizeof(out) - got;
+        ret = vmsplice(p1[0], &out_iov, 1, 0);
+        if (ret <= 0)
+            err(1, "vmsplice from a pipe");
+        got += ret;
+    }
+    if (memcmp(out, data, sizeof(out)))
+        errx(1, "wrong data after vmsplice");
+
+    close(p1[0]);
+    close(p1[1]);
+    close(p2[0]);
+    close(p2[1]);
+    printf("tee and vmsplice OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    for (size_t i = 0; i < DATA_SIZE; i++)
+        data[i] = (char)(i * 7 + i / 256);
+
+    test_file_to_socket();
+    test_errors();
+    test_nonblock_full_socket();
+    test_tee_vmsplice();
+
+    printf("TEST OK\n");
+    return 0;
+}
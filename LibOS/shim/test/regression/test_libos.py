@@ -161,6 +161,10 @@ class TC_01_Bootstrap(RegressionTestCase):
         self.assertIn('child exited with status: 0', stdout)
         self.assertIn('test completed successfully', stdout)
 
+    def test_206_exec_timer(self):
+        stdout, _ = self.run_binary(['exec_timer'])
+        self.assertIn('TEST OK', stdout)
+
     def test_210_exec_invalid_args(self):
         stdout, _ = self.run_binary(['exec_invalid_args'])
 
@@ -429,6 +433,26 @@ class TC_30_Syscall(RegressionTestCase):
 
         self.assertIn('TEST OK', stdout)
 
+    def test_055_mremap(self):
+        stdout, _ = self.run_binary(['mremap'])
+
+        self.assertIn('TEST OK', stdout)
+
+    def test_056_madvise(self):
+        stdout, _ = self.run_binary(['madvise'])
+
+        self.assertIn('TEST OK', stdout)
+
+    def test_057_shm(self):
+        stdout, _ = self.run_binary(['shm'])
+
+        self.assertIn('TEST OK', stdout)
+
+    def test_058_aio(self):
+        stdout, _ = self.run_binary(['aio'])
+
+        self.assertIn('TEST OK', stdout)
+
     @unittest.skip('sigaltstack isn\'t correctly implemented')
     def test_060_sigaltstack(self):
         stdout, _ = self.run_binary(['sigaltstack'])
@@ -456,6 +480,53 @@ class TC_30_Syscall(RegressionTestCase):
         self.assertIn('eventfd_using_various_flags completed successfully', stdout)
         self.assertIn('eventfd_using_fork completed successfully', stdout)
 
+    def test_071_timerfd(self):
+        stdout, _ = self.run_binary(['timerfd'])
+        self.assertIn('timerfd OK', stdout)
+        self.assertIn('timerfd with epoll OK', stdout)
+        self.assertIn('POSIX timer OK', stdout)
+        self.assertIn('itimer and alarm OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_072_splice(self):
+        stdout, _ = self.run_binary(['splice'])
+        self.assertIn('splice between file, pipe and socket OK', stdout)
+        self.assertIn('splice errors OK', stdout)
+        self.assertIn('non-blocking splice into a full socket OK', stdout)
+        self.assertIn('tee and vmsplice OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_073_fallocate(self):
+        stdout, _ = self.run_binary(['fallocate'])
+        self.assertIn('fallocate OK', stdout)
+        self.assertIn('fadvise and readahead OK', stdout)
+        self.assertIn('sync_file_range OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_074_preadv(self):
+        stdout, _ = self.run_binary(['preadv'])
+        self.assertIn('preadv and pwritev OK', stdout)
+        self.assertIn('preadv2 and pwritev2 OK', stdout)
+        self.assertIn('error cases OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    @unittest.skipIf(HAS_SGX,
+        'POSIX message queues need host objects mapped shared and writable, which SGX denies.')
+    def test_075_mqueue(self):
+        stdout, _ = self.run_binary(['mqueue'])
+        self.assertIn('priority order OK', stdout)
+        self.assertIn('non-blocking and timed operations OK', stdout)
+        self.assertIn('fork and epoll OK', stdout)
+        self.assertIn('mq_notify OK', stdout)
+        self.assertIn('mq_unlink OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_076_pipe_size(self):
+        stdout, _ = self.run_binary(['pipe_size'])
+        self.assertIn('pipe size OK', stdout)
+        self.assertIn('pipe ends OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
     def test_080_sched(self):
         stdout, _ = self.run_binary(['sched'])
 
@@ -488,6 +559,13 @@ class TC_30_Syscall(RegressionTestCase):
         stdout, _ = self.run_binary(['signal_multithread'])
         self.assertIn('TEST OK', stdout)
 
+    def test_094_signalfd(self):
+        stdout, _ = self.run_binary(['signalfd'])
+        self.assertIn('signalfd read OK', stdout)
+        self.assertIn('signalfd mask update and queued signals OK', stdout)
+        self.assertIn('signalfd with epoll and poll OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
 @unittest.skipUnless(HAS_SGX,
     'This test is only meaningful on SGX PAL because only SGX catches raw '
     'syscalls and redirects to Graphene\'s LibOS. If we will add seccomp to '
@@ -550,6 +628,13 @@ class TC_40_FileSystem(RegressionTestCase):
         # proc/cpuinfo Linux-based formatting
         self.assertIn('cpuinfo test passed', stdout)
 
+    def test_025_syscall_profile(self):
+        stdout, _ = self.run_binary(['proc_syscall_profile'], timeout=50)
+        self.assertIn('syscall profile test passed', stdout)
+
+        # the profile is also printed at exit
+        self.assertIn('syscall profile of process', stdout)
+
     def test_030_fdleak(self):
         stdout, _ = self.run_binary(['fdleak'], timeout=10)
         self.assertIn("Test succeeded.", stdout)
@@ -635,6 +720,18 @@ class TC_80_Socket(RegressionTestCase):
         self.assertIn('Data: This is packet 8', stdout)
         self.assertIn('Data: This is packet 9', stdout)
 
+    def test_210_socket_udp_sockaddr(self):
+        stdout, _ = self.run_binary(['udp_sockaddr'], timeout=50)
+        self.assertIn('IPv4 OK', stdout)
+        self.assertIn('IPv6 OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
+    def test_220_socket_msg_flags(self):
+        stdout, _ = self.run_binary(['socket_msg_flags'], timeout=50)
+        self.assertIn('UDP flags OK', stdout)
+        self.assertIn('TCP flags OK', stdout)
+        self.assertIn('TEST OK', stdout)
+
     def test_300_socket_tcp_msg_peek(self):
         stdout, _ = self.run_binary(['tcp_msg_peek'], timeout=50)
         self.assertIn('[client] receiving with MSG_PEEK: Hello from server!', stdout)
@@ -0,0 +1,196 @@
+#define _GNU_SOURCE
+#include <err.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/time.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NUM_TIMERFDS 64
+
+static volatile sig_atomic_t alarm_cnt;
+static volatile sig_atomic_t timer_cnt;
+static volatile int timer_value;
+
+static void alarm_handler(int sig) {
+    (void)sig;
+    alarm_cnt++;
+}
+
+static void timer_handler(int sig, siginfo_t* info, void* ctx) {
+    (void)sig;
+    (void)ctx;
+    if (info->si_code == SI_TIMER)
+        timer_value = info->si_value.sival_int;
+    timer_cnt++;
+}
+
+static void set_timerfd(int fd, long value_ms, long interval_ms) {
+    struct itimerspec spec = {
+        .it_value    = {.tv_sec = value_ms / 1000, .tv_nsec = (value_ms % 1000) * 1000000},
+        .it_interval = {.tv_sec = interval_ms / 1000, .tv_nsec = (interval_ms % 1000) * 1000000},
+    };
+    if (timerfd_settime(fd, 0, &spec, NULL) < 0)
+        err(1, "timerfd_settime");
+}
+
+static void test_timerfd(void) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (fd < 0)
+        err(1, "timerfd_create");
+
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != -1 || errno != EAGAIN)
+        errx(1, "read from a disarmed timerfd did not fail with EAGAIN");
+
+    /* periodic timer: at least a few expirations must accumulate */
+    set_timerfd(fd, 10, 10);
+    usleep(100000);
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        err(1, "read");
+    if (expirations < 2)
+        errx(1, "periodic timerfd expired only %lu times", expirations);
+
+    struct itimerspec cur;
+    if (timerfd_gettime(fd, &cur) < 0)
+        err(1, "timerfd_gettime");
+    if (cur.it_interval.tv_sec != 0 || cur.it_interval.tv_nsec != 10000000)
+        errx(1, "timerfd_gettime returned a wrong interval");
+
+    /* disarming drops pending expirations */
+    set_timerfd(fd, 0, 0);
+    if (read(fd, &expirations, sizeof(expirations)) != -1 || errno != EAGAIN)
+        errx(1, "read from a disarmed timerfd did not fail with EAGAIN");
+    close(fd);
+
+    /* blocking read */
+    fd = timerfd_create(CLOCK_REALTIME, 0);
+    if (fd < 0)
+        err(1, "timerfd_create");
+    set_timerfd(fd, 20, 0);
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        err(1, "blocking read");
+    if (expirations != 1)
+        errx(1, "one-shot timerfd expired %lu times", expirations);
+    close(fd);
+
+    printf("timerfd OK\n");
+}
+
+static void test_timerfd_epoll(void) {
+    int fds[NUM_TIMERFDS];
+    int epfd = epoll_create1(0);
+    if (epfd < 0)
+        err(1, "epoll_create1");
+
+    /* only the timerfd which expires first must be reported */
+    for (int i = 0; i < NUM_TIMERFDS; i++) {
+        fds[i] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (fds[i] < 0)
+            err(1, "timerfd_create");
+        set_timerfd(fds[i], i == NUM_TIMERFDS / 2 ? 20 : 10000 + i, 0);
+
+        struct epoll_event event = {.events = EPOLLIN, .data.u32 = i};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fds[i], &event) < 0)
+            err(1, "epoll_ctl");
+    }
+
+    struct epoll_event events[NUM_TIMERFDS];
+    int n = epoll_wait(epfd, events, NUM_TIMERFDS, 5000);
+    if (n < 0)
+        err(1, "epoll_wait");
+    if (n != 1 || events[0].data.u32 != NUM_TIMERFDS / 2)
+        errx(1, "epoll_wait reported %d timerfds (first: %u)", n, n ? events[0].data.u32 : 0);
+
+    for (int i = 0; i < NUM_TIMERFDS; i++)
+        close(fds[i]);
+    close(epfd);
+
+    printf("timerfd with epoll OK\n");
+}
+
+static void test_posix_timer(void) {
+    struct sigaction sa = {.sa_sigaction = timer_handler, .sa_flags = SA_SIGINFO};
+    if (sigaction(SIGUSR1, &sa, NULL) < 0)
+        err(1, "sigaction");
+
+    struct sigevent sev = {
+        .sigev_notify = SIGEV_SIGNAL,
+        .sigev_signo  = SIGUSR1,
+        .sigev_value  = {.sival_int = 42},
+    };
+    timer_t timer;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &timer) < 0)
+        err(1, "timer_create");
+
+    struct itimerspec spec = {.it_value = {.tv_nsec = 10000000}};
+    if (timer_settime(timer, 0, &spec, NULL) < 0)
+        err(1, "timer_settime");
+
+    for (int i = 0; i < 100 && !timer_cnt; i++)
+        usleep(10000);
+    if (timer_cnt != 1 || timer_value != 42)
+        errx(1, "POSIX timer signal: count %d, value %d", timer_cnt, timer_value);
+
+    struct itimerspec cur;
+    if (timer_gettime(timer, &cur) < 0)
+        err(1, "timer_gettime");
+    if (cur.it_value.tv_sec || cur.it_value.tv_nsec)
+        errx(1, "expired one-shot POSIX timer is still armed");
+
+    if (timer_delete(timer) < 0)
+        err(1, "timer_delete");
+    if (timer_delete(timer) != -1 || errno != EINVAL)
+        errx(1, "second timer_delete did not fail with EINVAL");
+
+    printf("POSIX timer OK\n");
+}
+
+static void test_itimer(void) {
+    if (signal(SIGALRM, alarm_handler) == SIG_ERR)
+        err(1, "signal");
+
+    struct itimerval val = {
+        .it_value    = {.tv_usec = 10000},
+        .it_interval = {.tv_usec = 10000},
+    };
+    if (setitimer(ITIMER_REAL, &val, NULL) < 0)
+        err(1, "setitimer");
+
+    for (int i = 0; i < 100 && alarm_cnt < 3; i++)
+        usleep(10000);
+
+    struct itimerval old;
+    memset(&val, 0, sizeof(val));
+    if (setitimer(ITIMER_REAL, &val, &old) < 0)
+        err(1, "setitimer");
+    if (alarm_cnt < 3)
+        errx(1, "periodic itimer fired only %d times", alarm_cnt);
+    if (old.it_interval.tv_sec != 0 || old.it_interval.tv_usec != 10000)
+        errx(1, "setitimer returned a wrong old interval");
+
+    if (alarm(10) != 0)
+        errx(1, "alarm() reported a pending alarm");
+    unsigned int left = alarm(0);
+    if (left < 9 || left > 10)
+        errx(1, "alarm(0) returned %u", left);
+
+    printf("itimer and alarm OK\n");
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    test_timerfd();
+    test_timerfd_epoll();
+    test_posix_timer();
+    test_itimer();
+
+    printf("TEST OK\n");
+    return 0;
+}
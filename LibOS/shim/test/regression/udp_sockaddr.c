@@ -0,0 +1,127 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <err.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int bound_socket(int domain, const void* loopback, struct sockaddr_storage* addr,
+                        socklen_t* addrlen) {
+    int fd = socket(domain, SOCK_DGRAM, 0);
+    if (fd < 0)
+        err(1, "socket");
+
+    memset(addr, 0, sizeof(*addr));
+    if (domain == AF_INET) {
+        struct sockaddr_in* in = (struct sockaddr_in*)addr;
+        in->sin_family = AF_INET;
+        memcpy(&in->sin_addr, loopback, sizeof(in->sin_addr));
+        *addrlen = sizeof(*in);
+    } else {
+        struct sockaddr_in6* in6 = (struct sockaddr_in6*)addr;
+        in6->sin6_family = AF_INET6;
+        memcpy(&in6->sin6_addr, loopback, sizeof(in6->sin6_addr));
+        *addrlen = sizeof(*in6);
+    }
+
+    /* port 0: the ephemeral port must be read back from the host */
+    if (bind(fd, (struct sockaddr*)addr, *addrlen) < 0)
+        err(1, "bind");
+    if (getsockname(fd, (struct sockaddr*)addr, addrlen) < 0)
+        err(1, "getsockname");
+    if (((struct sockaddr_in*)addr)->sin_port == 0)
+        errx(1, "getsockname after bind returned port 0");
+    return fd;
+}
+
+static void expect_same_addr(const struct sockaddr_storage* a, socklen_t a_len,
+                             const struct sockaddr_storage* b, socklen_t b_len, const char* what) {
+    if (a_len != b_len || a->ss_family != b->ss_family)
+        errx(1, "%s: address length or family differs", what);
+
+    if (a->ss_family == AF_INET) {
+        const struct sockaddr_in* x = (const struct sockaddr_in*)a;
+        const struct sockaddr_in* y = (const struct sockaddr_in*)b;
+        if (x->sin_port != y->sin_port || x->sin_addr.s_addr != y->sin_addr.s_addr)
+            errx(1, "%s: IPv4 address differs", what);
+    } else {
+        const struct sockaddr_in6* x = (const struct sockaddr_in6*)a;
+        const struct sockaddr_in6* y = (const struct sockaddr_in6*)b;
+        if (x->sin6_port != y->sin6_port || memcmp(&x->sin6_addr, &y->sin6_addr, 16))
+            errx(1, "%s: IPv6 address differs", what);
+    }
+}
+
+static void test_domain(int domain, const void* loopback, const char* name) {
+    struct sockaddr_storage srv_addr, cli_addr, from;
+    socklen_t srv_len, cli_len, from_len;
+    char buf[32];
+
+    int srv = bound_socket(domain, loopback, &srv_addr, &srv_len);
+    int cli = bound_socket(domain, loopback, &cli_addr, &cli_len);
+
+    if (sendto(cli, "ping", 5, 0, (struct sockaddr*)&srv_addr, srv_len) != 5)
+        err(1, "sendto(ping)");
+
+    /* the source address of a peeked datagram must survive until it is read */
+    from_len = sizeof(from);
+    if (recvfrom(srv, buf, sizeof(buf), MSG_PEEK, (struct sockaddr*)&from, &from_len) != 5)
+        err(1, "recvfrom(MSG_PEEK)");
+    expect_same_addr(&from, from_len, &cli_addr, cli_len, "recvfrom(MSG_PEEK) source");
+
+    memset(&from, 0, sizeof(from));
+    from_len = sizeof(from);
+    if (recvfrom(srv, buf, sizeof(buf), 0, (struct sockaddr*)&from, &from_len) != 5
+            || strcmp(buf, "ping"))
+        err(1, "recvfrom(ping)");
+    expect_same_addr(&from, from_len, &cli_addr, cli_len, "recvfrom source");
+
+    /* reply to the address returned by recvfrom */
+    if (sendto(srv, "pong", 5, 0, (struct sockaddr*)&from, from_len) != 5)
+        err(1, "sendto(pong)");
+
+    from_len = sizeof(from);
+    if (recvfrom(cli, buf, sizeof(buf), 0, (struct sockaddr*)&from, &from_len) != 5
+            || strcmp(buf, "pong"))
+        err(1, "recvfrom(pong)");
+    expect_same_addr(&from, from_len, &srv_addr, srv_len, "reply source");
+
+    /* connected socket: getpeername and send without an address */
+    int conn = socket(domain, SOCK_DGRAM, 0);
+    if (conn < 0)
+        err(1, "socket");
+    if (connect(conn, (struct sockaddr*)&srv_addr, srv_len) < 0)
+        err(1, "connect");
+
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    if (getpeername(conn, (struct sockaddr*)&peer, &peer_len) < 0)
+        err(1, "getpeername");
+    expect_same_addr(&peer, peer_len, &srv_addr, srv_len, "getpeername");
+
+    if (send(conn, "conn", 5, 0) != 5)
+        err(1, "send");
+    from_len = sizeof(from);
+    if (recvfrom(srv, buf, sizeof(buf), 0, (struct sockaddr*)&from, &from_len) != 5
+            || strcmp(buf, "conn"))
+        err(1, "recvfrom(conn)");
+
+    close(conn);
+    close(cli);
+    close(srv);
+    printf("%s OK\n", name);
+}
+
+int main(void) {
+    setbuf(stdout, NULL);
+
+    struct in_addr lo4 = {.s_addr = htonl(INADDR_LOOPBACK)};
+    test_domain(AF_INET, &lo4, "IPv4");
+    test_domain(AF_INET6, &in6addr_loopback, "IPv6");
+
+    printf("TEST OK\n");
+    return 0;
+}
@@ -25,6 +25,10 @@ typedef struct pal_tcb {
     struct pal_tcb* self;
     /* uint64_t for alignment */
     uint64_t libos_tcb[(PAL_LIBOS_TCB_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+    /* cycles spent by this thread inside PAL calls; only counted while `profile_pal_calls` is
+     * set (by the LibOS syscall profiler) and on PALs which can read the TSC */
+    uint64_t pal_cycles;
+    uint64_t profile_pal_calls;
     /* data private to PAL implementation follows this struct. */
 } PAL_TCB;
 
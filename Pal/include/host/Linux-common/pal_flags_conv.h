@@ -14,6 +14,8 @@
 
 #undef __GLIBC__
 #include <asm/fcntl.h>
+#include <linux/fadvise.h>
+#include <linux/falloc.h>
 #include <linux/mman.h>
 #include <linux/stat.h>
 #include <sys/types.h>
@@ -21,12 +23,29 @@
 #include "assert.h"
 #include "pal.h"
 
+#ifndef SYNC_FILE_RANGE_WAIT_BEFORE
+#define SYNC_FILE_RANGE_WAIT_BEFORE 1
+#define SYNC_FILE_RANGE_WRITE       2
+#define SYNC_FILE_RANGE_WAIT_AFTER  4
+#endif
+
+#ifndef RWF_HIPRI
+#define RWF_HIPRI  0x00000001
+#endif
+#ifndef RWF_NOWAIT
+#define RWF_NOWAIT 0x00000008
+#endif
+
 static inline int PAL_MEM_FLAGS_TO_LINUX(int alloc_type, int prot) {
     assert(WITHIN_MASK(alloc_type, PAL_ALLOC_MASK));
     assert(WITHIN_MASK(prot,       PAL_PROT_MASK));
 
-    return (alloc_type & PAL_ALLOC_RESERVE ? MAP_NORESERVE | MAP_UNINITIALIZED : 0) |
-           (prot & PAL_PROT_WRITECOPY      ? MAP_PRIVATE : MAP_SHARED);
+    return (alloc_type & PAL_ALLOC_RESERVE     ? MAP_NORESERVE | MAP_UNINITIALIZED : 0) |
+           (alloc_type & PAL_ALLOC_HUGEPAGE    ? MAP_HUGETLB : 0) |
+           (alloc_type & PAL_ALLOC_HUGEPAGE_1G ? MAP_HUGE_1GB : 0) |
+           (alloc_type & PAL_ALLOC_POPULATE    ? MAP_POPULATE : 0) |
+           (alloc_type & PAL_ALLOC_NORESERVE   ? MAP_NORESERVE : 0) |
+           (prot & PAL_PROT_WRITECOPY          ? MAP_PRIVATE : MAP_SHARED);
 }
 
 static inline int PAL_PROT_TO_LINUX(int prot) {
@@ -56,4 +75,37 @@ static inline int PAL_OPTION_TO_LINUX_OPEN(int options) {
            (options & PAL_OPTION_NONBLOCK ? O_NONBLOCK : 0);
 }
 
+static inline int PAL_FALLOCATE_TO_LINUX(int mode) {
+    assert(WITHIN_MASK(mode, PAL_FALLOCATE_MASK));
+    return (mode & PAL_FALLOCATE_KEEP_SIZE  ? FALLOC_FL_KEEP_SIZE  : 0) |
+           (mode & PAL_FALLOCATE_PUNCH_HOLE ? FALLOC_FL_PUNCH_HOLE : 0) |
+           (mode & PAL_FALLOCATE_ZERO_RANGE ? FALLOC_FL_ZERO_RANGE : 0);
+}
+
+static inline int PAL_ADVICE_TO_LINUX(int advice) {
+    switch (advice) {
+        case PAL_ADVICE_RANDOM:     return POSIX_FADV_RANDOM;
+        case PAL_ADVICE_SEQUENTIAL: return POSIX_FADV_SEQUENTIAL;
+        case PAL_ADVICE_WILLNEED:   return POSIX_FADV_WILLNEED;
+        case PAL_ADVICE_DONTNEED:   return POSIX_FADV_DONTNEED;
+        case PAL_ADVICE_NOREUSE:    return POSIX_FADV_NOREUSE;
+        default:
+            assert(advice == PAL_ADVICE_NORMAL);
+            return POSIX_FADV_NORMAL;
+    }
+}
+
+static inline int PAL_FLUSH_RANGE_TO_LINUX(int flags) {
+    assert(WITHIN_MASK(flags, PAL_FLUSH_RANGE_MASK));
+    return (flags & PAL_FLUSH_RANGE_WAIT_BEFORE ? SYNC_FILE_RANGE_WAIT_BEFORE : 0) |
+           (flags & PAL_FLUSH_RANGE_WRITE       ? SYNC_FILE_RANGE_WRITE       : 0) |
+           (flags & PAL_FLUSH_RANGE_WAIT_AFTER  ? SYNC_FILE_RANGE_WAIT_AFTER  : 0);
+}
+
+static inline int PAL_RW_TO_LINUX(int flags) {
+    assert(WITHIN_MASK(flags, PAL_RW_MASK));
+    return (flags & PAL_RW_NOWAIT ? RWF_NOWAIT : 0) |
+           (flags & PAL_RW_HIPRI  ? RWF_HIPRI  : 0);
+}
+
 #endif /* PAL_FLAGS_CONV_H */
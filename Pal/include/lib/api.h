@@ -217,6 +217,9 @@ DEFINE_LISTP(config);
 struct config_store {
     LISTP_TYPE(config) root;
     LISTP_TYPE(config) entries;
+    struct config ** hash_table;
+    size_t           hash_size;
+    size_t           hash_cnt;
     void *           raw_data;
     int              raw_size;
     void *           (*malloc) (size_t);
@@ -235,6 +238,8 @@ int get_config_entries (struct config_store * cfg, const char * key,
                         char * key_buf, size_t key_bufsize);
 ssize_t get_config_entries_size (struct config_store * cfg, const char * key);
 int set_config (struct config_store * cfg, const char * key, const char * val);
+ssize_t write_config_binary (struct config_store * cfg, void * buf, size_t buf_size);
+int read_config_binary (struct config_store * cfg, const void * data, size_t size);
 
 #define CONFIG_MAX      4096
 
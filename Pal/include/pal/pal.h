@@ -172,10 +172,15 @@ PAL_CONTROL * pal_control_addr (void);
 
 /*! Memory Allocation Flags */
 enum PAL_ALLOC {
-    PAL_ALLOC_RESERVE  = 0x1, /*!< Only reserve the memory */
-    PAL_ALLOC_INTERNAL = 0x2, /*!< Allocate for PAL (valid only if #IN_PAL) */
-
-    PAL_ALLOC_MASK     = 0x3,
+    PAL_ALLOC_RESERVE     = 0x1,  /*!< Only reserve the memory */
+    PAL_ALLOC_INTERNAL    = 0x2,  /*!< Allocate for PAL (valid only if #IN_PAL) */
+    PAL_ALLOC_HUGEPAGE    = 0x4,  /*!< Back the memory with huge pages of the host default size */
+    PAL_ALLOC_HUGEPAGE_1G = 0x8,  /*!< With #PAL_ALLOC_HUGEPAGE: use 1GB huge pages */
+    PAL_ALLOC_THP         = 0x10, /*!< Hint that the memory should use transparent huge pages */
+    PAL_ALLOC_POPULATE    = 0x20, /*!< Prefault the memory on allocation */
+    PAL_ALLOC_NORESERVE   = 0x40, /*!< Do not reserve host swap space for the memory */
+
+    PAL_ALLOC_MASK        = 0x7F,
 };
 
 /*! Memory Protection Flags */
@@ -201,6 +206,10 @@ enum PAL_PROT {
  * \param size must be a positive number, aligned at the allocation alignment.
  * \param alloc_type can be a combination of any of the #PAL_ALLOC flags
  * \param prot can be a combination of the #PAL_PROT flags
+ *
+ * #PAL_ALLOC_HUGEPAGE requires `addr` and `size` to be aligned at the huge page size and fails if
+ * the host has no free huge pages. #PAL_ALLOC_THP, #PAL_ALLOC_POPULATE and #PAL_ALLOC_NORESERVE are
+ * only hints and may be ignored by hosts which do not support them.
  */
 PAL_PTR
 DkVirtualMemoryAlloc(PAL_PTR addr, PAL_NUM size, PAL_FLG alloc_type, PAL_FLG prot);
@@ -229,6 +238,36 @@ DkVirtualMemoryFree(PAL_PTR addr, PAL_NUM size);
 PAL_BOL
 DkVirtualMemoryProtect(PAL_PTR addr, PAL_NUM size, PAL_FLG prot);
 
+/*!
+ * \brief Move a previously allocated memory mapping to a new address, without copying its contents.
+ *
+ * \param old_addr the address of the mapping
+ * \param old_size the size of the mapping
+ * \param new_addr the new address; any memory previously allocated in the range
+ *  [`new_addr`, `new_addr` + `new_size`) is replaced
+ * \param new_size the new size of the mapping; if it is bigger than `old_size`, the new tail of the
+ *  mapping is backed the same way as the old mapping (e.g. zero-filled for anonymous memory)
+ *
+ * All addresses and sizes must be non-zero and aligned at the allocation alignment, and the old
+ * and new ranges must not overlap. On success the old range is no longer mapped.
+ */
+PAL_BOL
+DkVirtualMemoryMove(PAL_PTR old_addr, PAL_NUM old_size, PAL_PTR new_addr, PAL_NUM new_size);
+
+/*!
+ * \brief Discard the contents of a previously allocated memory mapping and return the backing
+ * memory to the host.
+ *
+ * \param addr the address
+ * \param size the size
+ *
+ * The mapping itself stays valid. Subsequent accesses to anonymous memory see zero-filled pages,
+ * accesses to file-backed memory see the contents of the file. Both `addr` and `size` must be
+ * non-zero and aligned at the allocation alignment.
+ */
+PAL_BOL
+DkVirtualMemoryDiscard(PAL_PTR addr, PAL_NUM size);
+
 
 /*
  * PROCESS CREATION
@@ -356,6 +395,22 @@ DkStreamOpen(PAL_STR uri, PAL_FLG access, PAL_FLG share_flags, PAL_FLG create, P
 PAL_HANDLE
 DkStreamWaitForClient(PAL_HANDLE handle);
 
+/*!
+ * \brief Open an anonymous unidirectional pipe backed by a host pipe.
+ *
+ * \param[out] read_end handle of the end to read from
+ * \param[out] write_end handle of the end to write to
+ * \param options may contain #PAL_OPTION_NONBLOCK (applies to both ends)
+ *
+ * In contrast to `pipe:` streams, the data does not pass through host UNIX sockets and no named
+ * rendezvous is needed. The ends have the host pipe capacity (see `pipe.size` in #PAL_STREAM_ATTR)
+ * and can be spliced by the host. Fails with #PAL_ERROR_NOTIMPLEMENTED if the host does not
+ * provide such pipes (e.g., Linux-SGX, where pipe data must be protected); the caller then has to
+ * connect `pipe.srv:` and `pipe:` streams instead.
+ */
+PAL_BOL
+DkStreamOpenPipe(PAL_HANDLE* read_end, PAL_HANDLE* write_end, PAL_FLG options);
+
 /*!
  * \brief Read data from an open stream.
  *
@@ -377,6 +432,176 @@ DkStreamRead(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer, P
 PAL_NUM
 DkStreamWrite(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer, PAL_STR dest);
 
+/*! buffer of #DkStreamReadV() and #DkStreamWriteV(), same layout as `struct iovec` */
+typedef struct _PAL_IOVEC {
+    PAL_PTR buffer;
+    PAL_NUM size;
+} PAL_IOVEC;
+
+/*! flags of #DkStreamReadV() and #DkStreamWriteV() */
+enum PAL_RW {
+    PAL_RW_NOWAIT = 0x1, /*!< fail with #PAL_ERROR_TRYAGAIN instead of waiting for the device */
+    PAL_RW_HIPRI  = 0x2, /*!< high-priority request, poll for completion if the host can */
+
+    PAL_RW_MASK   = 0x3,
+};
+
+/*!
+ * \brief Read data from an open stream into multiple buffers.
+ *
+ * \param offset the offset to read at if the handle is a file (ignored otherwise)
+ * \param iov the buffers to fill, in order
+ * \param iov_count number of buffers in `iov`
+ * \param flags combination of #PAL_RW flags
+ *
+ * \return number of bytes read or #PAL_STREAM_ERROR. The call reads as much as a single
+ *  DkStreamRead() of the total size would. Fails with #PAL_ERROR_NOTSUPPORT if `flags` are not
+ *  supported for this stream.
+ */
+PAL_NUM
+DkStreamReadV(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* iov, PAL_NUM iov_count, PAL_FLG flags);
+
+/*!
+ * \brief Write data from multiple buffers to an open stream.
+ *
+ * Same as #DkStreamReadV(), but writes the buffers.
+ */
+PAL_NUM
+DkStreamWriteV(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* iov, PAL_NUM iov_count, PAL_FLG flags);
+
+/*! flags of #DkStreamSendTo() and #DkStreamRecvFrom() */
+enum PAL_MSG {
+    PAL_MSG_DONTWAIT = 0x01, /*!< fail with #PAL_ERROR_TRYAGAIN instead of blocking */
+    PAL_MSG_MORE     = 0x02, /*!< more data follows, the host may hold back a partial packet
+                                  (send only) */
+    PAL_MSG_WAITALL  = 0x04, /*!< block until `count` bytes are received on a stream socket
+                                  (receive only) */
+    PAL_MSG_TRUNC    = 0x08, /*!< return the full size of a datagram larger than `count`
+                                  (receive only) */
+    PAL_MSG_PEEK     = 0x10, /*!< leave the received data queued for the next receive
+                                  (receive only) */
+
+    PAL_MSG_SEND_MASK = PAL_MSG_DONTWAIT | PAL_MSG_MORE,
+    PAL_MSG_RECV_MASK = PAL_MSG_DONTWAIT | PAL_MSG_WAITALL | PAL_MSG_TRUNC | PAL_MSG_PEEK,
+};
+
+/*!
+ * \brief Send data on a socket.
+ *
+ * Same as DkStreamWrite(), but gathers the data from multiple buffers, takes per-call flags and,
+ * for a UDP socket, the destination as a host socket address (`struct sockaddr_in` or
+ * `struct sockaddr_in6`), so no URI is formatted and parsed per datagram. The buffers are sent in
+ * a single host call, so a UDP socket sends them as one datagram. Streams without native support
+ * (e.g. pipes) accept only #PAL_MSG_MORE, which is a hint.
+ *
+ * \param iov the buffers to send
+ * \param iov_count number of buffers in `iov`
+ * \param addr the destination address, or NULL to send to the peer of a connected socket
+ * \param addrlen size of `addr` in bytes
+ * \param flags combination of #PAL_MSG send flags
+ *
+ * \return number of bytes sent or #PAL_STREAM_ERROR
+ */
+PAL_NUM
+DkStreamSendTo(PAL_HANDLE handle, PAL_IOVEC* iov, PAL_NUM iov_count, PAL_PTR addr,
+               PAL_NUM addrlen, PAL_FLG flags);
+
+/*!
+ * \brief Receive data on a socket.
+ *
+ * Same as DkStreamRead(), but takes per-call flags and, for a UDP socket, returns the source as a
+ * host socket address. Streams without native support (e.g. pipes) accept no flags and fail with
+ * #PAL_ERROR_NOTSUPPORT otherwise.
+ *
+ * \param addr buffer for the source address, may be NULL
+ * \param[in,out] addrlen size of `addr` on input; full size of the source address on output, which
+ *  is truncated if larger than the buffer
+ * \param flags combination of #PAL_MSG receive flags
+ *
+ * \return number of bytes received (0 at the end of a stream) or #PAL_STREAM_ERROR
+ */
+PAL_NUM
+DkStreamRecvFrom(PAL_HANDLE handle, PAL_PTR buffer, PAL_NUM count, PAL_PTR addr,
+                 PAL_NUM* addrlen, PAL_FLG flags);
+
+/*! address selector of #DkStreamGetSockAddr() */
+enum PAL_SOCKADDR {
+    PAL_SOCKADDR_LOCAL = 0, /*!< address the socket is bound to */
+    PAL_SOCKADDR_PEER  = 1, /*!< address the socket is connected to */
+};
+
+/*!
+ * \brief Get the local or peer address of a TCP or UDP socket as a host socket address.
+ *
+ * \param which one of #PAL_SOCKADDR
+ * \param addr buffer for the address
+ * \param[in,out] addrlen size of `addr` on input; size of the address on output
+ *
+ * Fails with #PAL_ERROR_NOTCONNECTION if the socket has no such address and with
+ * #PAL_ERROR_OVERFLOW if `addr` is too small.
+ */
+PAL_BOL
+DkStreamGetSockAddr(PAL_HANDLE handle, PAL_FLG which, PAL_PTR addr, PAL_NUM* addrlen);
+
+enum PAL_IO_OP {
+    PAL_IO_READ  = 0, /*!< read `size` bytes at `offset` into `buffer` */
+    PAL_IO_WRITE = 1, /*!< write `size` bytes from `buffer` at `offset` */
+};
+
+/*! request of #DkStreamsBatchIo() */
+typedef struct _PAL_IO_REQUEST {
+    PAL_HANDLE handle;
+    PAL_FLG op;       /*!< #PAL_IO_OP */
+    PAL_NUM offset;
+    PAL_NUM size;
+    PAL_PTR buffer;
+    PAL_NUM result;   /*!< number of bytes transferred, set on return */
+    PAL_NUM error;    /*!< PAL error code or 0, set on return */
+} PAL_IO_REQUEST;
+
+/*!
+ * \brief Perform a batch of reads and writes at absolute offsets.
+ *
+ * \param reqs the requests
+ * \param count number of requests in `reqs`
+ *
+ * All requests are handed to the host before waiting for any of them, so the host may process
+ * them concurrently and in any order. The call returns once all requests are completed; `result`
+ * and `error` of each request tell its outcome. A read at the end of a stream succeeds with zero
+ * bytes. Failures of single requests do not fail the call.
+ */
+PAL_BOL
+DkStreamsBatchIo(PAL_IO_REQUEST* reqs, PAL_NUM count);
+
+/*! flags of #DkStreamSplice() */
+enum PAL_SPLICE {
+    PAL_SPLICE_NONBLOCK = 0x1, /*!< do not block waiting for data of `src` */
+    PAL_SPLICE_PEEK     = 0x2, /*!< do not consume the data of `src` (like `tee()`) */
+
+    PAL_SPLICE_MASK     = 0x3,
+};
+
+/*!
+ * \brief Move data from one stream to another without copying it through the caller.
+ *
+ * \param src the stream to read from
+ * \param src_offset the offset to read at if `src` is a file (ignored otherwise)
+ * \param dst the stream to write to
+ * \param dst_offset the offset to write at if `dst` is a file (ignored otherwise)
+ * \param count maximal number of bytes to move
+ * \param flags combination of #PAL_SPLICE flags
+ *
+ * \return number of bytes moved (which may be less than `count`, and zero at the end of `src`) or
+ *  #PAL_STREAM_ERROR. Fails with #PAL_ERROR_NOTSUPPORT if the host cannot move data between the
+ *  given streams; the caller then has to copy the data itself.
+ *
+ * All data read from `src` is written to `dst` before the call returns, so a non-blocking `dst`
+ * may block the call.
+ */
+PAL_NUM
+DkStreamSplice(PAL_HANDLE src, PAL_NUM src_offset, PAL_HANDLE dst, PAL_NUM dst_offset,
+               PAL_NUM count, PAL_FLG flags);
+
 enum PAL_DELETE {
     PAL_DELETE_RD = 1, /*!< shut down the read side only */
     PAL_DELETE_WR = 2, /*!< shut down the write side only */
@@ -423,6 +648,70 @@ DkStreamSetLength(PAL_HANDLE handle, PAL_NUM length);
 PAL_BOL
 DkStreamFlush(PAL_HANDLE handle);
 
+/*! modes of #DkStreamAllocate() */
+enum PAL_FALLOCATE {
+    PAL_FALLOCATE_KEEP_SIZE  = 0x1, /*!< do not extend the file size */
+    PAL_FALLOCATE_PUNCH_HOLE = 0x2, /*!< deallocate the range, requires #PAL_FALLOCATE_KEEP_SIZE */
+    PAL_FALLOCATE_ZERO_RANGE = 0x4, /*!< zero the range without writing the data */
+
+    PAL_FALLOCATE_MASK       = 0x7,
+};
+
+/*!
+ * \brief Allocate (or deallocate) the storage of a byte range of a file stream.
+ *
+ * \param mode combination of #PAL_FALLOCATE flags; zero allocates the range and extends the file if
+ *  the range ends past its end
+ *
+ * Fails with #PAL_ERROR_NOTSUPPORT if the host file system does not support the mode and with
+ * #PAL_ERROR_NOSPACE if there is not enough space.
+ */
+PAL_BOL
+DkStreamAllocate(PAL_HANDLE handle, PAL_FLG mode, PAL_NUM offset, PAL_NUM length);
+
+/*! access patterns for #DkStreamAdvise() */
+enum PAL_ADVICE {
+    PAL_ADVICE_NORMAL = 0,  /*!< no special treatment */
+    PAL_ADVICE_RANDOM,      /*!< random access, disable readahead */
+    PAL_ADVICE_SEQUENTIAL,  /*!< sequential access, read ahead aggressively */
+    PAL_ADVICE_WILLNEED,    /*!< the range will be accessed soon, start reading it */
+    PAL_ADVICE_DONTNEED,    /*!< the range will not be accessed soon, drop it from caches */
+    PAL_ADVICE_NOREUSE,     /*!< the range will be accessed only once */
+    PAL_ADVICE_BOUND,
+};
+
+/*!
+ * \brief Announce an access pattern for a byte range of a file stream.
+ *
+ * \param length length of the range; zero means up to the end of the file
+ * \param advice one of #PAL_ADVICE
+ *
+ * The advice is only a hint, it does not change the stream contents.
+ */
+PAL_BOL
+DkStreamAdvise(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG advice);
+
+/*! flags of #DkStreamFlushRange() */
+enum PAL_FLUSH_RANGE {
+    PAL_FLUSH_RANGE_WAIT_BEFORE = 0x1, /*!< wait for write-back already in progress */
+    PAL_FLUSH_RANGE_WRITE       = 0x2, /*!< start write-back of dirty data */
+    PAL_FLUSH_RANGE_WAIT_AFTER  = 0x4, /*!< wait for the write-back to finish */
+
+    PAL_FLUSH_RANGE_MASK        = 0x7,
+};
+
+/*!
+ * \brief Write back a byte range of a file stream.
+ *
+ * \param length length of the range; zero means up to the end of the file
+ * \param flags combination of #PAL_FLUSH_RANGE flags
+ *
+ * Unlike #DkStreamFlush(), this does not flush file metadata and does not guarantee that the data
+ * is durable.
+ */
+PAL_BOL
+DkStreamFlushRange(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG flags);
+
 /*!
  * \brief Send a PAL handle over another handle.
  *
@@ -439,6 +728,28 @@ DkSendHandle(PAL_HANDLE handle, PAL_HANDLE cargo);
 PAL_HANDLE
 DkReceiveHandle(PAL_HANDLE handle);
 
+/*!
+ * \brief Send several PAL handles over another handle at once.
+ *
+ * Equivalent to calling #DkSendHandle() on each handle in \p cargo, but cheaper for many handles.
+ *
+ * \param cargo array of the handles being sent
+ * \param count number of handles in \p cargo
+ */
+PAL_BOL
+DkSendHandles(PAL_HANDLE handle, PAL_HANDLE* cargo, PAL_NUM count);
+
+/*!
+ * \brief Receive several PAL handles sent with #DkSendHandles() over another handle.
+ *
+ * \param cargo array which receives the handles
+ * \param count number of handles to receive; must match the number of handles sent
+ *
+ * On failure, the handles which could not be received are set to NULL.
+ */
+PAL_BOL
+DkReceiveHandles(PAL_HANDLE handle, PAL_HANDLE* cargo, PAL_NUM count);
+
 /* stream attribute structure */
 typedef struct _PAL_STREAM_ATTR {
     PAL_IDX handle_type;
@@ -459,6 +770,9 @@ typedef struct _PAL_STREAM_ATTR {
             PAL_BOL tcp_keepalive;
             PAL_BOL tcp_nodelay;
         } socket;
+        struct {
+            PAL_NUM size; /*!< capacity of a host pipe, 0 for other pipes */
+        } pipe;
     };
 } PAL_STREAM_ATTR;
 
@@ -541,6 +855,37 @@ noreturn void DkThreadExit(PAL_PTR clear_child_tid);
 PAL_BOL
 DkThreadResume(PAL_HANDLE thread);
 
+/*!
+ * \brief Set the CPU affinity of a thread.
+ *
+ * \param thread PAL thread for which to set the CPU affinity
+ * \param cpumask_size size in bytes of the bitmask pointed by \a cpu_mask
+ * \param cpu_mask pointer to the new CPU mask
+ */
+PAL_BOL
+DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+
+/*!
+ * \brief Get the CPU affinity of a thread.
+ *
+ * \param thread PAL thread for which to get the CPU affinity
+ * \param cpumask_size size in bytes of the bitmask pointed by \a cpu_mask
+ * \param cpu_mask pointer to hold the current CPU mask; bits beyond the host CPU mask are cleared
+ */
+PAL_BOL
+DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+
+/*!
+ * \brief Get the CPU and the NUMA node the current thread is running on.
+ *
+ * The result is only a hint: the thread may be migrated right after this call returns.
+ *
+ * \param cpu pointer to hold the CPU number; may be NULL
+ * \param node pointer to hold the NUMA node number; may be NULL
+ */
+PAL_BOL
+DkThreadGetCpu(PAL_NUM* cpu, PAL_NUM* node);
+
 /*
  * Exception Handling
  */
@@ -657,6 +1002,41 @@ void DkEventWait(PAL_HANDLE handle);
  */
 PAL_BOL DkSynchronizationObjectWait(PAL_HANDLE handle, PAL_NUM timeout_us);
 
+enum PAL_FUTEX {
+    PAL_FUTEX_PRIVATE = 1, /*!< the word is only accessed by threads of the current process */
+    PAL_FUTEX_MASK    = 1,
+};
+
+/*!
+ * \brief Wait on a 32-bit word in memory.
+ *
+ * Blocks while the word at \a addr contains \a val, until DkFutexWake() is called on the same word
+ * or the timeout expires. Unless #PAL_FUTEX_PRIVATE is given, the word may live in memory shared
+ * with other processes (e.g. a shared mapping of a file), and the waiter can be woken up from any
+ * of them.
+ *
+ * \param addr address of the word, must be 4-byte aligned
+ * \param val value the word is expected to contain
+ * \param timeout_us maximum time to wait in microseconds, or #NO_TIMEOUT
+ * \param flags combination of #PAL_FUTEX values
+ * \return true if woken up or if the word did not contain \a val (the caller has to re-check its
+ *  condition in both cases, wakeups may be spurious), false on failure; the error is
+ *  PAL_ERROR_TRYAGAIN if the timeout expired and PAL_ERROR_INTERRUPTED if the wait was interrupted
+ */
+PAL_BOL
+DkFutexWait(PAL_PTR addr, PAL_NUM val, PAL_NUM timeout_us, PAL_FLG flags);
+
+/*!
+ * \brief Wake up threads waiting on a 32-bit word in memory.
+ *
+ * \param addr address of the word, must be 4-byte aligned
+ * \param count maximum number of waiters to wake up
+ * \param flags combination of #PAL_FUTEX values, must match the flags of the waiters
+ * \param[out] woken if not NULL, receives the number of waiters woken up
+ */
+PAL_BOL
+DkFutexWake(PAL_PTR addr, PAL_NUM count, PAL_FLG flags, PAL_NUM* woken);
+
 enum PAL_WAIT {
     PAL_WAIT_SIGNAL = 1, /*!< ignored in events */
     PAL_WAIT_READ   = 2,
@@ -40,8 +40,9 @@ typedef enum _pal_error_t {
     PAL_ERROR_ADDRNOTEXIST,
     PAL_ERROR_AFNOSUPPORT,
     PAL_ERROR_CONNFAILED_PIPE,
+    PAL_ERROR_NOSPACE,
 
-#define PAL_ERROR_NATIVE_COUNT PAL_ERROR_CONNFAILED_PIPE
+#define PAL_ERROR_NATIVE_COUNT PAL_ERROR_NOSPACE
 #define PAL_ERROR_CRYPTO_START PAL_ERROR_CRYPTO_FEATURE_UNAVAILABLE
 
     /* Crypto error constants and their descriptions are adapted from mbedtls. */
@@ -12,25 +12,116 @@
 #include <list.h>
 #include <pal_error.h>
 
+/*
+ * Every entry (leaf or branch) is indexed by its full dotted key in a hash table of the store, so
+ * looking up a key costs one hash computation and one comparison regardless of the manifest size.
+ * The tree structure (children / siblings lists) is kept for enumerating entries in manifest order.
+ */
 DEFINE_LIST(config);
 struct config {
-    const char* key;
+    const char* key;  /* last component of the key */
     const char* val;
     size_t klen, vlen; /* for leaf nodes, vlen stores the size of config
                           values; for branch nodes, vlen stores the sum
                           of config value lengths plus one of all the
                           immediate children. */
+    const char* path; /* full dotted key, ends with `key` */
+    size_t plen;
+    uint32_t hash;    /* hash of `path` */
     char* buf;
+    struct config* hnext; /* next entry in the same hash bucket */
     LIST_TYPE(config) list;
     LISTP_TYPE(config) children;
     LIST_TYPE(config) siblings;
 };
 
+#define CONFIG_HASH_INIT      2166136261U /* FNV-1a 32-bit */
+#define CONFIG_HASH_MIN_SIZE  64
+
+static inline uint32_t __hash_config_key(uint32_t hash, const char* s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+static int __init_config_hash(struct config_store* store, size_t nentries) {
+    size_t size = CONFIG_HASH_MIN_SIZE;
+    while (size < nentries)
+        size *= 2;
+
+    store->hash_table = store->malloc(sizeof(struct config*) * size);
+    if (!store->hash_table)
+        return -PAL_ERROR_NOMEM;
+
+    memset(store->hash_table, 0, sizeof(struct config*) * size);
+    store->hash_size = size;
+    store->hash_cnt  = 0;
+    return 0;
+}
+
+static void __grow_config_hash(struct config_store* store) {
+    size_t new_size = store->hash_size * 2;
+    struct config** new_table = store->malloc(sizeof(struct config*) * new_size);
+    if (!new_table)
+        return; /* keep using the current table, only lookups become slower */
+
+    memset(new_table, 0, sizeof(struct config*) * new_size);
+
+    for (size_t i = 0; i < store->hash_size; i++) {
+        struct config* e = store->hash_table[i];
+        while (e) {
+            struct config* next = e->hnext;
+            struct config** bucket = &new_table[e->hash & (new_size - 1)];
+            e->hnext = *bucket;
+            *bucket  = e;
+            e = next;
+        }
+    }
+
+    if (store->free)
+        store->free(store->hash_table);
+    store->hash_table = new_table;
+    store->hash_size  = new_size;
+}
+
+static void __hash_config(struct config_store* store, struct config* e) {
+    if (store->hash_cnt >= store->hash_size)
+        __grow_config_hash(store);
+
+    struct config** bucket = &store->hash_table[e->hash & (store->hash_size - 1)];
+    e->hnext = *bucket;
+    *bucket  = e;
+    store->hash_cnt++;
+}
+
+static void __unhash_config(struct config_store* store, struct config* e) {
+    struct config** pprev = &store->hash_table[e->hash & (store->hash_size - 1)];
+    for (; *pprev; pprev = &(*pprev)->hnext)
+        if (*pprev == e) {
+            *pprev = e->hnext;
+            store->hash_cnt--;
+            break;
+        }
+}
+
+static struct config* __lookup_config(struct config_store* store, const char* path, size_t plen,
+                                      uint32_t hash) {
+    struct config* e = store->hash_table[hash & (store->hash_size - 1)];
+    for (; e; e = e->hnext)
+        if (e->hash == hash && e->plen == plen && !memcmp(e->path, path, plen))
+            return e;
+    return NULL;
+}
+
 static int __add_config(struct config_store* store, const char* key, size_t klen, const char* val,
                         size_t vlen, struct config** entry) {
     LISTP_TYPE(config)* list = &store->root;
     struct config* e         = NULL;
     struct config* parent    = NULL;
+    const char* path         = key;
+    uint32_t hash            = CONFIG_HASH_INIT;
 
     while (klen) {
         if (e && e->val)
@@ -42,10 +133,14 @@ static int __add_config(struct config_store* store, const char* key, size_t klen
             if (token[len] == '.')
                 break;
 
-        LISTP_FOR_EACH_ENTRY(e, list, siblings) {
-            if (e->klen == len && !memcmp(e->key, token, len))
-                goto next;
-        }
+        if (parent)
+            hash = __hash_config_key(hash, ".", 1);
+        hash = __hash_config_key(hash, token, len);
+
+        size_t plen = token + len - path;
+        e = __lookup_config(store, path, plen, hash);
+        if (e)
+            goto next;
 
         e = store->malloc(sizeof(struct config));
         if (!e)
@@ -55,7 +150,11 @@ static int __add_config(struct config_store* store, const char* key, size_t klen
         e->klen = len;
         e->val  = NULL;
         e->vlen = 0;
+        e->path = path;
+        e->plen = plen;
+        e->hash = hash;
         e->buf  = NULL;
+        __hash_config(store, e);
         INIT_LIST_HEAD(e, list);
         LISTP_ADD_TAIL(e, &store->entries, list);
         INIT_LISTP(&e->children);
@@ -86,31 +185,11 @@ static int __add_config(struct config_store* store, const char* key, size_t klen
 }
 
 static struct config* __get_config(struct config_store* store, const char* key) {
-    LISTP_TYPE(config)* list = &store->root;
-    struct config* e         = NULL;
-
-    while (*key) {
-        const char* token = key;
-        size_t len        = 0;
-        for (; token[len]; len++)
-            if (token[len] == '.')
-                break;
-
-        LISTP_FOR_EACH_ENTRY(e, list, siblings) {
-            if (e->klen == len && !memcmp(e->key, token, len))
-                goto next;
-        }
-
+    size_t plen = strlen(key);
+    if (!plen)
         return NULL;
 
-    next:
-        if (token[len])
-            len++;
-        key += len;
-        list = &e->children;
-    }
-
-    return e;
+    return __lookup_config(store, key, plen, __hash_config_key(CONFIG_HASH_INIT, key, plen));
 }
 
 ssize_t get_config(struct config_store* store, const char* key, char* val_buf, size_t buf_size) {
@@ -193,6 +272,7 @@ static int __del_config(struct config_store* store, LISTP_TYPE(config)* root, st
 
     if (p)
         p->vlen -= (found->klen + 1);
+    __unhash_config(store, found);
     LISTP_DEL(found, root, siblings);
     LISTP_DEL(found, &store->entries, list);
     if (found->buf)
@@ -242,6 +322,14 @@ int read_config(struct config_store* store, bool (*filter)(const char* key, size
     INIT_LISTP(&store->root);
     INIT_LISTP(&store->entries);
 
+    /* a rough estimate of the number of entries, assuming ~64 bytes per manifest line */
+    int ret = __init_config_hash(store, store->raw_size / 64);
+    if (ret < 0) {
+        if (errstring)
+            *errstring = "out of memory";
+        return ret;
+    }
+
     char* ptr     = store->raw_data;
     char* ptr_end = store->raw_data + store->raw_size;
 
@@ -341,7 +429,7 @@ int read_config(struct config_store* store, bool (*filter)(const char* key, size
         ptr++;
 
         if (!filter || filter(key, klen)) {
-            int ret = __add_config(store, key, klen, val, vlen, NULL);
+            ret = __add_config(store, key, klen, val, vlen, NULL);
             if (ret < 0) {
                 if (ret == -PAL_ERROR_TOOLONG)
                     GOTO_INVAL("key too long");
@@ -380,109 +468,188 @@ int free_config(struct config_store* store) {
 
     INIT_LISTP(&store->root);
     INIT_LISTP(&store->entries);
+    store->free(store->hash_table);
+    store->hash_table = NULL;
+    store->hash_size  = 0;
+    store->hash_cnt   = 0;
     return 0;
 }
 
-static int __dup_config(const struct config_store* ss, const LISTP_TYPE(config) * sr,
-                        struct config_store* ts, LISTP_TYPE(config) * tr, void** data,
-                        size_t* size) {
+/*
+ * Binary form of a config store: a header, an array of entries in pre-order (every entry comes
+ * after its parent) and a string area. All references are offsets from the beginning of the blob,
+ * so the blob can be copied or mapped at any address. Entries carry their precomputed hashes,
+ * so loading a blob neither parses text nor hashes keys.
+ */
+#define CONFIG_BINARY_MAGIC 0x47464347 /* "GCFG" */
+
+struct config_binary_hdr {
+    uint32_t magic;
+    uint32_t nentries;
+    uint64_t size;
+};
+
+struct config_binary_entry {
+    uint32_t path_off, plen;
+    uint32_t klen;
+    uint32_t val_off, vlen; /* val_off == 0 for branch nodes */
+    uint32_t parent;        /* index of the parent entry plus one, or 0 for top-level entries */
+    uint32_t hash;
+    uint32_t reserved;
+};
+
+static void __write_config_binary(LISTP_TYPE(config)* root, uint32_t parent, void* buf,
+                                  uint32_t* idx, size_t* str_off) {
     struct config* e;
-    struct config* new;
+    LISTP_FOR_EACH_ENTRY(e, root, siblings) {
+        struct config_binary_entry* be =
+            (struct config_binary_entry*)((struct config_binary_hdr*)buf + 1) + *idx;
+        uint32_t this_idx = ++(*idx);
+
+        be->path_off = *str_off;
+        be->plen     = e->plen;
+        be->klen     = e->klen;
+        be->parent   = parent;
+        be->hash     = e->hash;
+        be->reserved = 0;
+        memcpy(buf + *str_off, e->path, e->plen);
+        *str_off += e->plen;
 
-    LISTP_FOR_EACH_ENTRY(e, sr, siblings) {
-        char* key = NULL;
-        char* val = NULL;
-        char* buf = NULL;
-        int need = 0;
-
-        if (e->key) {
-            if (*size > e->klen) {
-                key = *data;
-                *data += e->klen;
-                *size -= e->klen;
-                memcpy(key, e->key, e->klen);
-            } else {
-                need += e->klen;
-            }
-        }
         if (e->val) {
-            if (*size > e->vlen) {
-                val = *data;
-                *data += e->vlen;
-                *size -= e->vlen;
-                memcpy(val, e->val, e->vlen);
-            } else {
-                need += e->vlen;
-            }
+            be->val_off = *str_off;
+            be->vlen    = e->vlen;
+            memcpy(buf + *str_off, e->val, e->vlen);
+            *str_off += e->vlen;
+        } else {
+            be->val_off = 0;
+            be->vlen    = 0;
+            __write_config_binary(&e->children, this_idx, buf, idx, str_off);
         }
+    }
+}
+
+ssize_t write_config_binary(struct config_store* store, void* buf, size_t buf_size) {
+    struct config* e;
+    size_t nentries = 0;
+    size_t strsize  = 0;
+
+    LISTP_FOR_EACH_ENTRY(e, &store->entries, list) {
+        nentries++;
+        strsize += e->plen + (e->val ? e->vlen : 0);
+    }
+
+    size_t size = sizeof(struct config_binary_hdr) +
+                  sizeof(struct config_binary_entry) * nentries + strsize;
+    if (size > UINT32_MAX)
+        return -PAL_ERROR_TOOLONG;
+
+    if (!buf)
+        return size;
+
+    if (buf_size < size)
+        return -PAL_ERROR_TOOLONG;
+
+    struct config_binary_hdr* hdr = buf;
+    hdr->magic    = CONFIG_BINARY_MAGIC;
+    hdr->nentries = nentries;
+    hdr->size     = size;
+
+    uint32_t idx   = 0;
+    size_t str_off = sizeof(struct config_binary_hdr) +
+                     sizeof(struct config_binary_entry) * nentries;
+    __write_config_binary(&store->root, 0, buf, &idx, &str_off);
+
+    assert(idx == nentries && str_off == size);
+    return size;
+}
+
+int read_config_binary(struct config_store* store, const void* data, size_t size) {
+    INIT_LISTP(&store->root);
+    INIT_LISTP(&store->entries);
+    store->hash_table = NULL;
+
+    const struct config_binary_hdr* hdr = data;
+    if (size < sizeof(*hdr) || hdr->magic != CONFIG_BINARY_MAGIC || hdr->size != size ||
+        hdr->nentries > (size - sizeof(*hdr)) / sizeof(struct config_binary_entry))
+        return -PAL_ERROR_INVAL;
+
+    const struct config_binary_entry* entries = (const void*)(hdr + 1);
+    uint32_t nentries = hdr->nentries;
+
+    struct config** nodes = store->malloc(sizeof(struct config*) * (nentries ? : 1));
+    if (!nodes)
+        return -PAL_ERROR_NOMEM;
+
+    int ret = __init_config_hash(store, nentries);
+    if (ret < 0)
+        goto out;
 
-        if (need) {
-            buf = ts->malloc(need);
-            if (!buf)
-                return -PAL_ERROR_NOMEM;
+    for (uint32_t i = 0; i < nentries; i++) {
+        const struct config_binary_entry* be = &entries[i];
+
+        if (be->parent > i || be->klen > be->plen || be->path_off > size ||
+            be->plen > size - be->path_off || be->val_off > size || be->vlen > size - be->val_off) {
+            ret = -PAL_ERROR_INVAL;
+            goto out;
         }
 
-        if (e->key && !key) {
-            key = buf;
-            memcpy(key, e->key, e->klen);
+        struct config* parent = be->parent ? nodes[be->parent - 1] : NULL;
+        if (parent && parent->val) {
+            ret = -PAL_ERROR_INVAL;
+            goto out;
         }
 
-        if (e->val && !val) {
-            val = buf + (key == buf ? e->klen : 0);
-            memcpy(val, e->val, e->vlen);
+        struct config* e = store->malloc(sizeof(struct config));
+        if (!e) {
+            ret = -PAL_ERROR_NOMEM;
+            goto out;
         }
 
-        new = ts->malloc(sizeof(struct config));
-        if (!new)
-            return -PAL_ERROR_NOMEM;
+        e->path = data + be->path_off;
+        e->plen = be->plen;
+        e->key  = e->path + be->plen - be->klen;
+        e->klen = be->klen;
+        e->val  = be->val_off ? data + be->val_off : NULL;
+        e->vlen = be->vlen;
+        e->hash = be->hash;
+        e->buf  = NULL;
+        __hash_config(store, e);
+        INIT_LIST_HEAD(e, list);
+        LISTP_ADD_TAIL(e, &store->entries, list);
+        INIT_LISTP(&e->children);
+        INIT_LIST_HEAD(e, siblings);
+        LISTP_ADD_TAIL(e, parent ? &parent->children : &store->root, siblings);
+        if (parent)
+            parent->vlen += e->klen + 1;
 
-        new->key  = key;
-        new->klen = e->klen;
-        new->val  = val;
-        new->vlen = e->vlen;
-        new->buf  = buf;
-        INIT_LIST_HEAD(new, list);
-        LISTP_ADD_TAIL(new, &ts->entries, list);
-        INIT_LISTP(&new->children);
-        INIT_LIST_HEAD(new, siblings);
-        LISTP_ADD_TAIL(new, tr, siblings);
-
-        if (!LISTP_EMPTY(&e->children)) {
-            int ret = __dup_config(ss, &e->children, ts, &new->children, data, size);
-            if (ret < 0)
-                return ret;
-        }
+        nodes[i] = e;
     }
 
-    return 0;
+    store->raw_data = (void*)data;
+    store->raw_size = size;
+    ret = 0;
+out:
+    if (store->free)
+        store->free(nodes);
+    if (ret < 0 && store->free)
+        free_config(store);
+    return ret;
 }
 
 int copy_config(struct config_store* store, struct config_store* new_store) {
-    INIT_LISTP(&new_store->root);
-    INIT_LISTP(&new_store->entries);
-
-    struct config* e;
-    size_t size = 0;
-
-    LISTP_FOR_EACH_ENTRY(e, &store->entries, list) {
-        if (e->key)
-            size += e->klen;
-        if (e->val)
-            size += e->vlen;
-    }
+    ssize_t size = write_config_binary(store, NULL, 0);
+    if (size < 0)
+        return size;
 
     void* data = new_store->malloc(size);
-
     if (!data)
         return -PAL_ERROR_NOMEM;
 
-    void* dataptr = data;
-    size_t datasz = size;
-
-    new_store->raw_data = data;
-    new_store->raw_size = size;
+    size = write_config_binary(store, data, size);
+    if (size < 0)
+        return size;
 
-    return __dup_config(store, &store->root, new_store, &new_store->root, &dataptr, &datasz);
+    return read_config_binary(new_store, data, size);
 }
 
 static int __write_config(void* f, int (*write)(void*, void*, int), struct config_store* store,
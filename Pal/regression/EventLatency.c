@@ -0,0 +1,117 @@
+/* Measures the latency of PAL events and mutexes: setting events nobody waits on, uncontended
+ * mutex acquisitions, and handoffs between two threads through synchronization events and through
+ * a contended mutex. */
+
+#include "pal.h"
+#include "pal_debug.h"
+
+#define ROUNDS 20000
+
+static PAL_HANDLE ping;
+static PAL_HANDLE pong;
+static PAL_HANDLE mutex;
+static PAL_HANDLE done;
+
+static volatile int counter = 0;
+
+static int pong_thread(void* args) {
+    for (int i = 0; i < ROUNDS; i++) {
+        DkSynchronizationObjectWait(ping, NO_TIMEOUT);
+        DkEventSet(pong);
+    }
+    DkEventSet(done);
+    DkThreadExit(/*clear_child_tid=*/NULL);
+    /* UNREACHABLE */
+}
+
+static int mutex_thread(void* args) {
+    for (int i = 0; i < ROUNDS; i++) {
+        DkSynchronizationObjectWait(mutex, NO_TIMEOUT);
+        counter++;
+        DkMutexRelease(mutex);
+    }
+    DkEventSet(done);
+    DkThreadExit(/*clear_child_tid=*/NULL);
+    /* UNREACHABLE */
+}
+
+static void report(const char* what, uint64_t start, int ops) {
+    uint64_t us = DkSystemTimeQuery() - start;
+    pal_printf("%s: %d operations in %lu us (%lu ns each)\n", what, ops, us, us * 1000 / ops);
+}
+
+int main(int argc, char** argv) {
+    ping  = DkSynchronizationEventCreate(PAL_FALSE);
+    pong  = DkSynchronizationEventCreate(PAL_FALSE);
+    mutex = DkMutexCreate(0);
+    done  = DkNotificationEventCreate(PAL_FALSE);
+    if (!ping || !pong || !mutex || !done) {
+        pal_printf("Creating events or mutex failed\n");
+        return 1;
+    }
+
+    /* nobody waits on these, so no wakeup is needed */
+    uint64_t start = DkSystemTimeQuery();
+    for (int i = 0; i < ROUNDS; i++)
+        DkEventSet(done);
+    DkEventClear(done);
+    report("Notification event set without waiters", start, ROUNDS);
+
+    start = DkSystemTimeQuery();
+    for (int i = 0; i < ROUNDS; i++)
+        DkEventSet(ping);
+    report("Synchronization event set without waiters", start, ROUNDS);
+
+    /* a synchronization event stays signaled until a single wait consumes it */
+    if (!DkSynchronizationObjectWait(ping, 0) || DkSynchronizationObjectWait(ping, 0)) {
+        pal_printf("Synchronization event was not reset by a single wait\n");
+        return 1;
+    }
+    pal_printf("Synchronization event reset OK\n");
+
+    start = DkSystemTimeQuery();
+    for (int i = 0; i < ROUNDS; i++) {
+        DkSynchronizationObjectWait(mutex, NO_TIMEOUT);
+        DkMutexRelease(mutex);
+    }
+    report("Uncontended mutex lock and unlock", start, ROUNDS);
+
+    /* the events may be set before the other thread waits on them, which must not lose wakeups */
+    if (!DkThreadCreate(pong_thread, NULL)) {
+        pal_printf("DkThreadCreate failed\n");
+        return 1;
+    }
+    start = DkSystemTimeQuery();
+    for (int i = 0; i < ROUNDS; i++) {
+        DkEventSet(ping);
+        DkSynchronizationObjectWait(pong, NO_TIMEOUT);
+    }
+    report("Synchronization event handoff", start, 2 * ROUNDS);
+    DkSynchronizationObjectWait(done, NO_TIMEOUT);
+    DkEventClear(done);
+    pal_printf("Event handoff OK\n");
+
+    if (!DkThreadCreate(mutex_thread, NULL)) {
+        pal_printf("DkThreadCreate failed\n");
+        return 1;
+    }
+    start = DkSystemTimeQuery();
+    for (int i = 0; i < ROUNDS; i++) {
+        DkSynchronizationObjectWait(mutex, NO_TIMEOUT);
+        counter++;
+        DkMutexRelease(mutex);
+    }
+    DkSynchronizationObjectWait(done, NO_TIMEOUT);
+    report("Contended mutex lock and unlock", start, 2 * ROUNDS);
+    if (counter != 2 * ROUNDS) {
+        pal_printf("Contended mutex lost updates (%d instead of %d)\n", counter, 2 * ROUNDS);
+        return 1;
+    }
+    pal_printf("Contended mutex OK\n");
+
+    DkObjectClose(ping);
+    DkObjectClose(pong);
+    DkObjectClose(mutex);
+    DkObjectClose(done);
+    return 0;
+}
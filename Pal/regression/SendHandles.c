@@ -0,0 +1,68 @@
+#include "api.h"
+#include "pal.h"
+#include "pal_debug.h"
+
+/* more than one batch of DkSendHandles(), so that the receiver fails after it got the first one */
+#define SENT_HANDLES 200
+
+int main(int argc, char** argv) {
+    PAL_HANDLE handles[SENT_HANDLES];
+
+    if (argc == 2 && !memcmp(argv[1], "Child", 6)) {
+        /* the last batch does not match what the parent sent */
+        if (DkReceiveHandles(pal_control.parent_process, handles, SENT_HANDLES - 1)) {
+            pal_printf("Receiving a mismatched batch succeeded\n");
+        } else {
+            bool all_null = true;
+            for (int i = 0; i < SENT_HANDLES - 1; i++)
+                if (handles[i])
+                    all_null = false;
+            if (all_null)
+                pal_printf("Receive Handles failed without returning handles\n");
+        }
+
+        /* tell the parent that the handles are gone, then stay alive while it checks */
+        DkStreamWrite(pal_control.parent_process, 0, 1, "x", NULL);
+        DkThreadDelayExecution(3000000);
+        return 0;
+    }
+
+    PAL_HANDLE srv = DkStreamOpen("pipe.srv:SendHandles", PAL_ACCESS_RDWR, 0, 0, 0);
+    if (!srv)
+        return 1;
+    PAL_HANDLE writer = DkStreamOpen("pipe:SendHandles", PAL_ACCESS_RDWR, 0, 0, 0);
+    if (!writer)
+        return 1;
+    PAL_HANDLE reader = DkStreamWaitForClient(srv);
+    if (!reader)
+        return 1;
+
+    const char* args[3] = {"SendHandles", "Child", NULL};
+    PAL_HANDLE child = DkProcessCreate("file:SendHandles", args);
+    if (!child)
+        return 1;
+
+    /* only the first batch holds the writer; the batch which the child does not receive stays in
+     * the stream and must not keep the pipe open */
+    handles[0] = writer;
+    for (int i = 1; i < SENT_HANDLES; i++)
+        handles[i] = srv;
+    if (DkSendHandles(child, handles, SENT_HANDLES))
+        pal_printf("Send Handles OK\n");
+    DkObjectClose(writer);
+    DkObjectClose(srv);
+
+    char c;
+    if (DkStreamRead(child, 0, 1, &c, NULL, 0) != 1)
+        return 1;
+
+    /* the child closed its copies of the writer, so the pipe reports the end of the stream */
+    PAL_FLG events = PAL_WAIT_READ;
+    PAL_FLG ret_events = 0;
+    if (DkStreamsWaitEvents(1, &reader, &events, &ret_events, 0))
+        pal_printf("Failed batch released the received handles\n");
+
+    DkObjectClose(reader);
+    DkObjectClose(child);
+    return 0;
+}
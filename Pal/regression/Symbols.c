@@ -14,25 +14,40 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkVirtualMemoryAlloc);
     PRINT_SYMBOL(DkVirtualMemoryFree);
     PRINT_SYMBOL(DkVirtualMemoryProtect);
+    PRINT_SYMBOL(DkVirtualMemoryMove);
+    PRINT_SYMBOL(DkVirtualMemoryDiscard);
 
     PRINT_SYMBOL(DkProcessCreate);
     PRINT_SYMBOL(DkProcessExit);
 
     PRINT_SYMBOL(DkStreamOpen);
     PRINT_SYMBOL(DkStreamWaitForClient);
+    PRINT_SYMBOL(DkStreamOpenPipe);
     PRINT_SYMBOL(DkStreamRead);
     PRINT_SYMBOL(DkStreamWrite);
+    PRINT_SYMBOL(DkStreamReadV);
+    PRINT_SYMBOL(DkStreamWriteV);
+    PRINT_SYMBOL(DkStreamSendTo);
+    PRINT_SYMBOL(DkStreamRecvFrom);
     PRINT_SYMBOL(DkStreamDelete);
     PRINT_SYMBOL(DkStreamMap);
     PRINT_SYMBOL(DkStreamUnmap);
     PRINT_SYMBOL(DkStreamSetLength);
+    PRINT_SYMBOL(DkStreamsBatchIo);
+    PRINT_SYMBOL(DkStreamSplice);
     PRINT_SYMBOL(DkStreamFlush);
+    PRINT_SYMBOL(DkStreamAllocate);
+    PRINT_SYMBOL(DkStreamAdvise);
+    PRINT_SYMBOL(DkStreamFlushRange);
     PRINT_SYMBOL(DkSendHandle);
     PRINT_SYMBOL(DkReceiveHandle);
+    PRINT_SYMBOL(DkSendHandles);
+    PRINT_SYMBOL(DkReceiveHandles);
     PRINT_SYMBOL(DkStreamAttributesQuery);
     PRINT_SYMBOL(DkStreamAttributesQueryByHandle);
     PRINT_SYMBOL(DkStreamAttributesSetByHandle);
     PRINT_SYMBOL(DkStreamGetName);
+    PRINT_SYMBOL(DkStreamGetSockAddr);
     PRINT_SYMBOL(DkStreamChangeName);
     PRINT_SYMBOL(DkStreamsWaitEvents);
 
@@ -41,6 +56,9 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkThreadYieldExecution);
     PRINT_SYMBOL(DkThreadExit);
     PRINT_SYMBOL(DkThreadResume);
+    PRINT_SYMBOL(DkThreadSetCpuAffinity);
+    PRINT_SYMBOL(DkThreadGetCpuAffinity);
+    PRINT_SYMBOL(DkThreadGetCpu);
 
     PRINT_SYMBOL(DkSetExceptionHandler);
     PRINT_SYMBOL(DkExceptionReturn);
@@ -52,6 +70,8 @@ int main(int argc, char** argv, char** envp) {
     PRINT_SYMBOL(DkEventSet);
     PRINT_SYMBOL(DkEventClear);
     PRINT_SYMBOL(DkSynchronizationObjectWait);
+    PRINT_SYMBOL(DkFutexWait);
+    PRINT_SYMBOL(DkFutexWake);
 
     PRINT_SYMBOL(DkObjectClose);
 
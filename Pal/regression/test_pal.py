@@ -252,29 +252,47 @@ class TC_02_Symbols(RegressionTestCase):
         'DkVirtualMemoryAlloc',
         'DkVirtualMemoryFree',
         'DkVirtualMemoryProtect',
+        'DkVirtualMemoryMove',
+        'DkVirtualMemoryDiscard',
         'DkProcessCreate',
         'DkProcessExit',
         'DkStreamOpen',
         'DkStreamWaitForClient',
+        'DkStreamOpenPipe',
         'DkStreamRead',
         'DkStreamWrite',
+        'DkStreamReadV',
+        'DkStreamWriteV',
+        'DkStreamSendTo',
+        'DkStreamRecvFrom',
         'DkStreamDelete',
         'DkStreamMap',
         'DkStreamUnmap',
         'DkStreamSetLength',
+        'DkStreamsBatchIo',
+        'DkStreamSplice',
         'DkStreamFlush',
+        'DkStreamAllocate',
+        'DkStreamAdvise',
+        'DkStreamFlushRange',
         'DkSendHandle',
         'DkReceiveHandle',
+        'DkSendHandles',
+        'DkReceiveHandles',
         'DkStreamAttributesQuery',
         'DkStreamAttributesQueryByHandle',
         'DkStreamAttributesSetByHandle',
         'DkStreamGetName',
+        'DkStreamGetSockAddr',
         'DkStreamChangeName',
         'DkThreadCreate',
         'DkThreadDelayExecution',
         'DkThreadYieldExecution',
         'DkThreadExit',
         'DkThreadResume',
+        'DkThreadSetCpuAffinity',
+        'DkThreadGetCpuAffinity',
+        'DkThreadGetCpu',
         'DkSetExceptionHandler',
         'DkExceptionReturn',
         'DkMutexCreate',
@@ -284,6 +302,8 @@ class TC_02_Symbols(RegressionTestCase):
         'DkEventSet',
         'DkEventClear',
         'DkSynchronizationObjectWait',
+        'DkFutexWait',
+        'DkFutexWake',
         'DkStreamsWaitEvents',
         'DkObjectClose',
         'DkSystemTimeQuery',
@@ -471,6 +491,12 @@ class TC_20_SingleProcess(RegressionTestCase):
         self.assertIn('Wait with too short timeout ok.', stderr)
         self.assertIn('Wait with long enough timeout ok.', stderr)
 
+    def test_201_event_latency(self):
+        _, stderr = self.run_binary(['EventLatency'])
+        self.assertIn('Synchronization event reset OK', stderr)
+        self.assertIn('Event handoff OK', stderr)
+        self.assertIn('Contended mutex OK', stderr)
+
     def test_210_semaphore(self):
         _, stderr = self.run_binary(['Semaphore'])
 
@@ -680,6 +706,13 @@ class TC_23_SendHandle(RegressionTestCase):
         # Send File Handle
         self.assertEqual(counter['Receive File Handle: Hello World'], 1)
 
+    @unittest.skipIf(HAS_SGX, 'SGX PAL sends handles one by one, without batches')
+    def test_010_send_handles_failed_batch(self):
+        _, stderr = self.run_binary(['SendHandles'])
+        self.assertIn('Send Handles OK', stderr)
+        self.assertIn('Receive Handles failed without returning handles', stderr)
+        self.assertIn('Failed batch released the received handles', stderr)
+
 @unittest.skipUnless(HAS_SGX, 'This test is only meaningful on SGX PAL')
 class TC_50_Attestation(RegressionTestCase):
     def test_000_attestation_report(self):
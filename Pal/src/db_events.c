@@ -90,3 +90,46 @@ void DkEventClear(PAL_HANDLE handle) {
 
     LEAVE_PAL_CALL();
 }
+
+PAL_BOL DkFutexWait(PAL_PTR addr, PAL_NUM val, PAL_NUM timeout_us, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkFutexWait);
+
+    if (!addr || !IS_ALIGNED_PTR(addr, sizeof(uint32_t)) || val > UINT32_MAX ||
+            !WITHIN_MASK(flags, PAL_FUTEX_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int64_t timeout = timeout_us == NO_TIMEOUT ? -1 : (int64_t)timeout_us;
+    int ret = _DkFutexWait((uint32_t*)addr, (uint32_t)val, timeout, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL DkFutexWake(PAL_PTR addr, PAL_NUM count, PAL_FLG flags, PAL_NUM* woken) {
+    ENTER_PAL_CALL(DkFutexWake);
+
+    if (!addr || !IS_ALIGNED_PTR(addr, sizeof(uint32_t)) || !WITHIN_MASK(flags, PAL_FUTEX_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (count > INT32_MAX)
+        count = INT32_MAX;
+
+    int ret = _DkFutexWake((uint32_t*)addr, (uint32_t)count, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (woken)
+        *woken = ret;
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
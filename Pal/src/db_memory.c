@@ -93,3 +93,69 @@ DkVirtualMemoryProtect(PAL_PTR addr, PAL_NUM size, PAL_FLG prot) {
 
     LEAVE_PAL_CALL_RETURN(PAL_TRUE);
 }
+
+PAL_BOL
+DkVirtualMemoryMove(PAL_PTR old_addr, PAL_NUM old_size, PAL_PTR new_addr, PAL_NUM new_size) {
+    ENTER_PAL_CALL(DkVirtualMemoryMove);
+
+    if (!old_addr || !old_size || !new_addr || !new_size) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (!IS_ALLOC_ALIGNED_PTR(old_addr) || !IS_ALLOC_ALIGNED(old_size) ||
+            !IS_ALLOC_ALIGNED_PTR(new_addr) || !IS_ALLOC_ALIGNED(new_size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if ((void*)old_addr < (void*)new_addr + new_size &&
+            (void*)new_addr < (void*)old_addr + old_size) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (_DkCheckMemoryMappable((void*)old_addr, old_size) ||
+            _DkCheckMemoryMappable((void*)new_addr, new_size)) {
+        _DkRaiseFailure(PAL_ERROR_DENIED);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryMove((void*)old_addr, old_size, (void*)new_addr, new_size);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL
+DkVirtualMemoryDiscard(PAL_PTR addr, PAL_NUM size) {
+    ENTER_PAL_CALL(DkVirtualMemoryDiscard);
+
+    if (!addr || !size) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (!IS_ALLOC_ALIGNED_PTR(addr) || !IS_ALLOC_ALIGNED(size)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (_DkCheckMemoryMappable((void*)addr, size)) {
+        _DkRaiseFailure(PAL_ERROR_DENIED);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkVirtualMemoryDiscard((void*)addr, size);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
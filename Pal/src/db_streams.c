@@ -213,6 +213,24 @@ DkStreamWaitForClient(PAL_HANDLE handle) {
     LEAVE_PAL_CALL_RETURN(client);
 }
 
+PAL_BOL
+DkStreamOpenPipe(PAL_HANDLE* read_end, PAL_HANDLE* write_end, PAL_FLG options) {
+    ENTER_PAL_CALL(DkStreamOpenPipe);
+
+    if (!read_end || !write_end || !WITHIN_MASK(options, PAL_OPTION_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkStreamOpenPipe(read_end, write_end, options);
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
 /* _DkStreamDelete for internal use. This function will explicit delete
    the stream. For example, file will be deleted, socket witll be
    disconnected, etc */
@@ -347,6 +365,268 @@ DkStreamWrite(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM count, PAL_PTR buffer,
     LEAVE_PAL_CALL_RETURN(ret);
 }
 
+/* _DkStreamReadV for internal use, read into multiple buffers at absolute
+   offset. Streams without a 'readv' operation get one read per buffer */
+int64_t _DkStreamReadV(PAL_HANDLE handle, uint64_t offset, PAL_IOVEC* iov, uint64_t iov_count,
+                       int flags) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    int64_t ret;
+
+    if (ops->readv) {
+        ret = ops->readv(handle, offset, iov, iov_count, flags);
+        return ret ? ret : -PAL_ERROR_ENDOFSTREAM;
+    }
+
+    if (!ops->read || flags)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    uint64_t bytes = 0;
+    for (uint64_t i = 0; i < iov_count; i++) {
+        if (!iov[i].size)
+            continue;
+
+        ret = ops->read(handle, offset + bytes, iov[i].size, iov[i].buffer);
+        if (ret < 0) {
+            if (bytes)
+                break;
+            return ret;
+        }
+
+        bytes += ret;
+        if ((uint64_t)ret < iov[i].size)
+            break;
+    }
+
+    return bytes ? (int64_t)bytes : -PAL_ERROR_ENDOFSTREAM;
+}
+
+/* PAL call DkStreamReadV: Read into multiple buffers at absolute offset. Return number of bytes
+   if succeeded, or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM DkStreamReadV(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* iov, PAL_NUM iov_count,
+                      PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamReadV);
+
+    if (!handle || (!iov && iov_count) || !WITHIN_MASK(flags, PAL_RW_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamReadV(handle, offset, iov, iov_count, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* _DkStreamWriteV for internal use, write from multiple buffers at absolute
+   offset. Streams without a 'writev' operation get one write per buffer */
+int64_t _DkStreamWriteV(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* iov,
+                        uint64_t iov_count, int flags) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    int64_t ret;
+
+    if (ops->writev) {
+        ret = ops->writev(handle, offset, iov, iov_count, flags);
+        return ret ? ret : -PAL_ERROR_ENDOFSTREAM;
+    }
+
+    if (!ops->write || flags)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    uint64_t bytes = 0;
+    for (uint64_t i = 0; i < iov_count; i++) {
+        if (!iov[i].size)
+            continue;
+
+        ret = ops->write(handle, offset + bytes, iov[i].size, iov[i].buffer);
+        if (ret < 0) {
+            if (bytes)
+                break;
+            return ret;
+        }
+
+        bytes += ret;
+        if ((uint64_t)ret < iov[i].size)
+            break;
+    }
+
+    return bytes ? (int64_t)bytes : -PAL_ERROR_ENDOFSTREAM;
+}
+
+/* PAL call DkStreamWriteV: Write from multiple buffers at absolute offset. Return number of bytes
+   if succeeded, or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM DkStreamWriteV(PAL_HANDLE handle, PAL_NUM offset, PAL_IOVEC* iov, PAL_NUM iov_count,
+                       PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamWriteV);
+
+    if (!handle || (!iov && iov_count) || !WITHIN_MASK(flags, PAL_RW_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamWriteV(handle, offset, iov, iov_count, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* _DkStreamSendTo for internal use, send multiple buffers to a host socket address with PAL_MSG
+   flags. Streams without a 'sendto' operation get a plain write of the buffers, which can only
+   ignore PAL_MSG_MORE */
+int64_t _DkStreamSendTo(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                        const void* addr, size_t addrlen, int flags) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (ops->sendto)
+        return ops->sendto(handle, iov, iov_count, addr, addrlen, flags);
+
+    if (addr || (flags & ~PAL_MSG_MORE))
+        return -PAL_ERROR_NOTSUPPORT;
+
+    /* sending nothing on a stream succeeds, while a write of no bytes means the end of stream */
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < iov_count; i++)
+        count += iov[i].size;
+    if (!count)
+        return 0;
+
+    return _DkStreamWriteV(handle, 0, iov, iov_count, /*flags=*/0);
+}
+
+/* PAL call DkStreamSendTo: Send to a host socket address with PAL_MSG flags. Return number of
+   bytes if succeeded, or PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM DkStreamSendTo(PAL_HANDLE handle, PAL_IOVEC* iov, PAL_NUM iov_count, PAL_PTR addr,
+                       PAL_NUM addrlen, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamSendTo);
+
+    if (!handle || (!iov && iov_count) || (!addr && addrlen)
+            || !WITHIN_MASK(flags, PAL_MSG_SEND_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamSendTo(handle, iov, iov_count, addr, addrlen, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* _DkStreamRecvFrom for internal use, receive with PAL_MSG flags and return the host socket
+   address of the sender. Streams without a 'recvfrom' operation get a plain 'read' */
+int64_t _DkStreamRecvFrom(PAL_HANDLE handle, void* buf, uint64_t count, void* addr,
+                          size_t* addrlen, int flags) {
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (ops->recvfrom)
+        return ops->recvfrom(handle, buf, count, addr, addrlen, flags);
+
+    if (!ops->read || addr || flags)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->read(handle, 0, count, buf);
+}
+
+/* PAL call DkStreamRecvFrom: Receive with PAL_MSG flags and return the host socket address of the
+   sender. Return number of bytes if succeeded, or PAL_STREAM_ERROR for failure. Error code is
+   notified. */
+PAL_NUM DkStreamRecvFrom(PAL_HANDLE handle, PAL_PTR buffer, PAL_NUM count, PAL_PTR addr,
+                         PAL_NUM* addrlen, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamRecvFrom);
+
+    if (!handle || !buffer || (addr && !addrlen) || !WITHIN_MASK(flags, PAL_MSG_RECV_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    size_t len = addr ? *addrlen : 0;
+    int64_t ret = _DkStreamRecvFrom(handle, buffer, count, addr, addr ? &len : NULL, flags);
+
+    if (ret == -PAL_ERROR_ENDOFSTREAM) {
+        ret = 0;
+    } else if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    } else if (addr) {
+        *addrlen = len;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
+/* PAL call DkStreamsBatchIo: Read and write at absolute offsets for a batch of requests. Return
+   PAL_TRUE if all requests were processed (each one carries its own result). */
+PAL_BOL DkStreamsBatchIo(PAL_IO_REQUEST* reqs, PAL_NUM count) {
+    ENTER_PAL_CALL(DkStreamsBatchIo);
+
+    if (!reqs || !count) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    for (PAL_NUM i = 0; i < count; i++) {
+        if (!reqs[i].handle || !reqs[i].buffer
+                || (reqs[i].op != PAL_IO_READ && reqs[i].op != PAL_IO_WRITE)) {
+            _DkRaiseFailure(PAL_ERROR_INVAL);
+            LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+        }
+    }
+
+    int ret = _DkStreamsBatchIo(reqs, count);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+/* PAL call DkStreamSplice: Move data from one stream to another. Return number of bytes moved or
+   PAL_STREAM_ERROR for failure. Error code is notified. */
+PAL_NUM DkStreamSplice(PAL_HANDLE src, PAL_NUM src_offset, PAL_HANDLE dst, PAL_NUM dst_offset,
+                       PAL_NUM count, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamSplice);
+
+    if (!src || !dst || !WITHIN_MASK(flags, PAL_SPLICE_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_STREAM_ERROR);
+    }
+
+    int64_t ret = _DkStreamSplice(src, src_offset, dst, dst_offset, count, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        ret = PAL_STREAM_ERROR;
+    }
+
+    LEAVE_PAL_CALL_RETURN(ret);
+}
+
 /* _DkStreamAttributesQuery of internal use. The function query attribute
    of streams by their URI */
 int _DkStreamAttributesQuery(const char* uri, PAL_STREAM_ATTR* attr) {
@@ -495,6 +775,40 @@ PAL_NUM DkStreamGetName(PAL_HANDLE handle, PAL_PTR buffer, PAL_NUM size) {
     LEAVE_PAL_CALL_RETURN(ret);
 }
 
+/* PAL call DkStreamGetSockAddr: Copy the local or peer host socket address of a socket into
+ * buffer. Return PAL_TRUE if succeeded. Error code is notified */
+PAL_BOL DkStreamGetSockAddr(PAL_HANDLE handle, PAL_FLG which, PAL_PTR addr, PAL_NUM* addrlen) {
+    ENTER_PAL_CALL(DkStreamGetSockAddr);
+
+    if (!handle || !addr || !addrlen
+            || (which != PAL_SOCKADDR_LOCAL && which != PAL_SOCKADDR_PEER)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+    if (!ops) {
+        _DkRaiseFailure(PAL_ERROR_BADHANDLE);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    if (!ops->getsockaddr) {
+        _DkRaiseFailure(PAL_ERROR_NOTSUPPORT);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    size_t len = *addrlen;
+    int ret = ops->getsockaddr(handle, which, addr, &len);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    *addrlen = len;
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
 /* _DkStreamMap for internal use. Map specific handle to certain memory,
    with given protection, offset and size */
 int _DkStreamMap(PAL_HANDLE handle, void** paddr, int prot, uint64_t offset, uint64_t size) {
@@ -650,6 +964,119 @@ PAL_BOL DkStreamFlush(PAL_HANDLE handle) {
     LEAVE_PAL_CALL_RETURN(PAL_TRUE);
 }
 
+/* _DkStreamAllocate for internal use. This function allocates or deallocates
+   the storage of a byte range of a file. */
+int _DkStreamAllocate(PAL_HANDLE handle, int mode, uint64_t offset, uint64_t length) {
+    if (UNKNOWN_HANDLE(handle))
+        return -PAL_ERROR_BADHANDLE;
+
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->allocate)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->allocate(handle, mode, offset, length);
+}
+
+/* PAL call DkStreamAllocate: Allocate the storage of a byte range of a
+   file. Return TRUE if succeeded or FALSE if failed. Error code is notified. */
+PAL_BOL DkStreamAllocate(PAL_HANDLE handle, PAL_FLG mode, PAL_NUM offset, PAL_NUM length) {
+    ENTER_PAL_CALL(DkStreamAllocate);
+
+    if (!handle || !length || !WITHIN_MASK(mode, PAL_FALLOCATE_MASK) ||
+            ((mode & PAL_FALLOCATE_PUNCH_HOLE) && !(mode & PAL_FALLOCATE_KEEP_SIZE)) ||
+            offset + length < offset) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkStreamAllocate(handle, mode, offset, length);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+/* _DkStreamAdvise for internal use. This function passes an access pattern
+   of a byte range to the host. */
+int _DkStreamAdvise(PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice) {
+    if (UNKNOWN_HANDLE(handle))
+        return -PAL_ERROR_BADHANDLE;
+
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->advise)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->advise(handle, offset, length, advice);
+}
+
+/* PAL call DkStreamAdvise: Announce an access pattern of a byte range of a
+   file. Return TRUE if succeeded or FALSE if failed. Error code is notified. */
+PAL_BOL DkStreamAdvise(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG advice) {
+    ENTER_PAL_CALL(DkStreamAdvise);
+
+    if (!handle || advice >= PAL_ADVICE_BOUND) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkStreamAdvise(handle, offset, length, advice);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+/* _DkStreamFlushRange for internal use. This function writes back a byte
+   range of a file. */
+int _DkStreamFlushRange(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    if (UNKNOWN_HANDLE(handle))
+        return -PAL_ERROR_BADHANDLE;
+
+    const struct handle_ops* ops = HANDLE_OPS(handle);
+
+    if (!ops)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!ops->flushrange)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    return ops->flushrange(handle, offset, length, flags);
+}
+
+/* PAL call DkStreamFlushRange: Write back a byte range of a file. Return
+   TRUE if succeeded or FALSE if failed. Error code is notified. */
+PAL_BOL DkStreamFlushRange(PAL_HANDLE handle, PAL_NUM offset, PAL_NUM length, PAL_FLG flags) {
+    ENTER_PAL_CALL(DkStreamFlushRange);
+
+    if (!handle || !WITHIN_MASK(flags, PAL_FLUSH_RANGE_MASK)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    int ret = _DkStreamFlushRange(handle, offset, length, flags);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
 /* PAL call DkSendHandle: Write to a process handle.
    Return TRUE on success and FALSE on failure */
 PAL_BOL DkSendHandle(PAL_HANDLE handle, PAL_HANDLE cargo) {
@@ -709,6 +1136,51 @@ PAL_HANDLE DkReceiveHandle(PAL_HANDLE handle) {
     LEAVE_PAL_CALL_RETURN(cargo);
 }
 
+PAL_BOL DkSendHandles(PAL_HANDLE handle, PAL_HANDLE* cargo, PAL_NUM count) {
+    ENTER_PAL_CALL(DkSendHandles);
+
+    if (!handle || (count && !cargo)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    for (PAL_NUM i = 0; i < count; i++)
+        if (!cargo[i]) {
+            _DkRaiseFailure(PAL_ERROR_INVAL);
+            LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+        }
+
+    int ret = _DkSendHandles(handle, cargo, count);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
+PAL_BOL DkReceiveHandles(PAL_HANDLE handle, PAL_HANDLE* cargo, PAL_NUM count) {
+    ENTER_PAL_CALL(DkReceiveHandles);
+
+    if (!handle || (count && !cargo)) {
+        _DkRaiseFailure(PAL_ERROR_INVAL);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    for (PAL_NUM i = 0; i < count; i++)
+        cargo[i] = NULL;
+
+    int ret = _DkReceiveHandles(handle, cargo, count);
+
+    if (ret < 0) {
+        _DkRaiseFailure(-ret);
+        LEAVE_PAL_CALL_RETURN(PAL_FALSE);
+    }
+
+    LEAVE_PAL_CALL_RETURN(PAL_TRUE);
+}
+
 PAL_BOL DkStreamChangeName(PAL_HANDLE hdl, PAL_STR uri) {
     ENTER_PAL_CALL(DkStreamChangeName);
 
@@ -36,6 +36,13 @@ int _DkEventCreate(PAL_HANDLE* event, bool initialState, bool isnotification) {
     return 0;
 }
 
+/*
+ * Both kinds of events keep `signaled` set until it is consumed: a notification event until it is
+ * cleared, a synchronization event until a single waiter takes it. Waiters are counted in
+ * `nwaiters` before they check `signaled`, and setters check `nwaiters` after setting it, so the
+ * FUTEX_WAKE ocall is skipped whenever nobody can be sleeping on the event.
+ */
+
 int _DkEventSet(PAL_HANDLE event, int wakeup) {
     int ret = 0;
 
@@ -43,7 +50,7 @@ int _DkEventSet(PAL_HANDLE event, int wakeup) {
         // Leave it signaled, wake all
         uint32_t t = 0;
         if (__atomic_compare_exchange_n(event->event.signaled, &t, 1, /*weak=*/false,
-                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
             int nwaiters = __atomic_load_n(&event->event.nwaiters.counter, __ATOMIC_SEQ_CST);
             if (nwaiters) {
                 if (wakeup != -1 && nwaiters > wakeup)
@@ -58,71 +65,53 @@ int _DkEventSet(PAL_HANDLE event, int wakeup) {
             }
         }
     } else {
-        // Only one thread wakes up, leave unsignaled
-        ret = ocall_futex(event->event.signaled, FUTEX_WAKE, 1, -1);
-        if (IS_ERR(ret))
-            return unix_to_pal_error(ERRNO(ret));
+        // Leave it signaled until one thread takes it, wake one if there is a waiter
+        __atomic_store_n(event->event.signaled, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&event->event.nwaiters.counter, __ATOMIC_SEQ_CST)) {
+            ret = ocall_futex(event->event.signaled, FUTEX_WAKE, 1, -1);
+            if (IS_ERR(ret))
+                return unix_to_pal_error(ERRNO(ret));
+        }
     }
 
     return ret;
 }
 
-int _DkEventWaitTimeout(PAL_HANDLE event, int64_t timeout_us) {
-    int ret = 0;
+/* Returns true if the event is signaled; a synchronization event is reset at the same time. */
+static bool event_consume(PAL_HANDLE event) {
+    if (event->event.isnotification)
+        return __atomic_load_n(event->event.signaled, __ATOMIC_SEQ_CST);
 
-    if (timeout_us < 0)
-        return _DkEventWait(event);
+    uint32_t t = 1;
+    return __atomic_compare_exchange_n(event->event.signaled, &t, 0, /*weak=*/false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
 
-    if (!event->event.isnotification ||
-        !__atomic_load_n(event->event.signaled, __ATOMIC_SEQ_CST)) {
+int _DkEventWaitTimeout(PAL_HANDLE event, int64_t timeout_us) {
+    int ret = 0;
 
-        __atomic_add_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
+    if (event_consume(event))
+        return 0;
 
-        do {
-            ret = ocall_futex(event->event.signaled, FUTEX_WAIT, 0, timeout_us);
+    __atomic_add_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
 
-            if (IS_ERR(ret)) {
-                if (ERRNO(ret) == EWOULDBLOCK) {
-                    ret = 0;
-                } else {
-                    ret = unix_to_pal_error(ERRNO(ret));
-                    break;
-                }
-            }
-        } while (event->event.isnotification &&
-                 !__atomic_load_n(event->event.signaled, __ATOMIC_SEQ_CST));
+    while (!event_consume(event)) {
+        ret = ocall_futex(event->event.signaled, FUTEX_WAIT, 0, timeout_us);
 
-        __atomic_sub_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
+        if (IS_ERR(ret) && ERRNO(ret) != EWOULDBLOCK) {
+            ret = unix_to_pal_error(ERRNO(ret));
+            break;
+        }
+        ret = 0;
     }
 
+    __atomic_sub_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
+
     return ret;
 }
 
 int _DkEventWait(PAL_HANDLE event) {
-    int ret = 0;
-
-    if (!event->event.isnotification ||
-        !__atomic_load_n(event->event.signaled, __ATOMIC_SEQ_CST)) {
-
-        __atomic_add_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
-
-        do {
-            ret = ocall_futex(event->event.signaled, FUTEX_WAIT, 0, -1);
-            if (IS_ERR(ret)) {
-                if (ERRNO(ret) == EWOULDBLOCK) {
-                    ret = 0;
-                } else {
-                    ret = unix_to_pal_error(ERRNO(ret));
-                    break;
-                }
-            }
-        } while (event->event.isnotification &&
-                 !__atomic_load_n(event->event.signaled, __ATOMIC_SEQ_CST));
-
-        __atomic_sub_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
-    }
-
-    return ret;
+    return _DkEventWaitTimeout(event, -1);
 }
 
 int _DkEventClear(PAL_HANDLE event) {
@@ -130,6 +119,34 @@ int _DkEventClear(PAL_HANDLE event) {
     return 0;
 }
 
+/* Only words in untrusted memory can be handed to the host futex; enclave memory is not shared
+ * with other processes anyway, and waits on it would need an in-enclave implementation. */
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us, int flags) {
+    if (!sgx_is_completely_outside_enclave(addr, sizeof(*addr)))
+        return -PAL_ERROR_NOTIMPLEMENTED;
+
+    int op = FUTEX_WAIT | (flags & PAL_FUTEX_PRIVATE ? FUTEX_PRIVATE_FLAG : 0);
+    int ret = ocall_futex(addr, op, val, timeout_us);
+    if (IS_ERR(ret)) {
+        if (ERRNO(ret) == EWOULDBLOCK)
+            return 0;
+        return unix_to_pal_error(ERRNO(ret));
+    }
+    return 0;
+}
+
+int _DkFutexWake(uint32_t* addr, uint32_t count, int flags) {
+    if (!sgx_is_completely_outside_enclave(addr, sizeof(*addr)))
+        return -PAL_ERROR_NOTIMPLEMENTED;
+
+    int op = FUTEX_WAKE | (flags & PAL_FUTEX_PRIVATE ? FUTEX_PRIVATE_FLAG : 0);
+    int ret = ocall_futex(addr, op, count, -1);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+    /* the number of woken waiters comes from the untrusted host */
+    return MIN((uint32_t)ret, count);
+}
+
 static int event_close(PAL_HANDLE handle) {
     _DkEventSet(handle, -1);
     free_untrusted(handle->event.signaled);
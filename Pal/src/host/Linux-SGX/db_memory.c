@@ -50,6 +50,8 @@ int _DkVirtualMemoryAlloc(void** paddr, uint64_t size, int alloc_type, int prot)
         return -PAL_ERROR_INVAL;
     }
 
+    /* enclave memory is preallocated EPC memory, so the huge page, populate and no-reserve hints
+     * do not apply; pages are populated by the memset() below anyway */
     void* mem = get_enclave_pages(addr, size, alloc_type & PAL_ALLOC_INTERNAL);
     if (!mem)
         return addr ? -PAL_ERROR_DENIED : -PAL_ERROR_NOMEM;
@@ -88,6 +90,24 @@ int _DkVirtualMemoryProtect(void* addr, uint64_t size, int prot) {
     return 0;
 }
 
+int _DkVirtualMemoryMove(void* old_addr, uint64_t old_size, void* new_addr, uint64_t new_size) {
+    __UNUSED(old_addr);
+    __UNUSED(old_size);
+    __UNUSED(new_addr);
+    __UNUSED(new_size);
+
+    /* enclave pages cannot be remapped, the caller has to copy */
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkVirtualMemoryDiscard(void* addr, uint64_t size) {
+    __UNUSED(addr);
+    __UNUSED(size);
+
+    /* enclave pages cannot be returned to the host without removing them from the enclave */
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 uint64_t _DkMemoryQuota(void) {
     return g_pal_sec.heap_max - g_pal_sec.heap_min;
 }
@@ -319,6 +319,12 @@ static int pipe_private(PAL_HANDLE* handle, int options) {
     return 0;
 }
 
+/* Data of host pipes would leave the enclave unprotected, so DkStreamOpenPipe() is not available;
+ * LibOS falls back to connected `pipe.srv:` and `pipe:` streams, which are TLS-protected. */
+int _DkStreamOpenPipe(PAL_HANDLE* read_end, PAL_HANDLE* write_end, int options) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 /*!
  * \brief Create PAL handle of type `pipeprv`, `pipesrv`, or `pipe` depending on `type` and `uri`.
  *
@@ -384,7 +390,7 @@ static int64_t pipe_read(PAL_HANDLE handle, uint64_t offset, uint64_t len, void*
     ssize_t bytes;
     if (IS_HANDLE_TYPE(handle, pipeprv)) {
         /* pipeprv are currently not encrypted, see pipe_private() */
-        bytes = ocall_recv(handle->pipeprv.fds[0], buffer, len, NULL, NULL, NULL, NULL);
+        bytes = ocall_recv(handle->pipeprv.fds[0], buffer, len, NULL, NULL, NULL, NULL, 0);
         if (IS_ERR(bytes))
             return unix_to_pal_error(ERRNO(bytes));
     } else {
@@ -424,7 +430,7 @@ static int64_t pipe_write(PAL_HANDLE handle, uint64_t offset, uint64_t len, cons
     ssize_t bytes;
     if (IS_HANDLE_TYPE(handle, pipeprv)) {
         /* pipeprv are currently not encrypted, see pipe_private() */
-        bytes = ocall_send(handle->pipeprv.fds[1], buffer, len, NULL, 0, NULL, 0);
+        bytes = ocall_send(handle->pipeprv.fds[1], buffer, len, NULL, 0, NULL, 0, 0);
         if (IS_ERR(bytes))
             return unix_to_pal_error(ERRNO(bytes));
     } else {
@@ -39,6 +39,13 @@ typedef __kernel_pid_t pid_t;
 #define TCP_CORK 3
 #endif
 
+/* host MSG_* flags for the PAL_MSG flags of DkStreamSendTo and DkStreamRecvFrom */
+static int msg_flags(int flags) {
+    return (flags & PAL_MSG_DONTWAIT ? MSG_DONTWAIT : 0) | (flags & PAL_MSG_MORE ? MSG_MORE : 0) |
+           (flags & PAL_MSG_WAITALL ? MSG_WAITALL : 0) | (flags & PAL_MSG_TRUNC ? MSG_TRUNC : 0) |
+           (flags & PAL_MSG_PEEK ? MSG_PEEK : 0);
+}
+
 /* 96 bytes is the minimal size of buffer to store a IPv4/IPv6
    address */
 #define PAL_SOCKADDR_SIZE 96
@@ -456,11 +463,7 @@ static int tcp_open(PAL_HANDLE* handle, const char* type, const char* uri, int a
     return -PAL_ERROR_NOTSUPPORT;
 }
 
-/* 'read' operation of tcp stream */
-static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, uint64_t len, void* buf) {
-    if (offset)
-        return -PAL_ERROR_INVAL;
-
+static int64_t tcp_recv(PAL_HANDLE handle, uint64_t len, void* buf, int flags) {
     if (!IS_HANDLE_TYPE(handle, tcp) || !handle->sock.conn)
         return -PAL_ERROR_NOTCONNECTION;
 
@@ -470,7 +473,7 @@ static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, uint64_t len, void*
     if (len != (uint32_t)len)
         return -PAL_ERROR_INVAL;
 
-    ssize_t bytes = ocall_recv(handle->sock.fd, buf, len, NULL, NULL, NULL, NULL);
+    ssize_t bytes = ocall_recv(handle->sock.fd, buf, len, NULL, NULL, NULL, NULL, msg_flags(flags));
 
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
@@ -481,27 +484,105 @@ static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, uint64_t len, void*
     return bytes;
 }
 
-/* write' operation of tcp stream */
-static int64_t tcp_write(PAL_HANDLE handle, uint64_t offset, uint64_t len, const void* buf) {
-    if (offset)
-        return -PAL_ERROR_INVAL;
+/* Returns the data of `iov` in one buffer, so that it is passed to the host in a single OCALL and
+ * sent as one message. The buffer is allocated (and returned in `*to_free`) only if `iov` has more
+ * than one non-empty buffer. */
+static int gather_iov(const PAL_IOVEC* iov, uint64_t iov_count, const void** buf, uint64_t* len,
+                      void** to_free) {
+    uint64_t total = 0;
+    uint64_t nonempty = 0;
+    *buf = "";
+    for (uint64_t i = 0; i < iov_count; i++) {
+        if (!iov[i].size)
+            continue;
+        if (total + iov[i].size < total)
+            return -PAL_ERROR_INVAL;
+        total += iov[i].size;
+        *buf = iov[i].buffer;
+        nonempty++;
+    }
+
+    *len     = total;
+    *to_free = NULL;
+    if (nonempty <= 1)
+        return 0;
+
+    char* data = malloc(total);
+    if (!data)
+        return -PAL_ERROR_NOMEM;
+
+    char* ptr = data;
+    for (uint64_t i = 0; i < iov_count; i++) {
+        memcpy(ptr, iov[i].buffer, iov[i].size);
+        ptr += iov[i].size;
+    }
+
+    *buf     = data;
+    *to_free = data;
+    return 0;
+}
 
+static int64_t tcp_send(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count, int flags) {
     if (!IS_HANDLE_TYPE(handle, tcp) || !handle->sock.conn)
         return -PAL_ERROR_NOTCONNECTION;
 
     if (handle->sock.fd == PAL_IDX_POISON)
         return -PAL_ERROR_CONNFAILED;
 
-    if (len != (uint32_t)len)
-        return -PAL_ERROR_INVAL;
+    const void* buf;
+    uint64_t len;
+    void* to_free;
+    int ret = gather_iov(iov, iov_count, &buf, &len, &to_free);
+    if (ret < 0)
+        return ret;
 
-    ssize_t bytes = ocall_send(handle->sock.fd, buf, len, NULL, 0, NULL, 0);
+    ssize_t bytes = len != (uint32_t)len
+                    ? -EINVAL
+                    : ocall_send(handle->sock.fd, buf, len, NULL, 0, NULL, 0, msg_flags(flags));
+    free(to_free);
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
 
     return bytes;
 }
 
+/* 'read' operation of tcp stream */
+static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, uint64_t len, void* buf) {
+    if (offset)
+        return -PAL_ERROR_INVAL;
+
+    return tcp_recv(handle, len, buf, /*flags=*/0);
+}
+
+/* write' operation of tcp stream */
+static int64_t tcp_write(PAL_HANDLE handle, uint64_t offset, uint64_t len, const void* buf) {
+    if (offset)
+        return -PAL_ERROR_INVAL;
+
+    PAL_IOVEC iov = {.buffer = (void*)buf, .size = len};
+    return tcp_send(handle, &iov, 1, /*flags=*/0);
+}
+
+/* 'recvfrom' operation of tcp stream: the peer is fixed, so no address is returned */
+static int64_t tcp_recvfrom(PAL_HANDLE handle, void* buf, uint64_t len, void* addr,
+                            size_t* addrlen, int flags) {
+    if (addr)
+        *addrlen = 0;
+
+    return tcp_recv(handle, len, buf, flags);
+}
+
+/* 'sendto' operation of tcp stream */
+static int64_t tcp_sendto(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                          const void* addr, size_t addrlen, int flags) {
+    __UNUSED(addrlen);
+
+    if (addr)
+        return -PAL_ERROR_INVAL;
+
+    return tcp_send(handle, iov, iov_count, flags);
+}
+
 /* used by 'open' operation of tcp stream for bound socket */
 static int udp_bind(PAL_HANDLE* handle, char* uri, int create, int options) {
     struct sockaddr_storage buffer;
@@ -627,7 +708,7 @@ static int64_t udp_receive(PAL_HANDLE handle, uint64_t offset, uint64_t len, voi
     if (len != (uint32_t)len)
         return -PAL_ERROR_INVAL;
 
-    ssize_t ret = ocall_recv(handle->sock.fd, buf, len, NULL, NULL, NULL, NULL);
+    ssize_t ret = ocall_recv(handle->sock.fd, buf, len, NULL, NULL, NULL, NULL, 0);
     return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : ret;
 }
 
@@ -649,7 +730,7 @@ static int64_t udp_receivebyaddr(PAL_HANDLE handle, uint64_t offset, uint64_t le
     size_t conn_addrlen = sizeof(conn_addr);
 
     ssize_t bytes = ocall_recv(handle->sock.fd, buf, len,
-                               (struct sockaddr*)&conn_addr, &conn_addrlen, NULL, NULL);
+                               (struct sockaddr*)&conn_addr, &conn_addrlen, NULL, NULL, 0);
 
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
@@ -679,7 +760,7 @@ static int64_t udp_send(PAL_HANDLE handle, uint64_t offset, uint64_t len, const
     if (len != (uint32_t)len)
         return -PAL_ERROR_INVAL;
 
-    ssize_t bytes = ocall_send(handle->sock.fd, buf, len, NULL, 0, NULL, 0);
+    ssize_t bytes = ocall_send(handle->sock.fd, buf, len, NULL, 0, NULL, 0, 0);
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
 
@@ -717,7 +798,71 @@ static int64_t udp_sendbyaddr(PAL_HANDLE handle, uint64_t offset, uint64_t len,
         return ret;
 
     ssize_t bytes = ocall_send(handle->sock.fd, buf, len,
-                               (struct sockaddr*)&conn_addr, conn_addrlen, NULL, 0);
+                               (struct sockaddr*)&conn_addr, conn_addrlen, NULL, 0, 0);
+    if (IS_ERR(bytes))
+        return unix_to_pal_error(ERRNO(bytes));
+
+    return bytes;
+}
+
+/* 'recvfrom' operation of udp stream: like readbyaddr, but returns the host socket address
+   instead of a URI, and also works on connected sockets */
+static int64_t udp_recvfrom(PAL_HANDLE handle, void* buf, uint64_t len, void* addr,
+                            size_t* addrlen, int flags) {
+    if (!IS_HANDLE_TYPE(handle, udp) && !IS_HANDLE_TYPE(handle, udpsrv))
+        return -PAL_ERROR_NOTCONNECTION;
+
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (len != (uint32_t)len)
+        return -PAL_ERROR_INVAL;
+
+    struct sockaddr_storage conn_addr;
+    size_t conn_addrlen = sizeof(conn_addr);
+
+    ssize_t bytes = ocall_recv(handle->sock.fd, buf, len,
+                               addr ? (struct sockaddr*)&conn_addr : NULL,
+                               addr ? &conn_addrlen : NULL, NULL, NULL, msg_flags(flags));
+    if (IS_ERR(bytes))
+        return unix_to_pal_error(ERRNO(bytes));
+
+    if (addr) {
+        memcpy(addr, &conn_addr, MIN(*addrlen, conn_addrlen));
+        *addrlen = conn_addrlen;
+    }
+
+    return bytes;
+}
+
+/* 'sendto' operation of udp stream: like writebyaddr, but takes the host socket address instead
+   of a URI; without an address, sends to the peer of a connected socket */
+static int64_t udp_sendto(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                          const void* addr, size_t addrlen, int flags) {
+    if (!addr) {
+        if (!IS_HANDLE_TYPE(handle, udp))
+            return -PAL_ERROR_NOTCONNECTION;
+    } else if (!IS_HANDLE_TYPE(handle, udpsrv)) {
+        return -PAL_ERROR_NOTCONNECTION;
+    } else if (addrlen < sizeof(sa_family_t) || addrlen != addr_size(addr)) {
+        return -PAL_ERROR_INVAL;
+    }
+
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    const void* buf;
+    uint64_t len;
+    void* to_free;
+    int ret = gather_iov(iov, iov_count, &buf, &len, &to_free);
+    if (ret < 0)
+        return ret;
+
+    ssize_t bytes = len != (uint32_t)len
+                    ? -EINVAL
+                    : ocall_send(handle->sock.fd, buf, len, addr, addr ? addrlen : 0, NULL, 0,
+                                 msg_flags(flags));
+    free(to_free);
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
 
@@ -984,12 +1129,33 @@ static int socket_getname(PAL_HANDLE handle, char* buffer, size_t count) {
     return orig_count - count;
 }
 
+static int socket_getsockaddr(PAL_HANDLE handle, int which, void* addr, size_t* addrlen) {
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    struct sockaddr* sock_addr = (struct sockaddr*)(which == PAL_SOCKADDR_PEER ? handle->sock.conn
+                                                                               : handle->sock.bind);
+    if (!sock_addr)
+        return -PAL_ERROR_NOTCONNECTION;
+
+    size_t sock_addrlen = addr_size(sock_addr);
+    if (*addrlen < sock_addrlen)
+        return -PAL_ERROR_OVERFLOW;
+
+    memcpy(addr, sock_addr, sock_addrlen);
+    *addrlen = sock_addrlen;
+    return 0;
+}
+
 struct handle_ops g_tcp_ops = {
     .getname        = &socket_getname,
     .open           = &tcp_open,
     .waitforclient  = &tcp_accept,
     .read           = &tcp_read,
     .write          = &tcp_write,
+    .sendto         = &tcp_sendto,
+    .recvfrom       = &tcp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -1001,6 +1167,9 @@ struct handle_ops g_udp_ops = {
     .open           = &udp_open,
     .read           = &udp_receive,
     .write          = &udp_send,
+    .sendto         = &udp_sendto,
+    .recvfrom       = &udp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -1012,6 +1181,9 @@ struct handle_ops g_udpsrv_ops = {
     .open           = &udp_open,
     .readbyaddr     = &udp_receivebyaddr,
     .writebyaddr    = &udp_sendbyaddr,
+    .sendto         = &udp_sendto,
+    .recvfrom       = &udp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -87,6 +87,27 @@ int _DkStreamUnmap(void* addr, uint64_t size) {
     return free_enclave_pages(addr, size);
 }
 
+int _DkStreamsBatchIo(PAL_IO_REQUEST* reqs, uint64_t count) {
+    __UNUSED(reqs);
+    __UNUSED(count);
+
+    /* file contents are decrypted or checked inside the enclave, the host cannot do the I/O */
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int64_t _DkStreamSplice(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                        uint64_t count, int flags) {
+    __UNUSED(src);
+    __UNUSED(src_offset);
+    __UNUSED(dst);
+    __UNUSED(dst_offset);
+    __UNUSED(count);
+    __UNUSED(flags);
+
+    /* data of protected files and encrypted pipes has to pass through the enclave */
+    return -PAL_ERROR_NOTSUPPORT;
+}
+
 static ssize_t handle_serialize(PAL_HANDLE handle, void** data) {
     int ret;
     const void* d1;
@@ -268,7 +289,7 @@ int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo) {
         }
 
     /* first send hdl_hdr so the recipient knows how many FDs were transferred + how large is cargo */
-    ret = ocall_send(fd, &hdl_hdr, sizeof(struct hdl_header), NULL, 0, NULL, 0);
+    ret = ocall_send(fd, &hdl_hdr, sizeof(struct hdl_header), NULL, 0, NULL, 0, 0);
     if (IS_ERR(ret)) {
         free(hdl_data);
         return unix_to_pal_error(ERRNO(ret));
@@ -285,7 +306,8 @@ int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo) {
     memcpy(CMSG_DATA(control_hdr), fds, fds_size);
 
     /* next send FDs-to-transfer as ancillary data */
-    ret = ocall_send(fd, DUMMYPAYLOAD, DUMMYPAYLOADSIZE, NULL, 0, control_hdr, control_hdr->cmsg_len);
+    ret = ocall_send(fd, DUMMYPAYLOAD, DUMMYPAYLOADSIZE, NULL, 0, control_hdr, control_hdr->cmsg_len,
+                     0);
     if (IS_ERR(ret)) {
         free(hdl_data);
         return unix_to_pal_error(ERRNO(ret));
@@ -321,7 +343,7 @@ int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
     int fd = hdl->process.stream;
 
     /* first receive hdl_hdr so that we know how many FDs were transferred + how large is cargo */
-    ret = ocall_recv(fd, &hdl_hdr, sizeof(hdl_hdr), NULL, NULL, NULL, NULL);
+    ret = ocall_recv(fd, &hdl_hdr, sizeof(hdl_hdr), NULL, NULL, NULL, NULL, 0);
     if (IS_ERR(ret))
         return unix_to_pal_error(ERRNO(ret));
 
@@ -345,7 +367,8 @@ int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
 
     /* next receive FDs-to-transfer as ancillary data */
     char dummypayload[DUMMYPAYLOADSIZE];
-    ret = ocall_recv(fd, dummypayload, DUMMYPAYLOADSIZE, NULL, NULL, control_buf, &control_buf_size);
+    ret = ocall_recv(fd, dummypayload, DUMMYPAYLOADSIZE, NULL, NULL, control_buf, &control_buf_size,
+                     0);
     if (IS_ERR(ret))
         return unix_to_pal_error(ERRNO(ret));
 
@@ -389,3 +412,30 @@ int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
     *cargo = handle;
     return 0;
 }
+
+/* Handles are sent one by one: each of them goes through the (possibly encrypted) process stream
+ * separately, so batching their FDs as on the Linux PAL would not save any ocalls. */
+int _DkSendHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int ret = _DkSendHandle(hdl, cargo[i]);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+int _DkReceiveHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int ret = _DkReceiveHandle(hdl, &cargo[i]);
+        if (ret < 0) {
+            /* drop the handles received so far */
+            while (i > 0) {
+                i--;
+                _DkObjectClose(cargo[i]);
+                cargo[i] = NULL;
+            }
+            return ret;
+        }
+    }
+    return 0;
+}
@@ -151,6 +151,27 @@ int _DkThreadResume (PAL_HANDLE threadHandle)
     return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : ret;
 }
 
+/* CPU affinity is not forwarded to the host; the LibOS keeps the mask for bookkeeping only */
+int _DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    __UNUSED(thread);
+    __UNUSED(cpumask_size);
+    __UNUSED(cpu_mask);
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    __UNUSED(thread);
+    __UNUSED(cpumask_size);
+    __UNUSED(cpu_mask);
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkThreadGetCpu(PAL_NUM* cpu, PAL_NUM* node) {
+    __UNUSED(cpu);
+    __UNUSED(node);
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 struct handle_ops g_thread_ops = {
     /* nothing */
 };
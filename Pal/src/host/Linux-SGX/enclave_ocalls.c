@@ -1026,7 +1026,7 @@ int ocall_connect(int domain, int type, int protocol, int ipv6_v6only, const str
 }
 
 ssize_t ocall_recv(int sockfd, void* buf, size_t count, struct sockaddr* addr, size_t* addrlenptr,
-                   void* control, size_t* controllenptr) {
+                   void* control, size_t* controllenptr, int flags) {
     ssize_t retval = 0;
     void* obuf = NULL;
     bool is_obuf_mapped = false;
@@ -1071,13 +1071,19 @@ ssize_t ocall_recv(int sockfd, void* buf, size_t count, struct sockaddr* addr, s
     WRITE_ONCE(ms->ms_addr, untrusted_addr);
     WRITE_ONCE(ms->ms_control, untrusted_control);
     WRITE_ONCE(ms->ms_controllen, controllen);
+    WRITE_ONCE(ms->ms_flags, flags);
 
     retval = sgx_exitless_ocall(OCALL_RECV, ms);
 
     if (retval >= 0) {
-        if ((size_t)retval > count) {
-            retval = -EPERM;
-            goto out;
+        /* only MSG_TRUNC reports the full size of a datagram larger than the buffer */
+        size_t received = (size_t)retval;
+        if (received > count) {
+            if (!(flags & MSG_TRUNC)) {
+                retval = -EPERM;
+                goto out;
+            }
+            received = count;
         }
         if (addr && addrlen) {
             copied = sgx_copy_to_enclave(addr, addrlen,
@@ -1099,7 +1105,7 @@ ssize_t ocall_recv(int sockfd, void* buf, size_t count, struct sockaddr* addr, s
             *controllenptr = copied;
         }
 
-        if (retval > 0 && !sgx_copy_to_enclave(buf, count, READ_ONCE(ms->ms_buf), retval)) {
+        if (received > 0 && !sgx_copy_to_enclave(buf, count, READ_ONCE(ms->ms_buf), received)) {
             retval = -EPERM;
             goto out;
         }
@@ -1113,7 +1119,7 @@ out:
 }
 
 ssize_t ocall_send(int sockfd, const void* buf, size_t count, const struct sockaddr* addr,
-                   size_t addrlen, void* control, size_t controllen) {
+                   size_t addrlen, void* control, size_t controllen, int flags) {
     ssize_t retval = 0;
     void* obuf = NULL;
     bool is_obuf_mapped = false;
@@ -1165,6 +1171,7 @@ ssize_t ocall_send(int sockfd, const void* buf, size_t count, const struct socka
     WRITE_ONCE(ms->ms_addr, untrusted_addr);
     WRITE_ONCE(ms->ms_control, untrusted_control);
     WRITE_ONCE(ms->ms_controllen, controllen);
+    WRITE_ONCE(ms->ms_flags, flags);
 
     retval = sgx_exitless_ocall(OCALL_SEND, ms);
     if (retval > 0 && (size_t)retval > count) {
@@ -57,11 +57,12 @@ int ocall_connect(int domain, int type, int protocol, int ipv6_v6only, const str
                   size_t addrlen, struct sockaddr* bind_addr, size_t* bind_addrlen,
                   struct sockopt* sockopt);
 
+/* `flags` are host MSG_* flags; with MSG_TRUNC, ocall_recv may return more than `count` */
 ssize_t ocall_recv(int sockfd, void* buf, size_t count, struct sockaddr* addr, size_t* addrlenptr,
-                   void* control, size_t* controllenptr);
+                   void* control, size_t* controllenptr, int flags);
 
 ssize_t ocall_send(int sockfd, const void* buf, size_t count, const struct sockaddr* addr,
-                   size_t addrlen, void* control, size_t controllen);
+                   size_t addrlen, void* control, size_t controllen, int flags);
 
 int ocall_setsockopt(int sockfd, int level, int optname, const void* optval, size_t optlen);
 
@@ -74,6 +74,26 @@ struct sockaddr {
 #define MSG_NOSIGNAL 0x4000
 #endif
 
+#ifndef MSG_PEEK
+#define MSG_PEEK 0x2
+#endif
+
+#ifndef MSG_TRUNC
+#define MSG_TRUNC 0x20
+#endif
+
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0x40
+#endif
+
+#ifndef MSG_WAITALL
+#define MSG_WAITALL 0x100
+#endif
+
+#ifndef MSG_MORE
+#define MSG_MORE 0x8000
+#endif
+
 #ifndef SHUT_RD
 #define SHUT_RD 0
 #endif
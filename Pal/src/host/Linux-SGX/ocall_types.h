@@ -217,6 +217,7 @@ typedef struct {
     size_t ms_addrlen;
     void* ms_control;
     size_t ms_controllen;
+    int ms_flags;
 } ms_ocall_recv_t;
 
 typedef struct {
@@ -227,6 +228,7 @@ typedef struct {
     size_t ms_addrlen;
     void* ms_control;
     size_t ms_controllen;
+    int ms_flags;
 } ms_ocall_send_t;
 
 typedef struct {
@@ -500,7 +500,7 @@ static long sgx_ocall_recv(void* pms) {
     hdr.msg_controllen = ms->ms_controllen;
     hdr.msg_flags      = 0;
 
-    ret = INLINE_SYSCALL(recvmsg, 3, ms->ms_sockfd, &hdr, 0);
+    ret = INLINE_SYSCALL(recvmsg, 3, ms->ms_sockfd, &hdr, ms->ms_flags);
 
     if (!IS_ERR(ret) && hdr.msg_name) {
         /* note that ms->ms_addr is filled by recvmsg() itself */
@@ -539,7 +539,7 @@ static long sgx_ocall_send(void* pms) {
     hdr.msg_controllen = ms->ms_controllen;
     hdr.msg_flags      = 0;
 
-    ret = INLINE_SYSCALL(sendmsg, 3, ms->ms_sockfd, &hdr, MSG_NOSIGNAL);
+    ret = INLINE_SYSCALL(sendmsg, 3, ms->ms_sockfd, &hdr, MSG_NOSIGNAL | ms->ms_flags);
     return ret;
 }
 
@@ -31,6 +31,13 @@ int _DkEventCreate(PAL_HANDLE* event, bool initialState, bool isnotification) {
     return 0;
 }
 
+/*
+ * Both kinds of events keep `signaled` set until it is consumed: a notification event until it is
+ * cleared, a synchronization event until a single waiter takes it. Waiters are counted in
+ * `nwaiters` before they check `signaled`, and setters check `nwaiters` after setting it, so
+ * FUTEX_WAKE is skipped whenever nobody can be sleeping on the event.
+ */
+
 int _DkEventSet(PAL_HANDLE event, int wakeup) {
     int ret = 0;
 
@@ -38,7 +45,7 @@ int _DkEventSet(PAL_HANDLE event, int wakeup) {
         // Leave it signaled, wake all
         uint32_t t = 0;
         if (__atomic_compare_exchange_n(&event->event.signaled, &t, 1, /*weak=*/false,
-                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
             int nwaiters = __atomic_load_n(&event->event.nwaiters.counter, __ATOMIC_SEQ_CST);
             if (nwaiters) {
                 if (wakeup != -1 && nwaiters > wakeup)
@@ -51,81 +58,93 @@ int _DkEventSet(PAL_HANDLE event, int wakeup) {
             }
         }
     } else {
-        // Only one thread wakes up, leave unsignaled
-        ret = INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAKE, 1, NULL, NULL, 0);
+        // Leave it signaled until one thread takes it, wake one if there is a waiter
+        __atomic_store_n(&event->event.signaled, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&event->event.nwaiters.counter, __ATOMIC_SEQ_CST))
+            ret = INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAKE, 1, NULL, NULL, 0);
     }
 
     return IS_ERR(ret) ? -PAL_ERROR_TRYAGAIN : ret;
 }
 
+/* Returns true if the event is signaled; a synchronization event is reset at the same time. */
+static bool event_consume(PAL_HANDLE event) {
+    if (event->event.isnotification)
+        return __atomic_load_n(&event->event.signaled, __ATOMIC_SEQ_CST);
+
+    uint32_t t = 1;
+    return __atomic_compare_exchange_n(&event->event.signaled, &t, 0, /*weak=*/false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
 int _DkEventWaitTimeout(PAL_HANDLE event, int64_t timeout_us) {
     int ret = 0;
 
-    if (timeout_us < 0)
-        return _DkEventWait(event);
+    if (event_consume(event))
+        return 0;
 
-    if (!event->event.isnotification ||
-        !__atomic_load_n(&event->event.signaled, __ATOMIC_SEQ_CST)) {
-        struct timespec waittime;
+    struct timespec waittime;
+    struct timespec* waittimep = NULL;
+    if (timeout_us >= 0) {
         int64_t sec      = timeout_us / 1000000UL;
         int64_t microsec = timeout_us - (sec * 1000000UL);
         waittime.tv_sec  = sec;
         waittime.tv_nsec = microsec * 1000;
+        waittimep        = &waittime;
+    }
 
-        __atomic_add_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
-
-        do {
-            ret =
-                INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAIT, 0, &waittime, NULL, 0);
+    __atomic_add_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
 
-            if (IS_ERR(ret)) {
-                if (ERRNO(ret) == EWOULDBLOCK) {
-                    ret = 0;
-                } else {
-                    ret = unix_to_pal_error(ERRNO(ret));
-                    break;
-                }
-            }
-        } while (event->event.isnotification &&
-                 !__atomic_load_n(&event->event.signaled, __ATOMIC_SEQ_CST));
+    while (!event_consume(event)) {
+        ret = INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAIT, 0, waittimep, NULL, 0);
 
-        __atomic_sub_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
+        if (IS_ERR(ret) && ERRNO(ret) != EWOULDBLOCK) {
+            ret = unix_to_pal_error(ERRNO(ret));
+            break;
+        }
+        ret = 0;
     }
 
+    __atomic_sub_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
+
     return ret;
 }
 
 int _DkEventWait(PAL_HANDLE event) {
-    int ret = 0;
-
-    if (!event->event.isnotification ||
-        !__atomic_load_n(&event->event.signaled, __ATOMIC_SEQ_CST)) {
-
-        __atomic_add_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
+    return _DkEventWaitTimeout(event, -1);
+}
 
-        do {
-            ret = INLINE_SYSCALL(futex, 6, &event->event.signaled, FUTEX_WAIT, 0, NULL, NULL, 0);
+int _DkEventClear(PAL_HANDLE event) {
+    __atomic_store_n(&event->event.signaled, 0, __ATOMIC_SEQ_CST);
+    return 0;
+}
 
-            if (IS_ERR(ret)) {
-                if (ERRNO(ret) == EWOULDBLOCK) {
-                    ret = 0;
-                } else {
-                    ret = unix_to_pal_error(ERRNO(ret));
-                    break;
-                }
-            }
-        } while (event->event.isnotification &&
-                 !__atomic_load_n(&event->event.signaled, __ATOMIC_SEQ_CST));
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us, int flags) {
+    int op = FUTEX_WAIT | (flags & PAL_FUTEX_PRIVATE ? FUTEX_PRIVATE_FLAG : 0);
 
-        __atomic_sub_fetch(&event->event.nwaiters.counter, 1, __ATOMIC_SEQ_CST);
+    struct timespec waittime;
+    struct timespec* waittimep = NULL;
+    if (timeout_us >= 0) {
+        waittime.tv_sec  = timeout_us / 1000000;
+        waittime.tv_nsec = (timeout_us % 1000000) * 1000;
+        waittimep = &waittime;
     }
 
-    return ret;
+    int ret = INLINE_SYSCALL(futex, 6, addr, op, val, waittimep, NULL, 0);
+    if (IS_ERR(ret)) {
+        /* the word changed before we went to sleep, the caller re-checks its condition anyway */
+        if (ERRNO(ret) == EWOULDBLOCK)
+            return 0;
+        return unix_to_pal_error(ERRNO(ret));
+    }
+    return 0;
 }
 
-int _DkEventClear(PAL_HANDLE event) {
-    __atomic_store_n(&event->event.signaled, 0, __ATOMIC_SEQ_CST);
-    return 0;
+int _DkFutexWake(uint32_t* addr, uint32_t count, int flags) {
+    int op = FUTEX_WAKE | (flags & PAL_FUTEX_PRIVATE ? FUTEX_PRIVATE_FLAG : 0);
+
+    int ret = INLINE_SYSCALL(futex, 6, addr, op, count, NULL, NULL, 0);
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : ret;
 }
 
 static int event_close(PAL_HANDLE handle) {
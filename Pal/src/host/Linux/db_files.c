@@ -23,8 +23,19 @@
 typedef __kernel_pid_t pid_t;
 #undef __GLIBC__
 #include <linux/stat.h>
+#include <linux/uio.h>
 #include <asm/errno.h>
 
+#ifndef __NR_preadv2
+#define __NR_preadv2  327
+#define __NR_pwritev2 328
+#endif
+
+static_assert(sizeof(PAL_IOVEC) == sizeof(struct iovec) &&
+              offsetof(PAL_IOVEC, buffer) == offsetof(struct iovec, iov_base) &&
+              offsetof(PAL_IOVEC, size) == offsetof(struct iovec, iov_len),
+              "PAL_IOVEC must have the layout of struct iovec");
+
 /* 'open' operation for file streams */
 static int file_open(PAL_HANDLE* handle, const char* type, const char* uri, int access, int share,
                      int create, int options) {
@@ -122,6 +133,53 @@ static int64_t file_write (PAL_HANDLE handle, uint64_t offset, uint64_t count,
     return ret;
 }
 
+/* 'readv' operation for file streams. preadv2 is only used for flags, so
+   older hosts still get vectored reads without them */
+static int64_t file_readv(PAL_HANDLE handle, uint64_t offset, PAL_IOVEC* iov, uint64_t iov_count,
+                          int flags) {
+    int fd = handle->file.fd;
+    int64_t ret;
+
+    if (flags) {
+        ret = INLINE_SYSCALL(preadv2, 6, fd, iov, iov_count,
+                             handle->file.seekable ? (long)offset : -1L, 0, PAL_RW_TO_LINUX(flags));
+        if (IS_ERR(ret) && (ERRNO(ret) == ENOSYS || ERRNO(ret) == EOPNOTSUPP))
+            return -PAL_ERROR_NOTSUPPORT;
+    } else if (handle->file.seekable) {
+        ret = INLINE_SYSCALL(preadv, 5, fd, iov, iov_count, offset, 0);
+    } else {
+        ret = INLINE_SYSCALL(readv, 3, fd, iov, iov_count);
+    }
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    return ret;
+}
+
+/* 'writev' operation for file streams. */
+static int64_t file_writev(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* iov,
+                           uint64_t iov_count, int flags) {
+    int fd = handle->file.fd;
+    int64_t ret;
+
+    if (flags) {
+        ret = INLINE_SYSCALL(pwritev2, 6, fd, iov, iov_count,
+                             handle->file.seekable ? (long)offset : -1L, 0, PAL_RW_TO_LINUX(flags));
+        if (IS_ERR(ret) && (ERRNO(ret) == ENOSYS || ERRNO(ret) == EOPNOTSUPP))
+            return -PAL_ERROR_NOTSUPPORT;
+    } else if (handle->file.seekable) {
+        ret = INLINE_SYSCALL(pwritev, 5, fd, iov, iov_count, offset, 0);
+    } else {
+        ret = INLINE_SYSCALL(writev, 3, fd, iov, iov_count);
+    }
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    return ret;
+}
+
 /* 'close' operation for file streams. In this case, it will only
    close the file withou deleting it. */
 static int file_close (PAL_HANDLE handle)
@@ -201,6 +259,39 @@ static int file_flush (PAL_HANDLE handle)
     return 0;
 }
 
+/* 'allocate' operation for file stream. */
+static int file_allocate(PAL_HANDLE handle, int mode, uint64_t offset, uint64_t length) {
+    int ret = INLINE_SYSCALL(fallocate, 4, handle->file.fd, PAL_FALLOCATE_TO_LINUX(mode), offset,
+                             length);
+
+    if (IS_ERR(ret))
+        return ERRNO(ret) == EOPNOTSUPP ? -PAL_ERROR_NOTSUPPORT : unix_to_pal_error(ERRNO(ret));
+
+    return 0;
+}
+
+/* 'advise' operation for file stream. */
+static int file_advise(PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice) {
+    int ret = INLINE_SYSCALL(fadvise64, 4, handle->file.fd, offset, length,
+                             PAL_ADVICE_TO_LINUX(advice));
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    return 0;
+}
+
+/* 'flushrange' operation for file stream. */
+static int file_flushrange(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags) {
+    int ret = INLINE_SYSCALL(sync_file_range, 4, handle->file.fd, offset, length,
+                             PAL_FLUSH_RANGE_TO_LINUX(flags));
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    return 0;
+}
+
 static inline int file_stat_type (struct stat * stat)
 {
     if (S_ISREG(stat->st_mode))
@@ -330,11 +421,16 @@ struct handle_ops g_file_ops = {
     .open               = &file_open,
     .read               = &file_read,
     .write              = &file_write,
+    .readv              = &file_readv,
+    .writev             = &file_writev,
     .close              = &file_close,
     .delete             = &file_delete,
     .map                = &file_map,
     .setlength          = &file_setlength,
     .flush              = &file_flush,
+    .allocate           = &file_allocate,
+    .advise             = &file_advise,
+    .flushrange         = &file_flushrange,
     .attrquery          = &file_attrquery,
     .attrquerybyhdl     = &file_attrquerybyhdl,
     .attrsetbyhdl       = &file_attrsetbyhdl,
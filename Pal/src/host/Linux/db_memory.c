@@ -40,6 +40,11 @@ int _DkVirtualMemoryAlloc(void** paddr, size_t size, int alloc_type, int prot) {
     if (IS_ERR_P(mem))
         return unix_to_pal_error(ERRNO_P(mem));
 
+    if (alloc_type & PAL_ALLOC_THP) {
+        /* only a hint: hosts with THP disabled (or without THP support) reject it */
+        INLINE_SYSCALL(madvise, 3, mem, size, MADV_HUGEPAGE);
+    }
+
     *paddr = mem;
     return 0;
 }
@@ -56,6 +61,22 @@ int _DkVirtualMemoryProtect(void* addr, size_t size, int prot) {
     return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
 }
 
+int _DkVirtualMemoryMove(void* old_addr, size_t old_size, void* new_addr, size_t new_size) {
+    /* host mremap() moves the page tables, so the contents are not copied */
+    void* addr = (void*)INLINE_SYSCALL(mremap, 5, old_addr, old_size, new_size,
+                                       MREMAP_MAYMOVE | MREMAP_FIXED, new_addr);
+    if (IS_ERR_P(addr))
+        return unix_to_pal_error(ERRNO_P(addr));
+
+    assert(addr == new_addr);
+    return 0;
+}
+
+int _DkVirtualMemoryDiscard(void* addr, size_t size) {
+    int ret = INLINE_SYSCALL(madvise, 3, addr, size, MADV_DONTNEED);
+    return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+}
+
 static int read_proc_meminfo (const char * key, unsigned long * val)
 {
     int fd = INLINE_SYSCALL(open, 3, "/proc/meminfo", O_RDONLY, 0);
@@ -29,9 +29,20 @@
 #include <unistd.h>
 #endif
 
-#define MUTEX_SPINLOCK_TIMES 100
-#define MUTEX_UNLOCKED       0
-#define MUTEX_LOCKED         1
+#define MUTEX_SPIN_MIN 10
+#define MUTEX_SPIN_MAX 1000
+#define MUTEX_UNLOCKED 0
+#define MUTEX_LOCKED   1
+
+/* Adaptive spinning:
+ *
+ * A contended locker spins before going to sleep, but only if nobody is asleep on the mutex
+ * already (then the owner has to wake a sleeper first, and spinning just burns CPU time). It spins
+ * up to twice the average number of spins that contended acquisitions needed so far (plus
+ * MUTEX_SPIN_MIN), so mutexes held for short critical sections are taken without sleeping, while
+ * mutexes held across blocking operations quickly stop spinning. The spin loop only reads the
+ * lock word and tries to take it once it sees it unlocked.
+ */
 
 /* Interplay between locked and nwaiters:
  *
@@ -64,39 +75,53 @@ int _DkMutexCreate(PAL_HANDLE* handle, int initialCount) {
     PAL_HANDLE mut = malloc(HANDLE_SIZE(mutex));
     SET_HANDLE_TYPE(mut, mutex);
     __atomic_store_n(&mut->mutex.mut.nwaiters.counter, 0, __ATOMIC_SEQ_CST);
+    mut->mutex.mut.spins  = 0;
     mut->mutex.mut.locked = initialCount;
     *handle               = mut;
     return 0;
 }
 
 int _DkMutexLockTimeout(struct mutex_handle* m, int64_t timeout_us) {
-    int i, ret = 0;
+    int ret = 0;
 #ifdef DEBUG_MUTEX
     int tid = INLINE_SYSCALL(gettid, 0);
 #endif
-    /* If this is a trylock-style call, break more quickly. */
-    int iterations = (timeout_us == 0) ? 1 : MUTEX_SPINLOCK_TIMES;
-
-    /* Spin and try to take lock.  Ignore any contribution this makes toward
-     * the timeout.*/
-    for (i = 0; i < iterations; i++) {
-        uint32_t t = MUTEX_UNLOCKED;
-        if (__atomic_compare_exchange_n(&m->locked, &t, MUTEX_LOCKED, /*weak=*/true,
-                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
-            goto success;
-        CPU_RELAX();
-    }
+    uint32_t t = MUTEX_UNLOCKED;
+    if (__atomic_compare_exchange_n(&m->locked, &t, MUTEX_LOCKED, /*weak=*/false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        goto success;
 
+    /* If this is a trylock-style call, do not spin. */
     if (timeout_us == 0) {
         ret = -PAL_ERROR_TRYAGAIN;
         goto out;
     }
 
+    /* Spin and try to take lock.  Ignore any contribution this makes toward
+     * the timeout.*/
+    if (!__atomic_load_n(&m->nwaiters.counter, __ATOMIC_RELAXED)) {
+        int32_t spins = __atomic_load_n(&m->spins, __ATOMIC_RELAXED);
+        int32_t max_spins = MIN(MUTEX_SPIN_MAX, spins * 2 + MUTEX_SPIN_MIN);
+        int32_t i;
+        for (i = 0; i < max_spins; i++) {
+            CPU_RELAX();
+            if (__atomic_load_n(&m->locked, __ATOMIC_RELAXED) != MUTEX_UNLOCKED)
+                continue;
+            t = MUTEX_UNLOCKED;
+            if (__atomic_compare_exchange_n(&m->locked, &t, MUTEX_LOCKED, /*weak=*/true,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+                break;
+        }
+        __atomic_store_n(&m->spins, spins + (i - spins) / 8, __ATOMIC_RELAXED);
+        if (i < max_spins)
+            goto success;
+    }
+
     // Bump up the waiters count; we are probably going to block
     __atomic_add_fetch(&m->nwaiters.counter, 1, __ATOMIC_SEQ_CST);
 
     while (true) {
-        uint32_t t = MUTEX_UNLOCKED;
+        t = MUTEX_UNLOCKED;
         if (__atomic_compare_exchange_n(&m->locked, &t, MUTEX_LOCKED, /*weak=*/false,
                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
             break;
@@ -5,7 +5,7 @@
  * db_pipes.c
  *
  * This file contains oeprands to handle streams with URIs that start with
- * "pipe:" or "pipe.srv:".
+ * "pipe:" or "pipe.srv:", and the host pipes of DkStreamOpenPipe().
  */
 
 #include "api.h"
@@ -27,6 +27,11 @@ typedef __kernel_pid_t pid_t;
 #include <linux/un.h>
 #include <sys/socket.h>
 
+#ifndef F_SETPIPE_SZ
+#define F_SETPIPE_SZ 1031
+#define F_GETPIPE_SZ 1032
+#endif
+
 static int pipe_addr(const char* name, struct sockaddr_un* addr) {
     /* use abstract UNIX sockets for pipes, with name format "@/graphene/<pipename>" */
     addr->sun_family = AF_UNIX;
@@ -91,6 +96,7 @@ static int pipe_listen(PAL_HANDLE* handle, const char* name, int options) {
     HANDLE_HDR(hdl)->flags |= RFD(0);  /* cannot write to a listening socket */
     hdl->pipe.fd            = fd;
     hdl->pipe.nonblocking   = options & PAL_OPTION_NONBLOCK ? PAL_TRUE : PAL_FALSE;
+    hdl->pipe.host_pipe     = PAL_FALSE;
 
     /* padding with zeros is for uniformity with other PALs (in particular, Linux-SGX) */
     memset(&hdl->pipe.name.str, 0, sizeof(hdl->pipe.name.str));
@@ -135,6 +141,7 @@ static int pipe_waitforclient(PAL_HANDLE handle, PAL_HANDLE* client) {
     clnt->pipe.fd            = newfd;
     clnt->pipe.name          = handle->pipe.name;
     clnt->pipe.nonblocking   = PAL_FALSE; /* FIXME: must set nonblocking based on `handle` value */
+    clnt->pipe.host_pipe     = PAL_FALSE;
 
     *client = clnt;
     return 0;
@@ -183,6 +190,7 @@ static int pipe_connect(PAL_HANDLE* handle, const char* name, int options) {
     HANDLE_HDR(hdl)->flags |= RFD(0) | WFD(0);
     hdl->pipe.fd            = fd;
     hdl->pipe.nonblocking   = (options & PAL_OPTION_NONBLOCK) ? PAL_TRUE : PAL_FALSE;
+    hdl->pipe.host_pipe     = PAL_FALSE;
 
     /* padding with zeros is for uniformity with other PALs (in particular, Linux-SGX) */
     memset(&hdl->pipe.name.str, 0, sizeof(hdl->pipe.name.str));
@@ -229,6 +237,55 @@ static int pipe_private(PAL_HANDLE* handle, int options) {
     return 0;
 }
 
+static PAL_HANDLE host_pipe_handle(int fd, bool write, int options) {
+    PAL_HANDLE hdl = malloc(HANDLE_SIZE(pipe));
+    if (!hdl)
+        return NULL;
+
+    SET_HANDLE_TYPE(hdl, pipe);
+    HANDLE_HDR(hdl)->flags |= write ? WFD(0) : RFD(0);
+    hdl->pipe.fd            = fd;
+    hdl->pipe.nonblocking   = (options & PAL_OPTION_NONBLOCK) ? PAL_TRUE : PAL_FALSE;
+    hdl->pipe.host_pipe     = PAL_TRUE;
+    memset(&hdl->pipe.name.str, 0, sizeof(hdl->pipe.name.str));
+    return hdl;
+}
+
+/*!
+ * \brief Create PAL handles of type `pipe` for the two ends of a host pipe.
+ *
+ * Unlike other pipes, these are not sockets: the ends are unidirectional, have the capacity of host
+ * pipes (adjustable with F_SETPIPE_SZ through `pipe.size` attribute) and can be spliced directly.
+ *
+ * \param[out] read_end   PAL handle of type `pipe` for the read end.
+ * \param[out] write_end  PAL handle of type `pipe` for the write end.
+ * \param[in]  options    May contain PAL_OPTION_NONBLOCK.
+ * \return                0 on success, negative PAL error code otherwise.
+ */
+int _DkStreamOpenPipe(PAL_HANDLE* read_end, PAL_HANDLE* write_end, int options) {
+    int fds[2];
+
+    int nonblock = options & PAL_OPTION_NONBLOCK ? O_NONBLOCK : 0;
+
+    int ret = INLINE_SYSCALL(pipe2, 2, fds, O_CLOEXEC | nonblock);
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    PAL_HANDLE rd = host_pipe_handle(fds[0], /*write=*/false, options);
+    PAL_HANDLE wr = host_pipe_handle(fds[1], /*write=*/true, options);
+    if (!rd || !wr) {
+        free(rd);
+        free(wr);
+        INLINE_SYSCALL(close, 1, fds[0]);
+        INLINE_SYSCALL(close, 1, fds[1]);
+        return -PAL_ERROR_NOMEM;
+    }
+
+    *read_end  = rd;
+    *write_end = wr;
+    return 0;
+}
+
 /*!
  * \brief Create PAL handle of type `pipeprv`, `pipesrv`, or `pipe` depending on `type` and `uri`.
  *
@@ -388,8 +445,9 @@ static int pipe_delete(PAL_HANDLE handle, int access) {
             INLINE_SYSCALL(shutdown, 2, handle->pipeprv.fds[1], SHUT_WR);
         }
     } else {
-        /* other types of pipes have a single underlying FD, shut it down */
-        if (handle->pipe.fd != PAL_IDX_POISON) {
+        /* other types of pipes have a single underlying FD, shut it down (host pipes are
+         * unidirectional and cannot be shut down, only closed) */
+        if (handle->pipe.fd != PAL_IDX_POISON && !handle->pipe.host_pipe) {
             INLINE_SYSCALL(shutdown, 2, handle->pipe.fd, shutdown);
         }
     }
@@ -426,6 +484,15 @@ static int pipe_attrquerybyhdl(PAL_HANDLE handle, PAL_STREAM_ATTR* attr) {
         attr->pending_size = val;
     }
 
+    attr->pipe.size = 0;
+    if (IS_HANDLE_TYPE(handle, pipe) && handle->pipe.host_pipe) {
+        ret = INLINE_SYSCALL(fcntl, 2, handle->pipe.fd, F_GETPIPE_SZ);
+        if (IS_ERR(ret))
+            return unix_to_pal_error(ERRNO(ret));
+
+        attr->pipe.size = ret;
+    }
+
     /* query if there is data available for reading/writing */
     if (IS_HANDLE_TYPE(handle, pipeprv)) {
         /* for private pipe, readable and writable are queried on different fds */
@@ -454,6 +521,11 @@ static int pipe_attrquerybyhdl(PAL_HANDLE handle, PAL_STREAM_ATTR* attr) {
 
         attr->readable = ret == 1 && (pfd.revents & (POLLIN | POLLERR | POLLHUP)) == POLLIN;
         attr->writable = ret == 1 && (pfd.revents & (POLLOUT | POLLERR | POLLHUP)) == POLLOUT;
+
+        /* the other end of a host pipe was closed */
+        if (IS_HANDLE_TYPE(handle, pipe) && handle->pipe.host_pipe && ret == 1 &&
+                (pfd.revents & (POLLERR | POLLHUP)))
+            attr->disconnected = PAL_TRUE;
     }
 
     return 0;
@@ -462,7 +534,7 @@ static int pipe_attrquerybyhdl(PAL_HANDLE handle, PAL_STREAM_ATTR* attr) {
 /*!
  * \brief Set attributes of PAL handle.
  *
- * Currently only `nonblocking` attribute can be set.
+ * Currently only `nonblocking` attribute and, for host pipes, `pipe.size` attribute can be set.
  *
  * \param[in] handle  PAL handle of type `pipeprv`, `pipesrv`, `pipecli`, or `pipe`.
  * \param[in] attr    User-supplied buffer with new handle's attributes.
@@ -485,6 +557,14 @@ static int pipe_attrsetbyhdl(PAL_HANDLE handle, PAL_STREAM_ATTR* attr) {
         *nonblocking = attr->nonblocking;
     }
 
+    if (IS_HANDLE_TYPE(handle, pipe) && handle->pipe.host_pipe && attr->pipe.size) {
+        int ret = INLINE_SYSCALL(fcntl, 2, handle->pipe.fd, F_GETPIPE_SZ);
+        if (!IS_ERR(ret) && (PAL_NUM)ret != attr->pipe.size)
+            ret = INLINE_SYSCALL(fcntl, 3, handle->pipe.fd, F_SETPIPE_SZ, attr->pipe.size);
+        if (IS_ERR(ret))
+            return unix_to_pal_error(ERRNO(ret));
+    }
+
     return 0;
 }
 
@@ -224,5 +224,10 @@ void setup_vdso_map (ElfW(Addr) addr)
 #else
         g_linux_state.vdso_gettimeofday  = (void*)(load_offset + sym->st_value);
 #endif
+
+    const char * getcpu = "__vdso_getcpu";
+    sym = do_lookup_map(NULL, getcpu, elf_fast_hash(getcpu), elf_hash(getcpu), &vdso_map);
+    if (sym)
+        g_linux_state.vdso_getcpu = (void*)(load_offset + sym->st_value);
 }
 #endif
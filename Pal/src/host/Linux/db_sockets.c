@@ -56,6 +56,13 @@ static size_t addr_size(const struct sockaddr* addr) {
     }
 }
 
+/* host MSG_* flags for the PAL_MSG flags of DkStreamSendTo and DkStreamRecvFrom */
+static int msg_flags(int flags) {
+    return (flags & PAL_MSG_DONTWAIT ? MSG_DONTWAIT : 0) | (flags & PAL_MSG_MORE ? MSG_MORE : 0) |
+           (flags & PAL_MSG_WAITALL ? MSG_WAITALL : 0) | (flags & PAL_MSG_TRUNC ? MSG_TRUNC : 0) |
+           (flags & PAL_MSG_PEEK ? MSG_PEEK : 0);
+}
+
 /* parsing the string of uri, and fill in the socket address structure.
    the latest pointer of uri, length of socket address are returned. */
 static int inet_parse_uri(char** uri, struct sockaddr* addr, size_t* addrlen) {
@@ -547,11 +554,7 @@ static int tcp_open(PAL_HANDLE* handle, const char* type, const char* uri, int a
     return -PAL_ERROR_NOTSUPPORT;
 }
 
-/* 'read' operation of tcp stream */
-static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, size_t len, void* buf) {
-    if (offset)
-        return -PAL_ERROR_INVAL;
-
+static int64_t tcp_recv(PAL_HANDLE handle, size_t len, void* buf, int flags) {
     if (!IS_HANDLE_TYPE(handle, tcp) || !handle->sock.conn)
         return -PAL_ERROR_NOTCONNECTION;
 
@@ -570,7 +573,7 @@ static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, size_t len, void* bu
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, 0);
+    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, msg_flags(flags));
 
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
@@ -581,11 +584,8 @@ static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, size_t len, void* bu
     return bytes;
 }
 
-/* write' operation of tcp stream */
-static int64_t tcp_write(PAL_HANDLE handle, uint64_t offset, size_t len, const void* buf) {
-    if (offset)
-        return -PAL_ERROR_INVAL;
-
+/* PAL_IOVEC has the layout of struct iovec (see db_files.c) */
+static int64_t tcp_send(PAL_HANDLE handle, const PAL_IOVEC* iov, size_t iov_count, int flags) {
     if (!IS_HANDLE_TYPE(handle, tcp) || !handle->sock.conn)
         return -PAL_ERROR_NOTCONNECTION;
 
@@ -593,24 +593,59 @@ static int64_t tcp_write(PAL_HANDLE handle, uint64_t offset, size_t len, const v
         return -PAL_ERROR_CONNFAILED;
 
     struct msghdr hdr;
-    struct iovec iov;
-    iov.iov_base       = (void*)buf;
-    iov.iov_len        = len;
     hdr.msg_name       = NULL;
     hdr.msg_namelen    = 0;
-    hdr.msg_iov        = &iov;
-    hdr.msg_iovlen     = 1;
+    hdr.msg_iov        = (struct iovec*)iov;
+    hdr.msg_iovlen     = iov_count;
     hdr.msg_control    = NULL;
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr, MSG_NOSIGNAL);
+    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr,
+                                   MSG_NOSIGNAL | msg_flags(flags));
     if (IS_ERR(bytes))
         bytes = unix_to_pal_error(ERRNO(bytes));
 
     return bytes;
 }
 
+/* 'read' operation of tcp stream */
+static int64_t tcp_read(PAL_HANDLE handle, uint64_t offset, size_t len, void* buf) {
+    if (offset)
+        return -PAL_ERROR_INVAL;
+
+    return tcp_recv(handle, len, buf, /*flags=*/0);
+}
+
+/* write' operation of tcp stream */
+static int64_t tcp_write(PAL_HANDLE handle, uint64_t offset, size_t len, const void* buf) {
+    if (offset)
+        return -PAL_ERROR_INVAL;
+
+    PAL_IOVEC iov = {.buffer = (void*)buf, .size = len};
+    return tcp_send(handle, &iov, 1, /*flags=*/0);
+}
+
+/* 'recvfrom' operation of tcp stream: the peer is fixed, so no address is returned */
+static int64_t tcp_recvfrom(PAL_HANDLE handle, void* buf, uint64_t len, void* addr,
+                            size_t* addrlen, int flags) {
+    if (addr)
+        *addrlen = 0;
+
+    return tcp_recv(handle, len, buf, flags);
+}
+
+/* 'sendto' operation of tcp stream */
+static int64_t tcp_sendto(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                          const void* addr, size_t addrlen, int flags) {
+    __UNUSED(addrlen);
+
+    if (addr)
+        return -PAL_ERROR_INVAL;
+
+    return tcp_send(handle, iov, iov_count, flags);
+}
+
 /* used by 'open' operation of tcp stream for bound socket */
 static int udp_bind(PAL_HANDLE* handle, char* uri, int create, int options) {
     struct sockaddr_storage buffer;
@@ -773,36 +808,64 @@ static int udp_open(PAL_HANDLE* hdl, const char* type, const char* uri, int acce
     return -PAL_ERROR_NOTSUPPORT;
 }
 
-static int64_t udp_receive(PAL_HANDLE handle, uint64_t offset, size_t len, void* buf) {
-    if (offset)
-        return -PAL_ERROR_INVAL;
-
-    if (!IS_HANDLE_TYPE(handle, udp))
-        return -PAL_ERROR_NOTCONNECTION;
-
-    if (handle->sock.fd == PAL_IDX_POISON)
-        return -PAL_ERROR_BADHANDLE;
-
+/* receive one datagram and, if `addr` is given, the host socket address of its sender */
+static int64_t udp_recvmsg(PAL_HANDLE handle, void* buf, size_t len, struct sockaddr* addr,
+                           size_t* addrlen, int flags) {
     struct msghdr hdr;
     struct iovec iov;
     iov.iov_base       = buf;
     iov.iov_len        = len;
-    hdr.msg_name       = NULL;
-    hdr.msg_namelen    = 0;
+    hdr.msg_name       = addr;
+    hdr.msg_namelen    = addr ? *addrlen : 0;
     hdr.msg_iov        = &iov;
     hdr.msg_iovlen     = 1;
     hdr.msg_control    = NULL;
     hdr.msg_controllen = 0;
     hdr.msg_flags      = 0;
 
-    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, 0);
+    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, flags);
 
     if (IS_ERR(bytes))
         return unix_to_pal_error(ERRNO(bytes));
 
+    if (addr)
+        *addrlen = hdr.msg_namelen;
+
+    return bytes;
+}
+
+/* send one datagram gathered from `iov` to the host socket address `addr` */
+static int64_t udp_sendmsg(PAL_HANDLE handle, const PAL_IOVEC* iov, size_t iov_count,
+                           const struct sockaddr* addr, size_t addrlen, int flags) {
+    struct msghdr hdr;
+    hdr.msg_name       = (void*)addr;
+    hdr.msg_namelen    = addrlen;
+    hdr.msg_iov        = (struct iovec*)iov;
+    hdr.msg_iovlen     = iov_count;
+    hdr.msg_control    = NULL;
+    hdr.msg_controllen = 0;
+    hdr.msg_flags      = 0;
+
+    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr, MSG_NOSIGNAL | flags);
+    if (IS_ERR(bytes))
+        bytes = unix_to_pal_error(ERRNO(bytes));
+
     return bytes;
 }
 
+static int64_t udp_receive(PAL_HANDLE handle, uint64_t offset, size_t len, void* buf) {
+    if (offset)
+        return -PAL_ERROR_INVAL;
+
+    if (!IS_HANDLE_TYPE(handle, udp))
+        return -PAL_ERROR_NOTCONNECTION;
+
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    return udp_recvmsg(handle, buf, len, NULL, NULL, /*flags=*/0);
+}
+
 static int64_t udp_receivebyaddr(PAL_HANDLE handle, uint64_t offset, size_t len, void* buf,
                                  char* addr, size_t addrlen) {
     if (offset)
@@ -815,36 +878,51 @@ static int64_t udp_receivebyaddr(PAL_HANDLE handle, uint64_t offset, size_t len,
         return -PAL_ERROR_BADHANDLE;
 
     struct sockaddr_storage conn_addr;
+    size_t conn_addrlen = sizeof(conn_addr);
 
-    struct msghdr hdr;
-    struct iovec iov;
-    iov.iov_base       = buf;
-    iov.iov_len        = len;
-    hdr.msg_name       = &conn_addr;
-    hdr.msg_namelen    = sizeof(conn_addr);
-    hdr.msg_iov        = &iov;
-    hdr.msg_iovlen     = 1;
-    hdr.msg_control    = NULL;
-    hdr.msg_controllen = 0;
-    hdr.msg_flags      = 0;
-
-    int64_t bytes = INLINE_SYSCALL(recvmsg, 3, handle->sock.fd, &hdr, 0);
-
-    if (IS_ERR(bytes))
-        return unix_to_pal_error(ERRNO(bytes));
+    int64_t bytes = udp_recvmsg(handle, buf, len, (struct sockaddr*)&conn_addr, &conn_addrlen,
+                                /*flags=*/0);
+    if (bytes < 0)
+        return bytes;
 
     char* addr_uri = strcpy_static(addr, URI_PREFIX_UDP, addrlen);
     if (!addr_uri)
         return -PAL_ERROR_OVERFLOW;
 
     int ret = inet_create_uri(addr_uri, addr + addrlen - addr_uri,
-                              (struct sockaddr*)&conn_addr, hdr.msg_namelen);
+                              (struct sockaddr*)&conn_addr, conn_addrlen);
     if (ret < 0)
         return ret;
 
     return bytes;
 }
 
+/* 'recvfrom' operation of udp stream: like readbyaddr, but returns the host socket address
+   instead of a URI, and also works on connected sockets */
+static int64_t udp_recvfrom(PAL_HANDLE handle, void* buf, uint64_t len, void* addr,
+                            size_t* addrlen, int flags) {
+    if (!IS_HANDLE_TYPE(handle, udp) && !IS_HANDLE_TYPE(handle, udpsrv))
+        return -PAL_ERROR_NOTCONNECTION;
+
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    if (!addr)
+        return udp_recvmsg(handle, buf, len, NULL, NULL, msg_flags(flags));
+
+    struct sockaddr_storage conn_addr;
+    size_t conn_addrlen = sizeof(conn_addr);
+
+    int64_t bytes = udp_recvmsg(handle, buf, len, (struct sockaddr*)&conn_addr, &conn_addrlen,
+                                msg_flags(flags));
+    if (bytes < 0)
+        return bytes;
+
+    memcpy(addr, &conn_addr, MIN(*addrlen, conn_addrlen));
+    *addrlen = conn_addrlen;
+    return bytes;
+}
+
 static int64_t udp_send(PAL_HANDLE handle, uint64_t offset, size_t len, const void* buf) {
     if (offset)
         return -PAL_ERROR_INVAL;
@@ -855,23 +933,9 @@ static int64_t udp_send(PAL_HANDLE handle, uint64_t offset, size_t len, const vo
     if (handle->sock.fd == PAL_IDX_POISON)
         return -PAL_ERROR_BADHANDLE;
 
-    struct msghdr hdr;
-    struct iovec iov;
-    iov.iov_base       = (void*)buf;
-    iov.iov_len        = len;
-    hdr.msg_name       = (void*)handle->sock.conn;
-    hdr.msg_namelen    = addr_size((struct sockaddr*)handle->sock.conn);
-    hdr.msg_iov        = &iov;
-    hdr.msg_iovlen     = 1;
-    hdr.msg_control    = NULL;
-    hdr.msg_controllen = 0;
-    hdr.msg_flags      = 0;
-
-    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr, MSG_NOSIGNAL);
-    if (IS_ERR(bytes))
-        bytes = unix_to_pal_error(ERRNO(bytes));
-
-    return bytes;
+    struct sockaddr* conn_addr = (struct sockaddr*)handle->sock.conn;
+    PAL_IOVEC iov = {.buffer = (void*)buf, .size = len};
+    return udp_sendmsg(handle, &iov, 1, conn_addr, addr_size(conn_addr), /*flags=*/0);
 }
 
 static int64_t udp_sendbyaddr(PAL_HANDLE handle, uint64_t offset, size_t len, const void* buf,
@@ -901,23 +965,30 @@ static int64_t udp_sendbyaddr(PAL_HANDLE handle, uint64_t offset, size_t len, co
     if (ret < 0)
         return ret;
 
-    struct msghdr hdr;
-    struct iovec iov;
-    iov.iov_base       = (void*)buf;
-    iov.iov_len        = len;
-    hdr.msg_name       = &conn_addr;
-    hdr.msg_namelen    = conn_addrlen;
-    hdr.msg_iov        = &iov;
-    hdr.msg_iovlen     = 1;
-    hdr.msg_control    = NULL;
-    hdr.msg_controllen = 0;
-    hdr.msg_flags      = 0;
+    PAL_IOVEC iov = {.buffer = (void*)buf, .size = len};
+    return udp_sendmsg(handle, &iov, 1, (struct sockaddr*)&conn_addr, conn_addrlen,
+                       /*flags=*/0);
+}
 
-    int64_t bytes = INLINE_SYSCALL(sendmsg, 3, handle->sock.fd, &hdr, MSG_NOSIGNAL);
-    if (IS_ERR(bytes))
-        bytes = unix_to_pal_error(ERRNO(bytes));
+/* 'sendto' operation of udp stream: like writebyaddr, but takes the host socket address instead
+   of a URI; without an address, sends to the peer of a connected socket */
+static int64_t udp_sendto(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                          const void* addr, size_t addrlen, int flags) {
+    if (!addr) {
+        if (!IS_HANDLE_TYPE(handle, udp))
+            return -PAL_ERROR_NOTCONNECTION;
+        addr    = handle->sock.conn;
+        addrlen = addr_size(addr);
+    } else if (!IS_HANDLE_TYPE(handle, udpsrv)) {
+        return -PAL_ERROR_NOTCONNECTION;
+    } else if (addrlen < sizeof(sa_family_t) || addrlen != addr_size(addr)) {
+        return -PAL_ERROR_INVAL;
+    }
 
-    return bytes;
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    return udp_sendmsg(handle, iov, iov_count, addr, addrlen, msg_flags(flags));
 }
 
 static int socket_delete(PAL_HANDLE handle, int access) {
@@ -1191,12 +1262,49 @@ static int socket_getname(PAL_HANDLE handle, char* buffer, size_t count) {
     return orig_count - count;
 }
 
+static int socket_getsockaddr(PAL_HANDLE handle, int which, void* addr, size_t* addrlen) {
+    if (handle->sock.fd == PAL_IDX_POISON)
+        return -PAL_ERROR_BADHANDLE;
+
+    struct sockaddr_storage buffer;
+    struct sockaddr* sock_addr;
+    size_t sock_addrlen;
+
+    if (which == PAL_SOCKADDR_PEER) {
+        sock_addr = (struct sockaddr*)handle->sock.conn;
+        if (!sock_addr)
+            return -PAL_ERROR_NOTCONNECTION;
+        sock_addrlen = addr_size(sock_addr);
+    } else if (handle->sock.bind) {
+        sock_addr    = (struct sockaddr*)handle->sock.bind;
+        sock_addrlen = addr_size(sock_addr);
+    } else {
+        /* connected without an explicit local address, ask the host */
+        sock_addr = (struct sockaddr*)&buffer;
+        int len   = sizeof(buffer);
+        int ret   = INLINE_SYSCALL(getsockname, 3, handle->sock.fd, sock_addr, &len);
+        if (IS_ERR(ret))
+            return unix_to_pal_error(ERRNO(ret));
+        sock_addrlen = len;
+    }
+
+    if (*addrlen < sock_addrlen)
+        return -PAL_ERROR_OVERFLOW;
+
+    memcpy(addr, sock_addr, sock_addrlen);
+    *addrlen = sock_addrlen;
+    return 0;
+}
+
 struct handle_ops g_tcp_ops = {
     .getname        = &socket_getname,
     .open           = &tcp_open,
     .waitforclient  = &tcp_accept,
     .read           = &tcp_read,
     .write          = &tcp_write,
+    .sendto         = &tcp_sendto,
+    .recvfrom       = &tcp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -1208,6 +1316,9 @@ struct handle_ops g_udp_ops = {
     .open           = &udp_open,
     .read           = &udp_receive,
     .write          = &udp_send,
+    .sendto         = &udp_sendto,
+    .recvfrom       = &udp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -1219,6 +1330,9 @@ struct handle_ops g_udpsrv_ops = {
     .open           = &udp_open,
     .readbyaddr     = &udp_receivebyaddr,
     .writebyaddr    = &udp_sendbyaddr,
+    .sendto         = &udp_sendto,
+    .recvfrom       = &udp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
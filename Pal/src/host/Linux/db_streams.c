@@ -22,6 +22,7 @@ typedef __kernel_pid_t pid_t;
 #include <asm/fcntl.h>
 #include <asm/poll.h>
 #include <asm/socket.h>
+#include <linux/aio_abi.h>
 #include <linux/msg.h>
 #include <linux/socket.h>
 #include <linux/types.h>
@@ -95,6 +96,387 @@ int _DkStreamUnmap(void* addr, uint64_t size) {
     return 0;
 }
 
+#define AIO_BATCH_SIZE 64
+
+static void batch_io_sync(PAL_IO_REQUEST* req) {
+    int64_t ret;
+    if (req->op == PAL_IO_READ)
+        ret = _DkStreamRead(req->handle, req->offset, req->size, req->buffer, NULL, 0);
+    else
+        ret = _DkStreamWrite(req->handle, req->offset, req->size, req->buffer, NULL, 0);
+
+    if (ret == -PAL_ERROR_ENDOFSTREAM)
+        ret = 0;
+    req->result = ret < 0 ? 0 : ret;
+    req->error  = ret < 0 ? -ret : 0;
+}
+
+/* _DkStreamsBatchIo for internal use. Requests on regular files are submitted to the host AIO
+   context of the current thread, all other requests (and all requests if the host does not
+   support AIO) are done synchronously. */
+int _DkStreamsBatchIo(PAL_IO_REQUEST* reqs, uint64_t count) {
+    PAL_TCB_LINUX* tcb = get_tcb_linux();
+    if (!tcb->aio_ctx) {
+        aio_context_t ctx = 0;
+        int ret = INLINE_SYSCALL(io_setup, 2, AIO_BATCH_SIZE, &ctx);
+        if (!IS_ERR(ret))
+            tcb->aio_ctx = ctx;
+    }
+
+    struct iocb iocbs[AIO_BATCH_SIZE];
+    struct iocb* iocbps[AIO_BATCH_SIZE];
+    struct io_event events[AIO_BATCH_SIZE];
+
+    uint64_t i = 0;
+    while (i < count) {
+        int nr = 0;
+        for (; i < count && nr < AIO_BATCH_SIZE; i++) {
+            PAL_IO_REQUEST* req = &reqs[i];
+            if (!tcb->aio_ctx || !IS_HANDLE_TYPE(req->handle, file)
+                    || !req->handle->file.seekable) {
+                batch_io_sync(req);
+                continue;
+            }
+
+            struct iocb* cb = &iocbs[nr];
+            memset(cb, 0, sizeof(*cb));
+            cb->aio_data       = i;
+            cb->aio_lio_opcode = req->op == PAL_IO_READ ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
+            cb->aio_fildes     = req->handle->file.fd;
+            cb->aio_buf        = (uint64_t)req->buffer;
+            cb->aio_nbytes     = req->size;
+            cb->aio_offset     = req->offset;
+            iocbps[nr++] = cb;
+        }
+
+        int inflight = 0;
+        while (inflight < nr) {
+            int ret = INLINE_SYSCALL(io_submit, 3, tcb->aio_ctx, nr - inflight, &iocbps[inflight]);
+            if (IS_ERR(ret)) {
+                if (ERRNO(ret) == EINTR)
+                    continue;
+                /* the host refuses the first request (e.g. the file does not support AIO or the
+                 * host is out of AIO resources), do it synchronously instead */
+                batch_io_sync(&reqs[iocbps[inflight]->aio_data]);
+                iocbps[inflight] = iocbps[--nr];
+                continue;
+            }
+            inflight += ret;
+        }
+
+        while (inflight > 0) {
+            int ret = INLINE_SYSCALL(io_getevents, 5, tcb->aio_ctx, 1, inflight, events, NULL);
+            if (IS_ERR(ret)) {
+                if (ERRNO(ret) == EINTR)
+                    continue;
+                /* cannot happen with valid arguments; submitted buffers are still in use */
+                return unix_to_pal_error(ERRNO(ret));
+            }
+
+            for (int j = 0; j < ret; j++) {
+                PAL_IO_REQUEST* req = &reqs[events[j].data];
+                if ((int64_t)events[j].res < 0) {
+                    req->result = 0;
+                    req->error  = -unix_to_pal_error(-(int64_t)events[j].res);
+                } else {
+                    req->result = events[j].res;
+                    req->error  = 0;
+                }
+            }
+            inflight -= ret;
+        }
+    }
+
+    return 0;
+}
+
+#ifndef SPLICE_F_MOVE
+#define SPLICE_F_MOVE     1
+#define SPLICE_F_NONBLOCK 2
+#endif
+
+#ifndef F_SETPIPE_SZ
+#define F_SETPIPE_SZ 1031
+#endif
+
+/* capacity of the intermediate pipe of DkStreamSplice (the default limit for unprivileged users) */
+#define SPLICE_PIPE_SIZE (1024 * 1024)
+
+/* upper bound of the data which DkStreamSplice copies to emulate tee() */
+#define SPLICE_PEEK_SIZE (64 * 1024)
+
+/* Returns the host fd of `handle` for reading (`write` is false) or writing, or -1 if the handle
+ * type cannot be spliced. `*seekable` tells if the fd is a regular file which takes an offset. */
+static int splice_fd(PAL_HANDLE handle, bool write, bool* seekable) {
+    PAL_IDX fd;
+    *seekable = false;
+
+    if (IS_HANDLE_TYPE(handle, file)) {
+        *seekable = handle->file.seekable;
+        fd = handle->file.fd;
+    } else if (IS_HANDLE_TYPE(handle, pipe) || IS_HANDLE_TYPE(handle, pipecli)) {
+        fd = handle->pipe.fd;
+    } else if (IS_HANDLE_TYPE(handle, pipeprv)) {
+        fd = handle->pipeprv.fds[write ? 1 : 0];
+    } else if (IS_HANDLE_TYPE(handle, tcp)) {
+        fd = handle->sock.fd;
+    } else if (IS_HANDLE_TYPE(handle, dev)) {
+        fd = write ? handle->dev.fd_out : handle->dev.fd_in;
+    } else {
+        return -1;
+    }
+
+    return fd == PAL_IDX_POISON ? -1 : (int)fd;
+}
+
+/* non-seekable files are FIFOs and pipes from DkStreamOpenPipe() are host pipes, host splice()
+ * needs one of its ends to be one */
+static bool is_host_pipe(PAL_HANDLE handle) {
+    if (IS_HANDLE_TYPE(handle, pipe))
+        return handle->pipe.host_pipe;
+    return IS_HANDLE_TYPE(handle, file) && !handle->file.seekable;
+}
+
+static void close_splice_pipe(PAL_TCB_LINUX* tcb) {
+    INLINE_SYSCALL(close, 1, tcb->splice_pipe[0]);
+    INLINE_SYSCALL(close, 1, tcb->splice_pipe[1]);
+    tcb->splice_pipe[0] = tcb->splice_pipe[1] = 0;
+}
+
+/* Returns true if `fd` is writable; a broken fd counts as writable, the write reports the error. */
+static bool splice_fd_writable(int fd) {
+    struct pollfd pfd = {.fd = fd, .events = POLLOUT, .revents = 0};
+    int ret = INLINE_SYSCALL(poll, 3, &pfd, 1, 0);
+    return IS_ERR(ret) || ret > 0;
+}
+
+/* Writes the `count` bytes buffered in the intermediate pipe to `fd_out`. Only data read from a
+ * file goes through the pipe, so what cannot be written is dropped together with the pipe (the
+ * file offset is advanced only by the returned count), and the pipe is empty for the next call.
+ * With PAL_SPLICE_NONBLOCK, stops when `fd_out` is full. */
+static int64_t drain_splice_pipe(PAL_TCB_LINUX* tcb, int fd_out, int64_t* off_out,
+                                 uint64_t count, int flags) {
+    uint64_t done = 0;
+    int64_t ret = 0;
+
+    while (done < count) {
+        ret = INLINE_SYSCALL(splice, 6, tcb->splice_pipe[0], NULL, fd_out, off_out, count - done,
+                             SPLICE_F_MOVE | (flags & PAL_SPLICE_NONBLOCK ? SPLICE_F_NONBLOCK : 0));
+        if (IS_ERR(ret)) {
+            if (ERRNO(ret) == EINTR)
+                continue;
+            if (ERRNO(ret) == EAGAIN && !(flags & PAL_SPLICE_NONBLOCK)) {
+                /* O_NONBLOCK host fd, but the splice is blocking */
+                struct pollfd pfd = {.fd = fd_out, .events = POLLOUT, .revents = 0};
+                ret = INLINE_SYSCALL(poll, 3, &pfd, 1, -1);
+                if (!IS_ERR(ret) || ERRNO(ret) == EINTR)
+                    continue;
+            }
+            break;
+        }
+        if (!ret)
+            break;
+        done += ret;
+    }
+
+    if (done < count) {
+        close_splice_pipe(tcb);
+        if (!done)
+            return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : -PAL_ERROR_DENIED;
+    }
+    return done;
+}
+
+/* Writes `count` bytes of `buf` to `fd_out` (at `*off_out` if given). Stops at the first error, and
+ * when `fd_out` is full with PAL_SPLICE_NONBLOCK. Returns the number of bytes written, or the
+ * negated errno if nothing was written. */
+static int64_t splice_write_buf(int fd_out, int64_t* off_out, const char* buf, uint64_t count,
+                                int flags) {
+    uint64_t done = 0;
+    int64_t ret = 0;
+
+    while (done < count) {
+        if (off_out) {
+            ret = INLINE_SYSCALL(pwrite64, 4, fd_out, buf + done, count - done, *off_out + done);
+        } else {
+            ret = INLINE_SYSCALL(sendto, 6, fd_out, buf + done, count - done,
+                                 MSG_NOSIGNAL | (flags & PAL_SPLICE_NONBLOCK ? MSG_DONTWAIT : 0),
+                                 NULL, 0);
+            if (IS_ERR(ret) && ERRNO(ret) == ENOTSOCK)
+                ret = INLINE_SYSCALL(write, 3, fd_out, buf + done, count - done);
+        }
+        if (IS_ERR(ret)) {
+            if (ERRNO(ret) == EINTR)
+                continue;
+            if (ERRNO(ret) == EAGAIN && !(flags & PAL_SPLICE_NONBLOCK)) {
+                struct pollfd pfd = {.fd = fd_out, .events = POLLOUT, .revents = 0};
+                ret = INLINE_SYSCALL(poll, 3, &pfd, 1, -1);
+                if (!IS_ERR(ret) || ERRNO(ret) == EINTR)
+                    continue;
+            }
+            break;
+        }
+        if (!ret)
+            break;
+        done += ret;
+    }
+
+    if (off_out)
+        *off_out += done;
+    return done ? (int64_t)done : ret;
+}
+
+/* Moves data from a host socket (other PAL pipes, TCP). Data spliced out of a socket cannot be put
+ * back, so it is peeked into a bounded buffer and only as much is then consumed from the socket as
+ * `fd_out` accepted. */
+static int64_t splice_from_socket(int fd_in, int fd_out, int64_t* off_out, uint64_t count,
+                                  int flags) {
+    if (count > SPLICE_PEEK_SIZE)
+        count = SPLICE_PEEK_SIZE;
+
+    char* buf = malloc(count);
+    if (!buf)
+        return -PAL_ERROR_NOMEM;
+
+    int64_t ret;
+    do {
+        ret = INLINE_SYSCALL(recvfrom, 6, fd_in, buf, count,
+                             MSG_PEEK | (flags & PAL_SPLICE_NONBLOCK ? MSG_DONTWAIT : 0), NULL,
+                             NULL);
+    } while (IS_ERR(ret) && ERRNO(ret) == EINTR);
+    if (IS_ERR(ret) || !ret) {
+        free(buf);
+        if (!IS_ERR(ret))
+            return 0;
+        return ERRNO(ret) == ENOTSOCK ? -PAL_ERROR_NOTSUPPORT : unix_to_pal_error(ERRNO(ret));
+    }
+
+    ret = splice_write_buf(fd_out, off_out, buf, ret, flags);
+    if (ret <= 0) {
+        free(buf);
+        return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+    }
+
+    /* consume what was written; it is already queued in the socket, so this does not block */
+    uint64_t written = ret;
+    uint64_t consumed = 0;
+    while (consumed < written) {
+        ret = INLINE_SYSCALL(recvfrom, 6, fd_in, buf, written - consumed, MSG_DONTWAIT, NULL,
+                             NULL);
+        if (IS_ERR(ret) && ERRNO(ret) == EINTR)
+            continue;
+        if (IS_ERR(ret) || !ret)
+            break;
+        consumed += ret;
+    }
+
+    free(buf);
+    return written;
+}
+
+/* Other PAL pipes are host UNIX sockets, which host tee() cannot read from; their data is peeked
+ * into a bounded buffer instead. */
+static int64_t splice_peek_socket(int fd_in, int fd_out, uint64_t count, int flags) {
+    if (count > SPLICE_PEEK_SIZE)
+        count = SPLICE_PEEK_SIZE;
+
+    char* buf = malloc(count);
+    if (!buf)
+        return -PAL_ERROR_NOMEM;
+
+    int64_t ret = INLINE_SYSCALL(recvfrom, 6, fd_in, buf, count,
+                                 MSG_PEEK | (flags & PAL_SPLICE_NONBLOCK ? MSG_DONTWAIT : 0), NULL,
+                                 NULL);
+    if (IS_ERR(ret) || !ret) {
+        free(buf);
+        return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : 0;
+    }
+
+    uint64_t peeked = ret;
+    uint64_t done = 0;
+    while (done < peeked) {
+        ret = INLINE_SYSCALL(write, 3, fd_out, buf + done, peeked - done);
+        if (IS_ERR(ret)) {
+            if (ERRNO(ret) == EINTR)
+                continue;
+            break;
+        }
+        done += ret;
+    }
+
+    free(buf);
+    if (!done && IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+    return done;
+}
+
+/* _DkStreamSplice for internal use. Uses host splice() (or tee()) directly if one end is a host
+   pipe. Otherwise data from a file goes through an intermediate host pipe of the current thread,
+   which still keeps it in the host kernel, and data from a socket is peeked (see
+   splice_from_socket()). */
+int64_t _DkStreamSplice(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                        uint64_t count, int flags) {
+    bool seek_in, seek_out;
+    int fd_in  = splice_fd(src, /*write=*/false, &seek_in);
+    int fd_out = splice_fd(dst, /*write=*/true, &seek_out);
+    if (fd_in < 0 || fd_out < 0)
+        return -PAL_ERROR_NOTSUPPORT;
+
+    int64_t off_in    = src_offset;
+    int64_t off_out   = dst_offset;
+    int64_t* poff_in  = seek_in ? &off_in : NULL;
+    int64_t* poff_out = seek_out ? &off_out : NULL;
+    unsigned int splice_flags = SPLICE_F_MOVE
+                                | (flags & PAL_SPLICE_NONBLOCK ? SPLICE_F_NONBLOCK : 0);
+    int64_t ret;
+
+    if (flags & PAL_SPLICE_PEEK) {
+        if (is_host_pipe(src) && is_host_pipe(dst)) {
+            ret = INLINE_SYSCALL(tee, 4, fd_in, fd_out, count, splice_flags);
+            return IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : ret;
+        }
+        if ((IS_HANDLE_TYPE(src, pipe) && !src->pipe.host_pipe) || IS_HANDLE_TYPE(src, pipecli)
+                || IS_HANDLE_TYPE(src, pipeprv))
+            return splice_peek_socket(fd_in, fd_out, count, flags);
+        return -PAL_ERROR_NOTSUPPORT;
+    }
+
+    if (is_host_pipe(src) || is_host_pipe(dst)) {
+        ret = INLINE_SYSCALL(splice, 6, fd_in, poff_in, fd_out, poff_out, count, splice_flags);
+        if (IS_ERR(ret))
+            return ERRNO(ret) == EINVAL ? -PAL_ERROR_NOTSUPPORT : unix_to_pal_error(ERRNO(ret));
+        return ret;
+    }
+
+    if (!seek_in)
+        return splice_from_socket(fd_in, fd_out, poff_out, count, flags);
+
+    /* do not read from the file what could not be written anyway */
+    if ((flags & PAL_SPLICE_NONBLOCK) && !seek_out && !splice_fd_writable(fd_out))
+        return -PAL_ERROR_TRYAGAIN;
+
+    PAL_TCB_LINUX* tcb = get_tcb_linux();
+    /* the write end of a created pipe is never fd 0 */
+    if (!tcb->splice_pipe[1]) {
+        ret = INLINE_SYSCALL(pipe2, 2, tcb->splice_pipe, O_CLOEXEC);
+        if (IS_ERR(ret)) {
+            tcb->splice_pipe[0] = tcb->splice_pipe[1] = 0;
+            return unix_to_pal_error(ERRNO(ret));
+        }
+        /* a bigger pipe moves more data per call; the default size is fine as well */
+        INLINE_SYSCALL(fcntl, 3, tcb->splice_pipe[1], F_SETPIPE_SZ, SPLICE_PIPE_SIZE);
+    }
+
+    ret = INLINE_SYSCALL(splice, 6, fd_in, poff_in, tcb->splice_pipe[1], NULL, count,
+                         splice_flags);
+    if (IS_ERR(ret))
+        return ERRNO(ret) == EINVAL ? -PAL_ERROR_NOTSUPPORT : unix_to_pal_error(ERRNO(ret));
+    if (!ret)
+        return 0;
+
+    return drain_splice_pipe(tcb, fd_out, poff_out, ret, flags);
+}
+
 int handle_serialize(PAL_HANDLE handle, void** data) {
     const void* d1;
     const void* d2;
@@ -369,3 +751,286 @@ int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
     *cargo = handle;
     return 0;
 }
+
+/* maximal number of handles sent in one message by _DkSendHandles(); all their FDs must fit in one
+ * SCM_RIGHTS control message (the host allows at most 253 FDs there) */
+#define HANDLES_PER_MSG ((size_t)253 / MAX_FDS)
+
+/* header of a message with a batch of handles, see _DkSendHandles() */
+struct hdls_header {
+    size_t count;
+    struct hdl_header hdrs[HANDLES_PER_MSG];
+};
+
+/* Sends all `size` bytes of `iov`; only the first sendmsg() carries the control message `msg`. */
+static int sendmsg_all(int fd, struct msghdr* msg, struct iovec* iov, size_t iov_count,
+                       size_t size) {
+    size_t sent = 0;
+
+    msg->msg_iov    = iov;
+    msg->msg_iovlen = iov_count;
+    while (sent < size) {
+        ssize_t ret = INLINE_SYSCALL(sendmsg, 3, fd, msg, MSG_NOSIGNAL);
+        if (IS_ERR(ret)) {
+            if (ERRNO(ret) == EINTR)
+                continue;
+            return unix_to_pal_error(ERRNO(ret));
+        }
+        sent += ret;
+
+        /* skip the iovecs which were sent completely, FDs are sent with the first byte already */
+        msg->msg_control    = NULL;
+        msg->msg_controllen = 0;
+        while (msg->msg_iovlen && (size_t)ret >= msg->msg_iov->iov_len) {
+            ret -= msg->msg_iov->iov_len;
+            msg->msg_iov++;
+            msg->msg_iovlen--;
+        }
+        if (msg->msg_iovlen) {
+            msg->msg_iov->iov_base += ret;
+            msg->msg_iov->iov_len  -= ret;
+        }
+    }
+    return 0;
+}
+
+static int send_handles_batch(int fd, PAL_HANDLE* cargo, size_t count) {
+    struct hdls_header hdls_hdr = {.count = count};
+    void* hdl_data[HANDLES_PER_MSG];
+    struct iovec iov[HANDLES_PER_MSG];
+    int fds[HANDLES_PER_MSG * MAX_FDS];
+    size_t nfds = 0;
+    size_t data_size = 0;
+    size_t serialized = 0;
+    int ret;
+
+    assert(count <= HANDLES_PER_MSG);
+    memset(hdls_hdr.hdrs, 0, sizeof(hdls_hdr.hdrs));
+
+    for (; serialized < count; serialized++) {
+        PAL_HANDLE hdl = cargo[serialized];
+        ssize_t size = handle_serialize(hdl, &hdl_data[serialized]);
+        if (size < 0) {
+            ret = size;
+            goto out;
+        }
+
+        hdls_hdr.hdrs[serialized].data_size = size;
+        iov[serialized].iov_base = hdl_data[serialized];
+        iov[serialized].iov_len  = size;
+        data_size += size;
+
+        for (int i = 0; i < MAX_FDS; i++)
+            if (HANDLE_HDR(hdl)->flags & (RFD(i) | WFD(i))) {
+                hdls_hdr.hdrs[serialized].fds |= 1U << i;
+                fds[nfds++] = hdl->generic.fds[i];
+            }
+    }
+
+    /* first send the header so the recipient knows the sizes of the handles and their FDs */
+    struct iovec hdr_iov = {.iov_base = &hdls_hdr, .iov_len = sizeof(hdls_hdr)};
+    struct msghdr message_hdr = {0};
+    ret = sendmsg_all(fd, &message_hdr, &hdr_iov, 1, sizeof(hdls_hdr));
+    if (ret < 0)
+        goto out;
+
+    /* then the serialized handles as payload and all their FDs as ancillary data */
+    char control_buf[CMSG_SPACE(sizeof(fds))];
+    if (nfds) {
+        message_hdr.msg_control    = control_buf;
+        message_hdr.msg_controllen = sizeof(control_buf);
+
+        struct cmsghdr* control_hdr = CMSG_FIRSTHDR(&message_hdr);
+        control_hdr->cmsg_level = SOL_SOCKET;
+        control_hdr->cmsg_type  = SCM_RIGHTS;
+        control_hdr->cmsg_len   = CMSG_LEN(sizeof(int) * nfds);
+        memcpy(CMSG_DATA(control_hdr), fds, sizeof(int) * nfds);
+
+        message_hdr.msg_controllen = control_hdr->cmsg_len;
+    }
+    ret = sendmsg_all(fd, &message_hdr, iov, count, data_size);
+
+out:
+    for (size_t i = 0; i < serialized; i++)
+        free(hdl_data[i]);
+    return ret;
+}
+
+/*!
+ * \brief Send `count` handles from `cargo` to a process identified via `hdl` handle.
+ *
+ * Up to HANDLES_PER_MSG handles are sent with two sendmsg() calls (instead of two per handle in
+ * _DkSendHandle()), so migrating a large number of file descriptors on fork is cheap.
+ *
+ * \param[in] hdl    Process stream on which to send `cargo`.
+ * \param[in] cargo  Handles to serialize and send on `hdl`.
+ * \param[in] count  Number of handles in `cargo`.
+ * \return           0 on success, negative PAL error code otherwise.
+ */
+int _DkSendHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count) {
+    if (!IS_HANDLE_TYPE(hdl, process))
+        return -PAL_ERROR_BADHANDLE;
+
+    for (size_t i = 0; i < count; i += HANDLES_PER_MSG) {
+        int ret = send_handles_batch(hdl->process.stream, cargo + i,
+                                     MIN(count - i, HANDLES_PER_MSG));
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+/* the PAL is linked without libgcc, so __builtin_popcount() (__popcountdi2) is not available */
+static size_t count_fds(uint32_t fds_mask) {
+    size_t n = 0;
+    while (fds_mask) {
+        fds_mask &= fds_mask - 1;
+        n++;
+    }
+    return n;
+}
+
+static int receive_handles_batch(int fd, PAL_HANDLE* cargo, size_t count) {
+    struct hdls_header hdls_hdr;
+    ssize_t ret;
+
+    struct iovec iov = {.iov_base = &hdls_hdr, .iov_len = sizeof(hdls_hdr)};
+    struct msghdr message_hdr = {0};
+    message_hdr.msg_iov    = &iov;
+    message_hdr.msg_iovlen = 1;
+
+    /* a signal may interrupt MSG_WAITALL after part of the header arrived */
+    size_t hdr_received = 0;
+    while (hdr_received < sizeof(hdls_hdr)) {
+        iov.iov_base = (char*)&hdls_hdr + hdr_received;
+        iov.iov_len  = sizeof(hdls_hdr) - hdr_received;
+        ret = INLINE_SYSCALL(recvmsg, 3, fd, &message_hdr, MSG_WAITALL);
+        if (IS_ERR(ret) && ERRNO(ret) == EINTR)
+            continue;
+        if (IS_ERR(ret))
+            return unix_to_pal_error(ERRNO(ret));
+        if (!ret)
+            return hdr_received ? -PAL_ERROR_DENIED : -PAL_ERROR_TRYAGAIN;
+        hdr_received += ret;
+    }
+
+    /* do not trust the sender blindly: the batch must be as expected (see _DkReceiveHandle()) */
+    if (hdls_hdr.count != count)
+        return -PAL_ERROR_DENIED;
+
+    size_t nfds = 0;
+    size_t data_size = 0;
+    for (size_t i = 0; i < count; i++) {
+        /* a serialized handle contains at least the handle header */
+        if (hdls_hdr.hdrs[i].data_size < sizeof(PAL_HDR) ||
+                (hdls_hdr.hdrs[i].fds & ~((1U << MAX_FDS) - 1)))
+            return -PAL_ERROR_DENIED;
+        data_size += hdls_hdr.hdrs[i].data_size;
+        nfds += count_fds(hdls_hdr.hdrs[i].fds);
+    }
+
+    char* hdl_data = malloc(data_size);
+    if (!hdl_data)
+        return -PAL_ERROR_NOMEM;
+
+    int fds[HANDLES_PER_MSG * MAX_FDS];
+    char control_buf[CMSG_SPACE(sizeof(fds))];
+    size_t received_fds = 0;
+    size_t fds_idx = 0;
+
+    iov.iov_base = hdl_data;
+    iov.iov_len  = data_size;
+    message_hdr.msg_control    = control_buf;
+    message_hdr.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+
+    size_t received = 0;
+    while (received < data_size) {
+        ret = INLINE_SYSCALL(recvmsg, 3, fd, &message_hdr, 0);
+        if (IS_ERR(ret) && ERRNO(ret) == EINTR)
+            continue;
+        if (IS_ERR(ret) || !ret) {
+            ret = IS_ERR(ret) ? unix_to_pal_error(ERRNO(ret)) : -PAL_ERROR_DENIED;
+            goto out;
+        }
+
+        /* FDs arrive with the first byte of the data */
+        struct cmsghdr* control_hdr = CMSG_FIRSTHDR(&message_hdr);
+        if (!received && control_hdr && control_hdr->cmsg_type == SCM_RIGHTS) {
+            received_fds = MIN((control_hdr->cmsg_len - CMSG_LEN(0)) / sizeof(int), nfds);
+            memcpy(fds, CMSG_DATA(control_hdr), sizeof(int) * received_fds);
+        }
+
+        received += ret;
+        iov.iov_base = hdl_data + received;
+        iov.iov_len  = data_size - received;
+        message_hdr.msg_control    = NULL;
+        message_hdr.msg_controllen = 0;
+    }
+
+    /* deserialize the handles and restore their FDs from the received ones */
+    size_t off = 0;
+    size_t i;
+    ret = 0;
+    for (i = 0; i < count; i++) {
+        PAL_HANDLE handle = NULL;
+        ret = handle_deserialize(&handle, hdl_data + off, hdls_hdr.hdrs[i].data_size);
+        if (IS_ERR(ret))
+            break;
+        off += hdls_hdr.hdrs[i].data_size;
+
+        for (int j = 0; j < MAX_FDS; j++) {
+            if (hdls_hdr.hdrs[i].fds & (1U << j)) {
+                if (fds_idx < received_fds) {
+                    handle->generic.fds[j] = fds[fds_idx++];
+                } else {
+                    HANDLE_HDR(handle)->flags &= ~(RFD(j) | WFD(j));
+                }
+            }
+        }
+        cargo[i] = handle;
+    }
+
+    if (IS_ERR(ret)) {
+        /* the handles deserialized so far own their FDs */
+        while (i > 0) {
+            i--;
+            _DkObjectClose(cargo[i]);
+            cargo[i] = NULL;
+        }
+    }
+
+out:
+    /* close the received FDs which were not handed to a handle */
+    for (; fds_idx < received_fds; fds_idx++)
+        INLINE_SYSCALL(close, 1, fds[fds_idx]);
+    free(hdl_data);
+    return ret;
+}
+
+/*!
+ * \brief Receive `count` handles sent by _DkSendHandles() from a process identified via `hdl`.
+ *
+ * \param[in]  hdl    Process stream on which to receive `cargo`.
+ * \param[out] cargo  Array of `count` handles to receive on `hdl` and deserialize.
+ * \param[in]  count  Number of handles to receive, must match the number of handles sent.
+ * \return            0 on success, negative PAL error code otherwise.
+ */
+int _DkReceiveHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count) {
+    if (!IS_HANDLE_TYPE(hdl, process))
+        return -PAL_ERROR_BADHANDLE;
+
+    for (size_t i = 0; i < count; i += HANDLES_PER_MSG) {
+        int ret = receive_handles_batch(hdl->process.stream, cargo + i,
+                                        MIN(count - i, HANDLES_PER_MSG));
+        if (ret < 0) {
+            /* the failed batch cleaned up after itself, drop the batches received before it */
+            while (i > 0) {
+                i--;
+                _DkObjectClose(cargo[i]);
+                cargo[i] = NULL;
+            }
+            return ret;
+        }
+    }
+    return 0;
+}
@@ -28,50 +28,24 @@
  * needs to use raw system calls and inline asm. Thus, we resort to recycling thread stacks
  * allocated by previous threads and not used anymore. This still leaks memory but at least
  * it is bounded by the maximum number of simultaneously executing threads. Note that main
- * thread is not a part of this mechanism (it only allocates a tiny altstack). */
-struct thread_stack_map_t {
-    void* stack;
-    bool  used;
-};
-
-static struct thread_stack_map_t* g_thread_stack_map = NULL;
-static size_t g_thread_stack_num  = 0;
-static size_t g_thread_stack_size = 0;
+ * thread is not a part of this mechanism (it only allocates a tiny altstack).
+ *
+ * Unused stacks (together with the TCB and altstack that live in the same allocation) are kept in
+ * a LIFO list linked through the lowest word of each stack, which an exiting thread never touches,
+ * so both getting and recycling a stack take constant time and the most recently used (cache-hot)
+ * stack is handed out first. */
+static void* g_free_thread_stacks = NULL;
 static spinlock_t g_thread_stack_lock = INIT_SPINLOCK_UNLOCKED;
 
 static void* get_thread_stack(void) {
-    void* ret = NULL;
     spinlock_lock(&g_thread_stack_lock);
-    for (size_t i = 0; i < g_thread_stack_num; i++) {
-        if (!g_thread_stack_map[i].used) {
-            /* found allocated and unused stack -- use it */
-            g_thread_stack_map[i].used = true;
-            ret = g_thread_stack_map[i].stack;
-            goto out;
-        }
-    }
-
-    if (g_thread_stack_num == g_thread_stack_size) {
-        /* realloc g_thread_stack_map to accommodate more objects (includes the very first time) */
-        g_thread_stack_size += 8;
-        struct thread_stack_map_t* tmp = malloc(g_thread_stack_size * sizeof(*tmp));
-        if (!tmp)
-            goto out;
-
-        memcpy(tmp, g_thread_stack_map, g_thread_stack_num * sizeof(*tmp));
-        free(g_thread_stack_map);
-        g_thread_stack_map = tmp;
-    }
+    void* ret = g_free_thread_stacks;
+    if (ret)
+        g_free_thread_stacks = *(void**)ret;
+    spinlock_unlock(&g_thread_stack_lock);
 
-    ret = malloc(THREAD_STACK_SIZE + ALT_STACK_SIZE);
     if (!ret)
-        goto out;
-
-    g_thread_stack_map[g_thread_stack_num].stack = ret;
-    g_thread_stack_map[g_thread_stack_num].used  = true;
-    g_thread_stack_num++;
-out:
-    spinlock_unlock(&g_thread_stack_lock);
+        ret = malloc(THREAD_STACK_SIZE + ALT_STACK_SIZE);
     return ret;
 }
 
@@ -218,6 +192,13 @@ noreturn void _DkThreadExit(int* clear_child_tid) {
     assert(handle);
 
     block_async_signals(true);
+    if (tcb->aio_ctx)
+        INLINE_SYSCALL(io_destroy, 1, tcb->aio_ctx);
+    if (tcb->splice_pipe[1]) {
+        INLINE_SYSCALL(close, 1, tcb->splice_pipe[0]);
+        INLINE_SYSCALL(close, 1, tcb->splice_pipe[1]);
+    }
+
     if (tcb->alt_stack) {
         stack_t ss;
         ss.ss_sp    = NULL;
@@ -229,13 +210,12 @@ noreturn void _DkThreadExit(int* clear_child_tid) {
         INLINE_SYSCALL(sigaltstack, 2, &ss, NULL);
     }
 
-    /* we do not free thread stack but instead mark it as recycled, see get_thread_stack() */
+    /* we do not free thread stack but instead put it on the free list, see get_thread_stack() */
     spinlock_lock(&g_thread_stack_lock);
-    for (size_t i = 0; i < g_thread_stack_num; i++) {
-        if (g_thread_stack_map[i].stack == handle->thread.stack) {
-            g_thread_stack_map[i].used = false;
-            break;
-        }
+    /* the first thread only has a small altstack, not a stack from get_thread_stack() */
+    if (handle != g_pal_control.first_thread) {
+        *(void**)handle->thread.stack = g_free_thread_stacks;
+        g_free_thread_stacks = handle->thread.stack;
     }
     /* we might still be using the stack we just marked as unused until we enter the asm mode,
      * so we do not unlock now but rather in asm below */
@@ -279,6 +259,49 @@ int _DkThreadResume (PAL_HANDLE threadHandle)
     return 0;
 }
 
+int _DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    int ret = INLINE_SYSCALL(sched_setaffinity, 3, thread->thread.tid, cpumask_size, cpu_mask);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    return 0;
+}
+
+int _DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask) {
+    int ret = INLINE_SYSCALL(sched_getaffinity, 3, thread->thread.tid, cpumask_size, cpu_mask);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    /* the host copies only as many bytes as its own CPU mask has */
+    if ((PAL_NUM)ret < cpumask_size)
+        memset((char*)cpu_mask + ret, 0, cpumask_size - ret);
+
+    return 0;
+}
+
+int _DkThreadGetCpu(PAL_NUM* cpu, PAL_NUM* node) {
+    unsigned int host_cpu, host_node;
+    int ret;
+
+#if USE_VDSO_GETTIME == 1
+    if (g_linux_state.vdso_getcpu)
+        ret = g_linux_state.vdso_getcpu(&host_cpu, &host_node, NULL);
+    else
+#endif
+        ret = INLINE_SYSCALL(getcpu, 3, &host_cpu, &host_node, NULL);
+
+    if (IS_ERR(ret))
+        return unix_to_pal_error(ERRNO(ret));
+
+    if (cpu)
+        *cpu = host_cpu;
+    if (node)
+        *node = host_node;
+    return 0;
+}
+
 struct handle_ops g_thread_ops = {
     /* nothing */
 };
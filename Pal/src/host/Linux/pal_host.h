@@ -25,14 +25,16 @@
 typedef struct mutex_handle {
     uint32_t locked;
     struct atomic_int nwaiters;
+    int32_t spins; /* average spin count of contended acquisitions, see db_mutex.c */
 #ifdef DEBUG_MUTEX
     int owner;
 #endif
 } PAL_LOCK;
 
 /* Initializer of Mutexes */
-#define MUTEX_HANDLE_INIT    { .locked = 0, .nwaiters.counter = 0 }
-#define INIT_MUTEX_HANDLE(m)  do { (m)->locked = 0; atomic_set(&(m)->nwaiters, 0); } while (0)
+#define MUTEX_HANDLE_INIT    { .locked = 0, .nwaiters.counter = 0, .spins = 0 }
+#define INIT_MUTEX_HANDLE(m)  do { (m)->locked = 0; atomic_set(&(m)->nwaiters, 0); \
+                                   (m)->spins = 0; } while (0)
 
 #define LOCK_INIT MUTEX_HANDLE_INIT
 #define INIT_LOCK(lock) INIT_MUTEX_HANDLE(lock)
@@ -80,6 +82,7 @@ typedef struct pal_handle
             PAL_IDX fd;
             PAL_PIPE_NAME name;
             PAL_BOL nonblocking;
+            PAL_BOL host_pipe; /* one end of a host pipe from DkStreamOpenPipe, not a socket */
         } pipe;
 
         struct {
@@ -156,9 +159,19 @@ typedef struct pal_handle
 
 extern void __check_pending_event (void);
 
-#define LEAVE_PAL_CALL() do { __check_pending_event(); } while (0)
+#define ENTER_PAL_CALL(name)                                                \
+    uint64_t __pal_call_start __attribute__((unused)) =                     \
+        pal_get_tcb()->profile_pal_calls ? get_tsc() : 0
+
+#define ACCOUNT_PAL_CALL()                                                  \
+    do {                                                                    \
+        if (__pal_call_start)                                               \
+            pal_get_tcb()->pal_cycles += get_tsc() - __pal_call_start;      \
+    } while (0)
+
+#define LEAVE_PAL_CALL() do { ACCOUNT_PAL_CALL(); __check_pending_event(); } while (0)
 
 #define LEAVE_PAL_CALL_RETURN(retval) \
-    do { __check_pending_event(); return (retval); } while (0)
+    do { ACCOUNT_PAL_CALL(); __check_pending_event(); return (retval); } while (0)
 
 #endif /* PAL_HOST_H */
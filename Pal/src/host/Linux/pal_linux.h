@@ -56,6 +56,7 @@ extern struct pal_linux_state {
 # else
     long int (*vdso_gettimeofday) (struct timeval *, void *);
 # endif
+    long int (*vdso_getcpu) (unsigned int * cpu, unsigned int * node, void * unused);
 #endif
 } g_linux_state;
 
@@ -161,6 +162,9 @@ typedef struct pal_tcb_linux {
         void *      alt_stack;
         int         (*callback) (void *);
         void *      param;
+        unsigned long aio_ctx; /* host AIO context of DkStreamsBatchIo, created on first use */
+        int         splice_pipe[2]; /* intermediate host pipe of DkStreamSplice, created on first
+                                     * use */
     };
 } PAL_TCB_LINUX;
 
@@ -38,6 +38,8 @@ static inline __attribute__((unused)) int unix_to_pal_error(int unix_errno) {
             return -PAL_ERROR_CONNFAILED_PIPE;
         case EAFNOSUPPORT:
             return -PAL_ERROR_AFNOSUPPORT;
+        case ENOSPC:
+            return -PAL_ERROR_NOSPACE;
         default:
             return -PAL_ERROR_DENIED;
     }
@@ -33,6 +33,14 @@ int _DkEventClear(PAL_HANDLE event) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkFutexWake(uint32_t* addr, uint32_t count, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 static int event_close(PAL_HANDLE handle) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
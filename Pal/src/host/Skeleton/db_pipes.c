@@ -30,6 +30,10 @@ static int pipe_private(PAL_HANDLE* handle, int options) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _DkStreamOpenPipe(PAL_HANDLE* read_end, PAL_HANDLE* write_end, int options) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 static int pipe_open(PAL_HANDLE* handle, const char* type, const char* uri, int access, int share,
                      int create, int options) {
     if (!strcmp_static(type, URI_TYPE_PIPE) && !*uri)
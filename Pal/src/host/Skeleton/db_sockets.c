@@ -63,6 +63,16 @@ static int64_t tcp_write(PAL_HANDLE handle, uint64_t offset, size_t len, const v
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+static int64_t tcp_recvfrom(PAL_HANDLE handle, void* buf, uint64_t len, void* addr,
+                            size_t* addrlen, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+static int64_t tcp_sendto(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                          const void* addr, size_t addrlen, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 /* used by 'open' operation of tcp stream for bound socket */
 static int udp_bind(PAL_HANDLE* handle, char* uri, int create) {
     return -PAL_ERROR_NOTIMPLEMENTED;
@@ -110,6 +120,16 @@ static int64_t udp_sendbyaddr(PAL_HANDLE handle, uint64_t offset, size_t len, co
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+static int64_t udp_recvfrom(PAL_HANDLE handle, void* buf, uint64_t len, void* addr,
+                            size_t* addrlen, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+static int64_t udp_sendto(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                          const void* addr, size_t addrlen, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 static int socket_delete(PAL_HANDLE handle, int access) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
@@ -126,12 +146,19 @@ static int socket_getname(PAL_HANDLE handle, char* buffer, size_t count) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+static int socket_getsockaddr(PAL_HANDLE handle, int which, void* addr, size_t* addrlen) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 struct handle_ops g_tcp_ops = {
     .getname        = &socket_getname,
     .open           = &tcp_open,
     .waitforclient  = &tcp_accept,
     .read           = &tcp_read,
     .write          = &tcp_write,
+    .sendto         = &tcp_sendto,
+    .recvfrom       = &tcp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -142,6 +169,9 @@ struct handle_ops g_udp_ops = {
     .open           = &udp_open,
     .read           = &udp_receive,
     .write          = &udp_send,
+    .sendto         = &udp_sendto,
+    .recvfrom       = &udp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -152,6 +182,9 @@ struct handle_ops g_udpsrv_ops = {
     .open           = &udp_open,
     .readbyaddr     = &udp_receivebyaddr,
     .writebyaddr    = &udp_sendbyaddr,
+    .sendto         = &udp_sendto,
+    .recvfrom       = &udp_recvfrom,
+    .getsockaddr    = &socket_getsockaddr,
     .delete         = &socket_delete,
     .close          = &socket_close,
     .attrquerybyhdl = &socket_attrquerybyhdl,
@@ -25,6 +25,15 @@ int _DkStreamUnmap(void* addr, uint64_t size) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
 
+int _DkStreamsBatchIo(PAL_IO_REQUEST* reqs, uint64_t count) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int64_t _DkStreamSplice(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                        uint64_t count, int flags) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
 /* _DkSendHandle for internal use. Send a PAL_HANDLE over the given
    process handle. */
 int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo) {
@@ -36,3 +45,11 @@ int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo) {
 int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE* cargo) {
     return -PAL_ERROR_NOTIMPLEMENTED;
 }
+
+int _DkSendHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
+
+int _DkReceiveHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count) {
+    return -PAL_ERROR_NOTIMPLEMENTED;
+}
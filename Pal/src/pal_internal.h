@@ -46,6 +46,14 @@ struct handle_ops {
     int64_t (*write) (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                       const void * buffer);
 
+    /* 'readv' and 'writev' are used by DkStreamReadV and DkStreamWriteV.
+       Streams without them get one 'read' or 'write' per buffer, which
+       cannot honor any PAL_RW flags */
+    int64_t (*readv) (PAL_HANDLE handle, uint64_t offset, PAL_IOVEC* iov,
+                      uint64_t iov_count, int flags);
+    int64_t (*writev) (PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* iov,
+                       uint64_t iov_count, int flags);
+
     /* 'readbyaddr' and 'writebyaddr' are the same as read and write,
        but with extra field to specify address */
     int64_t (*readbyaddr) (PAL_HANDLE handle, uint64_t offset, uint64_t count,
@@ -53,6 +61,17 @@ struct handle_ops {
     int64_t (*writebyaddr) (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                             const void * buffer, const char * addr, size_t addrlen);
 
+    /* 'sendto', 'recvfrom' and 'getsockaddr' are used by DkStreamSendTo,
+       DkStreamRecvFrom and DkStreamGetSockAddr. They take host socket
+       addresses instead of URIs, and PAL_MSG flags; 'sendto' sends all
+       buffers of 'iov' in one message. Streams without 'sendto' and
+       'recvfrom' fall back to 'writev' (or 'write') and 'read' */
+    int64_t (*sendto) (PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                       const void* addr, size_t addrlen, int flags);
+    int64_t (*recvfrom) (PAL_HANDLE handle, void* buffer, uint64_t count,
+                         void* addr, size_t* addrlen, int flags);
+    int (*getsockaddr) (PAL_HANDLE handle, int which, void* addr, size_t* addrlen);
+
     /* 'close' and 'delete' is used by DkObjectClose and DkStreamDelete,
        'close' will close the stream, while 'delete' actually destroy
        the stream, such as deleting a file or shutting down a socket */
@@ -76,6 +95,14 @@ struct handle_ops {
     /* 'flush' is used by DkStreamFlush. It syncs the stream to the device */
     int (*flush) (PAL_HANDLE handle);
 
+    /* 'allocate', 'advise' and 'flushrange' are used by DkStreamAllocate,
+       DkStreamAdvise and DkStreamFlushRange. They operate on a byte range
+       of a file and take the PAL_FALLOCATE, PAL_ADVICE and PAL_FLUSH_RANGE
+       flags respectively */
+    int (*allocate) (PAL_HANDLE handle, int mode, uint64_t offset, uint64_t length);
+    int (*advise) (PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice);
+    int (*flushrange) (PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags);
+
     /* 'waitforclient' is used by DkStreamWaitforClient. It accepts an
        connection */
     int (*waitforclient) (PAL_HANDLE server, PAL_HANDLE *client);
@@ -212,22 +239,39 @@ int _DkGetCPUInfo (PAL_CPU_INFO * info);
 /* DkStream calls */
 int _DkStreamOpen(PAL_HANDLE* handle, const char* uri, int access, int share, int create,
                   int options);
+int _DkStreamOpenPipe(PAL_HANDLE* read_end, PAL_HANDLE* write_end, int options);
 int _DkStreamDelete (PAL_HANDLE handle, int access);
 int64_t _DkStreamRead (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                        void * buf, char * addr, int addrlen);
 int64_t _DkStreamWrite (PAL_HANDLE handle, uint64_t offset, uint64_t count,
                         const void * buf, const char * addr, int addrlen);
+int64_t _DkStreamReadV(PAL_HANDLE handle, uint64_t offset, PAL_IOVEC* iov, uint64_t iov_count,
+                       int flags);
+int64_t _DkStreamWriteV(PAL_HANDLE handle, uint64_t offset, const PAL_IOVEC* iov,
+                        uint64_t iov_count, int flags);
+int64_t _DkStreamSendTo(PAL_HANDLE handle, const PAL_IOVEC* iov, uint64_t iov_count,
+                        const void* addr, size_t addrlen, int flags);
+int64_t _DkStreamRecvFrom(PAL_HANDLE handle, void* buf, uint64_t count, void* addr,
+                          size_t* addrlen, int flags);
 int _DkStreamAttributesQuery (const char * uri, PAL_STREAM_ATTR * attr);
 int _DkStreamAttributesQueryByHandle (PAL_HANDLE hdl, PAL_STREAM_ATTR * attr);
 int _DkStreamMap (PAL_HANDLE handle, void ** addr, int prot, uint64_t offset,
                   uint64_t size);
 int _DkStreamUnmap (void * addr, uint64_t size);
 int64_t _DkStreamSetLength (PAL_HANDLE handle, uint64_t length);
+int _DkStreamsBatchIo(PAL_IO_REQUEST* reqs, uint64_t count);
+int64_t _DkStreamSplice(PAL_HANDLE src, uint64_t src_offset, PAL_HANDLE dst, uint64_t dst_offset,
+                        uint64_t count, int flags);
 int _DkStreamFlush (PAL_HANDLE handle);
+int _DkStreamAllocate(PAL_HANDLE handle, int mode, uint64_t offset, uint64_t length);
+int _DkStreamAdvise(PAL_HANDLE handle, uint64_t offset, uint64_t length, int advice);
+int _DkStreamFlushRange(PAL_HANDLE handle, uint64_t offset, uint64_t length, int flags);
 int _DkStreamGetName (PAL_HANDLE handle, char * buf, int size);
 const char * _DkStreamRealpath (PAL_HANDLE hdl);
 int _DkSendHandle(PAL_HANDLE hdl, PAL_HANDLE cargo);
 int _DkReceiveHandle(PAL_HANDLE hdl, PAL_HANDLE * cargo);
+int _DkSendHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count);
+int _DkReceiveHandles(PAL_HANDLE hdl, PAL_HANDLE* cargo, size_t count);
 
 /* DkProcess and DkThread calls */
 int _DkThreadCreate (PAL_HANDLE * handle, int (*callback) (void *),
@@ -236,6 +280,9 @@ noreturn void _DkThreadExit(int* clear_child_tid);
 int _DkThreadDelayExecution(uint64_t* duration_us);
 void _DkThreadYieldExecution (void);
 int _DkThreadResume (PAL_HANDLE threadHandle);
+int _DkThreadSetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+int _DkThreadGetCpuAffinity(PAL_HANDLE thread, PAL_NUM cpumask_size, PAL_PTR cpu_mask);
+int _DkThreadGetCpu(PAL_NUM* cpu, PAL_NUM* node);
 int _DkProcessCreate (PAL_HANDLE * handle, const char * uri,
                       const char ** args);
 noreturn void _DkProcessExit (int exitCode);
@@ -255,10 +302,17 @@ int _DkEventWaitTimeout(PAL_HANDLE event, int64_t timeout_us);
 int _DkEventWait(PAL_HANDLE event);
 int _DkEventClear (PAL_HANDLE event);
 
+/* DkFutex calls */
+int _DkFutexWait(uint32_t* addr, uint32_t val, int64_t timeout_us, int flags);
+/* returns the number of woken waiters on success */
+int _DkFutexWake(uint32_t* addr, uint32_t count, int flags);
+
 /* DkVirtualMemory calls */
 int _DkVirtualMemoryAlloc (void ** paddr, uint64_t size, int alloc_type, int prot);
 int _DkVirtualMemoryFree (void * addr, uint64_t size);
 int _DkVirtualMemoryProtect (void * addr, uint64_t size, int prot);
+int _DkVirtualMemoryMove(void* old_addr, uint64_t old_size, void* new_addr, uint64_t new_size);
+int _DkVirtualMemoryDiscard(void* addr, uint64_t size);
 
 /* DkObject calls */
 int _DkObjectReference (PAL_HANDLE objectHandle);